@@ -4,17 +4,24 @@
 #include "ThreadSafeQueue.h"
 #include "ApplicationState.h"
 #include "UICommand.h"
+#include "ClientEvents.h"
 #include "RoomInfo.h"
 #include <string>
 #include <thread>
 #include <atomic>
+#include <chrono>
+#include <future>
+#include <optional>
+#include <vector>
+#include "auth/IAuthService.h"
+#include "common/Trace.h"
 
 /**
  * ApplicationManager - The business logic layer
  * 
  * Responsibilities:
- * - Consume network_inbound queue (raw server messages)
- * - Parse messages and update ApplicationState
+ * - Consume network_inbound queue (ServerEvents decoded by NetworkManager)
+ * - Update ApplicationState from them
  * - Generate outbound network messages
  * - Generate UI commands for presentation
  * - Handle user input events
@@ -24,10 +31,10 @@
 class ApplicationManager {
 private:
     // Queue references (owned externally)
-    ThreadSafeQueue<std::string>& network_inbound_;
+    ThreadSafeQueue<ServerEvent>& network_inbound_;
     ThreadSafeQueue<std::string>& network_outbound_;
     ThreadSafeQueue<UICommand>& ui_commands_;
-    ThreadSafeQueue<std::string>& input_events_;
+    ThreadSafeQueue<InputEvent>& input_events_;
     
     // Network manager reference (for connecting after auth)
     class NetworkManager* network_manager_;
@@ -41,15 +48,80 @@ private:
     
     // Internal processing methods
     void application_loop();
-    void process_network_message(const std::string& message);
-    void process_input_event(const std::string& event);
-    
-    // Protocol parsing
-    std::vector<RoomInfo> parse_room_list(const std::string& data);
+    void process_network_event(ServerEvent& event);
+    void process_input_event(InputEvent& event);
     bool is_in_room() const;
     
     // State tracking for protocol
     bool in_room_;
+    
+    // Flow control: frames consumed since the last CREDIT was sent. Credit
+    // is only returned while the UI keeps up, so a slow terminal stalls the
+    // server-side queue rather than growing ours.
+    static constexpr uint32_t CREDIT_WINDOW = 64;
+    static constexpr size_t UI_BACKLOG_LIMIT = 256;
+    bool credit_open_ = false;
+    uint32_t frames_since_credit_ = 0;
+    void return_credit();
+    
+    // UI updates gathered between frames; screen changes and errors go
+    // straight out via push_ui, after whatever is pending
+    static constexpr auto UI_FRAME_INTERVAL = std::chrono::milliseconds(100);
+    static constexpr size_t MAX_FRAMES_PER_TICK = 256;
+    std::vector<std::string> pending_chat_;
+    std::vector<nlohmann::json> pending_traces_;
+    std::optional<std::vector<std::string>> pending_participants_;
+    std::optional<std::vector<RoomInfo>> pending_rooms_;
+    std::chrono::steady_clock::time_point last_ui_flush_;
+    void push_ui(UICommand cmd);
+    void queue_chat_message(std::string message);
+    // Sends pending updates if a frame interval has passed (or always, if forced)
+    void flush_ui_updates(bool force);
+    
+    // Paged foyer: rooms are fetched a page at a time with LIST_ROOMS as the
+    // UI scrolls. ROOMS_CHANGED marks the list stale; the loaded rows are
+    // then re-fetched at most once per ROOM_REFRESH_INTERVAL.
+    static constexpr size_t ROOM_PAGE_SIZE = 50;
+    static constexpr auto ROOM_REFRESH_INTERVAL = std::chrono::seconds(1);
+    struct RoomListView {
+        std::string prefix;
+        std::string sort = "name";
+        std::string next_cursor;               // "" once the last page is loaded
+        size_t loaded = 0;
+        std::optional<std::string> request;    // cursor of the page in flight
+        bool stale = false;
+        std::chrono::steady_clock::time_point last_refresh;
+    };
+    RoomListView room_view_;
+    // from_start: reload from the first row; otherwise fetch the next page
+    void request_room_page(bool from_start);
+    void refresh_rooms_if_stale();
+    void handle_room_page(RoomPageReply& reply);
+    
+    // Login in flight: authentication and the chat-server connect run on
+    // their own threads at the same time; each posts LOGIN_STEP (with the
+    // attempt number) to input_events_ when it finishes
+    struct PendingLogin {
+        uint64_t attempt = 0;
+        std::shared_future<AuthResult> auth;
+        std::shared_future<std::string> connect;  // empty = connected, else the error
+        std::thread auth_thread;
+        std::thread connect_thread;
+        bool error_shown = false;
+    };
+    std::optional<PendingLogin> login_;
+    uint64_t login_attempts_ = 0;
+    void start_login(const std::string& username, const std::string& password);
+    void on_login_step(uint64_t attempt);
+    void finish_login(const std::string& token, const std::string& display_name);
+    void cancel_login();
+
+    // Latency tracing: every trace_sample_-th chat line we send is traced,
+    // and traced lines we receive go to the UI to be stamped when drawn.
+    std::shared_ptr<tracing::TraceLog> trace_log_;
+    unsigned trace_sample_ = 0;
+    uint64_t chat_sent_ = 0;
+    void trace_received(nlohmann::json& trace);
 
     // Connection settings
     std::string auth_host_;
@@ -63,10 +135,10 @@ public:
      * Queues must outlive this ApplicationManager instance
      */
     ApplicationManager(
-        ThreadSafeQueue<std::string>& network_inbound,
+        ThreadSafeQueue<ServerEvent>& network_inbound,
         ThreadSafeQueue<std::string>& network_outbound,
         ThreadSafeQueue<UICommand>& ui_commands,
-        ThreadSafeQueue<std::string>& input_events,
+        ThreadSafeQueue<InputEvent>& input_events,
         class NetworkManager* network_manager,
         const std::string& auth_host = "127.0.0.1",
         int auth_port = 3001,
@@ -80,6 +152,12 @@ public:
     ApplicationManager(const ApplicationManager&) = delete;
     ApplicationManager& operator=(const ApplicationManager&) = delete;
     
+    /**
+     * Trace one in every sample_every chat lines sent (0 = none) and log
+     * traced lines received; call before start()
+     */
+    void set_tracing(std::shared_ptr<tracing::TraceLog> log, unsigned sample_every);
+    
     /**
      * Start the application processing thread
      */
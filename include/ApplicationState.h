@@ -2,6 +2,8 @@
 #define APPLICATIONSTATE_H
 
 #include "RoomInfo.h"
+#include "MessageRing.h"
+#include <span>
 #include <string>
 #include <vector>
 
@@ -11,6 +13,9 @@
  * IMPORTANT: This is NOT thread-safe by design!
  * Only the Application thread should access this state.
  * Other threads (Network, UI) communicate via queues.
+ *
+ * Chat history is a bounded MessageRing; getters return views into the
+ * state instead of copies, valid until the next modification.
  */
 class ApplicationState {
 public:
@@ -34,11 +39,11 @@ private:
     
     // Chatroom state
     std::string current_room_;
-    std::vector<std::string> chat_messages_;
+    MessageRing chat_messages_;
     std::vector<std::string> participants_;
 
 public:
-    ApplicationState();
+    explicit ApplicationState(size_t chat_capacity = MessageRing::DEFAULT_CAPACITY);
     
     // Connection state
     void set_connected(bool connected);
@@ -56,7 +61,7 @@ public:
     
     // Foyer state
     void set_rooms(const std::vector<RoomInfo>& rooms);
-    std::vector<RoomInfo> get_rooms() const;
+    std::span<const RoomInfo> get_rooms() const;
     void add_room(const RoomInfo& room);
     void clear_rooms();
     
@@ -64,12 +69,16 @@ public:
     void set_current_room(const std::string& room_name);
     std::string get_current_room() const;
     
-    void add_chat_message(const std::string& message);
-    std::vector<std::string> get_chat_messages() const;
+    // Returns the message's id; ids keep increasing across clears
+    uint64_t add_chat_message(std::string message);
+    MessageRing::View get_chat_messages() const;
+    // Messages added after last_seen_id (see MessageRing::since)
+    MessageRing::View get_chat_messages_since(uint64_t last_seen_id) const;
+    uint64_t last_chat_message_id() const;
     void clear_chat_messages();
     
     void set_participants(const std::vector<std::string>& participants);
-    std::vector<std::string> get_participants() const;
+    std::span<const std::string> get_participants() const;
     void add_participant(const std::string& username);
     void remove_participant(const std::string& username);
     
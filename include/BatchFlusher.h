@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+class ChatRoom;
+
+/**
+ * BatchConfig - when a room switches from one MESSAGE per chat line to
+ * MESSAGE_BATCH frames
+ *
+ * rate_threshold: messages/second in a room before batching starts
+ *                 (0 disables batching)
+ * max_delay:      latency budget; no message waits longer than this
+ * max_messages:   a batch is flushed early once it holds this many
+ */
+struct BatchConfig {
+    unsigned rate_threshold = 0;
+    std::chrono::milliseconds max_delay{5};
+    size_t max_messages = 64;
+};
+
+/**
+ * BatchStats - totals across every room
+ *
+ * immediate_messages: sent as a single MESSAGE frame
+ * batched_messages:   delivered inside a MESSAGE_BATCH
+ * batches:            MESSAGE_BATCH flushes (one frame per recipient each)
+ * delay_us_total/max: time batched messages spent waiting for their flush
+ */
+struct BatchStats {
+    std::atomic<uint64_t> immediate_messages{0};
+    std::atomic<uint64_t> batched_messages{0};
+    std::atomic<uint64_t> batches{0};
+    std::atomic<uint64_t> delay_us_total{0};
+    std::atomic<uint64_t> delay_us_max{0};
+
+    void record_delay(uint64_t delay_us);
+};
+
+/**
+ * BatchFlusher - timer thread that flushes room batches at their deadline
+ *
+ * A ChatRoom schedules itself when it opens a batch; the flusher calls
+ * ChatRoom::flush_pending() once the deadline passes. Rooms that filled
+ * their batch early have already flushed, so the late call is a no-op.
+ */
+class BatchFlusher {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit BatchFlusher(const BatchConfig& config);
+    ~BatchFlusher();
+
+    BatchFlusher(const BatchFlusher&) = delete;
+    BatchFlusher& operator=(const BatchFlusher&) = delete;
+
+    const BatchConfig& config() const { return config_; }
+    BatchStats& stats() { return stats_; }
+    const BatchStats& stats() const { return stats_; }
+
+    void schedule(std::weak_ptr<ChatRoom> room, Clock::time_point deadline);
+
+private:
+    struct Entry {
+        Clock::time_point deadline;
+        std::weak_ptr<ChatRoom> room;
+
+        bool operator>(const Entry& other) const { return deadline > other.deadline; }
+    };
+
+    void run();
+
+    BatchConfig config_;
+    BatchStats stats_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue_;
+    bool stopping_ = false;
+    std::thread thread_;
+};
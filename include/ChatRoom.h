@@ -4,38 +4,91 @@
 #include <vector>
 #include <mutex>
 #include <deque>
+#include <memory>
+#include <chrono>
+#include <nlohmann/json.hpp>
+#include "IoBackend.h"
+#include "ClientConnection.h"
+#include "BatchFlusher.h"
+#include "HistoryIndex.h"
+#include "common/Trace.h"
 
 constexpr size_t MAX_HISTORY_SIZE = 100;
 
-struct RoomClient {
-    int fd;
-    std::string name;
-    std::string ip;
-};
-
-class ChatRoom {
+class ChatRoom : public std::enable_shared_from_this<ChatRoom> {
 private:
+    // One MESSAGE_BATCH entry (see NetworkMessage::write_message_batch)
+    struct PendingMessage {
+        int sender_fd;
+        std::string sender;
+        std::string message;
+        uint64_t seq;
+        nlohmann::json trace;  // null unless traced
+        BatchFlusher::Clock::time_point queued_at;
+    };
+    
+
     std::string name_;
-    std::vector<RoomClient> clients_;
-    std::deque<std::string> chat_history_;
+    std::vector<std::shared_ptr<ClientConnection>> clients_;
+    std::deque<SharedPayload> chat_history_;
+    uint64_t next_seq_ = 1;
     mutable std::mutex room_mutex_;
+    std::shared_ptr<IoBackend> io_backend_;
+    std::shared_ptr<tracing::TraceLog> trace_log_;  // where traces end after the socket write
+    std::shared_ptr<HistoryIndex> history_index_;    // null: chat is not indexed
     
-    void add_message_internal(const std::string& message);
+    // Adaptive batching (only with a flusher): rate is measured over short
+    // windows and messages are held in pending_ while it stays high
+    std::shared_ptr<BatchFlusher> batch_flusher_;
+    BatchFlusher::Clock::time_point window_start_;
+    size_t window_count_ = 0;
+    size_t last_window_rate_ = 0;
+    std::vector<PendingMessage> pending_;
+    BatchFlusher::Clock::time_point pending_deadline_;
+    
+    void add_message_internal(const SharedPayload& message);
+    void send_to_members_locked(const SharedPayload& payload, int exclude_fd,
+                                std::string_view coalesce_key = {});
+    bool should_batch_locked(BatchFlusher::Clock::time_point now);
+    void flush_pending_locked();
+    void finish_trace(nlohmann::json trace);
 
 public:
-    explicit ChatRoom(const std::string& name);
+    /**
+     * batch_flusher: enables MESSAGE_BATCH delivery when the room gets busy;
+     * without one every message is sent on its own
+     * trace_log: receives traced messages once they are written out
+     */
+    explicit ChatRoom(const std::string& name, std::shared_ptr<IoBackend> io_backend = nullptr,
+                      std::shared_ptr<BatchFlusher> batch_flusher = nullptr,
+                      std::shared_ptr<tracing::TraceLog> trace_log = nullptr);
     
     std::string get_name() const;
     size_t get_client_count() const;
     
-    void add_client(int fd, const std::string& name, const std::string& ip);
+    void add_client(const std::shared_ptr<ClientConnection>& client);
     void remove_client(int fd);
     bool has_client(int fd) const;
     std::string get_client_display_name(int fd) const;
     
-    void add_message(const std::string& message);
-    void broadcast_message(const std::string& message, int sender_fd);
-    void send_history_to_client(int client_fd);
+    /**
+     * Send a MESSAGE tagged with this room and its next sequence number to
+     * every member except sender_fd, and keep it in the history.
+     * A non-null trace travels with the live copy (history stays plain).
+     * With a history index the message is indexed under the room lock, so
+     * the index sees a room's seqs in the order they were assigned.
+     * Returns the sequence number it was given.
+     */
+    uint64_t broadcast_message(const std::string& sender, const std::string& message, int sender_fd,
+                               const nlohmann::json& trace = nullptr);
+    
+    // Index chat from now on; numbering continues after the room's last indexed seq
+    void set_history_index(std::shared_ptr<HistoryIndex> history_index);
+    
+    // Send any held messages whose deadline has passed (called by the flusher)
+    void flush_pending();
+    void broadcast_member_list();
+    void send_history_to_client(ClientConnection& client);
     
     std::vector<std::string> get_client_names() const;
     std::vector<int> get_client_fds() const;
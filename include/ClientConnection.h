@@ -0,0 +1,162 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "IoBackend.h"
+
+/**
+ * ClientConnection - one authenticated client socket on the chat server
+ *
+ * Writes never block. The write mutex only decides what goes out next;
+ * the bytes are written with it released by the one thread that claimed
+ * the socket, so frames from different rooms still never interleave. When
+ * the socket is full, the unsent part and everything after it wait in the
+ * outbound queue until the IoBackend reports the socket writable again, so
+ * a member that stops reading holds up nobody else.
+ *
+ * A connection has at most one primary room (current_room, which drives
+ * the foyer/room flow of the standard client) and may subscribe to any
+ * number of rooms; the primary room is always one of them.
+ *
+ * Flow control: once the client sends its first CREDIT, every frame written
+ * costs one credit. Replies (send) always go out and may run the balance
+ * negative; broadcasts (deliver, send_batch) wait in the bounded outbound
+ * queue while the balance is exhausted. Queued frames with the same
+ * coalesce key (e.g. a room's member list) replace each other; when the
+ * queue is full the oldest chat frame is dropped, leaving a seq gap (or,
+ * if only state frames are waiting, the oldest of those).
+ *
+ * Liveness: the session thread touch()es the connection on every read;
+ * Heartbeat uses last_inbound() to decide when to ping() and when to
+ * reap() it.
+ */
+class ClientConnection : public std::enable_shared_from_this<ClientConnection> {
+public:
+    static constexpr size_t DEFAULT_MAX_QUEUED_FRAMES = 256;
+
+    ClientConnection(int fd, const std::string& name, const std::string& ip,
+                     const std::string& token, std::shared_ptr<IoBackend> io_backend,
+                     size_t max_queued_frames = DEFAULT_MAX_QUEUED_FRAMES);
+
+    ClientConnection(const ClientConnection&) = delete;
+    ClientConnection& operator=(const ClientConnection&) = delete;
+
+    int fd() const { return fd_; }
+    const std::string& name() const { return name_; }
+    const std::string& ip() const { return ip_; }
+    const std::string& token() const { return token_; }
+
+    bool send(std::string_view frame);
+    bool send(const SharedPayload& frame);
+    bool send_sequence(const std::vector<SharedPayload>& frames);
+
+    // Broadcast frame: sent now if credit allows, otherwise queued
+    bool deliver(const SharedPayload& frame, std::string_view coalesce_key = {});
+
+    /**
+     * Send one payload to many connections as a single IoBackend batch.
+     * Each write mutex is held only to choose between writing and queueing;
+     * no lock is held while the batch is written. Connections out of credit,
+     * or with frames already waiting, queue the payload instead.
+     * Returns the number of connections that took or queued the payload.
+     */
+    static size_t send_batch(IoBackend& io_backend,
+                             const std::vector<std::shared_ptr<ClientConnection>>& connections,
+                             const SharedPayload& payload,
+                             std::string_view coalesce_key = {});
+
+    // CREDIT from the client: enables flow control and flushes what it allows
+    void grant_credit(uint32_t frames);
+
+    enum class PingResult { SENT, BUSY, FAILED };
+
+    /**
+     * Heartbeat write: BUSY if frames are already waiting for the socket
+     * (the PING would only queue behind them), FAILED if the socket has
+     * failed. Costs one credit like any frame.
+     */
+    PingResult ping(std::string_view frame);
+
+    void touch();
+    std::chrono::steady_clock::time_point last_inbound() const;
+
+    // When the socket first refused data it still has not taken; a
+    // default-constructed time_point while writes keep up
+    std::chrono::steady_clock::time_point write_blocked_since() const;
+
+    // Shut the socket down so the session thread's read returns
+    void reap();
+    bool reaped() const { return reaped_.load(std::memory_order_relaxed); }
+
+    bool flow_controlled() const;
+    size_t queued_frames() const;
+    uint64_t dropped_frames() const;
+    uint64_t coalesced_frames() const;
+
+    std::string current_room() const;
+    void set_current_room(const std::string& room);
+
+    // False if already subscribed / not subscribed
+    bool subscribe(const std::string& room);
+    bool unsubscribe(const std::string& room);
+    bool is_subscribed(const std::string& room) const;
+    std::vector<std::string> rooms() const;
+
+    // Client asked (in AUTH) for ROOM_PAGE/ROOMS_CHANGED instead of full ROOM_LISTs
+    bool paged_room_list() const;
+    void set_paged_room_list(bool paged);
+
+private:
+    struct QueuedFrame {
+        SharedPayload payload;
+        std::string coalesce_key;
+    };
+
+    // All of these require write_mutex_
+    bool can_write_now_locked() const;
+    void charge_locked(size_t frames);
+    void enqueue_locked(const SharedPayload& frame, std::string_view coalesce_key);
+    void commit_locked(const SharedPayload& frame);
+    void flush_locked(std::unique_lock<std::mutex>& lock);
+    void consume_locked(size_t bytes);
+    void stall_locked();
+    void fail_locked();
+    void on_writable();
+
+    int fd_;
+    std::string name_;
+    std::string ip_;
+    std::string token_;
+    std::shared_ptr<IoBackend> io_backend_;
+
+    mutable std::mutex write_mutex_;
+
+    // Flow control and backlog state, guarded by write_mutex_
+    bool flow_controlled_ = false;
+    int64_t credit_ = 0;
+    std::deque<QueuedFrame> outbound_;
+    size_t committed_ = 0;        // leading frames already charged and due on the wire
+    size_t front_written_ = 0;    // bytes of outbound_.front() already written
+    bool writing_ = false;        // a thread is writing with the mutex released
+    bool stalled_ = false;        // waiting for IoBackend::wait_writable
+    bool failed_ = false;
+    size_t max_queued_frames_;
+    uint64_t dropped_frames_ = 0;
+    uint64_t coalesced_frames_ = 0;
+
+    std::atomic<std::chrono::steady_clock::rep> last_inbound_;
+    std::atomic<std::chrono::steady_clock::rep> write_blocked_since_{0};
+    std::atomic<bool> reaped_{false};
+
+    mutable std::mutex state_mutex_;
+    std::string current_room_;
+    std::set<std::string> rooms_;
+    bool paged_room_list_ = false;
+};
@@ -0,0 +1,157 @@
+#ifndef CLIENTEVENTS_H
+#define CLIENTEVENTS_H
+
+#include "UICommand.h"
+#include "RoomInfo.h"
+#include <nlohmann/json.hpp>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+/**
+ * ServerEvent - One server frame, decoded on the network thread
+ *
+ * NetworkManager turns each newline-terminated frame into a ServerEvent
+ * before queueing it, so ApplicationManager never touches JSON. Frames the
+ * client does not act on decode to UNHANDLED; they still count as
+ * consumed for flow control.
+ */
+
+enum class ServerEventType {
+    UNHANDLED,
+    DISCONNECTED,       // socket closed or failed (pushed by NetworkManager)
+    SERVER_ERROR,       // ERROR (ErrorData)
+    ROOM_JOINED,        // room name (std::string)
+    LEFT_ROOM,
+    ROOM_LIST,          // RoomListData
+    ROOM_PAGE,          // RoomPageReply
+    ROOMS_CHANGED,
+    CHAT_LINES,         // MESSAGE or MESSAGE_BATCH (ChatLinesData)
+    HISTORY_RESULTS,    // HistoryResultsData
+    PARTICIPANT_LIST,   // ParticipantsData
+    PING                // server heartbeat; answered with PONG
+};
+
+struct RoomPageReply {
+    std::vector<RoomInfo> rooms;
+    std::string prefix;
+    std::string sort;
+    std::string cursor;         // the cursor this page answers ("" = first page)
+    std::string next_cursor;    // "" once the last page is loaded
+    size_t total = 0;
+};
+
+struct ChatLine {
+    std::string sender;
+    std::string message;
+    nlohmann::json trace;       // null unless the line is traced (and well formed)
+};
+
+struct ChatLinesData {
+    std::vector<ChatLine> lines;
+};
+
+struct HistoryLine {
+    uint64_t seq = 0;
+    std::string sender;
+    std::string message;
+};
+
+struct HistoryResultsData {
+    std::string query;
+    std::vector<HistoryLine> hits;
+};
+
+struct ServerEvent {
+    ServerEventType type;
+
+    std::variant<
+        std::monostate,
+        ErrorData,
+        RoomListData,
+        RoomPageReply,
+        ChatLinesData,
+        HistoryResultsData,
+        ParticipantsData,
+        std::string
+    > data;
+
+    ServerEvent(ServerEventType t = ServerEventType::UNHANDLED) : type(t), data(std::monostate{}) {}
+
+    template<typename T>
+    ServerEvent(ServerEventType t, T&& d) : type(t), data(std::forward<T>(d)) {}
+
+    template<typename T>
+    const T& get() const {
+        return std::get<T>(data);
+    }
+
+    // Mutable access so payloads can be moved out
+    template<typename T>
+    T& get() {
+        return std::get<T>(data);
+    }
+
+    // Decode one frame (with or without its '\n'); malformed JSON is UNHANDLED
+    static ServerEvent decode(std::string_view frame);
+};
+
+/**
+ * InputEvent - User actions sent from UI thread to Application thread
+ */
+
+enum class InputEventType {
+    LOGIN,              // LoginData
+    LOGIN_STEP,         // attempt number (uint64_t), posted by the login threads
+    ROOM_SELECTED,      // room name (std::string)
+    CREATE_ROOM,        // room name (std::string)
+    ROOMS_MORE,         // foyer scrolled past the loaded rows
+    ROOM_FILTER,        // prefix (std::string, empty clears it)
+    ROOM_SORT,
+    LEAVE,
+    LOGOUT,
+    QUIT,
+    CHAT_MESSAGE,       // ChatInputData
+    SEARCH_HISTORY      // query (std::string)
+};
+
+struct LoginData {
+    std::string username;
+    std::string password;
+};
+
+struct ChatInputData {
+    std::string text;
+    int64_t input_us = 0;       // when Enter was pressed, if tracing (0 = not recorded)
+};
+
+struct InputEvent {
+    InputEventType type;
+
+    std::variant<
+        std::monostate,
+        LoginData,
+        ChatInputData,
+        std::string,
+        uint64_t
+    > data;
+
+    InputEvent(InputEventType t) : type(t), data(std::monostate{}) {}
+
+    template<typename T>
+    InputEvent(InputEventType t, T&& d) : type(t), data(std::forward<T>(d)) {}
+
+    template<typename T>
+    const T& get() const {
+        return std::get<T>(data);
+    }
+
+    template<typename T>
+    T& get() {
+        return std::get<T>(data);
+    }
+};
+
+#endif // CLIENTEVENTS_H
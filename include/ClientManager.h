@@ -1,53 +1,151 @@
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <set>
 #include <string>
 #include <vector>
 #include <map>
 #include <mutex>
 #include <memory>
 #include <chrono>
+#include <thread>
 #include "ChatRoom.h"
+#include "ClientConnection.h"
+#include "IoBackend.h"
+#include "BatchFlusher.h"
+#include "RoomDirectory.h"
+#include "HistoryIndex.h"
+#include "TrafficCapture.h"
+#include "Heartbeat.h"
+#include "auth/IAuthService.h"
+#include "common/NetworkMessage.h"
 
-struct ClientInfo {
-    int fd;
-    std::string name;
-    std::string ip;
-    std::string current_room;
-    std::string token;
+/**
+ * ClientManagerStripeStats - one lock stripe's share of the server state
+ */
+struct ClientManagerStripeStats {
+    size_t connections = 0;
+    size_t rooms = 0;
+    uint64_t token_cache_hits = 0;
+    uint64_t token_cache_misses = 0;
 };
 
 class ClientManager {
 private:
-    std::vector<ClientInfo> connected_clients_;
-    std::map<std::string, std::shared_ptr<ChatRoom>> chat_rooms_;
-    std::mutex clients_mutex_;
-    std::mutex rooms_mutex_;
-    std::mutex cout_mutex_;
+    /**
+     * Stripe - one lock's slice of the connection, room and token tables
+     *
+     * Connections are striped by fd, rooms by name and cached tokens by
+     * token, so session threads working on different clients and rooms
+     * rarely take the same lock. Session threads never touch more than one
+     * stripe per step; the work that spans stripes (the full room list,
+     * the directory sync, the foyer broadcast) visits them one at a time
+     * and never holds two stripe locks at once.
+     */
+    struct alignas(64) Stripe {
+        std::mutex mutex;
+        std::map<int, std::shared_ptr<ClientConnection>> connections;
+        std::map<std::string, std::shared_ptr<ChatRoom>> chat_rooms;
+        // Token validation cache: token -> last_validated_time
+        std::map<std::string, std::chrono::steady_clock::time_point> token_cache;
+        std::atomic<uint64_t> token_cache_hits{0};
+        std::atomic<uint64_t> token_cache_misses{0};
+        // Rooms created or joined/left since the directory last saw them
+        std::set<std::string> directory_dirty;
+    };
+
+    // Declared first so rooms are destroyed before the flusher they use
+    std::shared_ptr<BatchFlusher> batch_flusher_;
+    std::shared_ptr<tracing::TraceLog> trace_log_;
+    std::vector<std::unique_ptr<Stripe>> stripes_;
+    RoomDirectory room_directory_;  // names and member counts for LIST_ROOMS
+    std::mutex directory_sync_mutex_;  // one sync_directory() at a time
+    std::atomic<bool> directory_dirty_{false};  // some stripe has unsynced changes
+
+    // Foyer notices are coalesced on their own thread, so a join or leave
+    // only marks the room list changed instead of visiting every stripe
+    std::mutex foyer_mutex_;
+    std::condition_variable foyer_cv_;
+    std::atomic<bool> foyer_dirty_{false};
+    bool stopping_ = false;
+    std::thread foyer_thread_;
     
-    // Token validation cache: token -> last_validated_time
-    std::map<std::string, std::chrono::steady_clock::time_point> token_cache_;
-    std::mutex token_cache_mutex_;
     static constexpr int TOKEN_CACHE_SECONDS = 30;
+    // Joins and leaves within this window share one foyer notice
+    static constexpr std::chrono::milliseconds FOYER_NOTIFY_INTERVAL{50};
 
-    std::string auth_host_;
-    int auth_port_;
+    std::shared_ptr<IAuthService> auth_service_;
+    
+    std::shared_ptr<IoBackend> io_backend_;
+    size_t outbound_queue_limit_ = ClientConnection::DEFAULT_MAX_QUEUED_FRAMES;
+    std::shared_ptr<HistoryIndex> history_index_;  // null: chat is not indexed
+    std::shared_ptr<TrafficCapture> capture_;      // null: inbound frames are not recorded
+    std::shared_ptr<Heartbeat> heartbeat_;         // null: idle sessions are kept forever
 
+    Stripe& stripe_for(int client_fd) const { return *stripes_[static_cast<size_t>(client_fd) % stripes_.size()]; }
+    Stripe& stripe_for(const std::string& key) const { return *stripes_[std::hash<std::string>{}(key) % stripes_.size()]; }
+    std::vector<std::string> room_names() const;
     void remove_client(int client_fd);
-    std::string request_client_name(int client_fd, const std::string& client_ip);
     bool validate_token(const std::string& token);
-    void handle_foyer(int client_fd, ClientInfo& client_info);
-    void handle_room_chat(int client_fd, ClientInfo& client_info);
-    void send_room_list(int client_fd);
+    std::shared_ptr<ChatRoom> find_room(const std::string& room_name);
+    // pending: bytes already read past the AUTH frame; capture_id: 0 unless capturing
+    void handle_session(const std::shared_ptr<ClientConnection>& client, std::string pending,
+                        uint64_t capture_id);
+    bool dispatch(const std::shared_ptr<ClientConnection>& client, const NetworkMessage& net_msg);
+    void send_room_list(ClientConnection& client);
+    void send_room_page(ClientConnection& client, const proto::ListRooms& request);
+    void send_search_results(ClientConnection& client, const proto::SearchRooms& request);
+    void send_history_results(ClientConnection& client, const proto::SearchHistory& request);
     void broadcast_room_list_to_foyer();
-    void broadcast_member_list_to_room(const std::string& room_name);
+    // Room list changed: wake the foyer thread (cheap, any thread)
+    void notify_foyer();
+    void foyer_loop();
+    // Record that room_name's entry (or member count) needs refreshing
+    void mark_directory_dirty(const std::string& room_name);
+    // Apply every recorded change to room_directory_ before it is read
+    void sync_directory();
     bool create_room(const std::string& room_name);
-    bool join_room(int client_fd, ClientInfo& client_info, const std::string& room_name);
-    void leave_room(int client_fd, ClientInfo& client_info);
-    std::string get_client_name(int client_fd);
+    bool join_room(const std::shared_ptr<ClientConnection>& client, const std::string& room_name);
+    void leave_room(const std::shared_ptr<ClientConnection>& client);
+    // ack is sent after the history replay and before the member list
+    bool subscribe_room(const std::shared_ptr<ClientConnection>& client, const std::string& room_name,
+                        const std::string& ack);
+    bool unsubscribe_room(const std::shared_ptr<ClientConnection>& client, const std::string& room_name);
+    void send_error(ClientConnection& client, const std::string& message);
 
 public:
-    ClientManager(const std::string& auth_host = "127.0.0.1", int auth_port = 3001);
+    /**
+     * auth_service: where tokens are checked; defaults to an AuthClient
+     * for the standalone auth server on 127.0.0.1:3001
+     * batch_flusher: shared by every room for MESSAGE_BATCH delivery;
+     * null sends each message on its own
+     * trace_log: where traced chat lines are logged after fan-out;
+     * null still forwards traces to clients
+     * lock_stripes: how many independently locked slices the connection,
+     * room and token tables are split into; 0 means one per hardware thread
+     */
+    explicit ClientManager(std::shared_ptr<IAuthService> auth_service = nullptr,
+                           std::shared_ptr<IoBackend> io_backend = nullptr,
+                           std::shared_ptr<BatchFlusher> batch_flusher = nullptr,
+                           std::shared_ptr<tracing::TraceLog> trace_log = nullptr,
+                           size_t lock_stripes = 0);
     ~ClientManager();
 
+    // Broadcast frames held per connection while it is out of credit
+    void set_outbound_queue_limit(size_t frames) { outbound_queue_limit_ = frames; }
+
+    // Index chat messages for SEARCH_HISTORY; set before clients connect
+    void set_history_index(std::shared_ptr<HistoryIndex> index);
+
+    // Record every inbound frame for replay_traffic; set before clients connect
+    void set_traffic_capture(std::shared_ptr<TrafficCapture> capture) { capture_ = std::move(capture); }
+
+    // PING quiet sessions and reap dead ones; set before clients connect
+    void set_heartbeat(std::shared_ptr<Heartbeat> heartbeat) { heartbeat_ = std::move(heartbeat); }
+
+    size_t stripe_count() const { return stripes_.size(); }
+    std::vector<ClientManagerStripeStats> stripe_stats() const;
+
     void handle_client(int client_fd, const std::string& client_ip);
 };
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include "TimerWheel.h"
+
+class ClientConnection;
+
+/**
+ * HeartbeatConfig - when quiet connections are pinged and reaped
+ *
+ * ping_interval: inbound silence before the server sends a PING
+ * idle_timeout:  inbound silence before the session is shut down
+ *                (0 disables the heartbeat)
+ * tick:          timer wheel resolution
+ */
+struct HeartbeatConfig {
+    std::chrono::milliseconds ping_interval{15000};
+    std::chrono::milliseconds idle_timeout{45000};
+    std::chrono::milliseconds tick{100};
+};
+
+/**
+ * HeartbeatStats - totals since start
+ *
+ * pings_sent:         PING frames written
+ * pings_skipped:      PING attempts put off because the socket was busy or full
+ * reaped_connections: sessions shut down after idle_timeout of silence or
+ *                     of a blocked socket, or whose socket had failed
+ */
+struct HeartbeatStats {
+    std::atomic<uint64_t> pings_sent{0};
+    std::atomic<uint64_t> pings_skipped{0};
+    std::atomic<uint64_t> reaped_connections{0};
+};
+
+/**
+ * Heartbeat - keeps authenticated sessions honest
+ *
+ * Every watched connection has one timer on a TimerWheel, due at its next
+ * decision point: the PING time or the idle deadline, both measured from
+ * the last frame it sent. Reads only stamp ClientConnection::touch(), so
+ * the timer is never moved on the hot path; when it fires early because
+ * the client was active, it is simply rescheduled. A connection still
+ * silent at idle_timeout is shut down, which ends its session thread
+ * through the normal disconnect path. So is one whose socket has refused
+ * data for idle_timeout (ClientConnection::write_blocked_since): a client
+ * that keeps sending but never reads must not stay alive on its traffic.
+ *
+ * The session must forget() its connection before closing the fd; after
+ * forget() returns the heartbeat will not touch the socket again.
+ */
+class Heartbeat {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit Heartbeat(const HeartbeatConfig& config);
+    ~Heartbeat();
+
+    Heartbeat(const Heartbeat&) = delete;
+    Heartbeat& operator=(const Heartbeat&) = delete;
+
+    const HeartbeatConfig& config() const { return config_; }
+    const HeartbeatStats& stats() const { return stats_; }
+    size_t watched() const;
+
+    void watch(const std::shared_ptr<ClientConnection>& connection);
+    void forget(int fd);
+
+private:
+    struct Watched {
+        std::weak_ptr<ClientConnection> connection;
+        TimerWheel::TimerId timer = 0;
+        Clock::time_point pinged_for{};   // last_inbound() when the last PING went out
+    };
+
+    void run();
+    uint64_t tick_of(Clock::time_point time) const;
+    void expire_locked(int fd, Clock::time_point now);
+    void schedule_locked(int fd, Watched& watched, Clock::time_point due);
+
+    HeartbeatConfig config_;
+    HeartbeatStats stats_;
+    Clock::time_point start_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    TimerWheel wheel_;
+    std::unordered_map<int, Watched> watched_;
+    bool stopping_ = false;
+    std::thread thread_;
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "HistorySegment.h"
+
+struct HistoryIndexConfig {
+    size_t flush_messages = 4096;  // messages per memtable before it becomes a segment
+    size_t max_segments = 8;       // above this, adjacent segments are merged
+};
+
+struct HistoryHit {
+    uint64_t seq;
+    std::string sender;
+    std::string message;
+    int64_t timestamp_ms;
+    double score;
+};
+
+/**
+ * HistoryIndex - Persistent full-text index over room chat messages
+ *
+ * Every message is appended to messages.log (the only copy of the text)
+ * and indexed in an in-memory table. A full table is frozen and written
+ * by a background thread as an immutable HistorySegment; when there are
+ * more than max_segments, the cheapest run of adjacent segments is merged
+ * into one. MANIFEST (JSON, replaced atomically) lists the live segments
+ * and how much of the log they cover; on open the rest of the log is
+ * replayed into the memtable, so a crash loses at most a torn last record.
+ * The manifest also keeps each room's last seq, so a restarted room can
+ * carry on numbering instead of reusing seqs that are already indexed.
+ *
+ * search() matches every query term (AND), ranks by tf-idf with newer
+ * messages first on ties, and reads only the hits back from the log.
+ */
+class HistoryIndex {
+public:
+    static constexpr size_t DEFAULT_RESULTS = 10;
+    static constexpr size_t MAX_RESULTS = 50;
+    static constexpr size_t MAX_TERM_LENGTH = 64;  // longer tokens are cut
+    static constexpr size_t MERGE_WIDTH = 4;       // segments combined per merge
+
+    explicit HistoryIndex(std::string dir, HistoryIndexConfig config = {});
+    // Waits for segments being written; the memtable is rebuilt from the log next time
+    ~HistoryIndex();
+
+    HistoryIndex(const HistoryIndex&) = delete;
+    HistoryIndex& operator=(const HistoryIndex&) = delete;
+
+    // Create the directory if needed, load the manifest and replay the log
+    bool open();
+
+    bool add(const std::string& room, uint64_t seq, const std::string& sender, const std::string& message);
+
+    // Highest seq indexed for room (0 if none), including before a restart
+    uint64_t last_seq(const std::string& room) const;
+
+    // limit 0 uses DEFAULT_RESULTS; capped at MAX_RESULTS
+    std::vector<HistoryHit> search(const std::string& room, const std::string& query, size_t limit = 0) const;
+
+    // Write the memtable out as a segment and wait for it (and any merge)
+    void flush();
+    // Wait until no segment write or merge is pending
+    void wait_idle();
+
+    size_t segment_count() const;
+    uint64_t message_count() const;
+
+    // Lowercased ASCII letter/digit runs; non-ASCII bytes are kept as part of a term
+    static std::vector<std::string> tokenize(std::string_view text);
+
+private:
+    void run();
+    void freeze_locked();
+    bool merge_once();
+    bool write_manifest();
+    bool replay_log(uint64_t from);
+    void index_locked(const std::string& room, uint64_t doc, uint64_t seq,
+                      const std::string& message, uint64_t log_offset);
+    bool resolve_doc(uint64_t doc, HistoryDoc& out) const;
+    bool read_hit(const HistoryDoc& doc, HistoryHit& hit) const;
+    std::string segment_path(uint64_t generation) const;
+
+    std::string dir_;
+    HistoryIndexConfig config_;
+    int log_fd_ = -1;
+
+    mutable std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable idle_cv_;
+    HistoryMemTable memtable_;
+    std::deque<std::shared_ptr<const HistoryMemTable>> frozen_;  // oldest first
+    std::vector<std::shared_ptr<HistorySegment>> segments_;      // oldest first
+    std::map<std::string, uint64_t> last_seqs_;                  // room -> highest seq seen
+    uint64_t next_doc_ = 1;
+    uint64_t next_generation_ = 1;
+    uint64_t indexed_log_end_ = 0;  // log covered by segments
+    bool busy_ = false;          // writer is between taking work and publishing it
+    bool write_failed_ = false;  // stop writing; unwritten messages stay in the log
+    bool stopping_ = false;
+
+    std::thread writer_;
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * One message's occurrences of a term
+ */
+struct HistoryPosting {
+    uint64_t doc;
+    uint32_t tf;
+};
+
+/**
+ * Where a message lives: its record in the history log and its room seq
+ */
+struct HistoryDoc {
+    uint64_t doc;
+    uint64_t log_offset;
+    uint64_t seq;
+};
+
+/**
+ * HistoryMemTable - Inverted index of messages not yet in a segment
+ *
+ * Keys are "<room>\x1f<term>"; docs and every posting list are in doc
+ * order because documents are only appended.
+ */
+struct HistoryMemTable {
+    std::unordered_map<std::string, std::vector<HistoryPosting>> postings;
+    std::vector<HistoryDoc> docs;
+    uint64_t log_end = 0;   // log offset just past the last message added
+
+    const HistoryDoc* find_doc(uint64_t doc) const;
+};
+
+/**
+ * HistorySegment - Immutable, memory-mapped slice of the history index
+ *
+ * File layout (native byte order, like the session snapshot):
+ *   header      magic, version, doc range, counts, section offsets
+ *   docs        fixed-width HistoryDoc entries, sorted by doc
+ *   keys        term keys back to back, sorted
+ *   postings    per term: varint doc delta, varint tf, ...
+ *   terms       fixed-width entries (key span, postings span, doc freq)
+ *
+ * Lookups binary-search the term table in place; only the postings of
+ * the terms asked for are decoded. Segments cover disjoint, increasing
+ * doc ranges, so merging adjacent segments concatenates posting lists.
+ */
+class HistorySegment {
+public:
+    ~HistorySegment();
+
+    HistorySegment(const HistorySegment&) = delete;
+    HistorySegment& operator=(const HistorySegment&) = delete;
+
+    // nullptr if the file is missing or not a valid segment
+    static std::shared_ptr<HistorySegment> open(const std::string& path);
+
+    /**
+     * Write table (or the merge of adjacent segments, oldest first) to
+     * path: temp file, fsync, rename. False on I/O error.
+     */
+    static bool write(const std::string& path, const HistoryMemTable& table);
+    static bool merge(const std::string& path, const std::vector<std::shared_ptr<HistorySegment>>& inputs);
+
+    // Append the postings for key, in doc order
+    void append_postings(std::string_view key, std::vector<HistoryPosting>& out) const;
+    bool find_doc(uint64_t doc, HistoryDoc& out) const;
+
+    uint64_t first_doc() const { return first_doc_; }
+    uint64_t last_doc() const { return last_doc_; }
+    size_t doc_count() const { return doc_count_; }
+    size_t term_count() const { return term_count_; }
+    const std::string& path() const { return path_; }
+
+private:
+    HistorySegment() = default;
+
+    std::string_view key_at(size_t index) const;
+    void decode_postings(size_t index, std::vector<HistoryPosting>& out) const;
+
+    std::string path_;
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    uint64_t first_doc_ = 0;
+    uint64_t last_doc_ = 0;
+    size_t doc_count_ = 0;
+    size_t term_count_ = 0;
+    uint64_t docs_offset_ = 0;
+    uint64_t keys_offset_ = 0;
+    uint64_t postings_offset_ = 0;
+    uint64_t terms_offset_ = 0;
+};
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <sys/types.h>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "ZeroCopySender.h"
+
+/**
+ * IoStats - counters shared by every IoBackend implementation
+ *
+ * payloads: individual (fd, payload) writes requested
+ * bytes:    payload bytes handed to the kernel
+ * syscalls: kernel entries spent doing so
+ */
+struct IoStats {
+    std::atomic<uint64_t> payloads{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> syscalls{0};
+};
+
+/**
+ * IoBackend - outbound socket I/O used by ChatRoom and ClientManager
+ *
+ * The server still reads from each client on its own thread; the backend
+ * only owns the write side, where room fan-out turns one message into one
+ * write per member.
+ *
+ * Writes never block. A socket that cannot take a whole payload reports how
+ * much it did take; the caller (ClientConnection) keeps the rest and asks
+ * wait_writable() to call it back when the socket drains. One peer that
+ * stops reading therefore cannot hold up a batch for everyone else.
+ *
+ * Backends:
+ * - "io_uring": queues one SEND per recipient and submits the whole batch
+ *               with a single io_uring_enter()
+ * - "posix":    one non-blocking send() per recipient
+ *
+ * Independently of the backend, payloads at or above the zero-copy
+ * threshold are sent with MSG_ZEROCOPY (see ZeroCopySender).
+ */
+class IoBackend {
+public:
+    IoBackend() = default;
+    virtual ~IoBackend();
+
+    IoBackend(const IoBackend&) = delete;
+    IoBackend& operator=(const IoBackend&) = delete;
+
+    virtual const char* name() const = 0;
+
+    /**
+     * Write the same payload to every fd without blocking.
+     * written[i] is what fds[i] accepted: the whole payload, a prefix, 0 if
+     * its buffer is full, or -1 if the socket failed.
+     */
+    virtual void write_batch(const std::vector<int>& fds, std::string_view payload,
+                             std::vector<ssize_t>& written) = 0;
+
+    /**
+     * Write several payloads to one fd, in order, as a single gather write,
+     * starting `skip` bytes in. Returns the bytes accepted, or -1.
+     */
+    ssize_t write_sequence(int fd, const std::vector<std::string_view>& payloads, size_t skip = 0);
+
+    /**
+     * Shared-payload variants: large payloads take the zero-copy path and
+     * stay referenced until the kernel has finished with them.
+     */
+    void write_batch(const std::vector<int>& fds, const SharedPayload& payload,
+                     std::vector<ssize_t>& written);
+    ssize_t write_sequence(int fd, const std::vector<SharedPayload>& payloads, size_t skip = 0);
+
+    /**
+     * Whole-payload helpers: the number of fds (or whether the fd) took all
+     * of it. Whatever did not fit is lost, so these are for callers that do
+     * not keep a backlog.
+     */
+    size_t send_batch(const std::vector<int>& fds, std::string_view payload);
+    size_t send_batch(const std::vector<int>& fds, const SharedPayload& payload);
+    bool send_sequence(int fd, const std::vector<std::string_view>& payloads);
+    bool send_sequence(int fd, const std::vector<SharedPayload>& payloads);
+
+    bool send_to(int fd, std::string_view payload) {
+        return send_batch({fd}, payload) == 1;
+    }
+
+    /**
+     * Call on_writable once, from the backend's poll thread, when fd can
+     * take more data. A later call for the same fd replaces the callback.
+     */
+    void wait_writable(int fd, std::function<void()> on_writable);
+
+    /**
+     * Enable MSG_ZEROCOPY for payloads of at least `bytes` (0 disables)
+     */
+    void set_zerocopy_threshold(size_t bytes);
+    size_t get_zerocopy_threshold() const { return zerocopy_threshold_; }
+
+    /**
+     * Release per-socket state; call before closing a client fd. Once this
+     * returns no wait_writable() callback for fd is running or will run.
+     */
+    void forget(int fd);
+
+    /**
+     * Release buffers whose zero-copy sends the kernel has completed
+     */
+    void reap_completions() { zerocopy_.reap_all(); }
+
+    const IoStats& stats() const { return stats_; }
+    const ZeroCopySender::Stats& zerocopy_stats() const { return zerocopy_.stats(); }
+    size_t zerocopy_pending() const { return zerocopy_.pending(); }
+
+    /**
+     * Create the requested backend ("io_uring" or "posix").
+     * Falls back to "posix" if io_uring is unavailable; the reason is
+     * written to fallback_reason.
+     */
+    static std::shared_ptr<IoBackend> create(const std::string& preferred,
+                                             std::string& fallback_reason);
+
+protected:
+    IoStats stats_;
+
+private:
+    void poll_writable();
+
+    ZeroCopySender zerocopy_;
+    size_t zerocopy_threshold_ = 0;
+
+    // Sockets waiting for POLLOUT; the thread starts on first use
+    std::mutex writable_mutex_;
+    std::unordered_map<int, std::function<void()>> writable_callbacks_;
+    int epoll_fd_ = -1;
+    bool stopping_ = false;
+    std::thread writable_thread_;
+    // Held while callbacks run, so forget() can wait them out
+    std::mutex dispatch_mutex_;
+};
+
+class PosixIoBackend : public IoBackend {
+public:
+    using IoBackend::write_batch;
+    const char* name() const override { return "posix"; }
+    void write_batch(const std::vector<int>& fds, std::string_view payload,
+                     std::vector<ssize_t>& written) override;
+};
+
+class IoUringBackend : public IoBackend {
+public:
+    /**
+     * ring_count rings are created so that concurrent room broadcasts
+     * do not serialize on a single submission queue.
+     */
+    explicit IoUringBackend(unsigned ring_count = 0, unsigned ring_entries = 256);
+    ~IoUringBackend() override;
+
+    IoUringBackend(const IoUringBackend&) = delete;
+    IoUringBackend& operator=(const IoUringBackend&) = delete;
+
+    /**
+     * False if the kernel refused io_uring_setup (old kernel, seccomp, ...)
+     */
+    bool is_available() const { return !rings_.empty(); }
+
+    // errno from the failed ring setup, for is_available() == false
+    int setup_error() const { return setup_errno_; }
+
+    using IoBackend::write_batch;
+    const char* name() const override { return "io_uring"; }
+    void write_batch(const std::vector<int>& fds, std::string_view payload,
+                     std::vector<ssize_t>& written) override;
+
+private:
+    struct Ring;
+
+    Ring& acquire_ring();
+
+    std::vector<std::unique_ptr<Ring>> rings_;
+    std::atomic<unsigned> next_ring_{0};
+    int setup_errno_ = 0;
+};
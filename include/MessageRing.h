@@ -0,0 +1,113 @@
+#ifndef MESSAGERING_H
+#define MESSAGERING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <string>
+#include <vector>
+
+/**
+ * MessageRing - Fixed-capacity chat history with monotonically increasing ids
+ *
+ * The first message gets id 1 and every push takes the next id, also across
+ * clear(). Once full, a push overwrites the oldest message. Reads return a
+ * View over the stored strings (at most two contiguous spans, because the
+ * ring may wrap) rather than a copy.
+ *
+ * Like ApplicationState this is single-threaded; a View is only valid until
+ * the next push or clear.
+ */
+class MessageRing {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 1000;
+
+    class View {
+    public:
+        class iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = std::string;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const std::string*;
+            using reference = const std::string&;
+
+            iterator() = default;
+            iterator(const View* view, size_t index) : view_(view), index_(index) {}
+
+            reference operator*() const { return (*view_)[index_]; }
+            pointer operator->() const { return &(*view_)[index_]; }
+            iterator& operator++() { ++index_; return *this; }
+            iterator operator++(int) { iterator old = *this; ++index_; return old; }
+            bool operator==(const iterator& other) const { return index_ == other.index_; }
+
+        private:
+            const View* view_ = nullptr;
+            size_t index_ = 0;
+        };
+
+        View() = default;
+        View(std::span<const std::string> head, std::span<const std::string> tail, uint64_t first_id)
+            : head_(head), tail_(tail), first_id_(first_id) {}
+
+        size_t size() const { return head_.size() + tail_.size(); }
+        bool empty() const { return size() == 0; }
+
+        // Id of element 0; element i has id first_id() + i
+        uint64_t first_id() const { return first_id_; }
+
+        const std::string& operator[](size_t i) const {
+            return i < head_.size() ? head_[i] : tail_[i - head_.size()];
+        }
+        const std::string& back() const { return (*this)[size() - 1]; }
+
+        iterator begin() const { return iterator(this, 0); }
+        iterator end() const { return iterator(this, size()); }
+
+        // The contiguous pieces, oldest first (tail may be empty)
+        std::span<const std::string> head() const { return head_; }
+        std::span<const std::string> tail() const { return tail_; }
+
+    private:
+        std::span<const std::string> head_;
+        std::span<const std::string> tail_;
+        uint64_t first_id_ = 1;
+    };
+
+    explicit MessageRing(size_t capacity = DEFAULT_CAPACITY);
+
+    // Returns the id given to the message
+    uint64_t push(std::string message);
+    void clear();
+
+    size_t size() const { return size_; }
+    size_t capacity() const { return slots_.size(); }
+    bool empty() const { return size_ == 0; }
+
+    // Id of the oldest message kept, and the id the next push will get
+    uint64_t first_id() const { return next_id_ - size_; }
+    uint64_t next_id() const { return next_id_; }
+
+    View all() const;
+
+    /**
+     * Messages with an id greater than last_seen_id (0 = everything kept).
+     * If last_seen_id is older than first_id() - 1 some messages have been
+     * overwritten and the view starts at first_id().
+     */
+    View since(uint64_t last_seen_id) const;
+
+    // The newest count messages
+    View last(size_t count) const;
+
+private:
+    View slice(size_t offset, size_t count) const;
+
+    std::vector<std::string> slots_;
+    size_t head_ = 0;  // slot of the oldest message
+    size_t size_ = 0;
+    uint64_t next_id_ = 1;
+};
+
+#endif // MESSAGERING_H
@@ -2,35 +2,43 @@
 #define NETWORKMANAGER_H
 
 #include "ThreadSafeQueue.h"
+#include "ClientEvents.h"
 #include <string>
 #include <thread>
 #include <atomic>
 
 /**
- * NetworkManager - Pure TCP I/O layer
+ * NetworkManager - TCP I/O layer
  * 
  * Responsibilities:
  * - TCP socket management (connect/disconnect)
- * - Receive data from socket -> enqueue to inbound queue
+ * - Receive data from socket -> decode each newline-terminated frame into
+ *   a ServerEvent on this thread -> enqueue it
  * - Dequeue from outbound queue -> send to socket
+ * - Stop reading while the inbound queue is full, so a slow consumer
+ *   pushes back on the server through TCP instead of growing the queue
  * 
  * Does NOT:
- * - Parse messages
  * - Handle business logic
- * - Know about events or UI
- * 
- * This is a completely protocol-agnostic transport layer.
+ * - Know about UI
  */
 class NetworkManager {
 private:
     // Queue references (owned by application layer)
-    ThreadSafeQueue<std::string>& inbound_queue_;
+    ThreadSafeQueue<ServerEvent>& inbound_queue_;
     ThreadSafeQueue<std::string>& outbound_queue_;
     
+    // Stop reading once this many events are waiting
+    size_t inbound_limit_;
+    
+    // Bytes of a frame not yet terminated by '\n'
+    std::string partial_frame_;
+    
     // Socket state
     int socket_;
     std::atomic<bool> connected_;
     std::atomic<bool> running_;
+    std::atomic<bool> tracing_{false};
     
     // Network I/O thread
     std::thread network_thread_;
@@ -41,12 +49,15 @@ private:
     void send_data();
 
 public:
+    static constexpr size_t DEFAULT_INBOUND_LIMIT = 512;
+    
     /**
      * Constructor takes references to existing queues
      * Queues must outlive this NetworkManager instance
      */
-    NetworkManager(ThreadSafeQueue<std::string>& inbound,
-                   ThreadSafeQueue<std::string>& outbound);
+    NetworkManager(ThreadSafeQueue<ServerEvent>& inbound,
+                   ThreadSafeQueue<std::string>& outbound,
+                   size_t inbound_limit = DEFAULT_INBOUND_LIMIT);
     
     ~NetworkManager();
     
@@ -67,10 +78,18 @@ public:
     void start();
     
     /**
-     * Stop the network I/O thread and disconnect
+     * Stop the network I/O thread and disconnect. A disconnect asked for
+     * here is not reported as a DISCONNECTED event.
      */
     void stop();
     
+    /**
+     * Latency tracing: traced chat lines get client_recv stamped as they
+     * are decoded, and outbound frames that carry a trace get client_send
+     * stamped just before the write. Untraced frames are untouched.
+     */
+    void set_tracing(bool enabled) { tracing_ = enabled; }
+    
     /**
      * Check if currently connected
      */
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "RoomIndex.h"
+
+enum class RoomSort {
+    NAME,       // A-Z
+    MEMBERS     // most members first, then A-Z
+};
+
+/**
+ * RoomQuery - one page request
+ *
+ * cursor is the next_cursor of the previous page (empty for the first);
+ * it is only meaningful with the same prefix and sort.
+ */
+struct RoomQuery {
+    std::string prefix;
+    RoomSort sort = RoomSort::NAME;
+    std::string cursor;
+    size_t limit = 0;           // 0 = DEFAULT_PAGE_SIZE
+};
+
+struct RoomPage {
+    std::vector<RoomEntry> rooms;
+    std::string next_cursor;    // empty on the last page
+    size_t total = 0;           // rooms matching the prefix
+};
+
+/**
+ * RoomDirectory - Sorted index of rooms and their member counts
+ *
+ * Kept next to ClientManager's room map so the foyer can be served in
+ * pages instead of one frame listing every room. Rooms are indexed by
+ * name (prefix search, A-Z order) and by member count; both orders are
+ * updated in place on create, join and leave.
+ *
+ * Cursors name the last row returned rather than an offset, so a page
+ * continues at the right place even when rooms are added in between.
+ *
+ * search() answers SEARCH_ROOMS from a RoomIndex kept under the same lock.
+ */
+class RoomDirectory {
+public:
+    static constexpr size_t DEFAULT_PAGE_SIZE = 50;
+    static constexpr size_t MAX_PAGE_SIZE = 200;
+    static constexpr size_t DEFAULT_SEARCH_RESULTS = 20;
+    static constexpr size_t MAX_SEARCH_RESULTS = 100;
+
+    // False if the room is already listed
+    bool add(const std::string& name);
+    void set_members(const std::string& name, size_t members);
+
+    size_t size() const;
+    RoomPage query(const RoomQuery& query) const;
+
+    // Case-insensitive top-K by member count; limit 0 = DEFAULT_SEARCH_RESULTS
+    std::vector<RoomEntry> search(std::string_view text, RoomMatch match, size_t limit) const;
+
+    // "name" / "members"; anything else sorts by name
+    static RoomSort parse_sort(std::string_view sort);
+    static const char* sort_name(RoomSort sort);
+    // "substring" / "prefix"; anything else is a prefix search
+    static RoomMatch parse_match(std::string_view match);
+    static const char* match_name(RoomMatch match);
+
+private:
+    using MemberKey = std::pair<size_t, std::string>;
+
+    struct MostMembersFirst {
+        bool operator()(const MemberKey& a, const MemberKey& b) const {
+            if (a.first != b.first) {
+                return a.first > b.first;
+            }
+            return a.second < b.second;
+        }
+    };
+
+    RoomPage query_by_name_locked(const RoomQuery& query, size_t limit) const;
+    RoomPage query_by_members_locked(const RoomQuery& query, size_t limit) const;
+    size_t count_prefix_locked(const std::string& prefix) const;
+
+    mutable std::mutex mutex_;
+    std::map<std::string, size_t> by_name_;
+    std::set<MemberKey, MostMembersFirst> by_members_;
+    RoomIndex index_;
+};
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * RoomEntry - one row of a room listing or search result
+ */
+struct RoomEntry {
+    std::string name;
+    size_t members = 0;
+};
+
+enum class RoomMatch {
+    PREFIX,     // name starts with the query
+    SUBSTRING   // name contains the query
+};
+
+/**
+ * RoomIndex - Case-insensitive room search ranked by member count
+ *
+ * Prefix queries use the folded (lower-case) names in sorted order;
+ * substring queries use a trigram index: each room id is listed under
+ * every three-byte sequence of its folded name. The candidates are the
+ * ids common to the posting lists of the query's INTERSECT_TRIGRAMS
+ * rarest trigrams, and each is checked against the name.
+ *
+ * When a query has more than DENSE_SCAN_LIMIT candidates, or is too
+ * short for trigrams, the rooms are first walked in member order: the
+ * first K matches found there are the answer. That walk gives up after
+ * WALK_VISIT_LIMIT rooms, and only then is every candidate ranked (for
+ * a short substring, every room), so results are always exact and the
+ * full cost is paid only when the matches sit below the largest rooms.
+ *
+ * Rooms are only ever added (the server never deletes rooms), so ids are
+ * dense and posting lists stay sorted by appending. Not thread-safe;
+ * RoomDirectory calls it under its own lock.
+ */
+class RoomIndex {
+public:
+    static constexpr size_t DENSE_SCAN_LIMIT = 2048;
+    static constexpr size_t INTERSECT_TRIGRAMS = 3;
+    static constexpr size_t WALK_VISIT_LIMIT = 8 * DENSE_SCAN_LIMIT;
+
+    RoomIndex();
+    RoomIndex(const RoomIndex&) = delete;
+    RoomIndex& operator=(const RoomIndex&) = delete;
+
+    // False if the name is already indexed
+    bool add(const std::string& name);
+    void set_members(const std::string& name, size_t members);
+    size_t size() const { return rooms_.size(); }
+
+    /**
+     * Up to limit rooms matching text, most members first (then by name).
+     * An empty query returns the largest rooms.
+     */
+    std::vector<RoomEntry> search(std::string_view text, RoomMatch match, size_t limit) const;
+
+    static std::string fold(std::string_view text);
+
+private:
+    struct Room {
+        std::string name;
+        std::string folded;
+        size_t members = 0;
+    };
+
+    using RankKey = std::pair<size_t, uint32_t>;  // (members, id)
+
+    struct RankOrder {
+        const std::vector<Room>* rooms;
+        bool operator()(const RankKey& a, const RankKey& b) const;
+    };
+
+    static uint32_t trigram(const char* bytes);
+
+    bool matches(uint32_t id, const std::string& query, RoomMatch match) const;
+    // First limit matches in member order into results; false if it gave
+    // up after WALK_VISIT_LIMIT rooms with fewer than limit found
+    bool walk_ranked(const std::string& query, RoomMatch match, size_t limit,
+                     std::vector<RoomEntry>& results) const;
+    // Rank a small candidate set and keep the best limit
+    std::vector<RoomEntry> rank(std::vector<uint32_t>& ids, size_t limit) const;
+
+    std::vector<Room> rooms_;
+    std::unordered_map<std::string, uint32_t> ids_;
+    std::set<std::pair<std::string, uint32_t>> by_folded_;
+    std::set<RankKey, RankOrder> by_rank_;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> trigrams_;
+};
@@ -8,12 +8,18 @@ private:
     int server_fd_;
     int port_;
     bool listening_;
+    int keepalive_idle_s_ = 0;
+    int keepalive_interval_s_ = 0;
+    int keepalive_count_ = 0;
 
 public:
     ServerSocket(int port);
     ~ServerSocket();
 
     bool initialize(std::string& error_msg);
+    // TCP keepalive on accepted sockets: probe after idle_s of silence, every
+    // interval_s, giving up after count probes (idle_s 0 = off; 0 elsewhere = OS default)
+    void set_keepalive(int idle_s, int interval_s, int count);
     void accept_connections(std::function<void(int, const std::string&)> on_client_connected);
     void shutdown();
     bool is_listening() const;
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * TimerWheel - hierarchical timing wheel over integer ticks
+ *
+ * LEVELS wheels of SLOTS slots each; level L slot s holds timers whose
+ * expiry differs from the current tick only in digit L (base SLOTS). When
+ * the lower digits of the current tick roll over to zero, the matching
+ * slot one level up is emptied into the levels below. A timer therefore
+ * moves at most LEVELS - 1 times before it fires, and schedule, cancel
+ * and each expiry are O(1). Timers past the top level's reach wait in the
+ * next top-level slot and are placed again when it is emptied.
+ *
+ * Not thread-safe; the owner serialises access.
+ */
+class TimerWheel {
+public:
+    using TimerId = uint64_t;   // 0 is never a valid id
+
+    static constexpr unsigned SLOT_BITS = 6;
+    static constexpr size_t SLOTS = size_t{1} << SLOT_BITS;
+    static constexpr size_t LEVELS = 4;
+
+    explicit TimerWheel(uint64_t start_tick = 0);
+
+    uint64_t now() const { return now_; }
+    size_t size() const { return size_; }
+
+    // Fire payload once the wheel reaches now() + delay (at least one tick ahead)
+    TimerId schedule(uint64_t delay, uint64_t payload);
+
+    // False if the timer already fired or was cancelled
+    bool cancel(TimerId id);
+
+    // Move the wheel forward to tick and append the payload of every timer
+    // that expired on the way, in expiry order. Ticks in the past are a no-op.
+    void advance(uint64_t tick, std::vector<uint64_t>& expired);
+
+private:
+    static constexpr uint32_t NIL = UINT32_MAX;
+
+    struct Node {
+        uint64_t expires = 0;
+        uint64_t payload = 0;
+        uint32_t generation = 0;
+        uint32_t prev = NIL;
+        uint32_t next = NIL;
+        uint32_t slot = NIL;    // index into slots_, NIL while free
+    };
+
+    void place(uint32_t index);
+    void link(uint32_t index, uint32_t slot);
+    void unlink(uint32_t index);
+    void release(uint32_t index);
+    void cascade(size_t level);
+
+    uint64_t now_;
+    size_t size_ = 0;
+    std::vector<Node> nodes_;
+    std::vector<uint32_t> free_;
+    std::array<uint32_t, LEVELS * SLOTS> slots_;
+};
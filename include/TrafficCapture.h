@@ -0,0 +1,74 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "common/NetworkMessage.h"
+
+/**
+ * One line of a capture file
+ *
+ * OPEN carries the username and the AUTH data the client connected with;
+ * FRAME carries one inbound message body; CLOSE marks the disconnect.
+ */
+struct CapturedEvent {
+    enum class Kind { OPEN, FRAME, CLOSE };
+
+    Kind kind = Kind::FRAME;
+    uint64_t time_ns = 0;  // since the capture started
+    uint64_t conn = 0;     // capture-local id, never reused (unlike fds)
+    std::string user;      // OPEN only
+    std::string type;      // FRAME only
+    json data;             // AUTH data (OPEN) or body data (FRAME)
+};
+
+/**
+ * TrafficCapture - Records every inbound chat frame for later replay
+ *
+ * Writes JSON lines: a {"capture":1,...} header, then one object per
+ * event with "t" (steady-clock ns since start) and "conn". Frames are
+ * stored as their body only; tokens are never written, so a capture can
+ * be shared without handing out sessions. Lines are buffered and flushed
+ * at least once a second and on every disconnect.
+ */
+class TrafficCapture {
+public:
+    static constexpr int FORMAT_VERSION = 1;
+
+    explicit TrafficCapture(std::string path);
+    ~TrafficCapture();
+
+    TrafficCapture(const TrafficCapture&) = delete;
+    TrafficCapture& operator=(const TrafficCapture&) = delete;
+
+    // Create (truncate) the file and write the header
+    bool open();
+
+    // Returns the id to pass to frame()/connection_closed()
+    uint64_t connection_opened(const std::string& username, const json& auth_data);
+    void frame(uint64_t conn, const NetworkMessage& message);
+    void connection_closed(uint64_t conn);
+
+    uint64_t frames() const;
+
+    // Read a capture back; false (with error set) on a malformed line
+    static bool load(const std::string& path, std::vector<CapturedEvent>& events, std::string& error);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void write_locked(const json& record, bool flush);
+    uint64_t elapsed_ns() const;
+
+    std::string path_;
+    Clock::time_point start_;
+
+    mutable std::mutex mutex_;
+    FILE* file_ = nullptr;
+    uint64_t next_conn_ = 1;
+    uint64_t frames_ = 0;
+    Clock::time_point last_flush_;
+};
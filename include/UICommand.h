@@ -2,6 +2,7 @@
 #define UICOMMAND_H
 
 #include "RoomInfo.h"
+#include <nlohmann/json.hpp>
 #include <string>
 #include <vector>
 #include <variant>
@@ -11,6 +12,10 @@
  * 
  * UI thread polls the ui_commands queue and updates display accordingly.
  * Commands are simple, serializable, and contain all data needed for rendering.
+ *
+ * ApplicationManager sends chat lines, participant lists and room lists at
+ * most once per UI frame: lines arrive together in ADD_CHAT_MESSAGES and only
+ * the latest list of each kind is sent.
  */
 
 enum class UICommandType {
@@ -21,9 +26,11 @@ enum class UICommandType {
     
     // Foyer updates
     UPDATE_ROOM_LIST,
+    UPDATE_ROOM_PAGE,       // one page of a paged room list (RoomPageData)
     
     // Chatroom updates
     ADD_CHAT_MESSAGE,
+    ADD_CHAT_MESSAGES,      // several lines at once (ChatMessagesData)
     UPDATE_PARTICIPANTS,
     
     // Status/error messages
@@ -44,10 +51,25 @@ struct RoomListData {
     std::vector<RoomInfo> rooms;
 };
 
+// append: rows continue the loaded list; otherwise they replace it.
+// total is the number of rooms matching prefix, loaded or not.
+struct RoomPageData {
+    std::vector<RoomInfo> rooms;
+    size_t total = 0;
+    bool append = false;
+    std::string prefix;
+    std::string sort;
+};
+
 struct ChatMessageData {
     std::string message;
 };
 
+struct ChatMessagesData {
+    std::vector<std::string> messages;
+    std::vector<nlohmann::json> traces;  // traced lines among them, stamped once drawn
+};
+
 struct ParticipantsData {
     std::vector<std::string> participants;
 };
@@ -70,7 +92,9 @@ struct UICommand {
     std::variant<
         std::monostate,          // No data
         RoomListData,
+        RoomPageData,
         ChatMessageData,
+        ChatMessagesData,
         ParticipantsData,
         ErrorData,
         StatusData,
@@ -3,7 +3,10 @@
 
 #include "ThreadSafeQueue.h"
 #include "UICommand.h"
+#include "ClientEvents.h"
 #include "RoomInfo.h"
+#include "MessageRing.h"
+#include "common/Trace.h"
 #include <ui/Window.h>
 #include <ui/TextInput.h>
 #include <ui/Menu.h>
@@ -14,6 +17,7 @@
 #include <string>
 #include <vector>
 #include <atomic>
+#include <optional>
 
 /**
  * UIManager - Pure presentation layer
@@ -33,7 +37,7 @@ class UIManager {
 private:
     // Queue references
     ThreadSafeQueue<UICommand>& ui_commands_;
-    ThreadSafeQueue<std::string>& input_events_;
+    ThreadSafeQueue<InputEvent>& input_events_;
     
     // UI state (local to UI thread)
     enum class Screen {
@@ -44,9 +48,20 @@ private:
     Screen current_screen_;
     
     // UI-specific data (copies from commands)
+    // rooms_ holds the loaded rows of the foyer list; room_total_ counts
+    // every matching room, so the menu can scroll past what is loaded
     std::vector<RoomInfo> rooms_;
-    std::vector<std::string> chat_messages_;
+    std::vector<ui::MenuItem> room_items_;
+    size_t room_total_ = 0;
+    size_t more_rooms_requested_at_ = SIZE_MAX;  // rooms_.size() at the last ROOMS_MORE
+    std::string room_prefix_;
+    std::string room_sort_ = "name";
+    MessageRing chat_messages_;
     std::vector<std::string> participants_;
+    
+    // Traced chat lines applied this frame; stamped "render" once drawn
+    std::shared_ptr<tracing::TraceLog> trace_log_;
+    std::vector<nlohmann::json> drawn_traces_;
     std::string current_room_;
     std::string username_;
     std::string status_message_;
@@ -93,12 +108,18 @@ private:
     void setup_login_ui();
     void setup_foyer_ui();
     void setup_chatroom_ui();
+    void set_room_rows(const std::vector<RoomInfo>& rooms, bool append, size_t total);
+    void update_room_menu_title();
     void show_error_popup(const std::string& message);
     void show_create_room_dialog();
+    void show_room_filter_dialog();
+    // Single-line text prompt; nullopt if cancelled with Esc
+    std::optional<std::string> prompt_dialog(const std::string& title, const std::string& label,
+                                             const std::string& hint, bool allow_empty);
 
 public:
     UIManager(ThreadSafeQueue<UICommand>& ui_commands,
-              ThreadSafeQueue<std::string>& input_events);
+              ThreadSafeQueue<InputEvent>& input_events);
     
     ~UIManager();
     
@@ -112,6 +133,12 @@ public:
      */
     void run();
     
+    /**
+     * Log traced chat lines once they are on screen, and record when Enter
+     * was pressed on each chat line typed; call before run()
+     */
+    void set_trace_log(std::shared_ptr<tracing::TraceLog> log) { trace_log_ = std::move(log); }
+    
     /**
      * Stop the UI (typically called from signal handler)
      */
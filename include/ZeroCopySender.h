@@ -0,0 +1,120 @@
+#pragma once
+
+#include <sys/types.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Immutable payload shared between room history and in-flight sends.
+ * Whoever holds a reference keeps the bytes alive.
+ */
+using SharedPayload = std::shared_ptr<const std::string>;
+
+inline SharedPayload make_payload(std::string data) {
+    return std::make_shared<const std::string>(std::move(data));
+}
+
+/**
+ * ZeroCopySender - MSG_ZEROCOPY transmit path with completion tracking
+ *
+ * With MSG_ZEROCOPY the kernel pins the caller's pages instead of copying
+ * them, so the payload must stay alive until the kernel reports the send
+ * complete on the socket's error queue. Each send keeps a reference to its
+ * SharedPayload(s) until that notification is reaped.
+ *
+ * Sockets that reject SO_ZEROCOPY (e.g. AF_UNIX) are remembered and use a
+ * regular copying send.
+ */
+class ZeroCopySender {
+public:
+    struct Stats {
+        std::atomic<uint64_t> zerocopy_bytes{0};   // sent with MSG_ZEROCOPY
+        std::atomic<uint64_t> copied_bytes{0};     // kernel fell back to copying
+        std::atomic<uint64_t> fallback_bytes{0};   // sent with a normal send()
+        std::atomic<uint64_t> completions{0};      // error-queue notifications reaped
+        std::atomic<uint64_t> syscalls{0};
+    };
+
+    ZeroCopySender() = default;
+    ~ZeroCopySender();
+
+    ZeroCopySender(const ZeroCopySender&) = delete;
+    ZeroCopySender& operator=(const ZeroCopySender&) = delete;
+
+    /**
+     * Send payloads to fd in order as one non-blocking sendmsg(), starting
+     * `skip` bytes in. Returns the bytes accepted (0 if the socket is full),
+     * or -1 if it failed.
+     */
+    ssize_t send(int fd, const std::vector<SharedPayload>& payloads, size_t skip = 0);
+
+    /**
+     * Drain completion notifications for fd and release finished payloads
+     */
+    void reap(int fd);
+
+    /**
+     * reap() every socket that still has sends in flight
+     */
+    void reap_all();
+
+    /**
+     * Drop all state for fd (call before the fd is closed). Sends the
+     * kernel still has pinned keep their payloads: the socket is shut down
+     * and kept open through a dup(), which a reaper thread (started by the
+     * first such forget) closes once their completions arrive.
+     */
+    void forget(int fd);
+
+    /**
+     * Payload groups still pinned by the kernel across all sockets
+     */
+    size_t pending() const;
+
+    const Stats& stats() const { return stats_; }
+
+private:
+    struct InFlight {
+        uint32_t id;
+        std::vector<SharedPayload> payloads;
+        size_t bytes;
+    };
+
+    struct SocketState {
+        std::mutex mutex;
+        bool supported = true;
+        bool enabled = false;
+        uint32_t next_id = 0;              // kernel numbers zerocopy sends from 0
+        std::deque<InFlight> in_flight;
+    };
+
+    std::shared_ptr<SocketState> state_for(int fd);
+    void reap_locked(int fd, SocketState& state);
+    // Close retired sockets whose sends have all completed
+    void reap_retired();
+    void reaper_loop();
+    ssize_t send_copy(int fd, const std::vector<SharedPayload>& payloads, size_t skip);
+
+    mutable std::mutex sockets_mutex_;
+    std::unordered_map<int, std::shared_ptr<SocketState>> sockets_;
+    // Forgotten sockets with sends in flight, keyed by the dup() holding them open
+    std::unordered_map<int, std::shared_ptr<SocketState>> retired_;
+    std::vector<std::shared_ptr<SocketState>> leaked_;  // retired without a dup; never freed
+    std::thread reaper_;
+    std::condition_variable reaper_cv_;
+    bool stopping_ = false;  // guarded by sockets_mutex_
+    std::atomic<size_t> pending_{0};
+    Stats stats_;
+
+    static constexpr size_t MAX_IN_FLIGHT_PER_SOCKET = 256;
+    static constexpr std::chrono::milliseconds RETIRED_REAP_INTERVAL{10};
+};
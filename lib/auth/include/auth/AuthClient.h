@@ -1,54 +1,46 @@
 #pragma once
 
+#include "IAuthService.h"
 #include <string>
 #include <optional>
-#include <vector>
 
-struct AuthResult {
-    bool success;
-    std::string token;
-    std::string display_name;
-    std::string error_message;
-    
-    AuthResult() : success(false) {}
-};
-
-struct UserInfo {
-    std::string username;
-    std::string display_name;
-    std::vector<std::string> roles;
-    
-    UserInfo() = default;
-    UserInfo(const std::string& user, const std::string& display)
-        : username(user), display_name(display) {}
-    UserInfo(const std::string& user, const std::string& display, const std::vector<std::string>& user_roles)
-        : username(user), display_name(display), roles(user_roles) {}
+/**
+ * Where to reach the auth server.
+ * A Unix socket path replaces TCP when set; a shared-memory name adds the
+ * SharedAuthRing fast path for VALIDATE/GETUSER (falls back to the socket).
+ */
+struct AuthEndpoint {
+    std::string host = "127.0.0.1";
+    int port = 3001;
+    std::string unix_socket_path;
+    std::string shm_name;
 };
 
-class AuthClient {
+class AuthClient : public IAuthService {
 public:
     AuthClient(const std::string& host = "localhost", int port = 3001);
-    ~AuthClient() = default;
+    explicit AuthClient(const AuthEndpoint& endpoint);
+    ~AuthClient() override = default;
     
     // Authenticate and get token
-    AuthResult authenticate(const std::string& username, const std::string& password);
+    AuthResult authenticate(const std::string& username, const std::string& password) override;
     
     // Validate a token
-    bool validate_token(const std::string& token);
+    bool validate_token(const std::string& token) override;
     
     // Get user info from token
-    std::optional<UserInfo> get_user_info(const std::string& token);
+    std::optional<UserInfo> get_user_info(const std::string& token) override;
     
     // Register new user
     bool register_user(const std::string& username, const std::string& password, 
-                      const std::string& display_name);
+                      const std::string& display_name) override;
     
     // Revoke token
-    bool revoke_token(const std::string& token);
+    bool revoke_token(const std::string& token) override;
 
 private:
     std::string send_command(const std::string& command);
+    int connect_socket();
     
-    std::string host_;
-    int port_;
+    AuthEndpoint endpoint_;
 };
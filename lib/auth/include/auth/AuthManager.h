@@ -9,6 +9,7 @@
 #include <vector>
 
 class IUserRepository;
+class SessionStore;
 
 struct User {
     std::string username;
@@ -25,7 +26,12 @@ struct User {
 
 class AuthManager {
 public:
-    AuthManager(std::shared_ptr<IUserRepository> user_repository);
+    /**
+     * session_store: optional; when set, sessions are restored from it
+     * here and every issue/revoke is recorded so tokens survive restarts
+     */
+    AuthManager(std::shared_ptr<IUserRepository> user_repository,
+                std::shared_ptr<SessionStore> session_store = nullptr);
     ~AuthManager() = default;
     
     // Authenticate user and return token
@@ -43,6 +49,9 @@ public:
     // Get roles from token
     std::optional<std::vector<std::string>> get_roles(const std::string& token);
     
+    // Get the whole session for a token in one lookup
+    std::optional<AuthToken> get_token(const std::string& token);
+    
     // Revoke token (logout)
     void revoke_token(const std::string& token);
     
@@ -51,12 +60,21 @@ public:
     
     // Clean up expired tokens
     void cleanup_expired_tokens();
+    
+    // Write the session snapshot now (no-op without a session store)
+    void snapshot_sessions();
 
 private:
     std::string generate_token();
     std::string hash_password(const std::string& password);
+    void write_snapshot();
+    
+    // Compact the session log once it holds this many records
+    static constexpr size_t SESSION_LOG_COMPACT_RECORDS = 4096;
     
     std::shared_ptr<IUserRepository> user_repository_;
+    std::shared_ptr<SessionStore> session_store_;
     std::unordered_map<std::string, AuthToken> active_tokens_;  // token -> AuthToken
     mutable std::mutex mutex_;
+    std::mutex snapshot_mutex_;  // one snapshot at a time; taken before mutex_
 };
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "AuthManager.h"
+#include "SharedAuthRing.h"
 #include <string>
 #include <thread>
 #include <atomic>
@@ -8,7 +9,22 @@
 
 class AuthServer {
 public:
-    explicit AuthServer(int port = 3001, const std::string& user_db_path = "users.json");
+    /**
+     * unix_socket_path: also accept requests on this Unix domain socket
+     * shm_name:         also serve VALIDATE/GETUSER over a SharedAuthRing
+     * Either may be empty to disable it.
+     */
+    explicit AuthServer(int port = 3001, const std::string& user_db_path = "users.json",
+                        const std::string& unix_socket_path = "",
+                        const std::string& shm_name = "");
+    
+    /**
+     * Serve an existing AuthManager (e.g. one shared with an
+     * EmbeddedAuthService inside the chat server)
+     */
+    AuthServer(std::shared_ptr<AuthManager> auth_manager, int port,
+               const std::string& unix_socket_path = "",
+               const std::string& shm_name = "");
     ~AuthServer();
     
     // Start the auth server
@@ -22,13 +38,21 @@ public:
 
 private:
     void server_loop();
+    void shm_loop();
+    bool open_unix_socket();
     void handle_client(int client_fd);
     void process_request(int client_fd, const std::string& request);
+    std::string execute_command(const std::string& request);
     
     int port_;
     std::string user_db_path_;
+    std::string unix_socket_path_;
+    std::string shm_name_;
     int server_fd_;
+    int unix_fd_;
     std::atomic<bool> running_;
     std::unique_ptr<std::thread> server_thread_;
-    std::unique_ptr<AuthManager> auth_manager_;
+    std::unique_ptr<std::thread> shm_thread_;
+    std::unique_ptr<SharedAuthRing> shm_ring_;
+    std::shared_ptr<AuthManager> auth_manager_;
 };
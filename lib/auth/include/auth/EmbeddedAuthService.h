@@ -0,0 +1,28 @@
+#pragma once
+
+#include "IAuthService.h"
+#include "AuthManager.h"
+#include <memory>
+
+/**
+ * EmbeddedAuthService - IAuthService backed by an in-process AuthManager
+ * 
+ * Lets the chat server check tokens without a network hop. The same
+ * AuthManager can be shared with an AuthServer so clients still have
+ * somewhere to log in.
+ */
+class EmbeddedAuthService : public IAuthService {
+public:
+    explicit EmbeddedAuthService(std::shared_ptr<AuthManager> auth_manager);
+    ~EmbeddedAuthService() override = default;
+    
+    AuthResult authenticate(const std::string& username, const std::string& password) override;
+    bool validate_token(const std::string& token) override;
+    std::optional<UserInfo> get_user_info(const std::string& token) override;
+    bool register_user(const std::string& username, const std::string& password, 
+                       const std::string& display_name) override;
+    bool revoke_token(const std::string& token) override;
+
+private:
+    std::shared_ptr<AuthManager> auth_manager_;
+};
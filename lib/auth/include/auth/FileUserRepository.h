@@ -1,8 +1,7 @@
 #pragma once
 
-#include "IUserRepository.h"
+#include "SnapshotUserRepository.h"
 #include <string>
-#include <mutex>
 
 /**
  * FileUserRepository - JSON file-based implementation of user repository
@@ -14,27 +13,20 @@
  *     ...
  *   ]
  * }
- * Thread-safe with mutex protection.
  * Loads all users into memory on construction and writes back on modifications.
+ * Lookups read a copy-on-write snapshot and never wait for a file write.
  */
-class FileUserRepository : public IUserRepository {
+class FileUserRepository : public SnapshotUserRepository {
 public:
     FileUserRepository(const std::string& file_path);
     ~FileUserRepository() override = default;
-    
-    std::future<std::optional<User>> find_user(const std::string& username) override;
-    std::future<bool> create_user(const User& user) override;
-    std::future<bool> update_user(const User& user) override;
-    std::future<bool> delete_user(const std::string& username) override;
-    std::future<bool> user_exists(const std::string& username) override;
-    std::future<std::vector<User>> get_all_users() override;
-    std::future<size_t> get_user_count() override;
+
+protected:
+    void on_modified(const UserTable& table) override;
     
 private:
     void load_from_file();
-    void save_to_file();
+    void save_to_file(const UserTable& table);
     
     std::string file_path_;
-    std::unordered_map<std::string, User> users_;
-    mutable std::mutex mutex_;
 };
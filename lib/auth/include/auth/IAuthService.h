@@ -0,0 +1,54 @@
+#pragma once
+
+#include <string>
+#include <optional>
+#include <vector>
+
+struct AuthResult {
+    bool success;
+    std::string token;
+    std::string display_name;
+    std::string error_message;
+    
+    AuthResult() : success(false) {}
+};
+
+struct UserInfo {
+    std::string username;
+    std::string display_name;
+    std::vector<std::string> roles;
+    
+    UserInfo() = default;
+    UserInfo(const std::string& user, const std::string& display)
+        : username(user), display_name(display) {}
+    UserInfo(const std::string& user, const std::string& display, const std::vector<std::string>& user_roles)
+        : username(user), display_name(display), roles(user_roles) {}
+};
+
+/**
+ * IAuthService - Abstract interface for authentication operations
+ * 
+ * Implemented by AuthClient (talks to a separate auth_server) and
+ * EmbeddedAuthService (calls an AuthManager in the same process).
+ * Implementations must be safe to call from multiple threads.
+ */
+class IAuthService {
+public:
+    virtual ~IAuthService() = default;
+    
+    // Authenticate and get token
+    virtual AuthResult authenticate(const std::string& username, const std::string& password) = 0;
+    
+    // Validate a token
+    virtual bool validate_token(const std::string& token) = 0;
+    
+    // Get user info from token
+    virtual std::optional<UserInfo> get_user_info(const std::string& token) = 0;
+    
+    // Register new user
+    virtual bool register_user(const std::string& username, const std::string& password, 
+                               const std::string& display_name) = 0;
+    
+    // Revoke token
+    virtual bool revoke_token(const std::string& token) = 0;
+};
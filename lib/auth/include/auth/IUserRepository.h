@@ -4,6 +4,8 @@
 #include <string>
 #include <optional>
 #include <future>
+#include <memory>
+#include <string_view>
 #include <vector>
 
 /**
@@ -23,6 +25,16 @@ public:
      */
     virtual std::future<std::optional<User>> find_user(const std::string& username) = 0;
     
+    /**
+     * Synchronous lookup for hot paths (login); returns nullptr if not found.
+     * The default goes through find_user(); in-memory implementations
+     * override it to hand out their stored User without copying.
+     */
+    virtual std::shared_ptr<const User> lookup_user(std::string_view username) {
+        auto user = find_user(std::string(username)).get();
+        return user ? std::make_shared<const User>(std::move(*user)) : nullptr;
+    }
+    
     /**
      * Create a new user
      * Returns true if created, false if user already exists
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "AuthToken.h"
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * SessionStore - On-disk copy of AuthManager's active tokens
+ *
+ * Files sharing a base path:
+ *   <path>.snapshot  every live session at the time of the last compaction
+ *   <path>.log.old   the log set aside by rotate_log() for the snapshot
+ *                    being written; removed once that snapshot is in place
+ *   <path>.log       sessions issued/revoked since then, appended per change
+ *
+ * load() maps the snapshot and replays both logs on top of it, oldest
+ * first. Replay is idempotent, so a crash between writing a snapshot and
+ * removing the old log only costs a slightly longer replay. Records are
+ * length-prefixed binary; a torn record at the end of a log is ignored.
+ */
+class SessionStore {
+public:
+    explicit SessionStore(const std::string& path);
+    ~SessionStore();
+
+    SessionStore(const SessionStore&) = delete;
+    SessionStore& operator=(const SessionStore&) = delete;
+
+    /**
+     * Read snapshot + log; returns sessions that have not expired
+     */
+    std::vector<AuthToken> load();
+
+    // Record a newly issued token
+    void append_issue(const AuthToken& token);
+
+    // Record a revoked token
+    void append_revoke(const std::string& token);
+
+    /**
+     * Set the current log aside and start an empty one. Call this at the
+     * moment the sessions for the next write_snapshot() are copied, so
+     * records appended while the snapshot is written stay in the new log.
+     */
+    void rotate_log();
+
+    /**
+     * Replace the snapshot with these sessions and drop the log set aside
+     * by rotate_log(). Written to a temp file, fsync'd and renamed into place.
+     * Does not block appends; callers run one snapshot at a time.
+     */
+    bool write_snapshot(const std::vector<AuthToken>& sessions);
+
+    // Records appended since the last snapshot
+    size_t log_records() const;
+
+private:
+    bool open_log();
+    void append(const std::string& record);
+
+    std::string snapshot_path_;
+    std::string log_path_;
+    std::string old_log_path_;
+    int log_fd_;
+    size_t log_records_;
+    mutable std::mutex mutex_;
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+
+/**
+ * SharedAuthRing - shared-memory request/response slots for token lookups
+ *
+ * When the chat server and auth server run on the same host, VALIDATE and
+ * GETUSER can skip the socket entirely: the client writes the command line
+ * into a free slot, rings a futex doorbell, and waits on the slot's state
+ * futex for the response line. Commands and responses use the same text
+ * format as the socket protocol.
+ *
+ * The auth server creates the segment (create()) and serves it from one
+ * thread (serve_once()). Clients attach() and use call(); a stale server
+ * heartbeat makes call() return nullopt so the caller can use the socket.
+ */
+class SharedAuthRing {
+public:
+    static constexpr uint32_t SLOT_COUNT = 64;
+    static constexpr size_t MAX_COMMAND = 256;
+    static constexpr size_t MAX_RESPONSE = 1024;
+
+    ~SharedAuthRing();
+
+    SharedAuthRing(const SharedAuthRing&) = delete;
+    SharedAuthRing& operator=(const SharedAuthRing&) = delete;
+
+    /**
+     * Create (or recreate) the segment; server side
+     */
+    static std::unique_ptr<SharedAuthRing> create(const std::string& name);
+
+    /**
+     * Map an existing segment; client side.
+     * Mappings are cached per name for the life of the process.
+     */
+    static std::shared_ptr<SharedAuthRing> attach(const std::string& name);
+
+    /**
+     * Send one command and wait for its response line (without newline).
+     * Returns nullopt if the server is not serving or no slot is free,
+     * in which case the caller should fall back to the socket.
+     */
+    std::optional<std::string> call(const std::string& command);
+
+    /**
+     * Serve pending requests; blocks up to max_wait_ms on the doorbell when
+     * idle. Returns the number of requests handled. Server side.
+     */
+    size_t serve_once(const std::function<std::string(const std::string&)>& handler,
+                      int max_wait_ms = 100);
+
+    /**
+     * Wake a serve_once() blocked on the doorbell (used during shutdown)
+     */
+    void wake_server();
+
+    /**
+     * True if the server has refreshed its heartbeat recently
+     */
+    bool server_alive() const;
+
+private:
+    struct Segment;
+
+    SharedAuthRing(const std::string& name, Segment* segment, bool owner);
+
+    std::string name_;
+    Segment* segment_;
+    bool owner_;
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "IUserRepository.h"
+#include "UserTable.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+/**
+ * SnapshotUserRepository - Copy-on-write core shared by the in-process repositories
+ * 
+ * Readers load the current UserTable through an atomic shared_ptr and never
+ * take a lock, so logins are not held up by a registration that is busy
+ * writing the user file. Writers serialize on a mutex, copy the table
+ * (pointers only), apply their change and publish the new table.
+ * 
+ * Subclasses add persistence by overriding on_modified().
+ */
+class SnapshotUserRepository : public IUserRepository {
+public:
+    ~SnapshotUserRepository() override = default;
+    
+    std::shared_ptr<const User> lookup_user(std::string_view username) override;
+    std::future<std::optional<User>> find_user(const std::string& username) override;
+    std::future<bool> create_user(const User& user) override;
+    std::future<bool> update_user(const User& user) override;
+    std::future<bool> delete_user(const std::string& username) override;
+    std::future<bool> user_exists(const std::string& username) override;
+    std::future<std::vector<User>> get_all_users() override;
+    std::future<size_t> get_user_count() override;
+    
+    struct BulkResult {
+        size_t added = 0;
+        size_t replaced = 0;
+        size_t skipped = 0;   // already present and not replaced
+    };
+    
+    /**
+     * Add many users as a single update (one on_modified() call).
+     * Existing usernames are overwritten only if replace_existing.
+     */
+    BulkResult bulk_insert(const std::vector<UserTable::UserPtr>& users, bool replace_existing);
+    
+    // Current table; stays valid and unchanged for as long as it is held
+    std::shared_ptr<const UserTable> snapshot() const;
+
+protected:
+    SnapshotUserRepository();
+    
+    /**
+     * Called with the write mutex held after a change is published
+     */
+    virtual void on_modified(const UserTable& table) { (void)table; }
+    
+    // Replace the whole table without calling on_modified() (initial load)
+    void publish(std::shared_ptr<const UserTable> table);
+
+    std::mutex write_mutex_;
+
+private:
+    template <typename Fn>
+    bool modify(Fn&& change);
+    
+    std::atomic<std::shared_ptr<const UserTable>> table_;
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "SnapshotUserRepository.h"
+#include "UserTable.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Outcome of a bulk import. errors holds the first few problems found,
+ * each prefixed with its line (CSV) or array index (JSON).
+ */
+struct ImportReport {
+    size_t records = 0;      // rows/objects read
+    size_t invalid = 0;      // rejected by validation
+    size_t duplicates = 0;   // repeated within the input (first one wins)
+    size_t imported = 0;     // new users added to the repository
+    size_t replaced = 0;     // existing users overwritten (replace_existing)
+    size_t existing = 0;     // existing users left alone
+    std::vector<std::string> errors;
+
+    static constexpr size_t MAX_ERRORS = 20;
+};
+
+/**
+ * UserImporter - Parallel bulk loader for users.csv / users.json
+ *
+ * The input is memory-mapped and cut into chunks on record boundaries;
+ * each chunk is parsed and validated on its own thread. Usernames are then
+ * de-duplicated and the whole batch goes into the repository as one
+ * copy-on-write update, so a FileUserRepository writes its file once.
+ *
+ * CSV rows: username,password_hash,display_name,roles (roles separated by
+ * ';'; '#' starts a comment line). JSON: {"users": [...]} as written by
+ * FileUserRepository, or a bare array of the same objects.
+ */
+class UserImporter {
+public:
+    // threads == 0 uses the hardware concurrency
+    explicit UserImporter(unsigned threads = 0);
+
+    /**
+     * Parse path (format from extension, else content) and add the users
+     * to repository in one update.
+     */
+    ImportReport import_file(const std::string& path, SnapshotUserRepository& repository,
+                             bool replace_existing = false);
+
+    /**
+     * Parse and validate without touching a repository.
+     * Returns unique users in input order.
+     */
+    std::vector<UserTable::UserPtr> parse_csv(std::string_view data, ImportReport& report);
+    std::vector<UserTable::UserPtr> parse_json(std::string_view data, ImportReport& report);
+
+private:
+    std::vector<UserTable::UserPtr> deduplicate(std::vector<std::vector<UserTable::UserPtr>>& chunks,
+                                                ImportReport& report);
+
+    unsigned threads_;
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "AuthManager.h"
+#include <memory>
+#include <string_view>
+#include <vector>
+
+/**
+ * UserTable - Open-addressing hash table of immutable users
+ *
+ * Linear probing over a flat, power-of-two slot array; each slot holds the
+ * cached hash and a shared_ptr<const User>. Lookups take a string_view and
+ * never allocate. Copying a table copies pointers, not users, which is what
+ * makes copy-on-write updates in SnapshotUserRepository cheap.
+ *
+ * Not synchronized: share it as shared_ptr<const UserTable> and never
+ * modify a table once it is visible to readers.
+ */
+class UserTable {
+public:
+    using UserPtr = std::shared_ptr<const User>;
+
+    explicit UserTable(size_t expected_users = 0);
+
+    // User with this username, or nullptr
+    UserPtr find(std::string_view username) const;
+
+    // Add a user; false if the username is already present
+    bool insert(UserPtr user);
+
+    // Replace an existing user; false if the username is not present
+    bool assign(UserPtr user);
+
+    // Remove a user; false if the username is not present
+    bool erase(std::string_view username);
+
+    // Make room for this many users without rehashing
+    void reserve(size_t expected_users);
+
+    size_t size() const { return size_; }
+
+    template <typename Fn>
+    void for_each(Fn&& fn) const {
+        for (const auto& slot : slots_) {
+            if (slot.user) {
+                fn(slot.user);
+            }
+        }
+    }
+
+private:
+    struct Slot {
+        size_t hash = 0;
+        UserPtr user;
+    };
+
+    // Index of the matching slot, or of the empty slot where it would go
+    size_t probe(std::string_view username, size_t hash) const;
+    void rehash(size_t capacity);
+
+    std::vector<Slot> slots_;
+    size_t size_ = 0;
+};
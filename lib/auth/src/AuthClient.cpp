@@ -1,5 +1,7 @@
 #include "auth/AuthClient.h"
+#include "auth/SharedAuthRing.h"
 #include <sys/socket.h>
+#include <sys/un.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
@@ -7,7 +9,13 @@
 #include <sstream>
 
 AuthClient::AuthClient(const std::string& host, int port)
-    : host_(host), port_(port)
+{
+    endpoint_.host = host;
+    endpoint_.port = port;
+}
+
+AuthClient::AuthClient(const AuthEndpoint& endpoint)
+    : endpoint_(endpoint)
 {
 }
 
@@ -105,11 +113,13 @@ bool AuthClient::revoke_token(const std::string& token) {
     return response.find("REVOKED") == 0;
 }
 
-std::string AuthClient::send_command(const std::string& command) {
+int AuthClient::connect_socket() {
+    bool use_unix = !endpoint_.unix_socket_path.empty();
+    
     // Create socket
-    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    int sock = socket(use_unix ? AF_UNIX : AF_INET, SOCK_STREAM, 0);
     if (sock < 0) {
-        return "";
+        return -1;
     }
     
     // Set socket timeout
@@ -120,13 +130,46 @@ std::string AuthClient::send_command(const std::string& command) {
     setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
     
     // Connect to server
-    struct sockaddr_in server_addr;
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(port_);
-    inet_pton(AF_INET, host_.c_str(), &server_addr.sin_addr);
+    int result;
+    if (use_unix) {
+        struct sockaddr_un server_addr{};
+        server_addr.sun_family = AF_UNIX;
+        std::strncpy(server_addr.sun_path, endpoint_.unix_socket_path.c_str(),
+                     sizeof(server_addr.sun_path) - 1);
+        result = connect(sock, (struct sockaddr*)&server_addr, sizeof(server_addr));
+    } else {
+        struct sockaddr_in server_addr{};
+        server_addr.sin_family = AF_INET;
+        server_addr.sin_port = htons(endpoint_.port);
+        inet_pton(AF_INET, endpoint_.host.c_str(), &server_addr.sin_addr);
+        result = connect(sock, (struct sockaddr*)&server_addr, sizeof(server_addr));
+    }
     
-    if (connect(sock, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+    if (result < 0) {
         close(sock);
+        return -1;
+    }
+    
+    return sock;
+}
+
+std::string AuthClient::send_command(const std::string& command) {
+    // Co-located token lookups go through shared memory when it is being served
+    if (!endpoint_.shm_name.empty() &&
+        (command.rfind("VALIDATE ", 0) == 0 || command.rfind("GETUSER ", 0) == 0)) {
+        if (auto ring = SharedAuthRing::attach(endpoint_.shm_name)) {
+            std::string line = command;
+            if (!line.empty() && line.back() == '\n') {
+                line.pop_back();
+            }
+            if (auto response = ring->call(line)) {
+                return *response;
+            }
+        }
+    }
+    
+    int sock = connect_socket();
+    if (sock < 0) {
         return "";
     }
     
@@ -1,35 +1,62 @@
 #include "auth/AuthManager.h"
 #include "auth/IUserRepository.h"
+#include "auth/SessionStore.h"
 #include <random>
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
 
-AuthManager::AuthManager(std::shared_ptr<IUserRepository> user_repository)
+AuthManager::AuthManager(std::shared_ptr<IUserRepository> user_repository,
+                         std::shared_ptr<SessionStore> session_store)
     : user_repository_(user_repository)
+    , session_store_(std::move(session_store))
 {
+    if (session_store_) {
+        for (auto& token : session_store_->load()) {
+            std::string key = token.token;
+            active_tokens_[key] = std::move(token);
+        }
+        // Fold the replayed log into a fresh snapshot so the next start is a single map
+        write_snapshot();
+    }
 }
 
 AuthToken AuthManager::authenticate(const std::string& username, const std::string& password) {
     // Find user from repository
-    auto user_future = user_repository_->find_user(username);
-    auto user_opt = user_future.get();
+    auto user_ptr = user_repository_->lookup_user(username);
     
-    if (!user_opt) {
+    if (!user_ptr) {
         return AuthToken();  // Invalid token
     }
     
-    auto& user = *user_opt;
+    const User& user = *user_ptr;
     std::string password_hash = hash_password(password);
     if (user.password_hash != password_hash) {
         return AuthToken();  // Invalid token
     }
     
     // Generate new token
-    std::lock_guard<std::mutex> lock(mutex_);
-    std::string token = generate_token();
-    AuthToken auth_token(token, username, user.display_name, user.roles);
-    active_tokens_[token] = auth_token;
+    AuthToken auth_token;
+    bool compact = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::string token = generate_token();
+        auth_token = AuthToken(token, username, user.display_name, user.roles);
+        active_tokens_[token] = auth_token;
+        
+        if (session_store_) {
+            session_store_->append_issue(auth_token);
+            compact = session_store_->log_records() >= SESSION_LOG_COMPACT_RECORDS;
+        }
+    }
+    
+    if (compact) {
+        // Whoever already holds the snapshot lock is compacting this log
+        std::unique_lock<std::mutex> snapshot_lock(snapshot_mutex_, std::try_to_lock);
+        if (snapshot_lock.owns_lock()) {
+            write_snapshot();
+        }
+    }
     
     return auth_token;
 }
@@ -98,9 +125,27 @@ std::optional<std::vector<std::string>> AuthManager::get_roles(const std::string
     return it->second.roles;
 }
 
+std::optional<AuthToken> AuthManager::get_token(const std::string& token) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    auto it = active_tokens_.find(token);
+    if (it == active_tokens_.end()) {
+        return std::nullopt;
+    }
+    
+    if (it->second.is_expired()) {
+        active_tokens_.erase(it);
+        return std::nullopt;
+    }
+    
+    return it->second;
+}
+
 void AuthManager::revoke_token(const std::string& token) {
     std::lock_guard<std::mutex> lock(mutex_);
-    active_tokens_.erase(token);
+    if (active_tokens_.erase(token) > 0 && session_store_) {
+        session_store_->append_revoke(token);
+    }
 }
 
 bool AuthManager::register_user(const std::string& username, const std::string& password, const std::string& display_name) {
@@ -122,6 +167,33 @@ void AuthManager::cleanup_expired_tokens() {
     }
 }
 
+void AuthManager::snapshot_sessions() {
+    std::lock_guard<std::mutex> snapshot_lock(snapshot_mutex_);
+    write_snapshot();
+}
+
+// Caller holds snapshot_mutex_ (or is the constructor). Only the copy runs under mutex_; the
+// write and fsync leave logins and lookups free to proceed.
+void AuthManager::write_snapshot() {
+    if (!session_store_) {
+        return;
+    }
+    
+    std::vector<AuthToken> sessions;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        sessions.reserve(active_tokens_.size());
+        for (const auto& [token, auth_token] : active_tokens_) {
+            if (!auth_token.is_expired()) {
+                sessions.push_back(auth_token);
+            }
+        }
+        // Later issues/revokes land in the new log, after this copy
+        session_store_->rotate_log();
+    }
+    session_store_->write_snapshot(sessions);
+}
+
 std::string AuthManager::generate_token() {
     // Generate a random token (32 hex characters)
     std::random_device rd;
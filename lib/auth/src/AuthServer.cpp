@@ -3,7 +3,9 @@
 #include <iostream>
 #include <cstring>
 #include <sys/socket.h>
+#include <sys/un.h>
 #include <netinet/in.h>
+#include <poll.h>
 #include <unistd.h>
 #include <sstream>
 #include <fcntl.h>
@@ -11,15 +13,31 @@
 #include <chrono>
 #include <thread>
 
-AuthServer::AuthServer(int port, const std::string& user_db_path)
+AuthServer::AuthServer(int port, const std::string& user_db_path,
+                       const std::string& unix_socket_path, const std::string& shm_name)
     : port_(port)
     , user_db_path_(user_db_path)
+    , unix_socket_path_(unix_socket_path)
+    , shm_name_(shm_name)
     , server_fd_(-1)
+    , unix_fd_(-1)
     , running_(false)
 {
     // Create file-based user repository
     auto user_repository = std::make_shared<FileUserRepository>(user_db_path_);
-    auth_manager_ = std::make_unique<AuthManager>(user_repository);
+    auth_manager_ = std::make_shared<AuthManager>(user_repository);
+}
+
+AuthServer::AuthServer(std::shared_ptr<AuthManager> auth_manager, int port,
+                       const std::string& unix_socket_path, const std::string& shm_name)
+    : port_(port)
+    , unix_socket_path_(unix_socket_path)
+    , shm_name_(shm_name)
+    , server_fd_(-1)
+    , unix_fd_(-1)
+    , running_(false)
+    , auth_manager_(std::move(auth_manager))
+{
 }
 
 AuthServer::~AuthServer() {
@@ -69,10 +87,63 @@ void AuthServer::start() {
         fcntl(server_fd_, F_SETFL, flags | O_NONBLOCK);
     }
     
+    if (!unix_socket_path_.empty() && !open_unix_socket()) {
+        std::cerr << "Failed to listen on Unix socket " << unix_socket_path_ << "\n";
+    }
+    
+    if (!shm_name_.empty()) {
+        shm_ring_ = SharedAuthRing::create(shm_name_);
+        if (!shm_ring_) {
+            std::cerr << "Failed to create shared-memory ring " << shm_name_ << "\n";
+        }
+    }
+    
     running_ = true;
     server_thread_ = std::make_unique<std::thread>(&AuthServer::server_loop, this);
+    if (shm_ring_) {
+        shm_thread_ = std::make_unique<std::thread>(&AuthServer::shm_loop, this);
+    }
+    
+    std::cout << "Auth server listening on port " << port_;
+    if (unix_fd_ >= 0) {
+        std::cout << " and " << unix_socket_path_;
+    }
+    if (shm_ring_) {
+        std::cout << " (shared memory " << shm_name_ << ")";
+    }
+    std::cout << "...\n";
+}
+
+bool AuthServer::open_unix_socket() {
+    unix_fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (unix_fd_ < 0) {
+        return false;
+    }
+    
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (unix_socket_path_.size() >= sizeof(address.sun_path)) {
+        close(unix_fd_);
+        unix_fd_ = -1;
+        return false;
+    }
+    std::strncpy(address.sun_path, unix_socket_path_.c_str(), sizeof(address.sun_path) - 1);
     
-    std::cout << "Auth server listening on port " << port_ << "...\n";
+    // Remove a stale socket file from a previous run
+    unlink(unix_socket_path_.c_str());
+    
+    if (bind(unix_fd_, (struct sockaddr*)&address, sizeof(address)) < 0 ||
+        listen(unix_fd_, 10) < 0) {
+        close(unix_fd_);
+        unix_fd_ = -1;
+        return false;
+    }
+    
+    int flags = fcntl(unix_fd_, F_GETFL, 0);
+    if (flags >= 0) {
+        fcntl(unix_fd_, F_SETFL, flags | O_NONBLOCK);
+    }
+    return true;
 }
 
 void AuthServer::stop() {
@@ -82,13 +153,28 @@ void AuthServer::stop() {
     
     running_ = false;
     
+    if (shm_ring_) {
+        shm_ring_->wake_server();
+    }
+    
+    if (server_thread_ && server_thread_->joinable()) {
+        server_thread_->join();
+    }
+    
+    if (shm_thread_ && shm_thread_->joinable()) {
+        shm_thread_->join();
+    }
+    shm_ring_.reset();
+    
     if (server_fd_ >= 0) {
         close(server_fd_);
         server_fd_ = -1;
     }
     
-    if (server_thread_ && server_thread_->joinable()) {
-        server_thread_->join();
+    if (unix_fd_ >= 0) {
+        close(unix_fd_);
+        unix_fd_ = -1;
+        unlink(unix_socket_path_.c_str());
     }
     
     std::cout << "Auth server stopped\n";
@@ -99,24 +185,51 @@ bool AuthServer::is_running() const {
 }
 
 void AuthServer::server_loop() {
+    pollfd listeners[2];
+    nfds_t listener_count = 0;
+    listeners[listener_count++] = {server_fd_, POLLIN, 0};
+    if (unix_fd_ >= 0) {
+        listeners[listener_count++] = {unix_fd_, POLLIN, 0};
+    }
+    
     while (running_) {
-        sockaddr_in client_addr{};
-        socklen_t client_len = sizeof(client_addr);
-        int client_fd = accept(server_fd_, (struct sockaddr*)&client_addr, &client_len);
-        if (client_fd < 0) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        // Wake on either listener; the timeout bounds how long stop() waits
+        int ready = poll(listeners, listener_count, 100);
+        if (ready <= 0) {
+            continue;
+        }
+        
+        for (nfds_t i = 0; i < listener_count; ++i) {
+            if (!(listeners[i].revents & POLLIN)) {
                 continue;
             }
-            if (running_) {
-                std::cerr << "Auth server accept failed\n";
+            
+            int client_fd = accept(listeners[i].fd, nullptr, nullptr);
+            if (client_fd < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK && running_) {
+                    std::cerr << "Auth server accept failed\n";
+                }
+                continue;
             }
-            continue;
+            
+            // Handle client inline; socket will time out if client stays silent
+            handle_client(client_fd);
+            close(client_fd);
         }
-        
-        // Handle client inline; socket will time out if client stays silent
-        handle_client(client_fd);
-        close(client_fd);
+    }
+}
+
+void AuthServer::shm_loop() {
+    auto handler = [this](const std::string& request) {
+        // Only token lookups are served here; everything else needs the socket
+        if (request.rfind("VALIDATE ", 0) != 0 && request.rfind("GETUSER ", 0) != 0) {
+            return std::string("UNKNOWN_COMMAND\n");
+        }
+        return execute_command(request);
+    };
+    
+    while (running_) {
+        shm_ring_->serve_once(handler);
     }
 }
 
@@ -141,6 +254,11 @@ void AuthServer::handle_client(int client_fd) {
 }
 
 void AuthServer::process_request(int client_fd, const std::string& request) {
+    std::string response = execute_command(request);
+    send(client_fd, response.c_str(), response.length(), 0);
+}
+
+std::string AuthServer::execute_command(const std::string& request) {
     std::istringstream iss(request);
     std::string command;
     iss >> command;
@@ -159,7 +277,7 @@ void AuthServer::process_request(int client_fd, const std::string& request) {
             response = "FAILED\n";
         }
         
-        send(client_fd, response.c_str(), response.length(), 0);
+        return response;
         
     } else if (command == "VALIDATE") {
         // VALIDATE token
@@ -169,7 +287,7 @@ void AuthServer::process_request(int client_fd, const std::string& request) {
         bool valid = auth_manager_->validate_token(token);
         std::string response = valid ? "VALID\n" : "INVALID\n";
         
-        send(client_fd, response.c_str(), response.length(), 0);
+        return response;
         
     } else if (command == "GETUSER") {
         // GETUSER token
@@ -192,7 +310,7 @@ void AuthServer::process_request(int client_fd, const std::string& request) {
             response = "NOTFOUND\n";
         }
         
-        send(client_fd, response.c_str(), response.length(), 0);
+        return response;
         
     } else if (command == "REGISTER") {
         // REGISTER username password display_name (rest of line)
@@ -211,7 +329,7 @@ void AuthServer::process_request(int client_fd, const std::string& request) {
         bool success = auth_manager_->register_user(username, password, display_name);
         std::string response = success ? "REGISTERED\n" : "EXISTS\n";
         
-        send(client_fd, response.c_str(), response.length(), 0);
+        return response;
         
     } else if (command == "REVOKE") {
         // REVOKE token
@@ -221,10 +339,9 @@ void AuthServer::process_request(int client_fd, const std::string& request) {
         auth_manager_->revoke_token(token);
         std::string response = "REVOKED\n";
         
-        send(client_fd, response.c_str(), response.length(), 0);
+        return response;
         
     } else {
-        std::string response = "UNKNOWN_COMMAND\n";
-        send(client_fd, response.c_str(), response.length(), 0);
+        return "UNKNOWN_COMMAND\n";
     }
 }
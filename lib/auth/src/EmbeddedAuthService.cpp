@@ -0,0 +1,43 @@
+#include "auth/EmbeddedAuthService.h"
+
+EmbeddedAuthService::EmbeddedAuthService(std::shared_ptr<AuthManager> auth_manager)
+    : auth_manager_(std::move(auth_manager))
+{
+}
+
+AuthResult EmbeddedAuthService::authenticate(const std::string& username, const std::string& password) {
+    AuthResult result;
+    
+    AuthToken token = auth_manager_->authenticate(username, password);
+    if (token.is_valid) {
+        result.success = true;
+        result.token = token.token;
+        result.display_name = token.display_name;
+    } else {
+        result.error_message = "Authentication failed";
+    }
+    
+    return result;
+}
+
+bool EmbeddedAuthService::validate_token(const std::string& token) {
+    return auth_manager_->validate_token(token);
+}
+
+std::optional<UserInfo> EmbeddedAuthService::get_user_info(const std::string& token) {
+    auto session = auth_manager_->get_token(token);
+    if (!session) {
+        return std::nullopt;
+    }
+    return UserInfo(session->username, session->display_name, session->roles);
+}
+
+bool EmbeddedAuthService::register_user(const std::string& username, const std::string& password, 
+                                        const std::string& display_name) {
+    return auth_manager_->register_user(username, password, display_name);
+}
+
+bool EmbeddedAuthService::revoke_token(const std::string& token) {
+    auth_manager_->revoke_token(token);
+    return true;
+}
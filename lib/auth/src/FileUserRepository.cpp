@@ -1,10 +1,44 @@
 #include "auth/FileUserRepository.h"
 #include <nlohmann/json.hpp>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
 #include <fstream>
 #include <iostream>
 
 using json = nlohmann::json;
 
+namespace {
+
+// Quote and escape s the way json::dump() does (UTF-8 passed through)
+void append_json_string(std::string& out, const std::string& s) {
+    static const char* hex = "0123456789abcdef";
+    out += '"';
+    for (unsigned char c : s) {
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    out += "\\u00";
+                    out += hex[c >> 4];
+                    out += hex[c & 0xf];
+                } else {
+                    out += static_cast<char>(c);
+                }
+        }
+    }
+    out += '"';
+}
+
+} // namespace
+
 FileUserRepository::FileUserRepository(const std::string& file_path)
     : file_path_(file_path)
 {
@@ -12,8 +46,7 @@ FileUserRepository::FileUserRepository(const std::string& file_path)
 }
 
 void FileUserRepository::load_from_file() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    users_.clear();
+    std::lock_guard<std::mutex> lock(write_mutex_);
     
     std::ifstream file(file_path_);
     if (!file.is_open()) {
@@ -27,6 +60,7 @@ void FileUserRepository::load_from_file() {
         file >> j;
         
         if (j.contains("users") && j["users"].is_array()) {
+            auto table = std::make_shared<UserTable>(j["users"].size());
             for (const auto& user_json : j["users"]) {
                 User user;
                 user.username = user_json.value("username", "");
@@ -40,9 +74,10 @@ void FileUserRepository::load_from_file() {
                 }
                 
                 if (!user.username.empty()) {
-                    users_[user.username] = user;
+                    table->insert(std::make_shared<const User>(std::move(user)));
                 }
             }
+            publish(table);
         }
     } catch (const json::exception& e) {
         std::cerr << "Error parsing JSON file: " << e.what() << "\n";
@@ -51,134 +86,69 @@ void FileUserRepository::load_from_file() {
     file.close();
 }
 
-void FileUserRepository::save_to_file() {
-    // Note: mutex should already be locked by caller
-    
-    std::ofstream file(file_path_);
-    if (!file.is_open()) {
-        std::cerr << "Error: Could not write to user file: " << file_path_ << "\n";
-        return;
-    }
-    
-    json j;
-    j["users"] = json::array();
-    
-    for (const auto& [username, user] : users_) {
-        json user_json;
-        user_json["username"] = user.username;
-        user_json["password_hash"] = user.password_hash;
-        user_json["display_name"] = user.display_name;
-        user_json["roles"] = user.roles;
-        
-        j["users"].push_back(user_json);
-    }
-    
-    file << j.dump(2);  // Pretty print with 2-space indent
-    file.close();
-}
-
-std::future<std::optional<User>> FileUserRepository::find_user(const std::string& username) {
-    std::promise<std::optional<User>> promise;
-    
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        auto it = users_.find(username);
-        if (it != users_.end()) {
-            promise.set_value(it->second);
-        } else {
-            promise.set_value(std::nullopt);
-        }
-    }
-    
-    return promise.get_future();
+void FileUserRepository::on_modified(const UserTable& table) {
+    save_to_file(table);
 }
 
-std::future<bool> FileUserRepository::create_user(const User& user) {
-    std::promise<bool> promise;
-    
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        if (users_.find(user.username) != users_.end()) {
-            promise.set_value(false);  // User already exists
-        } else {
-            users_[user.username] = user;
-            save_to_file();
-            promise.set_value(true);
-        }
-    }
-    
-    return promise.get_future();
-}
-
-std::future<bool> FileUserRepository::update_user(const User& user) {
-    std::promise<bool> promise;
-    
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        auto it = users_.find(user.username);
-        if (it != users_.end()) {
-            it->second = user;
-            save_to_file();
-            promise.set_value(true);
+void FileUserRepository::save_to_file(const UserTable& table) {
+    // Note: write mutex should already be locked by caller
+    
+    // Stream the same layout json::dump(2) produces (keys sorted) without
+    // building a json tree; bulk imports make this file large
+    std::string out;
+    out.reserve(table.size() * 160 + 32);
+    out += "{\n  \"users\": [";
+    
+    bool first = true;
+    table.for_each([&](const UserTable::UserPtr& user) {
+        out += first ? "\n" : ",\n";
+        first = false;
+        
+        out += "    {\n      \"display_name\": ";
+        append_json_string(out, user->display_name);
+        out += ",\n      \"password_hash\": ";
+        append_json_string(out, user->password_hash);
+        out += ",\n      \"roles\": ";
+        if (user->roles.empty()) {
+            out += "[]";
         } else {
-            promise.set_value(false);  // User not found
-        }
-    }
-    
-    return promise.get_future();
-}
-
-std::future<bool> FileUserRepository::delete_user(const std::string& username) {
-    std::promise<bool> promise;
-    
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        size_t removed = users_.erase(username);
-        if (removed > 0) {
-            save_to_file();
+            out += "[";
+            for (size_t i = 0; i < user->roles.size(); ++i) {
+                out += i == 0 ? "\n        " : ",\n        ";
+                append_json_string(out, user->roles[i]);
+            }
+            out += "\n      ]";
         }
-        promise.set_value(removed > 0);
-    }
-    
-    return promise.get_future();
-}
-
-std::future<bool> FileUserRepository::user_exists(const std::string& username) {
-    std::promise<bool> promise;
-    
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        promise.set_value(users_.find(username) != users_.end());
+        out += ",\n      \"username\": ";
+        append_json_string(out, user->username);
+        out += "\n    }";
+    });
+    
+    out += first ? "]\n}" : "\n  ]\n}";
+    
+    // Write a temp file and rename it over the old one so a crash never
+    // leaves a truncated user database
+    std::string temp_path = file_path_ + ".tmp";
+    int fd = open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::cerr << "Error: Could not write to user file: " << temp_path << "\n";
+        return;
     }
     
-    return promise.get_future();
-}
-
-std::future<std::vector<User>> FileUserRepository::get_all_users() {
-    std::promise<std::vector<User>> promise;
-    
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        std::vector<User> users;
-        users.reserve(users_.size());
-        
-        for (const auto& [username, user] : users_) {
-            users.push_back(user);
+    bool ok = true;
+    for (size_t offset = 0; ok && offset < out.size();) {
+        ssize_t written = write(fd, out.data() + offset, out.size() - offset);
+        if (written < 0 && errno != EINTR) {
+            ok = false;
+        } else if (written > 0) {
+            offset += written;
         }
-        
-        promise.set_value(std::move(users));
     }
+    ok = ok && fsync(fd) == 0;
+    close(fd);
     
-    return promise.get_future();
-}
-
-std::future<size_t> FileUserRepository::get_user_count() {
-    std::promise<size_t> promise;
-    
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        promise.set_value(users_.size());
+    if (!ok || rename(temp_path.c_str(), file_path_.c_str()) != 0) {
+        std::cerr << "Error: Could not write to user file: " << file_path_ << "\n";
+        unlink(temp_path.c_str());
     }
-    
-    return promise.get_future();
 }
@@ -0,0 +1,321 @@
+#include "auth/SessionStore.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+
+namespace {
+
+constexpr char RECORD_ISSUE = 'I';
+constexpr char RECORD_REVOKE = 'R';
+constexpr uint32_t SNAPSHOT_MAGIC = 0x4E534B42;  // "BKSN"
+constexpr uint32_t SNAPSHOT_VERSION = 1;
+
+int64_t to_ms(std::chrono::system_clock::time_point tp) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(tp.time_since_epoch()).count();
+}
+
+std::chrono::system_clock::time_point from_ms(int64_t ms) {
+    return std::chrono::system_clock::time_point(std::chrono::milliseconds(ms));
+}
+
+template <typename T>
+void put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void put_string(std::string& out, const std::string& value) {
+    uint16_t length = static_cast<uint16_t>(std::min<size_t>(value.size(), UINT16_MAX));
+    put(out, length);
+    out.append(value.data(), length);
+}
+
+std::string encode(char type, const std::string& payload) {
+    std::string record;
+    record.reserve(1 + sizeof(uint32_t) + payload.size());
+    record.push_back(type);
+    put(record, static_cast<uint32_t>(payload.size()));
+    record += payload;
+    return record;
+}
+
+std::string encode_issue(const AuthToken& token) {
+    std::string payload;
+    put_string(payload, token.token);
+    put_string(payload, token.username);
+    put_string(payload, token.display_name);
+    put(payload, static_cast<uint16_t>(token.roles.size()));
+    for (const auto& role : token.roles) {
+        put_string(payload, role);
+    }
+    put(payload, to_ms(token.issued_at));
+    put(payload, to_ms(token.expires_at));
+    return encode(RECORD_ISSUE, payload);
+}
+
+// Bounds-checked cursor over a mapped file
+class Reader {
+public:
+    Reader(const char* data, size_t size) : data_(data), size_(size), pos_(0) {}
+
+    template <typename T>
+    bool get(T& value) {
+        if (size_ - pos_ < sizeof(T)) return false;
+        std::memcpy(&value, data_ + pos_, sizeof(T));
+        pos_ += sizeof(T);
+        return true;
+    }
+
+    bool get_string(std::string& value) {
+        uint16_t length;
+        if (!get(length) || size_ - pos_ < length) return false;
+        value.assign(data_ + pos_, length);
+        pos_ += length;
+        return true;
+    }
+
+    bool skip(size_t count) {
+        if (size_ - pos_ < count) return false;
+        pos_ += count;
+        return true;
+    }
+
+    size_t position() const { return pos_; }
+    bool done() const { return pos_ == size_; }
+
+private:
+    const char* data_;
+    size_t size_;
+    size_t pos_;
+};
+
+bool decode_issue(Reader& reader, AuthToken& token) {
+    uint16_t role_count;
+    int64_t issued_ms, expires_ms;
+    if (!reader.get_string(token.token) || !reader.get_string(token.username) ||
+        !reader.get_string(token.display_name) || !reader.get(role_count)) {
+        return false;
+    }
+    token.roles.resize(role_count);
+    for (auto& role : token.roles) {
+        if (!reader.get_string(role)) return false;
+    }
+    if (!reader.get(issued_ms) || !reader.get(expires_ms)) {
+        return false;
+    }
+    token.issued_at = from_ms(issued_ms);
+    token.expires_at = from_ms(expires_ms);
+    token.is_valid = true;
+    return true;
+}
+
+// Apply every complete record in [data, data + size) to sessions
+void replay(const char* data, size_t size, std::unordered_map<std::string, AuthToken>& sessions) {
+    Reader reader(data, size);
+    while (!reader.done()) {
+        char type;
+        uint32_t length;
+        if (!reader.get(type) || !reader.get(length)) {
+            return;  // torn header
+        }
+
+        size_t start = reader.position();
+        Reader payload(data + start, std::min<size_t>(length, size - start));
+        if (!reader.skip(length)) {
+            return;  // torn payload
+        }
+
+        if (type == RECORD_ISSUE) {
+            AuthToken token;
+            if (decode_issue(payload, token)) {
+                std::string key = token.token;
+                sessions[key] = std::move(token);
+            }
+        } else if (type == RECORD_REVOKE) {
+            std::string key;
+            if (payload.get_string(key)) {
+                sessions.erase(key);
+            }
+        }
+    }
+}
+
+// Map a whole file read-only and hand it to fn; missing/empty files are skipped
+template <typename Fn>
+void with_mapped_file(const std::string& path, Fn&& fn) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+
+    struct stat st{};
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            madvise(data, st.st_size, MADV_SEQUENTIAL);
+            fn(static_cast<const char*>(data), static_cast<size_t>(st.st_size));
+            munmap(data, st.st_size);
+        }
+    }
+    close(fd);
+}
+
+bool write_all(int fd, const std::string& data) {
+    size_t offset = 0;
+    while (offset < data.size()) {
+        ssize_t written = write(fd, data.data() + offset, data.size() - offset);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        offset += written;
+    }
+    return true;
+}
+
+} // namespace
+
+SessionStore::SessionStore(const std::string& path)
+    : snapshot_path_(path + ".snapshot")
+    , log_path_(path + ".log")
+    , old_log_path_(path + ".log.old")
+    , log_fd_(-1)
+    , log_records_(0)
+{
+}
+
+SessionStore::~SessionStore() {
+    if (log_fd_ >= 0) {
+        close(log_fd_);
+    }
+}
+
+std::vector<AuthToken> SessionStore::load() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::unordered_map<std::string, AuthToken> sessions;
+
+    with_mapped_file(snapshot_path_, [&](const char* data, size_t size) {
+        Reader header(data, size);
+        uint32_t magic, version;
+        if (!header.get(magic) || !header.get(version) ||
+            magic != SNAPSHOT_MAGIC || version != SNAPSHOT_VERSION) {
+            std::cerr << "Ignoring unrecognised session snapshot: " << snapshot_path_ << "\n";
+            return;
+        }
+        replay(data + header.position(), size - header.position(), sessions);
+    });
+
+    for (const auto* log_path : {&old_log_path_, &log_path_}) {
+        with_mapped_file(*log_path, [&](const char* data, size_t size) {
+            replay(data, size, sessions);
+        });
+    }
+
+    std::vector<AuthToken> live;
+    live.reserve(sessions.size());
+    for (auto& [key, token] : sessions) {
+        if (!token.is_expired()) {
+            live.push_back(std::move(token));
+        }
+    }
+    return live;
+}
+
+bool SessionStore::open_log() {
+    if (log_fd_ < 0) {
+        log_fd_ = open(log_path_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+    }
+    return log_fd_ >= 0;
+}
+
+void SessionStore::append(const std::string& record) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!open_log()) {
+        std::cerr << "Error: Could not open session log: " << log_path_ << "\n";
+        return;
+    }
+    // No fsync: the page cache survives a process restart, which is the case
+    // this protects against; snapshots are fsync'd
+    if (write_all(log_fd_, record)) {
+        ++log_records_;
+    }
+}
+
+void SessionStore::append_issue(const AuthToken& token) {
+    append(encode_issue(token));
+}
+
+void SessionStore::append_revoke(const std::string& token) {
+    std::string payload;
+    put_string(payload, token);
+    append(encode(RECORD_REVOKE, payload));
+}
+
+void SessionStore::rotate_log() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (log_fd_ >= 0) {
+        close(log_fd_);
+        log_fd_ = -1;
+    }
+
+    if (access(old_log_path_.c_str(), F_OK) == 0) {
+        // The last snapshot failed; its old log is still needed, so keep
+        // this log's records after it rather than replacing it
+        int old_fd = open(old_log_path_.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+        bool ok = old_fd >= 0;
+        with_mapped_file(log_path_, [&](const char* data, size_t size) {
+            ok = ok && write_all(old_fd, std::string(data, size));
+        });
+        if (old_fd >= 0) {
+            close(old_fd);
+        }
+        if (!ok) {
+            std::cerr << "Error: Could not set session log aside: " << old_log_path_ << "\n";
+            return;  // keep appending to the current log
+        }
+        unlink(log_path_.c_str());
+    } else if (rename(log_path_.c_str(), old_log_path_.c_str()) != 0 && errno != ENOENT) {
+        std::cerr << "Error: Could not set session log aside: " << log_path_ << "\n";
+        return;
+    }
+
+    log_fd_ = open(log_path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0600);
+    log_records_ = 0;
+}
+
+bool SessionStore::write_snapshot(const std::vector<AuthToken>& sessions) {
+    std::string data;
+    put(data, SNAPSHOT_MAGIC);
+    put(data, SNAPSHOT_VERSION);
+    for (const auto& token : sessions) {
+        data += encode_issue(token);
+    }
+
+    // Only the file work below; appends go on in parallel under mutex_
+    std::string temp_path = snapshot_path_ + ".tmp";
+    int fd = open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        std::cerr << "Error: Could not write session snapshot: " << temp_path << "\n";
+        return false;
+    }
+    bool ok = write_all(fd, data) && fsync(fd) == 0;
+    close(fd);
+    if (!ok || rename(temp_path.c_str(), snapshot_path_.c_str()) != 0) {
+        unlink(temp_path.c_str());
+        return false;
+    }
+
+    // Everything in the old log is now in the snapshot
+    unlink(old_log_path_.c_str());
+    return true;
+}
+
+size_t SessionStore::log_records() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return log_records_;
+}
@@ -0,0 +1,310 @@
+#include "auth/SharedAuthRing.h"
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <new>
+
+namespace {
+
+enum SlotState : uint32_t {
+    FREE = 0,
+    CLAIMED,      // client is writing the command
+    REQUEST,      // waiting for the server
+    PROCESSING,   // server is handling it
+    RESPONSE,     // response ready for the client
+    ABANDONED     // client timed out while the server was processing
+};
+
+constexpr uint32_t SEGMENT_MAGIC = 0x41555452;  // "AUTR"
+constexpr uint32_t SEGMENT_VERSION = 1;
+constexpr int64_t HEARTBEAT_STALE_MS = 1000;
+constexpr int64_t CALL_TIMEOUT_MS = 2000;
+constexpr int64_t REATTACH_INTERVAL_MS = 1000;
+constexpr int CLIENT_SPIN = 4000;
+constexpr int SERVER_SPIN = 2000;
+
+int64_t monotonic_ms() {
+    timespec ts{};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+void futex_wait(std::atomic<uint32_t>* addr, uint32_t expected, int timeout_ms) {
+    timespec ts{};
+    ts.tv_sec = timeout_ms / 1000;
+    ts.tv_nsec = static_cast<long>(timeout_ms % 1000) * 1000000;
+    // Shared (non-private) futex: the word lives in memory mapped by two processes
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAIT, expected, &ts,
+            nullptr, 0);
+}
+
+void futex_wake(std::atomic<uint32_t>* addr, int count) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAKE, count, nullptr,
+            nullptr, 0);
+}
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+} // namespace
+
+struct SharedAuthRing::Segment {
+    struct alignas(64) Slot {
+        std::atomic<uint32_t> state{FREE};
+        std::atomic<uint32_t> client_waiting{0};
+        uint32_t command_len = 0;
+        uint32_t response_len = 0;
+        char command[MAX_COMMAND];
+        char response[MAX_RESPONSE];
+    };
+
+    std::atomic<uint32_t> magic{0};
+    uint32_t version = SEGMENT_VERSION;
+    std::atomic<uint32_t> doorbell{0};
+    std::atomic<uint32_t> server_waiting{0};
+    std::atomic<int64_t> heartbeat_ms{0};
+    std::atomic<uint32_t> next_slot{0};
+    Slot slots[SLOT_COUNT];
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free);
+static_assert(std::atomic<int64_t>::is_always_lock_free);
+
+SharedAuthRing::SharedAuthRing(const std::string& name, Segment* segment, bool owner)
+    : name_(name)
+    , segment_(segment)
+    , owner_(owner)
+{
+}
+
+SharedAuthRing::~SharedAuthRing() {
+    if (segment_) {
+        munmap(segment_, sizeof(Segment));
+    }
+    if (owner_) {
+        shm_unlink(name_.c_str());
+    }
+}
+
+std::unique_ptr<SharedAuthRing> SharedAuthRing::create(const std::string& name) {
+    // Remove a segment left behind by a previous server instance
+    shm_unlink(name.c_str());
+
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    if (ftruncate(fd, sizeof(Segment)) < 0) {
+        close(fd);
+        shm_unlink(name.c_str());
+        return nullptr;
+    }
+
+    void* memory = mmap(nullptr, sizeof(Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        shm_unlink(name.c_str());
+        return nullptr;
+    }
+
+    auto* segment = new (memory) Segment();
+    segment->heartbeat_ms.store(monotonic_ms(), std::memory_order_relaxed);
+    segment->magic.store(SEGMENT_MAGIC, std::memory_order_release);
+
+    return std::unique_ptr<SharedAuthRing>(new SharedAuthRing(name, segment, true));
+}
+
+std::shared_ptr<SharedAuthRing> SharedAuthRing::attach(const std::string& name) {
+    struct CacheEntry {
+        std::shared_ptr<SharedAuthRing> ring;
+        int64_t last_attempt_ms = 0;
+    };
+    static std::mutex cache_mutex;
+    static std::map<std::string, CacheEntry> cache;
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    CacheEntry& entry = cache[name];
+
+    if (entry.ring && entry.ring->server_alive()) {
+        return entry.ring;
+    }
+
+    // Server down or restarted (new segment); retry the open at most once a second
+    int64_t now = monotonic_ms();
+    if (now - entry.last_attempt_ms < REATTACH_INTERVAL_MS) {
+        return entry.ring;
+    }
+    entry.last_attempt_ms = now;
+
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        return entry.ring;
+    }
+
+    struct stat st{};
+    if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(Segment)) {
+        close(fd);
+        return entry.ring;
+    }
+
+    void* memory = mmap(nullptr, sizeof(Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        return entry.ring;
+    }
+
+    auto* segment = static_cast<Segment*>(memory);
+    if (segment->magic.load(std::memory_order_acquire) != SEGMENT_MAGIC ||
+        segment->version != SEGMENT_VERSION) {
+        munmap(memory, sizeof(Segment));
+        return entry.ring;
+    }
+
+    entry.ring = std::shared_ptr<SharedAuthRing>(new SharedAuthRing(name, segment, false));
+    return entry.ring;
+}
+
+bool SharedAuthRing::server_alive() const {
+    int64_t heartbeat = segment_->heartbeat_ms.load(std::memory_order_acquire);
+    return monotonic_ms() - heartbeat < HEARTBEAT_STALE_MS;
+}
+
+std::optional<std::string> SharedAuthRing::call(const std::string& command) {
+    if (command.size() > MAX_COMMAND || !server_alive()) {
+        return std::nullopt;
+    }
+
+    // Claim a free slot, starting from a rotating position
+    Segment::Slot* slot = nullptr;
+    uint32_t start = segment_->next_slot.fetch_add(1, std::memory_order_relaxed);
+    for (uint32_t i = 0; i < SLOT_COUNT; ++i) {
+        Segment::Slot& candidate = segment_->slots[(start + i) % SLOT_COUNT];
+        uint32_t expected = FREE;
+        if (candidate.state.compare_exchange_strong(expected, CLAIMED,
+                                                    std::memory_order_acquire)) {
+            slot = &candidate;
+            break;
+        }
+    }
+    if (!slot) {
+        return std::nullopt;
+    }
+
+    std::memcpy(slot->command, command.data(), command.size());
+    slot->command_len = static_cast<uint32_t>(command.size());
+    slot->client_waiting.store(0, std::memory_order_relaxed);
+    slot->state.store(REQUEST, std::memory_order_seq_cst);
+
+    segment_->doorbell.fetch_add(1, std::memory_order_seq_cst);
+    if (segment_->server_waiting.load(std::memory_order_seq_cst)) {
+        futex_wake(&segment_->doorbell, 1);
+    }
+
+    // Spin briefly (the common co-located case answers in microseconds),
+    // then sleep on the slot's futex
+    int64_t deadline = monotonic_ms() + CALL_TIMEOUT_MS;
+    for (int spins = 0;; ++spins) {
+        uint32_t state = slot->state.load(std::memory_order_acquire);
+
+        if (state == RESPONSE) {
+            std::string response(slot->response, slot->response_len);
+            slot->state.store(FREE, std::memory_order_release);
+            return response;
+        }
+
+        if (spins < CLIENT_SPIN) {
+            cpu_relax();
+            continue;
+        }
+
+        if (monotonic_ms() > deadline) {
+            uint32_t expected = REQUEST;
+            if (slot->state.compare_exchange_strong(expected, FREE)) {
+                return std::nullopt;
+            }
+            expected = PROCESSING;
+            if (slot->state.compare_exchange_strong(expected, ABANDONED)) {
+                return std::nullopt;  // server frees the slot when it finishes
+            }
+            continue;  // response just arrived
+        }
+
+        slot->client_waiting.store(1, std::memory_order_seq_cst);
+        futex_wait(&slot->state, state, 10);
+    }
+}
+
+size_t SharedAuthRing::serve_once(const std::function<std::string(const std::string&)>& handler,
+                                  int max_wait_ms) {
+    auto scan = [this, &handler]() {
+        size_t handled = 0;
+        for (auto& slot : segment_->slots) {
+            uint32_t expected = REQUEST;
+            if (!slot.state.compare_exchange_strong(expected, PROCESSING,
+                                                    std::memory_order_acquire)) {
+                continue;
+            }
+
+            std::string response = handler(std::string(slot.command, slot.command_len));
+            if (!response.empty() && response.back() == '\n') {
+                response.pop_back();
+            }
+            size_t length = std::min(response.size(), MAX_RESPONSE);
+            std::memcpy(slot.response, response.data(), length);
+            slot.response_len = static_cast<uint32_t>(length);
+
+            expected = PROCESSING;
+            if (slot.state.compare_exchange_strong(expected, RESPONSE, std::memory_order_seq_cst)) {
+                if (slot.client_waiting.load(std::memory_order_seq_cst)) {
+                    futex_wake(&slot.state, 1);
+                }
+            } else {
+                slot.state.store(FREE, std::memory_order_release);  // client gave up
+            }
+            ++handled;
+        }
+        return handled;
+    };
+
+    segment_->heartbeat_ms.store(monotonic_ms(), std::memory_order_release);
+
+    size_t handled = scan();
+    if (handled > 0) {
+        return handled;
+    }
+
+    // Poll the doorbell for a moment before paying for a futex sleep
+    uint32_t bell = segment_->doorbell.load(std::memory_order_acquire);
+    for (int spins = 0; spins < SERVER_SPIN; ++spins) {
+        if (segment_->doorbell.load(std::memory_order_acquire) != bell) {
+            return scan();
+        }
+        cpu_relax();
+    }
+
+    segment_->server_waiting.store(1, std::memory_order_seq_cst);
+    handled = scan();
+    if (handled == 0) {
+        futex_wait(&segment_->doorbell, bell, max_wait_ms);
+    }
+    segment_->server_waiting.store(0, std::memory_order_seq_cst);
+
+    return handled + scan();
+}
+
+void SharedAuthRing::wake_server() {
+    segment_->doorbell.fetch_add(1, std::memory_order_seq_cst);
+    futex_wake(&segment_->doorbell, 1);
+}
@@ -0,0 +1,97 @@
+#include "auth/SnapshotUserRepository.h"
+
+namespace {
+
+template <typename T>
+std::future<T> ready(T value) {
+    std::promise<T> promise;
+    promise.set_value(std::move(value));
+    return promise.get_future();
+}
+
+} // namespace
+
+SnapshotUserRepository::SnapshotUserRepository()
+    : table_(std::make_shared<const UserTable>())
+{
+}
+
+std::shared_ptr<const UserTable> SnapshotUserRepository::snapshot() const {
+    return table_.load(std::memory_order_acquire);
+}
+
+void SnapshotUserRepository::publish(std::shared_ptr<const UserTable> table) {
+    table_.store(std::move(table), std::memory_order_release);
+}
+
+template <typename Fn>
+bool SnapshotUserRepository::modify(Fn&& change) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    
+    auto next = std::make_shared<UserTable>(*snapshot());
+    if (!change(*next)) {
+        return false;
+    }
+    
+    publish(next);
+    on_modified(*next);
+    return true;
+}
+
+SnapshotUserRepository::BulkResult SnapshotUserRepository::bulk_insert(
+    const std::vector<UserTable::UserPtr>& users, bool replace_existing) {
+    BulkResult result;
+    modify([&](UserTable& table) {
+        table.reserve(table.size() + users.size());
+        for (const auto& user : users) {
+            if (table.insert(user)) {
+                ++result.added;
+            } else if (replace_existing && table.assign(user)) {
+                ++result.replaced;
+            } else {
+                ++result.skipped;
+            }
+        }
+        return result.added + result.replaced > 0;
+    });
+    return result;
+}
+
+std::shared_ptr<const User> SnapshotUserRepository::lookup_user(std::string_view username) {
+    return snapshot()->find(username);
+}
+
+std::future<std::optional<User>> SnapshotUserRepository::find_user(const std::string& username) {
+    auto user = lookup_user(username);
+    return ready(user ? std::optional<User>(*user) : std::nullopt);
+}
+
+std::future<bool> SnapshotUserRepository::create_user(const User& user) {
+    auto stored = std::make_shared<const User>(user);
+    return ready(modify([&](UserTable& table) { return table.insert(stored); }));
+}
+
+std::future<bool> SnapshotUserRepository::update_user(const User& user) {
+    auto stored = std::make_shared<const User>(user);
+    return ready(modify([&](UserTable& table) { return table.assign(stored); }));
+}
+
+std::future<bool> SnapshotUserRepository::delete_user(const std::string& username) {
+    return ready(modify([&](UserTable& table) { return table.erase(username); }));
+}
+
+std::future<bool> SnapshotUserRepository::user_exists(const std::string& username) {
+    return ready(lookup_user(username) != nullptr);
+}
+
+std::future<std::vector<User>> SnapshotUserRepository::get_all_users() {
+    auto table = snapshot();
+    std::vector<User> users;
+    users.reserve(table->size());
+    table->for_each([&](const UserTable::UserPtr& user) { users.push_back(*user); });
+    return ready(std::move(users));
+}
+
+std::future<size_t> SnapshotUserRepository::get_user_count() {
+    return ready(snapshot()->size());
+}
@@ -0,0 +1,387 @@
+#include "auth/UserImporter.h"
+#include <nlohmann/json.hpp>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <thread>
+
+using json = nlohmann::json;
+
+namespace {
+
+// Inputs smaller than this are parsed on the calling thread
+constexpr size_t MIN_CHUNK_BYTES = 64 * 1024;
+constexpr size_t MAX_USERNAME = 64;
+
+struct ChunkResult {
+    std::vector<UserTable::UserPtr> users;
+    size_t records = 0;
+    size_t invalid = 0;
+    size_t lines = 0;                                   // CSV: lines in this chunk
+    std::vector<std::pair<size_t, std::string>> errors; // (local line/index, message)
+};
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r')) s.remove_suffix(1);
+    return s;
+}
+
+bool has_space(std::string_view s) {
+    return std::any_of(s.begin(), s.end(), [](char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    });
+}
+
+bool valid_username(std::string_view name) {
+    if (name.empty() || name.size() > MAX_USERNAME) {
+        return false;
+    }
+    // The auth text protocol splits on whitespace, so keep names to a safe set
+    return std::all_of(name.begin(), name.end(), [](char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+               c == '_' || c == '.' || c == '-';
+    });
+}
+
+// Normalises user in place; returns an error message, or empty if valid
+std::string validate(User& user) {
+    if (!valid_username(user.username)) {
+        return "invalid username '" + user.username + "'";
+    }
+    if (user.password_hash.empty() || has_space(user.password_hash)) {
+        return "missing or malformed password hash for '" + user.username + "'";
+    }
+    if (user.display_name.find_first_of("\r\n") != std::string::npos) {
+        return "display name for '" + user.username + "' contains a line break";
+    }
+    if (user.display_name.empty()) {
+        user.display_name = user.username;
+    }
+    user.roles.erase(std::remove(user.roles.begin(), user.roles.end(), std::string()),
+                     user.roles.end());
+    for (const auto& role : user.roles) {
+        if (has_space(role)) {
+            return "malformed role '" + role + "' for '" + user.username + "'";
+        }
+    }
+    return "";
+}
+
+void accept(ChunkResult& result, User&& user, size_t position) {
+    std::string error = validate(user);
+    if (error.empty()) {
+        result.users.push_back(std::make_shared<const User>(std::move(user)));
+        return;
+    }
+    ++result.invalid;
+    if (result.errors.size() < ImportReport::MAX_ERRORS) {
+        result.errors.emplace_back(position, std::move(error));
+    }
+}
+
+void parse_csv_chunk(std::string_view chunk, ChunkResult& result) {
+    while (!chunk.empty()) {
+        size_t end = chunk.find('\n');
+        std::string_view line = chunk.substr(0, end);
+        chunk.remove_prefix(end == std::string_view::npos ? chunk.size() : end + 1);
+        ++result.lines;
+
+        line = trim(line);
+        if (line.empty() || line.front() == '#') {
+            continue;
+        }
+        ++result.records;
+
+        std::vector<std::string_view> fields;
+        size_t start = 0;
+        for (size_t comma; (comma = line.find(',', start)) != std::string_view::npos; start = comma + 1) {
+            fields.push_back(trim(line.substr(start, comma - start)));
+        }
+        fields.push_back(trim(line.substr(start)));
+
+        if (fields.size() < 3) {
+            ++result.invalid;
+            if (result.errors.size() < ImportReport::MAX_ERRORS) {
+                result.errors.emplace_back(result.lines, "expected username,password_hash,display_name,roles");
+            }
+            continue;
+        }
+
+        User user;
+        user.username = fields[0];
+        user.password_hash = fields[1];
+        // Unquoted CSV: extra commas belong to the display name
+        size_t display_end = fields.size() >= 4 ? fields.size() - 1 : fields.size();
+        for (size_t i = 2; i < display_end; ++i) {
+            if (i > 2) user.display_name += ", ";
+            user.display_name += fields[i];
+        }
+        if (fields.size() >= 4) {
+            std::string_view roles = fields.back();
+            size_t role_start = 0;
+            for (size_t semi; (semi = roles.find(';', role_start)) != std::string_view::npos; role_start = semi + 1) {
+                user.roles.emplace_back(trim(roles.substr(role_start, semi - role_start)));
+            }
+            user.roles.emplace_back(trim(roles.substr(role_start)));
+        }
+
+        accept(result, std::move(user), result.lines);
+    }
+}
+
+void parse_json_objects(std::string_view data, const std::vector<std::pair<size_t, size_t>>& spans,
+                        size_t first, size_t last, ChunkResult& result) {
+    for (size_t i = first; i < last; ++i) {
+        ++result.records;
+        User user;
+        try {
+            auto object = json::parse(data.begin() + spans[i].first, data.begin() + spans[i].second);
+            user.username = object.value("username", "");
+            user.password_hash = object.value("password_hash", "");
+            user.display_name = object.value("display_name", "");
+            if (object.contains("roles") && object["roles"].is_array()) {
+                for (const auto& role : object["roles"]) {
+                    user.roles.push_back(role.get<std::string>());
+                }
+            }
+        } catch (const json::exception& e) {
+            ++result.invalid;
+            if (result.errors.size() < ImportReport::MAX_ERRORS) {
+                result.errors.emplace_back(i, e.what());
+            }
+            continue;
+        }
+        accept(result, std::move(user), i);
+    }
+}
+
+/**
+ * Byte ranges of the user objects: elements of a top-level array, or of
+ * the array under the top-level object. A quote/escape-aware brace scan;
+ * the objects themselves are parsed later, in parallel.
+ */
+std::vector<std::pair<size_t, size_t>> find_user_objects(std::string_view data) {
+    std::vector<std::pair<size_t, size_t>> spans;
+    size_t first = data.find_first_not_of(" \t\r\n");
+    if (first == std::string_view::npos) {
+        return spans;
+    }
+    int element_depth = data[first] == '[' ? 1 : 2;
+
+    int depth = 0;
+    size_t object_start = 0;
+    bool in_string = false;
+    for (size_t i = first; i < data.size(); ++i) {
+        char c = data[i];
+        if (in_string) {
+            if (c == '\\') {
+                ++i;
+            } else if (c == '"') {
+                in_string = false;
+            }
+            continue;
+        }
+        switch (c) {
+            case '"':
+                in_string = true;
+                break;
+            case '{':
+                if (depth == element_depth) object_start = i;
+                ++depth;
+                break;
+            case '[':
+                ++depth;
+                break;
+            case '}':
+                --depth;
+                if (depth == element_depth) spans.emplace_back(object_start, i + 1);
+                break;
+            case ']':
+                --depth;
+                break;
+            default:
+                break;
+        }
+    }
+    return spans;
+}
+
+// Run fn(chunk_index) for each chunk, one thread per chunk beyond the first
+template <typename Fn>
+void run_chunks(size_t count, Fn&& fn) {
+    std::vector<std::thread> workers;
+    workers.reserve(count > 0 ? count - 1 : 0);
+    for (size_t i = 1; i < count; ++i) {
+        workers.emplace_back(fn, i);
+    }
+    if (count > 0) {
+        fn(0);
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat st{};
+        if (fstat(fd, &st) == 0) {
+            opened_ = true;
+            if (st.st_size > 0) {
+                void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (data != MAP_FAILED) {
+                    madvise(data, st.st_size, MADV_SEQUENTIAL);
+                    data_ = static_cast<const char*>(data);
+                    size_ = st.st_size;
+                } else {
+                    opened_ = false;
+                }
+            }
+        }
+        close(fd);
+    }
+
+    ~MappedFile() {
+        if (data_) {
+            munmap(const_cast<char*>(data_), size_);
+        }
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool is_open() const { return opened_; }
+    std::string_view view() const { return {data_, size_}; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool opened_ = false;
+};
+
+bool ends_with(const std::string& s, const std::string& suffix) {
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+} // namespace
+
+UserImporter::UserImporter(unsigned threads)
+    : threads_(threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency()))
+{
+}
+
+std::vector<UserTable::UserPtr> UserImporter::parse_csv(std::string_view data, ImportReport& report) {
+    size_t chunk_count = std::clamp<size_t>(data.size() / MIN_CHUNK_BYTES, 1, threads_);
+
+    // Cut on line boundaries
+    std::vector<std::string_view> chunks;
+    size_t start = 0;
+    for (size_t i = 1; i <= chunk_count && start < data.size(); ++i) {
+        size_t end = i == chunk_count ? data.size() : data.size() * i / chunk_count;
+        end = std::max(end, start);
+        size_t newline = data.find('\n', end);
+        end = (i == chunk_count || newline == std::string_view::npos) ? data.size() : newline + 1;
+        chunks.push_back(data.substr(start, end - start));
+        start = end;
+    }
+
+    std::vector<ChunkResult> results(chunks.size());
+    run_chunks(chunks.size(), [&](size_t i) { parse_csv_chunk(chunks[i], results[i]); });
+
+    std::vector<std::vector<UserTable::UserPtr>> users;
+    size_t line_offset = 0;
+    for (auto& result : results) {
+        report.records += result.records;
+        report.invalid += result.invalid;
+        for (auto& [line, message] : result.errors) {
+            if (report.errors.size() < ImportReport::MAX_ERRORS) {
+                report.errors.push_back("line " + std::to_string(line_offset + line) + ": " + message);
+            }
+        }
+        line_offset += result.lines;
+        users.push_back(std::move(result.users));
+    }
+    return deduplicate(users, report);
+}
+
+std::vector<UserTable::UserPtr> UserImporter::parse_json(std::string_view data, ImportReport& report) {
+    auto spans = find_user_objects(data);
+    size_t chunk_count = std::clamp<size_t>(data.size() / MIN_CHUNK_BYTES, 1, threads_);
+    chunk_count = std::min(chunk_count, std::max<size_t>(spans.size(), 1));
+
+    std::vector<ChunkResult> results(chunk_count);
+    run_chunks(chunk_count, [&](size_t i) {
+        size_t first = spans.size() * i / chunk_count;
+        size_t last = spans.size() * (i + 1) / chunk_count;
+        parse_json_objects(data, spans, first, last, results[i]);
+    });
+
+    std::vector<std::vector<UserTable::UserPtr>> users;
+    for (auto& result : results) {
+        report.records += result.records;
+        report.invalid += result.invalid;
+        for (auto& [index, message] : result.errors) {
+            if (report.errors.size() < ImportReport::MAX_ERRORS) {
+                report.errors.push_back("user #" + std::to_string(index) + ": " + message);
+            }
+        }
+        users.push_back(std::move(result.users));
+    }
+    return deduplicate(users, report);
+}
+
+std::vector<UserTable::UserPtr> UserImporter::deduplicate(
+    std::vector<std::vector<UserTable::UserPtr>>& chunks, ImportReport& report) {
+    size_t total = 0;
+    for (const auto& chunk : chunks) {
+        total += chunk.size();
+    }
+
+    UserTable seen(total);
+    std::vector<UserTable::UserPtr> unique;
+    unique.reserve(total);
+    for (auto& chunk : chunks) {
+        for (auto& user : chunk) {
+            if (seen.insert(user)) {
+                unique.push_back(std::move(user));
+            } else {
+                ++report.duplicates;
+            }
+        }
+    }
+    return unique;
+}
+
+ImportReport UserImporter::import_file(const std::string& path, SnapshotUserRepository& repository,
+                                       bool replace_existing) {
+    ImportReport report;
+
+    MappedFile file(path);
+    if (!file.is_open()) {
+        report.errors.push_back("could not open " + path);
+        return report;
+    }
+
+    std::string_view data = file.view();
+    bool is_json = ends_with(path, ".json");
+    if (!is_json && !ends_with(path, ".csv")) {
+        size_t first = data.find_first_not_of(" \t\r\n");
+        is_json = first != std::string_view::npos && (data[first] == '{' || data[first] == '[');
+    }
+
+    auto users = is_json ? parse_json(data, report) : parse_csv(data, report);
+
+    auto result = repository.bulk_insert(users, replace_existing);
+    report.imported = result.added;
+    report.replaced = result.replaced;
+    report.existing = result.skipped;
+    return report;
+}
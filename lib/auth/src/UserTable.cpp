@@ -0,0 +1,129 @@
+#include "auth/UserTable.h"
+#include <functional>
+
+namespace {
+
+constexpr size_t MIN_CAPACITY = 16;
+
+// Keep probes short: grow once the table is 70% full
+bool over_load(size_t size, size_t capacity) {
+    return size * 10 > capacity * 7;
+}
+
+size_t capacity_for(size_t expected_users) {
+    size_t capacity = MIN_CAPACITY;
+    while (over_load(expected_users, capacity)) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+size_t hash_of(std::string_view username) {
+    return std::hash<std::string_view>{}(username);
+}
+
+} // namespace
+
+UserTable::UserTable(size_t expected_users) {
+    if (expected_users > 0) {
+        slots_.resize(capacity_for(expected_users));
+    }
+}
+
+size_t UserTable::probe(std::string_view username, size_t hash) const {
+    size_t mask = slots_.size() - 1;
+    size_t index = hash & mask;
+    while (slots_[index].user) {
+        if (slots_[index].hash == hash && slots_[index].user->username == username) {
+            return index;
+        }
+        index = (index + 1) & mask;
+    }
+    return index;
+}
+
+UserTable::UserPtr UserTable::find(std::string_view username) const {
+    if (size_ == 0) {
+        return nullptr;
+    }
+    return slots_[probe(username, hash_of(username))].user;
+}
+
+bool UserTable::insert(UserPtr user) {
+    if (slots_.empty() || over_load(size_ + 1, slots_.size())) {
+        rehash(capacity_for(size_ + 1));
+    }
+
+    size_t hash = hash_of(user->username);
+    size_t index = probe(user->username, hash);
+    if (slots_[index].user) {
+        return false;
+    }
+
+    slots_[index] = Slot{hash, std::move(user)};
+    ++size_;
+    return true;
+}
+
+bool UserTable::assign(UserPtr user) {
+    if (size_ == 0) {
+        return false;
+    }
+
+    size_t index = probe(user->username, hash_of(user->username));
+    if (!slots_[index].user) {
+        return false;
+    }
+
+    slots_[index].user = std::move(user);
+    return true;
+}
+
+bool UserTable::erase(std::string_view username) {
+    if (size_ == 0) {
+        return false;
+    }
+
+    size_t mask = slots_.size() - 1;
+    size_t hole = probe(username, hash_of(username));
+    if (!slots_[hole].user) {
+        return false;
+    }
+    slots_[hole] = Slot{};
+    --size_;
+
+    // Backward-shift deletion: pull later entries of the cluster into the
+    // hole when that moves them closer to their home slot (no tombstones)
+    for (size_t next = (hole + 1) & mask; slots_[next].user; next = (next + 1) & mask) {
+        size_t home = slots_[next].hash & mask;
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            slots_[hole] = std::move(slots_[next]);
+            slots_[next] = Slot{};
+            hole = next;
+        }
+    }
+    return true;
+}
+
+void UserTable::reserve(size_t expected_users) {
+    if (over_load(expected_users, slots_.size())) {
+        rehash(capacity_for(expected_users));
+    }
+}
+
+void UserTable::rehash(size_t capacity) {
+    std::vector<Slot> old_slots(capacity);
+    old_slots.swap(slots_);
+
+    size_t mask = capacity - 1;
+    for (auto& slot : old_slots) {
+        if (!slot.user) {
+            continue;
+        }
+        size_t index = slot.hash & mask;
+        while (slots_[index].user) {
+            index = (index + 1) & mask;
+        }
+        slots_[index] = std::move(slot);
+    }
+}
@@ -0,0 +1,279 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/**
+ * FrameWriter - Writes NetworkMessage frames straight into a string
+ *
+ * NetworkMessage::serialize() builds a json document per frame and dumps
+ * it. For the frames sent on hot paths the shape is fixed, so these
+ * writers append the bytes directly:
+ *
+ *   frame::write<"MESSAGE">(out, timestamp, token, trace,
+ *                           frame::field<"message">(text), frame::field<"sender">(name));
+ *
+ * The output is byte-for-byte what serialize() produces for the same
+ * message: objects are written in nlohmann's (sorted) key order, which
+ * write() checks at compile time, and strings are escaped exactly as
+ * dump() escapes them. A json-valued field that is null is left out, as
+ * serialize() does for header.trace. Strings that are not valid UTF-8 are
+ * handed to nlohmann, so they fail with the same type_error as before.
+ */
+namespace frame {
+
+// A string literal usable as a template argument
+template<size_t N>
+struct Key {
+    char chars[N]{};
+    constexpr Key(const char (&text)[N]) { std::copy_n(text, N, chars); }
+    constexpr std::string_view view() const { return {chars, N - 1}; }
+
+    // Keys and type names are written as-is, so they must not need escaping
+    constexpr bool plain() const {
+        for (size_t i = 0; i + 1 < N; ++i) {
+            unsigned char c = static_cast<unsigned char>(chars[i]);
+            if (c == '"' || c == '\\' || c < 0x20 || c >= 0x80) return false;
+        }
+        return true;
+    }
+};
+
+template<Key K, typename T>
+struct Field {
+    static_assert(K.plain(), "field keys are written unescaped");
+    static constexpr std::string_view key = K.view();
+    const T& value;
+};
+
+template<Key K, typename T>
+constexpr Field<K, T> field(const T& value) {
+    return Field<K, T>{value};
+}
+
+// Array value: writer(out, element) is called for each element of range
+template<typename Range, typename Writer>
+struct Each {
+    const Range& range;
+    Writer writer;
+};
+
+template<typename Range, typename Writer>
+Each<Range, Writer> each(const Range& range, Writer writer) {
+    return Each<Range, Writer>{range, std::move(writer)};
+}
+
+namespace detail {
+
+inline constexpr char HEX[] = "0123456789abcdef";
+
+// Bytes of the well-formed UTF-8 sequence at s[0], or 0 if it is not one
+inline size_t utf8_sequence(const unsigned char* s, size_t available) {
+    unsigned char lead = s[0];
+    size_t length;
+    unsigned char low = 0x80;
+    unsigned char high = 0xBF;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        length = 2;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        length = 3;
+        if (lead == 0xE0) low = 0xA0;        // overlong
+        else if (lead == 0xED) high = 0x9F;  // surrogates
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        length = 4;
+        if (lead == 0xF0) low = 0x90;        // overlong
+        else if (lead == 0xF4) high = 0x8F;  // above U+10FFFF
+    } else {
+        return 0;
+    }
+    if (available < length || s[1] < low || s[1] > high) {
+        return 0;
+    }
+    for (size_t i = 2; i < length; ++i) {
+        if (s[i] < 0x80 || s[i] > 0xBF) {
+            return 0;
+        }
+    }
+    return length;
+}
+
+// Offset of the first byte in [from, size) that needs attention: '"', '\\',
+// a control character, or a non-ASCII byte (validated as UTF-8)
+inline size_t find_special(const char* data, size_t from, size_t size) {
+    size_t i = from;
+#if defined(__SSE2__)
+    // Signed compare: bytes >= 0x80 are negative, so "< 0x20" catches them too
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i space = _mm_set1_epi8(0x20);
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i special = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+            _mm_cmplt_epi8(chunk, space));
+        int mask = _mm_movemask_epi8(special);
+        if (mask != 0) {
+            return i + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+        }
+    }
+#endif
+    for (; i < size; ++i) {
+        unsigned char c = static_cast<unsigned char>(data[i]);
+        if (c == '"' || c == '\\' || c < 0x20 || c >= 0x80) {
+            return i;
+        }
+    }
+    return size;
+}
+
+} // namespace detail
+
+// Append text as a JSON string, escaped as nlohmann::json::dump() does
+inline void write_string(std::string& out, std::string_view text) {
+    const char* data = text.data();
+    const size_t size = text.size();
+    size_t mark = out.size();
+    out += '"';
+    size_t start = 0;
+    while (start < size) {
+        size_t i = detail::find_special(data, start, size);
+        out.append(data + start, i - start);
+        if (i == size) {
+            break;
+        }
+        unsigned char c = static_cast<unsigned char>(data[i]);
+        if (c >= 0x80) {
+            size_t length = detail::utf8_sequence(reinterpret_cast<const unsigned char*>(data + i), size - i);
+            if (length == 0) {
+                out.resize(mark);
+                out += nlohmann::json(std::string(text)).dump();  // throws type_error 316
+                return;
+            }
+            out.append(data + i, length);
+            start = i + length;
+            continue;
+        }
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\t': out += "\\t"; break;
+            case '\n': out += "\\n"; break;
+            case '\f': out += "\\f"; break;
+            case '\r': out += "\\r"; break;
+            default: {
+                char escape[6] = {'\\', 'u', '0', '0', detail::HEX[c >> 4], detail::HEX[c & 0xF]};
+                out.append(escape, sizeof(escape));
+                break;
+            }
+        }
+        start = i + 1;
+    }
+    out += '"';
+}
+
+inline void write_value(std::string& out, std::string_view text) { write_string(out, text); }
+inline void write_value(std::string& out, const std::string& text) { write_string(out, text); }
+inline void write_value(std::string& out, const char* text) { write_string(out, text); }
+inline void write_value(std::string& out, bool flag) { out += flag ? "true" : "false"; }
+inline void write_value(std::string& out, const nlohmann::json& value) { out += value.dump(); }
+
+template<typename T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>, int> = 0>
+void write_value(std::string& out, T number) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    out.append(digits, result.ptr);
+}
+
+inline void write_value(std::string& out, const std::vector<std::string>& strings) {
+    out += '[';
+    for (size_t i = 0; i < strings.size(); ++i) {
+        if (i) out += ',';
+        write_string(out, strings[i]);
+    }
+    out += ']';
+}
+
+template<typename Range, typename Writer>
+void write_value(std::string& out, const Each<Range, Writer>& array) {
+    out += '[';
+    bool first = true;
+    for (const auto& element : array.range) {
+        if (!first) out += ',';
+        first = false;
+        array.writer(out, element);
+    }
+    out += ']';
+}
+
+namespace detail {
+
+template<typename T>
+bool omitted(const T&) { return false; }
+inline bool omitted(const nlohmann::json& value) { return value.is_null(); }
+
+template<typename... Fields>
+constexpr bool keys_sorted() {
+    std::string_view keys[] = {std::string_view{}, Fields::key...};
+    for (size_t i = 2; i < sizeof...(Fields) + 1; ++i) {
+        if (!(keys[i - 1] < keys[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<typename F>
+void write_field(std::string& out, bool& first, const F& field) {
+    if (omitted(field.value)) {
+        return;
+    }
+    if (!first) out += ',';
+    first = false;
+    out += '"';
+    out += F::key;
+    out += "\":";
+    write_value(out, field.value);
+}
+
+} // namespace detail
+
+// Append {"key":value,...}; fields must be given in sorted key order
+template<typename... Fields>
+void write_object(std::string& out, const Fields&... fields) {
+    static_assert(detail::keys_sorted<Fields...>(), "fields must be in sorted key order, as nlohmann writes them");
+    out += '{';
+    bool first = true;
+    (detail::write_field(out, first, fields), ...);
+    out += '}';
+}
+
+/**
+ * Append one frame, newline included, as NetworkMessage::serialize() would
+ * write a message with this header and body (data = the fields)
+ */
+template<Key Type, typename... Fields>
+void write(std::string& out, std::string_view timestamp, std::string_view token,
+           const nlohmann::json& trace, const Fields&... data) {
+    static_assert(Type.plain(), "message types are written unescaped");
+    out += "{\"body\":{\"data\":";
+    write_object(out, data...);
+    out += ",\"type\":\"";
+    out += Type.view();
+    out += "\"},\"header\":";
+    write_object(out, field<"timestamp">(timestamp), field<"token">(token), field<"trace">(trace));
+    out += "}\n";
+}
+
+} // namespace frame
@@ -0,0 +1,539 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+/**
+ * MessageSchema - Every protocol message shape, declared once
+ *
+ * PROTO_RECORDS and PROTO_MESSAGES below are the only description of what
+ * each body.data holds. For every entry they generate a typed struct (in
+ * namespace proto) with:
+ *
+ *   to_json() / from_json(data)        the JSON body.data used on the wire
+ *   write_binary(out) / read_binary(in) a compact binary form
+ *
+ * plus MessageId, AnyMessage (a variant of every message) and the
+ * type-name lookup. NetworkMessage's factories, ClientManager's dispatch
+ * and the client's frame decoder all go through these structs, so adding
+ * a message is a field list and one line in PROTO_MESSAGES.
+ *
+ * Field columns are (type, name, default, presence). ALWAYS fields are
+ * always written; OPTIONAL ones are left out while they hold their
+ * default. Reading is lenient, as the old value() calls were: a missing
+ * field or one of the wrong type keeps its default, and array elements of
+ * the wrong type are skipped. from_json() walks the members once, finding
+ * each in a key table sorted at compile time.
+ *
+ * Binary form: one byte of MessageId, then the fields in declaration
+ * order. Integers are LEB128 varints (zigzag if signed), doubles 8 bytes
+ * little-endian, bools one byte, strings and arrays a varint length then
+ * their contents, json fields their dump() as a string ("" for null).
+ * MessageId is the position in PROTO_MESSAGES, so new messages go at the
+ * end.
+ */
+
+// Objects nested in message arrays
+#define PROTO_ROOM_ITEM(F) \
+    F(std::string, name, {}, ALWAYS) \
+    F(uint64_t, members, 0, ALWAYS)
+
+#define PROTO_HISTORY_ITEM(F) \
+    F(uint64_t, seq, 0, ALWAYS) \
+    F(std::string, sender, "Unknown", ALWAYS) \
+    F(std::string, message, {}, ALWAYS) \
+    F(int64_t, timestamp, 0, ALWAYS) \
+    F(double, score, 0.0, ALWAYS)
+
+#define PROTO_BATCH_ITEM(F) \
+    F(std::string, sender, "Unknown", ALWAYS) \
+    F(std::string, message, {}, ALWAYS) \
+    F(uint64_t, seq, 0, ALWAYS) \
+    F(nlohmann::json, trace, nullptr, OPTIONAL)
+
+#define PROTO_RECORDS(R) \
+    R(RoomItem, PROTO_ROOM_ITEM) \
+    R(HistoryItem, PROTO_HISTORY_ITEM) \
+    R(BatchItem, PROTO_BATCH_ITEM)
+
+// Client -> server
+#define PROTO_NO_FIELDS(F)
+
+#define PROTO_AUTH(F) \
+    F(std::string, room_list, {}, OPTIONAL)     /* "paged": foyer via LIST_ROOMS */
+
+#define PROTO_ROOM_NAME(F) \
+    F(std::string, room_name, {}, ALWAYS)
+
+#define PROTO_CHAT_MESSAGE(F) \
+    F(std::string, message, {}, ALWAYS) \
+    F(std::string, room_name, {}, OPTIONAL)     /* "" = the primary room */
+
+#define PROTO_LIST_ROOMS(F) \
+    F(std::string, prefix, {}, ALWAYS) \
+    F(std::string, sort, "name", ALWAYS) \
+    F(std::string, cursor, {}, ALWAYS) \
+    F(uint64_t, limit, 0, ALWAYS)
+
+#define PROTO_SEARCH_ROOMS(F) \
+    F(std::string, query, {}, ALWAYS) \
+    F(std::string, match, "prefix", ALWAYS) \
+    F(uint64_t, limit, 0, ALWAYS)
+
+#define PROTO_SEARCH_HISTORY(F) \
+    F(std::string, room_name, {}, ALWAYS) \
+    F(std::string, query, {}, ALWAYS) \
+    F(uint64_t, limit, 0, ALWAYS)
+
+#define PROTO_CREDIT(F) \
+    F(uint32_t, frames, 0, ALWAYS)
+
+// Server -> client
+#define PROTO_ERROR(F) \
+    F(std::string, message, "Unknown error", ALWAYS)
+
+#define PROTO_ROOM_LIST(F) \
+    F(std::vector<std::string>, rooms, {}, ALWAYS)
+
+#define PROTO_ROOM_PAGE(F) \
+    F(std::string, prefix, {}, ALWAYS) \
+    F(std::string, sort, "name", ALWAYS) \
+    F(std::string, cursor, {}, ALWAYS) \
+    F(std::vector<RoomItem>, rooms, {}, ALWAYS) \
+    F(std::string, next_cursor, {}, ALWAYS) \
+    F(uint64_t, total, 0, ALWAYS)
+
+#define PROTO_SEARCH_RESULTS(F) \
+    F(std::string, query, {}, ALWAYS) \
+    F(std::string, match, "prefix", ALWAYS) \
+    F(std::vector<RoomItem>, rooms, {}, ALWAYS)
+
+#define PROTO_HISTORY_RESULTS(F) \
+    F(std::string, room_name, {}, ALWAYS) \
+    F(std::string, query, {}, ALWAYS) \
+    F(std::vector<HistoryItem>, results, {}, ALWAYS)
+
+#define PROTO_ROOMS_CHANGED(F) \
+    F(uint64_t, total, 0, ALWAYS)
+
+#define PROTO_PARTICIPANT_LIST(F) \
+    F(std::vector<std::string>, participants, {}, ALWAYS) \
+    F(std::string, room, {}, OPTIONAL)
+
+#define PROTO_MESSAGE(F) \
+    F(std::string, sender, "Unknown", ALWAYS) \
+    F(std::string, message, {}, ALWAYS) \
+    F(std::string, room, {}, OPTIONAL) \
+    F(uint64_t, seq, 0, OPTIONAL)               /* room sequence numbers start at 1 */
+
+#define PROTO_MESSAGE_BATCH(F) \
+    F(std::string, room, {}, ALWAYS) \
+    F(std::vector<BatchItem>, messages, {}, ALWAYS)
+
+#define PROTO_MESSAGES(M) \
+    M(Auth, "AUTH", PROTO_AUTH) \
+    M(JoinRoom, "JOIN_ROOM", PROTO_ROOM_NAME) \
+    M(CreateRoom, "CREATE_ROOM", PROTO_ROOM_NAME) \
+    M(Leave, "LEAVE", PROTO_NO_FIELDS) \
+    M(ChatMessage, "CHAT_MESSAGE", PROTO_CHAT_MESSAGE) \
+    M(RefreshRooms, "REFRESH_ROOMS", PROTO_NO_FIELDS) \
+    M(ListRooms, "LIST_ROOMS", PROTO_LIST_ROOMS) \
+    M(SearchRooms, "SEARCH_ROOMS", PROTO_SEARCH_ROOMS) \
+    M(SearchHistory, "SEARCH_HISTORY", PROTO_SEARCH_HISTORY) \
+    M(Subscribe, "SUBSCRIBE", PROTO_ROOM_NAME) \
+    M(Unsubscribe, "UNSUBSCRIBE", PROTO_ROOM_NAME) \
+    M(Credit, "CREDIT", PROTO_CREDIT) \
+    M(Quit, "QUIT", PROTO_NO_FIELDS) \
+    M(Error, "ERROR", PROTO_ERROR) \
+    M(RoomJoined, "ROOM_JOINED", PROTO_ROOM_NAME) \
+    M(Subscribed, "SUBSCRIBED", PROTO_ROOM_NAME) \
+    M(Unsubscribed, "UNSUBSCRIBED", PROTO_ROOM_NAME) \
+    M(LeftRoom, "LEFT_ROOM", PROTO_ERROR) \
+    M(RoomList, "ROOM_LIST", PROTO_ROOM_LIST) \
+    M(RoomPage, "ROOM_PAGE", PROTO_ROOM_PAGE) \
+    M(SearchResults, "SEARCH_RESULTS", PROTO_SEARCH_RESULTS) \
+    M(HistoryResults, "HISTORY_RESULTS", PROTO_HISTORY_RESULTS) \
+    M(RoomsChanged, "ROOMS_CHANGED", PROTO_ROOMS_CHANGED) \
+    M(ParticipantList, "PARTICIPANT_LIST", PROTO_PARTICIPANT_LIST) \
+    M(Message, "MESSAGE", PROTO_MESSAGE) \
+    M(MessageBatch, "MESSAGE_BATCH", PROTO_MESSAGE_BATCH) \
+    M(Ping, "PING", PROTO_NO_FIELDS) \
+    M(Pong, "PONG", PROTO_NO_FIELDS)
+
+namespace proto {
+
+enum Presence { ALWAYS, OPTIONAL };
+
+namespace detail {
+
+template<typename T>
+struct is_vector : std::false_type {};
+template<typename T>
+struct is_vector<std::vector<T>> : std::true_type {};
+
+template<typename T>
+nlohmann::json to_json_value(const T& value) {
+    if constexpr (requires { value.to_json(); }) {
+        return value.to_json();
+    } else if constexpr (is_vector<T>::value) {
+        nlohmann::json array = nlohmann::json::array();
+        for (const auto& element : value) {
+            array.push_back(to_json_value(element));
+        }
+        return array;
+    } else {
+        return nlohmann::json(value);
+    }
+}
+
+template<Presence P, typename T>
+bool written(const T& value, const T& default_value) {
+    if constexpr (P == ALWAYS) {
+        return true;
+    } else {
+        return value != default_value;
+    }
+}
+
+// false (and value untouched) if j does not hold a T
+template<typename T>
+bool from_json_value(const nlohmann::json& j, T& value) {
+    if constexpr (std::is_same_v<T, nlohmann::json>) {
+        value = j;
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        if (!j.is_string()) return false;
+        value = j.get_ref<const std::string&>();
+    } else if constexpr (std::is_same_v<T, bool>) {
+        if (!j.is_boolean()) return false;
+        value = j.get<bool>();
+    } else if constexpr (std::is_integral_v<T>) {
+        if (j.is_number_unsigned()) {
+            uint64_t n = j.get<uint64_t>();
+            if (!std::in_range<T>(n)) return false;
+            value = static_cast<T>(n);
+        } else if (j.is_number_integer()) {
+            int64_t n = j.get<int64_t>();
+            if (!std::in_range<T>(n)) return false;
+            value = static_cast<T>(n);
+        } else {
+            return false;
+        }
+    } else if constexpr (std::is_floating_point_v<T>) {
+        if (!j.is_number()) return false;
+        value = j.get<T>();
+    } else if constexpr (is_vector<T>::value) {
+        if (!j.is_array()) return false;
+        value.clear();
+        value.reserve(j.size());
+        for (const auto& element : j) {
+            typename T::value_type item{};
+            if (from_json_value(element, item)) {
+                value.push_back(std::move(item));
+            }
+        }
+    } else {
+        if (!j.is_object()) return false;
+        value = T::from_json(j);
+    }
+    return true;
+}
+
+// A field's JSON key and its position in the field list
+using FieldKey = std::pair<std::string_view, size_t>;
+
+template<size_t N>
+constexpr std::array<FieldKey, N> sorted_keys(std::array<FieldKey, N> keys) {
+    std::sort(keys.begin(), keys.end());
+    return keys;
+}
+
+// Position of the field named key; N if the record has no such field
+template<size_t N>
+size_t field_of(const std::array<FieldKey, N>& keys, std::string_view key) {
+    auto it = std::lower_bound(keys.begin(), keys.end(), key,
+                               [](const FieldKey& entry, std::string_view name) { return entry.first < name; });
+    return it != keys.end() && it->first == key ? it->second : N;
+}
+
+inline void write_varint(std::string& out, uint64_t n) {
+    while (n >= 0x80) {
+        out += static_cast<char>((n & 0x7F) | 0x80);
+        n >>= 7;
+    }
+    out += static_cast<char>(n);
+}
+
+// Cursor over a binary message; any short or malformed read clears ok
+struct Reader {
+    std::string_view data;
+    size_t pos = 0;
+    bool ok = true;
+
+    uint64_t varint() {
+        uint64_t n = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (pos >= data.size()) break;
+            uint8_t byte = static_cast<uint8_t>(data[pos++]);
+            n |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return n;
+        }
+        ok = false;
+        return 0;
+    }
+
+    std::string_view bytes(uint64_t length) {
+        if (length > data.size() - pos) {
+            ok = false;
+            return {};
+        }
+        std::string_view result = data.substr(pos, length);
+        pos += length;
+        return result;
+    }
+};
+
+template<typename T>
+void write_binary_value(std::string& out, const T& value) {
+    if constexpr (std::is_same_v<T, nlohmann::json>) {
+        write_binary_value(out, value.is_null() ? std::string() : value.dump());
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        write_varint(out, value.size());
+        out += value;
+    } else if constexpr (std::is_same_v<T, bool>) {
+        out += static_cast<char>(value ? 1 : 0);
+    } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+        int64_t n = value;
+        write_varint(out, (static_cast<uint64_t>(n) << 1) ^ static_cast<uint64_t>(n >> 63));
+    } else if constexpr (std::is_integral_v<T>) {
+        write_varint(out, value);
+    } else if constexpr (std::is_same_v<T, double>) {
+        uint64_t bits = std::bit_cast<uint64_t>(value);
+        for (int i = 0; i < 8; ++i) {
+            out += static_cast<char>(bits >> (8 * i));
+        }
+    } else if constexpr (is_vector<T>::value) {
+        write_varint(out, value.size());
+        for (const auto& element : value) {
+            write_binary_value(out, element);
+        }
+    } else {
+        value.write_binary(out);
+    }
+}
+
+template<typename T>
+void read_binary_value(Reader& in, T& value) {
+    if constexpr (std::is_same_v<T, nlohmann::json>) {
+        std::string_view text = in.bytes(in.varint());
+        value = text.empty() ? nlohmann::json() : nlohmann::json::parse(text, nullptr, false);
+        if (value.is_discarded()) in.ok = false;
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        value = std::string(in.bytes(in.varint()));
+    } else if constexpr (std::is_same_v<T, bool>) {
+        std::string_view byte = in.bytes(1);
+        value = !byte.empty() && byte[0] != 0;
+    } else if constexpr (std::is_integral_v<T>) {
+        uint64_t raw = in.varint();
+        if constexpr (std::is_signed_v<T>) {
+            int64_t n = static_cast<int64_t>(raw >> 1) ^ -static_cast<int64_t>(raw & 1);
+            if (!std::in_range<T>(n)) in.ok = false;
+            value = static_cast<T>(n);
+        } else {
+            if (!std::in_range<T>(raw)) in.ok = false;
+            value = static_cast<T>(raw);
+        }
+    } else if constexpr (std::is_same_v<T, double>) {
+        std::string_view bytes = in.bytes(8);
+        uint64_t bits = 0;
+        for (size_t i = 0; i < bytes.size(); ++i) {
+            bits |= static_cast<uint64_t>(static_cast<uint8_t>(bytes[i])) << (8 * i);
+        }
+        value = std::bit_cast<double>(bits);
+    } else if constexpr (is_vector<T>::value) {
+        uint64_t count = in.varint();
+        value.clear();
+        // Each element takes at least a byte, which bounds a hostile count
+        if (count > in.data.size() - in.pos) {
+            in.ok = false;
+            return;
+        }
+        value.reserve(count);
+        for (uint64_t i = 0; i < count && in.ok; ++i) {
+            typename T::value_type element{};
+            read_binary_value(in, element);
+            value.push_back(std::move(element));
+        }
+    } else {
+        value.read_binary(in);
+    }
+}
+
+} // namespace detail
+
+#define PROTO_MEMBER(type, name, default_value, presence) \
+    type name = default_value;
+
+#define PROTO_FIELD_TO_JSON(type, name, default_value, presence) \
+    if (detail::written<presence>(name, defaults.name)) { \
+        j[#name] = detail::to_json_value(name); \
+    }
+
+#define PROTO_FIELD_ORDINAL(type, name, default_value, presence) FIELD_##name,
+
+#define PROTO_FIELD_KEY(type, name, default_value, presence) \
+    detail::FieldKey{#name, FIELD_##name},
+
+#define PROTO_FIELD_FROM_JSON(type, name, default_value, presence) \
+    case FIELD_##name: \
+        detail::from_json_value(it.value(), result.name); \
+        break;
+
+#define PROTO_FIELD_WRITE(type, name, default_value, presence) \
+    detail::write_binary_value(out, name);
+
+#define PROTO_FIELD_READ(type, name, default_value, presence) \
+    detail::read_binary_value(in, name);
+
+#define PROTO_CODECS(Name, FIELDS) \
+    nlohmann::json to_json() const { \
+        [[maybe_unused]] static const Name defaults{}; \
+        nlohmann::json j = nlohmann::json::object(); \
+        FIELDS(PROTO_FIELD_TO_JSON) \
+        return j; \
+    } \
+    static Name from_json([[maybe_unused]] const nlohmann::json& j) { \
+        enum : size_t { FIELDS(PROTO_FIELD_ORDINAL) FIELD_COUNT }; \
+        static constexpr auto keys = detail::sorted_keys( \
+            std::array<detail::FieldKey, FIELD_COUNT>{FIELDS(PROTO_FIELD_KEY)}); \
+        Name result; \
+        if (!j.is_object()) { \
+            return result; \
+        } \
+        /* One pass over the members present; unknown keys are skipped */ \
+        for (auto it = j.begin(); it != j.end(); ++it) { \
+            switch (detail::field_of(keys, it.key())) { \
+                FIELDS(PROTO_FIELD_FROM_JSON) \
+                default: break; \
+            } \
+        } \
+        return result; \
+    } \
+    void write_binary([[maybe_unused]] std::string& out) const { \
+        FIELDS(PROTO_FIELD_WRITE) \
+    } \
+    void read_binary([[maybe_unused]] detail::Reader& in) { \
+        FIELDS(PROTO_FIELD_READ) \
+    }
+
+#define PROTO_RECORD_STRUCT(Name, FIELDS) \
+    struct Name { \
+        FIELDS(PROTO_MEMBER) \
+        PROTO_CODECS(Name, FIELDS) \
+    };
+
+PROTO_RECORDS(PROTO_RECORD_STRUCT)
+
+#define PROTO_ID(Name, type_name, FIELDS) Name,
+
+enum class MessageId : uint8_t {
+    PROTO_MESSAGES(PROTO_ID)
+    UNKNOWN
+};
+
+#define PROTO_MESSAGE_STRUCT(Name, type_name, FIELDS) \
+    struct Name { \
+        static constexpr std::string_view TYPE = type_name; \
+        static constexpr MessageId ID = MessageId::Name; \
+        FIELDS(PROTO_MEMBER) \
+        PROTO_CODECS(Name, FIELDS) \
+    };
+
+PROTO_MESSAGES(PROTO_MESSAGE_STRUCT)
+
+#define PROTO_ALTERNATIVE(Name, type_name, FIELDS) , Name
+
+using AnyMessage = std::variant<std::monostate PROTO_MESSAGES(PROTO_ALTERNATIVE)>;
+
+// MessageId for a body.type; UNKNOWN if no message has that name
+inline MessageId id_of(std::string_view type) {
+#define PROTO_NAME_ENTRY(Name, type_name, FIELDS) std::pair{std::string_view(type_name), MessageId::Name},
+    static constexpr auto by_name = [] {
+        std::array entries{PROTO_MESSAGES(PROTO_NAME_ENTRY)};
+        std::sort(entries.begin(), entries.end());
+        return entries;
+    }();
+#undef PROTO_NAME_ENTRY
+    auto it = std::lower_bound(by_name.begin(), by_name.end(), type,
+                               [](const auto& entry, std::string_view name) { return entry.first < name; });
+    return it != by_name.end() && it->first == type ? it->second : MessageId::UNKNOWN;
+}
+
+// The message named type, read from body.data; monostate for unknown types
+inline AnyMessage from_json(std::string_view type, const nlohmann::json& data) {
+#define PROTO_FROM_JSON_CASE(Name, type_name, FIELDS) \
+    case MessageId::Name: return Name::from_json(data);
+    switch (id_of(type)) {
+        PROTO_MESSAGES(PROTO_FROM_JSON_CASE)
+        case MessageId::UNKNOWN: break;
+    }
+#undef PROTO_FROM_JSON_CASE
+    return std::monostate{};
+}
+
+template<typename T>
+void write_binary(std::string& out, const T& message) {
+    out += static_cast<char>(T::ID);
+    message.write_binary(out);
+}
+
+// nullopt unless bytes is exactly one well-formed binary message
+inline std::optional<AnyMessage> read_binary(std::string_view bytes) {
+    if (bytes.empty()) {
+        return std::nullopt;
+    }
+    detail::Reader in{bytes, 1};
+    AnyMessage result;
+#define PROTO_READ_CASE(Name, type_name, FIELDS) \
+    case MessageId::Name: { \
+        Name message; \
+        message.read_binary(in); \
+        result = std::move(message); \
+        break; \
+    }
+    switch (static_cast<MessageId>(static_cast<uint8_t>(bytes[0]))) {
+        PROTO_MESSAGES(PROTO_READ_CASE)
+        default: return std::nullopt;
+    }
+#undef PROTO_READ_CASE
+    if (!in.ok || in.pos != bytes.size()) {
+        return std::nullopt;
+    }
+    return result;
+}
+
+#undef PROTO_ALTERNATIVE
+#undef PROTO_MESSAGE_STRUCT
+#undef PROTO_ID
+#undef PROTO_RECORD_STRUCT
+#undef PROTO_CODECS
+#undef PROTO_FIELD_READ
+#undef PROTO_FIELD_WRITE
+#undef PROTO_FIELD_FROM_JSON
+#undef PROTO_FIELD_KEY
+#undef PROTO_FIELD_ORDINAL
+#undef PROTO_FIELD_TO_JSON
+#undef PROTO_MEMBER
+
+} // namespace proto
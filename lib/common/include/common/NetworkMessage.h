@@ -3,6 +3,9 @@
 #include <nlohmann/json.hpp>
 #include <string>
 #include <chrono>
+#include <functional>
+#include "common/FrameWriter.h"
+#include "common/MessageSchema.h"
 
 using json = nlohmann::json;
 
@@ -13,30 +16,46 @@ using json = nlohmann::json;
  * {
  *   "header": {
  *     "timestamp": "2026-01-17T12:34:56Z",
- *     "token": "abc123..." (optional, empty for server responses)
+ *     "token": "abc123..." (optional, empty for server responses),
+ *     "trace": {"id": ..., "stages": [...]} (optional)
  *   },
  *   "body": {
  *     "type": "MESSAGE|JOIN_ROOM|CREATE_ROOM|LEAVE|...",
  *     "data": {...}  (type-specific data)
  *   }
  * }
+ *
+ * body.data for each type is declared in common/MessageSchema.h; the
+ * create_* factories fill it from the typed proto:: structs.
+ *
+ * The write_* functions append the same bytes as create_*(...).serialize()
+ * for the frames sent on hot paths, without building a json document
+ * (see common/FrameWriter.h).
  */
 struct NetworkMessage {
     struct Header {
         std::string timestamp;
         std::string token;
+        json trace;  // null unless the frame is being traced (see common/Trace.h)
         
         json to_json() const {
-            return json{
+            json j{
                 {"timestamp", timestamp},
                 {"token", token}
             };
+            if (!trace.is_null()) {
+                j["trace"] = trace;
+            }
+            return j;
         }
         
         static Header from_json(const json& j) {
             Header h;
             h.timestamp = j.value("timestamp", "");
             h.token = j.value("token", "");
+            if (j.contains("trace")) {
+                h.trace = j["trace"];
+            }
             return h;
         }
     };
@@ -95,107 +114,216 @@ struct NetworkMessage {
         return std::string(buffer);
     }
     
-    // Factory methods for common message types
-    static NetworkMessage create_auth(const std::string& token) {
+    // Any message declared in common/MessageSchema.h
+    template<typename T>
+    static NetworkMessage create(const std::string& token, const T& message) {
         NetworkMessage msg;
         msg.header.timestamp = get_timestamp();
         msg.header.token = token;
-        msg.body.type = "AUTH";
-        msg.body.data = json::object();
+        msg.body.type = T::TYPE;
+        msg.body.data = message.to_json();
         return msg;
     }
     
+    // Factory methods for common message types
+    static NetworkMessage create_auth(const std::string& token) {
+        return create(token, proto::Auth{});
+    }
+    
+    // paged_room_list: the client fetches the foyer with LIST_ROOMS instead of full ROOM_LISTs
+    static NetworkMessage create_auth(const std::string& token, bool paged_room_list) {
+        return create(token, proto::Auth{.room_list = paged_room_list ? "paged" : ""});
+    }
+    
     static NetworkMessage create_join_room(const std::string& token, const std::string& room_name) {
-        NetworkMessage msg;
-        msg.header.timestamp = get_timestamp();
-        msg.header.token = token;
-        msg.body.type = "JOIN_ROOM";
-        msg.body.data = {{"room_name", room_name}};
-        return msg;
+        return create(token, proto::JoinRoom{.room_name = room_name});
     }
     
     static NetworkMessage create_create_room(const std::string& token, const std::string& room_name) {
-        NetworkMessage msg;
-        msg.header.timestamp = get_timestamp();
-        msg.header.token = token;
-        msg.body.type = "CREATE_ROOM";
-        msg.body.data = {{"room_name", room_name}};
-        return msg;
+        return create(token, proto::CreateRoom{.room_name = room_name});
     }
     
     static NetworkMessage create_leave(const std::string& token) {
-        NetworkMessage msg;
-        msg.header.timestamp = get_timestamp();
-        msg.header.token = token;
-        msg.body.type = "LEAVE";
-        msg.body.data = json::object();
-        return msg;
+        return create(token, proto::Leave{});
     }
     
     static NetworkMessage create_chat_message(const std::string& token, const std::string& message) {
-        NetworkMessage msg;
-        msg.header.timestamp = get_timestamp();
-        msg.header.token = token;
-        msg.body.type = "CHAT_MESSAGE";
-        msg.body.data = {{"message", message}};
-        return msg;
+        return create(token, proto::ChatMessage{.message = message});
+    }
+    
+    // Chat into one of several subscribed rooms
+    static NetworkMessage create_chat_message(const std::string& token, const std::string& message,
+                                              const std::string& room_name) {
+        return create(token, proto::ChatMessage{.message = message, .room_name = room_name});
+    }
+    
+    // One page of rooms; cursor is the previous page's next_cursor ("" for the first)
+    static NetworkMessage create_list_rooms(const std::string& token, const std::string& prefix,
+                                            const std::string& sort, const std::string& cursor,
+                                            size_t limit) {
+        return create(token, proto::ListRooms{.prefix = prefix, .sort = sort, .cursor = cursor, .limit = limit});
+    }
+    
+    // Top rooms by member count whose name starts with / contains query
+    // (match "prefix" or "substring", case-insensitive)
+    static NetworkMessage create_search_rooms(const std::string& token, const std::string& query,
+                                              const std::string& match, size_t limit) {
+        return create(token, proto::SearchRooms{.query = query, .match = match, .limit = limit});
+    }
+    
+    // Best-matching past messages in room containing every word of query
+    static NetworkMessage create_search_history(const std::string& token, const std::string& room_name,
+                                                const std::string& query, size_t limit) {
+        return create(token, proto::SearchHistory{.room_name = room_name, .query = query, .limit = limit});
+    }
+    
+    // Receive a room's traffic without leaving the current room
+    static NetworkMessage create_subscribe(const std::string& token, const std::string& room_name) {
+        return create(token, proto::Subscribe{.room_name = room_name});
+    }
+    
+    static NetworkMessage create_unsubscribe(const std::string& token, const std::string& room_name) {
+        return create(token, proto::Unsubscribe{.room_name = room_name});
     }
     
     static NetworkMessage create_quit(const std::string& token) {
-        NetworkMessage msg;
-        msg.header.timestamp = get_timestamp();
-        msg.header.token = token;
-        msg.body.type = "QUIT";
-        msg.body.data = json::object();
-        return msg;
+        return create(token, proto::Quit{});
+    }
+    
+    // Flow control: the client can take this many more frames
+    static NetworkMessage create_credit(const std::string& token, uint32_t frames) {
+        return create(token, proto::Credit{.frames = frames});
+    }
+    
+    // Answer to the server's PING
+    static NetworkMessage create_pong(const std::string& token) {
+        return create(token, proto::Pong{});
     }
     
     // Server response messages (no token)
     static NetworkMessage create_error(const std::string& error_message) {
-        NetworkMessage msg;
-        msg.header.timestamp = get_timestamp();
-        msg.header.token = "";
-        msg.body.type = "ERROR";
-        msg.body.data = {{"message", error_message}};
-        return msg;
+        return create("", proto::Error{.message = error_message});
     }
     
     static NetworkMessage create_room_joined(const std::string& room_name) {
-        NetworkMessage msg;
-        msg.header.timestamp = get_timestamp();
-        msg.header.token = "";
-        msg.body.type = "ROOM_JOINED";
-        msg.body.data = {{"room_name", room_name}};
-        return msg;
+        return create("", proto::RoomJoined{.room_name = room_name});
+    }
+    
+    static NetworkMessage create_subscribed(const std::string& room_name) {
+        return create("", proto::Subscribed{.room_name = room_name});
+    }
+    
+    static NetworkMessage create_unsubscribed(const std::string& room_name) {
+        return create("", proto::Unsubscribed{.room_name = room_name});
+    }
+    
+    // Heartbeat to a connection that has been quiet; the client answers PONG
+    static NetworkMessage create_ping() {
+        return create("", proto::Ping{});
+    }
+    
+    static NetworkMessage create_left_room() {
+        return create("", proto::LeftRoom{.message = "Left room"});
     }
     
     static NetworkMessage create_room_list(const std::vector<std::string>& rooms) {
-        NetworkMessage msg;
-        msg.header.timestamp = get_timestamp();
-        msg.header.token = "";
-        msg.body.type = "ROOM_LIST";
-        msg.body.data = {{"rooms", rooms}};
-        return msg;
+        return create("", proto::RoomList{.rooms = rooms});
+    }
+    
+    // Reply to LIST_ROOMS; echoes the query so the client can match it up.
+    // next_cursor is "" on the last page
+    static NetworkMessage create_room_page(const std::string& prefix, const std::string& sort,
+                                           const std::string& cursor, const std::vector<proto::RoomItem>& rooms,
+                                           const std::string& next_cursor, size_t total) {
+        return create("", proto::RoomPage{.prefix = prefix, .sort = sort, .cursor = cursor, .rooms = rooms,
+                                          .next_cursor = next_cursor, .total = total});
+    }
+    
+    // Reply to SEARCH_ROOMS; rooms best first
+    static NetworkMessage create_search_results(const std::string& query, const std::string& match,
+                                                const std::vector<proto::RoomItem>& rooms) {
+        return create("", proto::SearchResults{.query = query, .match = match, .rooms = rooms});
+    }
+    
+    // Reply to SEARCH_HISTORY; results best first
+    static NetworkMessage create_history_results(const std::string& room_name, const std::string& query,
+                                                 const std::vector<proto::HistoryItem>& results) {
+        return create("", proto::HistoryResults{.room_name = room_name, .query = query, .results = results});
+    }
+    
+    // Foyer notice for paged clients: the room list changed, re-fetch what is shown
+    static NetworkMessage create_rooms_changed(size_t total) {
+        return create("", proto::RoomsChanged{.total = total});
     }
     
     static NetworkMessage create_participant_list(const std::vector<std::string>& participants) {
-        NetworkMessage msg;
-        msg.header.timestamp = get_timestamp();
-        msg.header.token = "";
-        msg.body.type = "PARTICIPANT_LIST";
-        msg.body.data = {{"participants", participants}};
-        return msg;
+        return create("", proto::ParticipantList{.participants = participants});
+    }
+    
+    // Member list tagged with the room it belongs to
+    static NetworkMessage create_participant_list(const std::vector<std::string>& participants,
+                                                  const std::string& room) {
+        return create("", proto::ParticipantList{.participants = participants, .room = room});
     }
     
     static NetworkMessage create_broadcast_message(const std::string& sender, const std::string& message) {
-        NetworkMessage msg;
-        msg.header.timestamp = get_timestamp();
-        msg.header.token = "";
-        msg.body.type = "MESSAGE";
-        msg.body.data = {
-            {"sender", sender},
-            {"message", message}
+        return create("", proto::Message{.sender = sender, .message = message});
+    }
+    
+    // Room-tagged MESSAGE; seq increases by one per message within a room
+    static NetworkMessage create_room_message(const std::string& room, uint64_t seq,
+                                              const std::string& sender, const std::string& message) {
+        return create("", proto::Message{.sender = sender, .message = message, .room = room, .seq = seq});
+    }
+    
+    // Several room messages in one frame
+    static NetworkMessage create_message_batch(const std::string& room, const std::vector<proto::BatchItem>& messages) {
+        return create("", proto::MessageBatch{.room = room, .messages = messages});
+    }
+    
+    // Direct writers; each matches its create_* counterpart byte for byte.
+    // timestamp defaults to now, as in the factories.
+    
+    static void write_chat_message(std::string& out, const std::string& token, const std::string& message,
+                                   const json& trace = nullptr,
+                                   const std::string& timestamp = get_timestamp()) {
+        frame::write<"CHAT_MESSAGE">(out, timestamp, token, trace, frame::field<"message">(message));
+    }
+    
+    static void write_credit(std::string& out, const std::string& token, uint32_t frames,
+                             const std::string& timestamp = get_timestamp()) {
+        frame::write<"CREDIT">(out, timestamp, token, nullptr, frame::field<"frames">(frames));
+    }
+    
+    static void write_room_message(std::string& out, const std::string& room, uint64_t seq,
+                                   const std::string& sender, const std::string& message,
+                                   const json& trace = nullptr,
+                                   const std::string& timestamp = get_timestamp()) {
+        frame::write<"MESSAGE">(out, timestamp, "", trace,
+                                frame::field<"message">(message), frame::field<"room">(room),
+                                frame::field<"sender">(sender), frame::field<"seq">(seq));
+    }
+    
+    // entries: any range of objects (or reference_wrappers to them) with
+    // sender, message, seq and trace (json, null when untraced) members
+    template<typename Entries>
+    static void write_message_batch(std::string& out, const std::string& room, const Entries& entries,
+                                    const std::string& timestamp = get_timestamp()) {
+        auto entry_writer = [](std::string& dest, const auto& element) {
+            using Entry = std::unwrap_reference_t<std::decay_t<decltype(element)>>;
+            const Entry& entry = element;
+            frame::write_object(dest, frame::field<"message">(entry.message), frame::field<"sender">(entry.sender),
+                                frame::field<"seq">(entry.seq), frame::field<"trace">(entry.trace));
         };
-        return msg;
+        frame::write<"MESSAGE_BATCH">(out, timestamp, "", nullptr,
+                                      frame::field<"messages">(frame::each(entries, entry_writer)),
+                                      frame::field<"room">(room));
+    }
+    
+    static void write_participant_list(std::string& out, const std::vector<std::string>& participants,
+                                       const std::string& room,
+                                       const std::string& timestamp = get_timestamp()) {
+        frame::write<"PARTICIPANT_LIST">(out, timestamp, "", nullptr,
+                                         frame::field<"participants">(participants), frame::field<"room">(room));
     }
 };
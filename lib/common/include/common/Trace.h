@@ -0,0 +1,95 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <random>
+#include <string>
+#include <string_view>
+
+/**
+ * Message latency tracing
+ *
+ * A traced frame carries header.trace = {"id": "...", "stages": [[stage, t_us], ...]}.
+ * Every hop appends its stage with wall-clock microseconds, which compare
+ * between processes on one host. A hop that ends a trace (the server
+ * after its socket write, a receiving client after render) writes it to
+ * its TraceLog; trace_report joins the logs by id into per-stage
+ * latency histograms. Frames without a trace pay nothing.
+ */
+namespace tracing {
+
+// Stages in the order a chat line passes them
+inline constexpr const char* CLIENT_INPUT = "client_input";            // Enter pressed
+inline constexpr const char* CLIENT_SEND = "client_send";              // written to the socket
+inline constexpr const char* SERVER_RECV = "server_recv";              // read by the session thread
+inline constexpr const char* SERVER_VALIDATED = "server_validated";    // token checked
+inline constexpr const char* BROADCAST_ENQUEUE = "broadcast_enqueue";  // seq assigned in the room
+inline constexpr const char* SOCKET_WRITE = "socket_write";            // fan-out handed to the IoBackend
+inline constexpr const char* CLIENT_RECV = "client_recv";              // read by NetworkManager
+inline constexpr const char* CLIENT_PROCESS = "client_process";        // handled by ApplicationManager
+inline constexpr const char* RENDER = "render";                        // on screen
+
+inline int64_t now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Fresh trace with a random 64-bit id and no stages
+inline nlohmann::json start() {
+    thread_local std::mt19937_64 rng{std::random_device{}()};
+    char id[17];
+    std::snprintf(id, sizeof(id), "%016llx", static_cast<unsigned long long>(rng()));
+    return nlohmann::json{{"id", id}, {"stages", nlohmann::json::array()}};
+}
+
+// Traces arriving from the network are only followed if they look like ours
+inline bool well_formed(const nlohmann::json& trace) {
+    constexpr size_t MAX_STAGES = 16;
+    return trace.is_object() && trace.contains("id") && trace["id"].is_string() &&
+           trace.contains("stages") && trace["stages"].is_array() && trace["stages"].size() < MAX_STAGES;
+}
+
+inline void stamp(nlohmann::json& trace, std::string_view stage, int64_t t_us = now_us()) {
+    if (trace.is_object()) {
+        trace["stages"].push_back({stage, t_us});
+    }
+}
+
+/**
+ * TraceLog - JSON-lines sink for finished traces; safe to share between threads
+ */
+class TraceLog {
+public:
+    TraceLog() = default;
+    ~TraceLog() {
+        if (file_) std::fclose(file_);
+    }
+
+    TraceLog(const TraceLog&) = delete;
+    TraceLog& operator=(const TraceLog&) = delete;
+
+    // Appends to path; false if it cannot be opened
+    bool open(const std::string& path) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!file_) file_ = std::fopen(path.c_str(), "a");
+        return file_ != nullptr;
+    }
+
+    void write(const nlohmann::json& trace) {
+        std::string line = trace.dump();
+        line += '\n';
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!file_) return;
+        std::fwrite(line.data(), 1, line.size(), file_);
+        std::fflush(file_);
+    }
+
+private:
+    std::mutex mutex_;
+    FILE* file_ = nullptr;
+};
+
+} // namespace tracing
@@ -2,6 +2,7 @@
 #define UI_LABEL_H
 
 #include "Widget.h"
+#include "LayoutCache.h"
 #include <string>
 #include <vector>
 #include <ncurses.h>
@@ -13,6 +14,7 @@ namespace ui {
  * 
  * Displays non-editable text with optional styling.
  * Supports single or multi-line text, alignment, and word wrapping.
+ * Wrapped lines are cached until the text or width changes.
  */
 class Label : public Widget {
 public:
@@ -112,16 +114,12 @@ private:
     bool word_wrap_;
     int attributes_;
     int color_pair_;
+    TextLayout layout_;
     
     /**
-     * Split text into lines for rendering
+     * Lines to render (cached)
      */
-    std::vector<std::string> get_lines() const;
-    
-    /**
-     * Wrap text to fit width
-     */
-    std::vector<std::string> wrap_text(const std::string& text, int width) const;
+    const std::vector<std::string>& get_lines();
 };
 
 /**
@@ -0,0 +1,84 @@
+#ifndef UI_LAYOUTCACHE_H
+#define UI_LAYOUTCACHE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <ncurses.h>
+
+namespace ui {
+
+/**
+ * Line-breaking rules used by the text widgets
+ */
+enum class WrapMode {
+    NONE,         // split on '\n' only (Label without word wrap)
+    LINES,        // word-wrap each '\n'-separated line, keeping blank lines (Label)
+    FLOW          // word-wrap the whole text as one paragraph (MessageBox)
+};
+
+/**
+ * Break text into lines; the uncached work TextLayout memoizes
+ */
+std::vector<std::string> layout_text(const std::string& text, int width, WrapMode mode);
+
+/**
+ * TextLayout - Memoized line layout for one widget's text
+ *
+ * Results are keyed by (text revision, width, mode). Widgets call
+ * invalidate() whenever their text changes; a resize changes the width
+ * and so misses the cache by itself. An unchanged frame does no string work.
+ */
+class TextLayout {
+public:
+    const std::vector<std::string>& lines(const std::string& text, int width, WrapMode mode);
+
+    /**
+     * Text changed: the next lines() call lays it out again
+     */
+    void invalidate() { ++revision_; }
+
+    /**
+     * Number of times layout actually ran (for tests and diagnostics)
+     */
+    uint64_t layouts() const { return layouts_; }
+
+private:
+    uint64_t revision_ = 0;
+    bool valid_ = false;
+    uint64_t cached_revision_ = 0;
+    int cached_width_ = 0;
+    WrapMode cached_mode_ = WrapMode::NONE;
+    std::vector<std::string> lines_;
+    uint64_t layouts_ = 0;
+};
+
+/**
+ * SubWindow - A derwin kept alive across frames
+ *
+ * get() returns the same WINDOW while parent and geometry are unchanged and
+ * recreates it otherwise (e.g. after a terminal resize moves a centered box).
+ */
+class SubWindow {
+public:
+    SubWindow() = default;
+    ~SubWindow() { reset(); }
+
+    SubWindow(const SubWindow&) = delete;
+    SubWindow& operator=(const SubWindow&) = delete;
+
+    WINDOW* get(WINDOW* parent, int height, int width, int y, int x);
+    void reset();
+
+private:
+    WINDOW* window_ = nullptr;
+    WINDOW* parent_ = nullptr;
+    int height_ = 0;
+    int width_ = 0;
+    int y_ = 0;
+    int x_ = 0;
+};
+
+} // namespace ui
+
+#endif // UI_LAYOUTCACHE_H
@@ -2,6 +2,7 @@
 #define UI_LISTBOX_H
 
 #include "Widget.h"
+#include "RowBuffer.h"
 #include <string>
 #include <vector>
 
@@ -12,6 +13,7 @@ namespace ui {
  * 
  * Displays a vertical list of items with optional border and title.
  * Read-only display, no selection or interaction.
+ * Rows are composed in a reused RowBuffer; unchanged rows are not redrawn.
  */
 class ListBox : public Widget {
 public:
@@ -82,6 +84,7 @@ private:
     bool bordered_;
     std::string title_;
     int scroll_offset_;
+    RowBuffer row_;
     
     int get_visible_height() const;
 };
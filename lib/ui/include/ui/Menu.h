@@ -3,6 +3,7 @@
 
 #include "Widget.h"
 #include "Window.h"
+#include "RowBuffer.h"
 #include <string>
 #include <vector>
 #include <functional>
@@ -34,6 +35,13 @@ struct MenuItem {
  * 
  * Displays a vertical list of items that can be navigated with arrow keys.
  * Supports scrolling, selection highlighting, and callbacks.
+ * Rows are composed in a reused RowBuffer; unchanged rows are not redrawn.
+ *
+ * Virtual mode: instead of owning its items, the menu is given an item
+ * count and a provider that returns the item at an index, or nullptr if
+ * it is not loaded yet. Missing rows render as a placeholder and the
+ * items-needed callback asks the owner to load them, so a very long list
+ * is only fetched as far as the user scrolls.
  */
 class Menu : public Widget {
 public:
@@ -42,6 +50,8 @@ public:
      */
     using SelectCallback = std::function<void(size_t index, const MenuItem& item)>;
     using ActivateCallback = std::function<void(size_t index, const MenuItem& item)>;
+    using ItemProvider = std::function<const MenuItem*(size_t index)>;
+    using ItemsNeededCallback = std::function<void(size_t first_missing)>;
     
     /**
      * Constructor
@@ -89,25 +99,42 @@ public:
     void clear_items();
     
     /**
-     * Get all items
+     * Get all items (empty in virtual mode)
      */
     const std::vector<MenuItem>& get_items() const { return items_; }
     
     /**
-     * Set all items at once
+     * Set all items at once (leaves virtual mode)
      */
     void set_items(const std::vector<MenuItem>& items);
     
+    /**
+     * Switch to virtual mode with count rows served by provider
+     */
+    void set_virtual(ItemProvider provider, size_t count);
+    
+    /**
+     * Change the virtual row count, keeping the selection where possible
+     */
+    void set_virtual_count(size_t count);
+    
+    bool is_virtual() const { return static_cast<bool>(provider_); }
+    
     /**
      * Get number of items
      */
-    size_t get_item_count() const { return items_.size(); }
+    size_t get_item_count() const { return provider_ ? virtual_count_ : items_.size(); }
     
     /**
-     * Get item at index
+     * Get item at index (owned items only; see find_item for virtual mode)
      */
     const MenuItem& get_item(size_t index) const { return items_[index]; }
     
+    /**
+     * Item at index, or nullptr if out of range or not loaded
+     */
+    const MenuItem* find_item(size_t index) const;
+    
     /**
      * Update item at index
      */
@@ -163,6 +190,13 @@ public:
         on_activate_ = callback;
     }
     
+    /**
+     * Set callback for when a visible (or next-page) row is not loaded
+     */
+    void set_on_items_needed(ItemsNeededCallback callback) {
+        on_items_needed_ = callback;
+    }
+    
     /**
      * Render the menu
      */
@@ -227,15 +261,24 @@ protected:
      */
     int get_content_width() const;
     
+    /**
+     * Unloaded virtual rows count as enabled so they can be scrolled onto
+     */
+    bool is_item_enabled(size_t index) const;
+    
     std::vector<MenuItem> items_;
+    ItemProvider provider_;
+    size_t virtual_count_ = 0;
     int selected_index_;
     int scroll_offset_;        // First visible item index
     bool bordered_;
     bool numbered_;
     std::string title_;
+    RowBuffer row_;
     
     SelectCallback on_select_;
     ActivateCallback on_activate_;
+    ItemsNeededCallback on_items_needed_;
 };
 
 /**
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Widget.h"
+#include "LayoutCache.h"
 #include <string>
 #include <functional>
 #include <vector>
@@ -16,6 +17,9 @@ namespace ui {
  * - Multi-line message support
  * - Closes on Enter key
  * - Optional callback when closed
+ *
+ * The box's sub-window and wrapped message are kept between frames and
+ * rebuilt only when the message or the parent's size changes.
  */
 class MessageBox : public Widget {
 public:
@@ -38,8 +42,8 @@ private:
     int height_;
     bool visible_;
     std::function<void()> on_close_;
-    
-    std::vector<std::string> wrap_text(const std::string& text, int max_width);
+    TextLayout layout_;
+    SubWindow box_window_;
 };
 
 } // namespace ui
@@ -0,0 +1,72 @@
+#ifndef UI_ROWBUFFER_H
+#define UI_ROWBUFFER_H
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include <ncurses.h>
+
+namespace ui {
+
+/**
+ * RowBuffer - Reusable chtype line for list-style widgets
+ *
+ * A row is composed in memory (text, attributes, padding) and written with
+ * a single mvwaddchnstr. Before writing, the target cells are read back and
+ * the write is skipped when they already hold the same row, so redrawing
+ * an unchanged list does not touch the window. The buffers grow to the
+ * widest row seen and are reused, so rendering does not allocate per row.
+ *
+ * Text is copied byte for byte; control characters become spaces.
+ */
+class RowBuffer {
+public:
+    /**
+     * Start a new row of the given width filled with blanks
+     */
+    void reset(int width);
+
+    /**
+     * Write text at col, clipped to the row; returns the column after it
+     */
+    int put(int col, std::string_view text, attr_t attrs = A_NORMAL);
+
+    /**
+     * Write text in at most max_width cells, ending in "..." when cut
+     */
+    int put_truncated(int col, std::string_view text, int max_width, attr_t attrs = A_NORMAL);
+
+    /**
+     * Write a decimal number; returns the column after it
+     */
+    int put_number(int col, long value, attr_t attrs = A_NORMAL);
+
+    int width() const { return width_; }
+    const chtype* cells() const { return cells_.data(); }
+
+    /**
+     * Copy the row to win at (y, x) unless those cells already match.
+     * Returns true if the window was written.
+     */
+    bool draw(WINDOW* win, int y, int x);
+
+    uint64_t rows_drawn() const { return rows_drawn_; }
+    uint64_t rows_skipped() const { return rows_skipped_; }
+
+private:
+    std::vector<chtype> cells_;
+    std::vector<chtype> screen_;  // read-back scratch for draw()
+    int width_ = 0;
+    uint64_t rows_drawn_ = 0;
+    uint64_t rows_skipped_ = 0;
+};
+
+/**
+ * Draw a border around (x, y, width, height) with native line characters
+ * and an optional title in the top edge.
+ */
+void draw_frame(WINDOW* win, int x, int y, int width, int height, std::string_view title = {});
+
+} // namespace ui
+
+#endif // UI_ROWBUFFER_H
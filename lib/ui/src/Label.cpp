@@ -1,6 +1,5 @@
 #include "ui/Label.h"
 #include <algorithm>
-#include <sstream>
 #include <vector>
 
 namespace ui {
@@ -40,7 +39,11 @@ Label::Label(const Rect& bounds, const std::string& text)
 }
 
 void Label::set_text(const std::string& text) {
+    if (text == text_) {
+        return;  // keep the cached layout
+    }
     text_ = text;
+    layout_.invalidate();
     
     // Auto-adjust width for single-line labels
     if (bounds_.size.height == 1 && !word_wrap_) {
@@ -74,8 +77,8 @@ void Label::render(WINDOW* parent_window) {
         wattron(parent_window, COLOR_PAIR(color_pair_));
     }
     
-    // Get lines to render
-    std::vector<std::string> lines = get_lines();
+    // Get lines to render (laid out once per text/width change)
+    const std::vector<std::string>& lines = get_lines();
     
     // Render each line
     int line_num = 0;
@@ -85,27 +88,24 @@ void Label::render(WINDOW* parent_window) {
         }
         
         int line_y = y + line_num;
-        std::string display_line = line;
         
-        // Truncate or pad based on width
-        if (static_cast<int>(display_line.length()) > width) {
-            display_line = display_line.substr(0, width);
-        }
+        // Truncate to width without copying
+        int length = std::min(static_cast<int>(line.length()), std::max(0, width));
         
         // Calculate x position based on alignment
         int line_x = x;
         if (alignment_ == Alignment::CENTER) {
-            int padding = (width - display_line.length()) / 2;
+            int padding = (width - length) / 2;
             line_x = x + std::max(0, padding);
         } else if (alignment_ == Alignment::RIGHT) {
-            int padding = width - display_line.length();
+            int padding = width - length;
             line_x = x + std::max(0, padding);
         }
         
         // Draw the text (mvwprintw clears to end of line)
         wmove(parent_window, line_y, x);
         wclrtoeol(parent_window);
-        mvwprintw(parent_window, line_y, line_x, "%s", display_line.c_str());
+        mvwaddnstr(parent_window, line_y, line_x, line.c_str(), length);
         
         line_num++;
     }
@@ -129,68 +129,10 @@ Size Label::get_preferred_size() const {
     }
 }
 
-std::vector<std::string> Label::get_lines() const {
-    if (word_wrap_ && bounds_.size.width > 0) {
-        // Wrap text to fit width
-        return wrap_text(text_, bounds_.size.width);
-    } else {
-        // Single line or multi-line without wrapping
-        std::vector<std::string> lines;
-        std::istringstream iss(text_);
-        std::string line;
-        while (std::getline(iss, line)) {
-            lines.push_back(line);
-        }
-        
-        if (lines.empty() && !text_.empty()) {
-            lines.push_back(text_);
-        }
-        
-        return lines;
-    }
-}
-
-std::vector<std::string> Label::wrap_text(const std::string& text, int width) const {
-    std::vector<std::string> lines;
-    
-    if (width <= 0) {
-        return lines;
-    }
-    
-    std::istringstream iss(text);
-    std::string line;
-    
-    while (std::getline(iss, line)) {
-        // Process each line (handle existing newlines)
-        if (line.empty()) {
-            lines.push_back("");
-            continue;
-        }
-        
-        // Word wrap this line
-        std::string current_line;
-        std::istringstream line_stream(line);
-        std::string word;
-        
-        while (line_stream >> word) {
-            // Check if adding this word would exceed width
-            if (current_line.empty()) {
-                current_line = word;
-            } else if (static_cast<int>(current_line.length() + 1 + word.length()) <= width) {
-                current_line += " " + word;
-            } else {
-                // Start a new line
-                lines.push_back(current_line);
-                current_line = word;
-            }
-        }
-        
-        if (!current_line.empty()) {
-            lines.push_back(current_line);
-        }
-    }
-    
-    return lines;
+const std::vector<std::string>& Label::get_lines() {
+    // Wrap to width, or split on newlines only
+    WrapMode mode = (word_wrap_ && bounds_.size.width > 0) ? WrapMode::LINES : WrapMode::NONE;
+    return layout_.lines(text_, bounds_.size.width, mode);
 }
 
 } // namespace ui
@@ -0,0 +1,100 @@
+#include "ui/LayoutCache.h"
+#include <sstream>
+
+namespace ui {
+
+namespace {
+
+// Greedy word wrap of one paragraph; whitespace runs collapse to one space
+void wrap_words(const std::string& text, int width, std::vector<std::string>& lines) {
+    std::istringstream stream(text);
+    std::string word;
+    std::string current_line;
+
+    while (stream >> word) {
+        if (current_line.empty()) {
+            current_line = word;
+        } else if (static_cast<int>(current_line.length() + 1 + word.length()) <= width) {
+            current_line += " " + word;
+        } else {
+            lines.push_back(current_line);
+            current_line = word;
+        }
+    }
+
+    if (!current_line.empty()) {
+        lines.push_back(current_line);
+    }
+}
+
+} // namespace
+
+std::vector<std::string> layout_text(const std::string& text, int width, WrapMode mode) {
+    std::vector<std::string> lines;
+
+    if (mode == WrapMode::FLOW) {
+        if (width > 0) {
+            wrap_words(text, width, lines);
+        }
+        return lines;
+    }
+
+    if (mode == WrapMode::LINES && width <= 0) {
+        return lines;
+    }
+
+    std::istringstream iss(text);
+    std::string line;
+    while (std::getline(iss, line)) {
+        if (mode == WrapMode::NONE) {
+            lines.push_back(line);
+        } else if (line.empty()) {
+            lines.push_back("");
+        } else {
+            wrap_words(line, width, lines);
+        }
+    }
+
+    if (mode == WrapMode::NONE && lines.empty() && !text.empty()) {
+        lines.push_back(text);
+    }
+    return lines;
+}
+
+const std::vector<std::string>& TextLayout::lines(const std::string& text, int width, WrapMode mode) {
+    if (!valid_ || cached_revision_ != revision_ || cached_width_ != width || cached_mode_ != mode) {
+        lines_ = layout_text(text, width, mode);
+        valid_ = true;
+        cached_revision_ = revision_;
+        cached_width_ = width;
+        cached_mode_ = mode;
+        ++layouts_;
+    }
+    return lines_;
+}
+
+WINDOW* SubWindow::get(WINDOW* parent, int height, int width, int y, int x) {
+    if (window_ && parent == parent_ && height == height_ && width == width_ && y == y_ && x == x_) {
+        return window_;
+    }
+
+    reset();
+    window_ = derwin(parent, height, width, y, x);
+    if (window_) {
+        parent_ = parent;
+        height_ = height;
+        width_ = width;
+        y_ = y;
+        x_ = x;
+    }
+    return window_;
+}
+
+void SubWindow::reset() {
+    if (window_) {
+        delwin(window_);
+        window_ = nullptr;
+    }
+}
+
+} // namespace ui
@@ -59,25 +59,7 @@ void ListBox::render(WINDOW* parent_window) {
     
     // Draw border if enabled
     if (bordered_) {
-        for (int i = 0; i < height; ++i) {
-            mvwprintw(parent_window, y + i, x, "|");
-            mvwprintw(parent_window, y + i, x + width - 1, "|");
-        }
-        for (int i = 0; i < width; ++i) {
-            mvwprintw(parent_window, y, x + i, "-");
-            mvwprintw(parent_window, y + height - 1, x + i, "-");
-        }
-        mvwprintw(parent_window, y, x, "+");
-        mvwprintw(parent_window, y, x + width - 1, "+");
-        mvwprintw(parent_window, y + height - 1, x, "+");
-        mvwprintw(parent_window, y + height - 1, x + width - 1, "+");
-        
-        // Draw title
-        if (!title_.empty() && width > 4) {
-            int title_len = std::min(static_cast<int>(title_.size()), width - 4);
-            std::string display_title = " " + title_.substr(0, title_len) + " ";
-            mvwprintw(parent_window, y, x + 2, "%s", display_title.c_str());
-        }
+        draw_frame(parent_window, x, y, width, height, title_);
     }
     
     // Calculate content area
@@ -90,28 +72,16 @@ void ListBox::render(WINDOW* parent_window) {
     int visible_count = std::min(visible_height, static_cast<int>(items_.size()) - scroll_offset_);
     
     for (int i = 0; i < visible_count; ++i) {
-        int item_index = scroll_offset_ + i;
-        const std::string& item = items_[item_index];
-        
-        int item_y = content_y + i;
-        
-        // Clear line
-        std::string blank(content_width, ' ');
-        mvwprintw(parent_window, item_y, content_x, "%s", blank.c_str());
-        
         // Draw item text (truncate if needed)
-        std::string display_text = item;
-        if (static_cast<int>(display_text.length()) > content_width) {
-            display_text = display_text.substr(0, content_width - 3) + "...";
-        }
-        
-        mvwprintw(parent_window, item_y, content_x, "%s", display_text.c_str());
+        row_.reset(content_width);
+        row_.put_truncated(0, items_[scroll_offset_ + i], content_width);
+        row_.draw(parent_window, content_y + i, content_x);
     }
     
     // Clear remaining lines if list is shorter than visible area
-    for (int i = visible_count; i < visible_height; ++i) {
-        std::string blank(content_width, ' ');
-        mvwprintw(parent_window, content_y + i, content_x, "%s", blank.c_str());
+    row_.reset(content_width);
+    for (int i = std::max(visible_count, 0); i < visible_height; ++i) {
+        row_.draw(parent_window, content_y + i, content_x);
     }
 }
 
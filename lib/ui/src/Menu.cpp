@@ -65,12 +65,16 @@ void Menu::remove_item(size_t index) {
 
 void Menu::clear_items() {
     items_.clear();
+    provider_ = nullptr;
+    virtual_count_ = 0;
     selected_index_ = -1;
     scroll_offset_ = 0;
 }
 
 void Menu::set_items(const std::vector<MenuItem>& items) {
     items_ = items;
+    provider_ = nullptr;
+    virtual_count_ = 0;
     selected_index_ = -1;
     scroll_offset_ = 0;
     
@@ -83,6 +87,37 @@ void Menu::set_items(const std::vector<MenuItem>& items) {
     }
 }
 
+void Menu::set_virtual(ItemProvider provider, size_t count) {
+    items_.clear();
+    provider_ = std::move(provider);
+    virtual_count_ = count;
+    selected_index_ = count > 0 ? 0 : -1;
+    scroll_offset_ = 0;
+}
+
+void Menu::set_virtual_count(size_t count) {
+    virtual_count_ = count;
+    if (selected_index_ >= static_cast<int>(count)) {
+        selected_index_ = static_cast<int>(count) - 1;
+    } else if (selected_index_ < 0 && count > 0) {
+        selected_index_ = 0;
+    }
+    scroll_offset_ = std::min(scroll_offset_, std::max(0, static_cast<int>(count) - get_visible_height()));
+    ensure_selection_visible();
+}
+
+const MenuItem* Menu::find_item(size_t index) const {
+    if (provider_) {
+        return index < virtual_count_ ? provider_(index) : nullptr;
+    }
+    return index < items_.size() ? &items_[index] : nullptr;
+}
+
+bool Menu::is_item_enabled(size_t index) const {
+    const MenuItem* item = find_item(index);
+    return item ? item->enabled : index < get_item_count();
+}
+
 void Menu::set_item(size_t index, const MenuItem& item) {
     if (index < items_.size()) {
         items_[index] = item;
@@ -90,12 +125,12 @@ void Menu::set_item(size_t index, const MenuItem& item) {
 }
 
 void Menu::set_selected_index(int index) {
-    if (index < -1 || index >= static_cast<int>(items_.size())) {
+    if (index < -1 || index >= static_cast<int>(get_item_count())) {
         return;
     }
     
     // Skip disabled items
-    if (index >= 0 && !items_[index].enabled) {
+    if (index >= 0 && !is_item_enabled(index)) {
         return;
     }
     
@@ -105,15 +140,14 @@ void Menu::set_selected_index(int index) {
     ensure_selection_visible();
     
     if (old_index != selected_index_ && on_select_ && selected_index_ >= 0) {
-        on_select_(selected_index_, items_[selected_index_]);
+        if (const MenuItem* item = find_item(selected_index_)) {
+            on_select_(selected_index_, *item);
+        }
     }
 }
 
 const MenuItem* Menu::get_selected_item() const {
-    if (selected_index_ >= 0 && selected_index_ < static_cast<int>(items_.size())) {
-        return &items_[selected_index_];
-    }
-    return nullptr;
+    return selected_index_ >= 0 ? find_item(selected_index_) : nullptr;
 }
 
 void Menu::render() {
@@ -136,25 +170,7 @@ void Menu::render(WINDOW* parent_window) {
     
     // Draw border if enabled
     if (bordered_) {
-        for (int i = 0; i < height; ++i) {
-            mvwprintw(parent_window, y + i, x, "|");
-            mvwprintw(parent_window, y + i, x + width - 1, "|");
-        }
-        for (int i = 0; i < width; ++i) {
-            mvwprintw(parent_window, y, x + i, "-");
-            mvwprintw(parent_window, y + height - 1, x + i, "-");
-        }
-        mvwprintw(parent_window, y, x, "+");
-        mvwprintw(parent_window, y, x + width - 1, "+");
-        mvwprintw(parent_window, y + height - 1, x, "+");
-        mvwprintw(parent_window, y + height - 1, x + width - 1, "+");
-        
-        // Draw title
-        if (!title_.empty() && width > 4) {
-            int title_len = std::min(static_cast<int>(title_.size()), width - 4);
-            std::string display_title = " " + title_.substr(0, title_len) + " ";
-            mvwprintw(parent_window, y, x + 2, "%s", display_title.c_str());
-        }
+        draw_frame(parent_window, x, y, width, height, title_);
     }
     
     // Calculate content area
@@ -164,75 +180,73 @@ void Menu::render(WINDOW* parent_window) {
     int visible_height = get_visible_height();
     
     // Draw items
-    int visible_count = std::min(visible_height, static_cast<int>(items_.size()) - scroll_offset_);
+    int item_count = static_cast<int>(get_item_count());
+    int visible_count = std::min(visible_height, item_count - scroll_offset_);
+    int first_missing = -1;
+    static const MenuItem placeholder("...", "", false);
     
     for (int i = 0; i < visible_count; ++i) {
         int item_index = scroll_offset_ + i;
-        const MenuItem& item = items_[item_index];
-        
-        int item_y = content_y + i;
-        
-        // Clear line
-        std::string blank(content_width, ' ');
-        mvwprintw(parent_window, item_y, content_x, "%s", blank.c_str());
+        const MenuItem* loaded = find_item(item_index);
+        if (!loaded && first_missing < 0) {
+            first_missing = item_index;
+        }
+        const MenuItem& item = loaded ? *loaded : placeholder;
         
         // Determine style
         bool is_selected = (item_index == selected_index_);
-        bool is_focused_selected = is_selected && focused_;
-        
-        if (is_focused_selected) {
-            wattron(parent_window, A_REVERSE);
+        attr_t attrs = A_NORMAL;
+        if (is_selected && focused_) {
+            attrs = A_REVERSE;
         } else if (is_selected) {
-            wattron(parent_window, A_BOLD);
+            attrs = A_BOLD;
         } else if (!item.enabled) {
-            wattron(parent_window, A_DIM);
+            attrs = A_DIM;
         }
         
-        // Draw item text
-        int text_x = content_x;
-        std::string prefix = "";
-        
+        // Compose the row: prefix, text, right-aligned secondary text
+        row_.reset(content_width);
+        int col = 0;
         if (numbered_) {
-            prefix = std::to_string(item_index + 1) + ". ";
-        } else if (is_selected) {
-            prefix = "> ";
+            col = row_.put_number(col, item_index + 1, attrs);
+            col = row_.put(col, ". ", attrs);
         } else {
-            prefix = "  ";
+            col = row_.put(col, is_selected ? "> " : "  ", attrs);
         }
         
-        int available_width = content_width - prefix.length();
+        int available_width = content_width - col;
         if (!item.secondary_text.empty()) {
             available_width -= item.secondary_text.length() + 1;
         }
+        row_.put_truncated(col, item.text, available_width, attrs);
         
-        std::string display_text = item.text;
-        if (static_cast<int>(display_text.length()) > available_width) {
-            display_text = display_text.substr(0, available_width - 3) + "...";
-        }
-        
-        mvwprintw(parent_window, item_y, text_x, "%s%s", prefix.c_str(), display_text.c_str());
-        
-        // Draw secondary text (right-aligned)
         if (!item.secondary_text.empty()) {
-            int sec_x = content_x + content_width - item.secondary_text.length();
-            mvwprintw(parent_window, item_y, sec_x, "%s", item.secondary_text.c_str());
+            int sec_col = content_width - static_cast<int>(item.secondary_text.length());
+            row_.put(sec_col, item.secondary_text, attrs);
         }
         
-        if (is_focused_selected) {
-            wattroff(parent_window, A_REVERSE);
-        } else if (is_selected) {
-            wattroff(parent_window, A_BOLD);
-        } else if (!item.enabled) {
-            wattroff(parent_window, A_DIM);
+        row_.draw(parent_window, content_y + i, content_x);
+    }
+    
+    // Ask for missing rows on screen, or for the next screenful ahead of time
+    if (provider_ && on_items_needed_) {
+        int lookahead_end = std::min(item_count, scroll_offset_ + 2 * visible_height);
+        for (int index = scroll_offset_ + std::max(visible_count, 0); first_missing < 0 && index < lookahead_end; ++index) {
+            if (!find_item(index)) {
+                first_missing = index;
+            }
+        }
+        if (first_missing >= 0) {
+            on_items_needed_(first_missing);
         }
     }
     
     // Draw scroll indicators if needed
-    if (bordered_ && items_.size() > static_cast<size_t>(visible_height)) {
+    if (bordered_ && item_count > visible_height) {
         if (scroll_offset_ > 0) {
             mvwprintw(parent_window, content_y - 1, x + width - 2, "^");
         }
-        if (scroll_offset_ + visible_height < static_cast<int>(items_.size())) {
+        if (scroll_offset_ + visible_height < item_count) {
             mvwprintw(parent_window, content_y + visible_height, x + width - 2, "v");
         }
     }
@@ -273,7 +287,7 @@ bool Menu::handle_event(const Event& event) {
     // Number key selection (if numbered)
     if (numbered_ && key >= '1' && key <= '9') {
         int index = (key - '1');
-        if (index < static_cast<int>(items_.size()) && items_[index].enabled) {
+        if (index < static_cast<int>(get_item_count()) && is_item_enabled(index)) {
             set_selected_index(index);
             activate_selected();
             return true;
@@ -303,7 +317,7 @@ Size Menu::get_preferred_size() const {
         max_width += 2;
     }
     
-    int height = items_.size();
+    int height = get_item_count();
     if (bordered_) {
         height += 2;
     }
@@ -321,13 +335,13 @@ void Menu::on_focus_lost() {
 }
 
 void Menu::move_selection_up() {
-    if (items_.empty() || selected_index_ < 0) {
+    if (get_item_count() == 0 || selected_index_ < 0) {
         return;
     }
     
     // Find previous enabled item
     int new_index = selected_index_ - 1;
-    while (new_index >= 0 && !items_[new_index].enabled) {
+    while (new_index >= 0 && !is_item_enabled(new_index)) {
         new_index--;
     }
     
@@ -337,24 +351,25 @@ void Menu::move_selection_up() {
 }
 
 void Menu::move_selection_down() {
-    if (items_.empty()) {
+    int count = static_cast<int>(get_item_count());
+    if (count == 0) {
         return;
     }
     
     // Find next enabled item
     int new_index = (selected_index_ < 0) ? 0 : selected_index_ + 1;
-    while (new_index < static_cast<int>(items_.size()) && !items_[new_index].enabled) {
+    while (new_index < count && !is_item_enabled(new_index)) {
         new_index++;
     }
     
-    if (new_index < static_cast<int>(items_.size())) {
+    if (new_index < count) {
         set_selected_index(new_index);
     }
 }
 
 void Menu::move_selection_home() {
-    for (size_t i = 0; i < items_.size(); ++i) {
-        if (items_[i].enabled) {
+    for (size_t i = 0; i < get_item_count(); ++i) {
+        if (is_item_enabled(i)) {
             set_selected_index(i);
             break;
         }
@@ -362,8 +377,8 @@ void Menu::move_selection_home() {
 }
 
 void Menu::move_selection_end() {
-    for (int i = items_.size() - 1; i >= 0; --i) {
-        if (items_[i].enabled) {
+    for (int i = static_cast<int>(get_item_count()) - 1; i >= 0; --i) {
+        if (is_item_enabled(i)) {
             set_selected_index(i);
             break;
         }
@@ -371,11 +386,10 @@ void Menu::move_selection_end() {
 }
 
 void Menu::activate_selected() {
-    if (selected_index_ >= 0 && selected_index_ < static_cast<int>(items_.size())) {
-        const MenuItem& item = items_[selected_index_];
-        if (item.enabled && on_activate_) {
-            on_activate_(selected_index_, item);
-        }
+    // Unloaded rows cannot be activated until their item arrives
+    const MenuItem* item = get_selected_item();
+    if (item && item->enabled && on_activate_) {
+        on_activate_(selected_index_, *item);
     }
 }
 
@@ -1,6 +1,5 @@
 #include "ui/MessageBox.h"
 #include <algorithm>
-#include <sstream>
 #include <cstring>
 
 namespace ui {
@@ -30,8 +29,8 @@ void MessageBox::render(WINDOW* parent) {
     int start_y = (max_y - height_) / 2;
     int start_x = (max_x - width_) / 2;
     
-    // Create window for message box
-    WINDOW* box_win = derwin(parent, height_, width_, start_y, start_x);
+    // Reuse the message box window unless the parent was resized
+    WINDOW* box_win = box_window_.get(parent, height_, width_, start_y, start_x);
     if (!box_win) return;
 
     // Apply a dedicated popup color pair (configured in UIManager) for a darker blue tone
@@ -48,7 +47,7 @@ void MessageBox::render(WINDOW* parent) {
     mvwprintw(box_win, 0, title_x, "[ %s ]", title_.c_str());
     
     // Wrap and display message
-    std::vector<std::string> lines = wrap_text(message_, width_ - 4);
+    const std::vector<std::string>& lines = layout_.lines(message_, width_ - 4, WrapMode::FLOW);
     int message_start_y = (height_ - lines.size() - 2) / 2;
     
     for (size_t i = 0; i < lines.size() && i < (size_t)(height_ - 4); i++) {
@@ -68,7 +67,6 @@ void MessageBox::render(WINDOW* parent) {
     }
     
     wrefresh(box_win);
-    delwin(box_win);
 }
 
 bool MessageBox::handle_event(const Event& event) {
@@ -90,6 +88,7 @@ bool MessageBox::handle_event(const Event& event) {
 
 void MessageBox::set_message(const std::string& message) {
     message_ = message;
+    layout_.invalidate();
 }
 
 void MessageBox::set_title(const std::string& title) {
@@ -100,28 +99,4 @@ void MessageBox::set_on_close(std::function<void()> callback) {
     on_close_ = callback;
 }
 
-std::vector<std::string> MessageBox::wrap_text(const std::string& text, int max_width) {
-    std::vector<std::string> lines;
-    std::istringstream stream(text);
-    std::string word;
-    std::string current_line;
-    
-    while (stream >> word) {
-        if (current_line.empty()) {
-            current_line = word;
-        } else if (current_line.length() + 1 + word.length() <= (size_t)max_width) {
-            current_line += " " + word;
-        } else {
-            lines.push_back(current_line);
-            current_line = word;
-        }
-    }
-    
-    if (!current_line.empty()) {
-        lines.push_back(current_line);
-    }
-    
-    return lines;
-}
-
 } // namespace ui
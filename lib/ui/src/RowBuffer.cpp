@@ -0,0 +1,99 @@
+#include "ui/RowBuffer.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+namespace ui {
+
+void RowBuffer::reset(int width) {
+    width_ = std::max(0, width);
+    // One extra cell so the row can be handed to ncurses null-terminated
+    if (cells_.size() < static_cast<size_t>(width_) + 1) {
+        cells_.resize(width_ + 1);
+    }
+    std::fill(cells_.begin(), cells_.begin() + width_, static_cast<chtype>(' '));
+    cells_[width_] = 0;
+}
+
+int RowBuffer::put(int col, std::string_view text, attr_t attrs) {
+    if (col < 0) {
+        col = 0;
+    }
+    for (char c : text) {
+        if (col >= width_) {
+            break;
+        }
+        unsigned char byte = static_cast<unsigned char>(c);
+        if (byte < 0x20 || byte == 0x7f) {
+            byte = ' ';
+        }
+        cells_[col++] = static_cast<chtype>(byte) | attrs;
+    }
+    return col;
+}
+
+int RowBuffer::put_truncated(int col, std::string_view text, int max_width, attr_t attrs) {
+    if (max_width <= 0) {
+        return col;
+    }
+    if (static_cast<int>(text.size()) <= max_width) {
+        return put(col, text, attrs);
+    }
+    if (max_width <= 3) {
+        return put(col, text.substr(0, max_width), attrs);
+    }
+    col = put(col, text.substr(0, max_width - 3), attrs);
+    return put(col, "...", attrs);
+}
+
+int RowBuffer::put_number(int col, long value, attr_t attrs) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    return put(col, std::string_view(digits, result.ptr - digits), attrs);
+}
+
+bool RowBuffer::draw(WINDOW* win, int y, int x) {
+    if (!win || width_ <= 0) {
+        return false;
+    }
+    int count = std::min(width_, getmaxx(win) - x);
+    if (count <= 0 || y < 0 || y >= getmaxy(win)) {
+        return false;
+    }
+
+    if (screen_.size() < static_cast<size_t>(count) + 1) {
+        screen_.resize(count + 1);
+    }
+    int read = mvwinchnstr(win, y, x, screen_.data(), count);
+    if (read == count && std::memcmp(screen_.data(), cells_.data(), count * sizeof(chtype)) == 0) {
+        ++rows_skipped_;
+        return false;
+    }
+
+    mvwaddchnstr(win, y, x, cells_.data(), count);
+    ++rows_drawn_;
+    return true;
+}
+
+void draw_frame(WINDOW* win, int x, int y, int width, int height, std::string_view title) {
+    if (!win || width < 2 || height < 2) {
+        return;
+    }
+    mvwaddch(win, y, x, ACS_ULCORNER);
+    mvwhline(win, y, x + 1, ACS_HLINE, width - 2);
+    mvwaddch(win, y, x + width - 1, ACS_URCORNER);
+    mvwvline(win, y + 1, x, ACS_VLINE, height - 2);
+    mvwvline(win, y + 1, x + width - 1, ACS_VLINE, height - 2);
+    mvwaddch(win, y + height - 1, x, ACS_LLCORNER);
+    mvwhline(win, y + height - 1, x + 1, ACS_HLINE, width - 2);
+    mvwaddch(win, y + height - 1, x + width - 1, ACS_LRCORNER);
+
+    if (!title.empty() && width > 4) {
+        int title_len = std::min(static_cast<int>(title.size()), width - 4);
+        mvwaddch(win, y, x + 2, ' ');
+        waddnstr(win, title.data(), title_len);
+        waddch(win, ' ');
+    }
+}
+
+} // namespace ui
@@ -1,4 +1,6 @@
 #include "auth/AuthServer.h"
+#include "auth/FileUserRepository.h"
+#include "auth/SessionStore.h"
 #include <iostream>
 #include <signal.h>
 #include <fstream>
@@ -16,6 +18,10 @@ void signal_handler(int signal) {
 struct AuthConfig {
     int port = 3001;
     std::string user_db_path = "users.json";
+    std::string unix_socket_path;
+    std::string shm_name;
+    std::string session_path;
+    int snapshot_interval_seconds = 300;
 };
 
 AuthConfig load_config() {
@@ -29,6 +35,10 @@ AuthConfig load_config() {
         file >> j;
         if (j.contains("port")) cfg.port = j.value("port", cfg.port);
         if (j.contains("user_db_path")) cfg.user_db_path = j.value("user_db_path", cfg.user_db_path);
+        if (j.contains("unix_socket_path")) cfg.unix_socket_path = j.value("unix_socket_path", cfg.unix_socket_path);
+        if (j.contains("shm_name")) cfg.shm_name = j.value("shm_name", cfg.shm_name);
+        if (j.contains("session_path")) cfg.session_path = j.value("session_path", cfg.session_path);
+        if (j.contains("snapshot_interval_seconds")) cfg.snapshot_interval_seconds = j.value("snapshot_interval_seconds", cfg.snapshot_interval_seconds);
     } catch (const std::exception& ex) {
         std::cerr << "Failed to parse config/auth_config.json: " << ex.what() << "\n";
     }
@@ -43,7 +53,15 @@ int main(int argc, char* argv[]) {
         cfg.port = std::atoi(argv[1]);
     }
     
-    AuthServer server(cfg.port, cfg.user_db_path);
+    // Sessions survive restarts when session_path is set
+    std::shared_ptr<SessionStore> session_store;
+    if (!cfg.session_path.empty()) {
+        session_store = std::make_shared<SessionStore>(cfg.session_path);
+    }
+    auto auth_manager = std::make_shared<AuthManager>(
+        std::make_shared<FileUserRepository>(cfg.user_db_path), session_store);
+    
+    AuthServer server(auth_manager, cfg.port, cfg.unix_socket_path, cfg.shm_name);
     g_server = &server;
     
     // Set up signal handlers for graceful shutdown
@@ -53,10 +71,17 @@ int main(int argc, char* argv[]) {
     server.start();
     
     if (server.is_running()) {
-        // Keep main thread alive
+        // Keep main thread alive; periodically drop expired sessions and compact the log
+        int seconds = 0;
         while (server.is_running()) {
             std::this_thread::sleep_for(std::chrono::seconds(1));
+            if (session_store && cfg.snapshot_interval_seconds > 0 &&
+                ++seconds % cfg.snapshot_interval_seconds == 0) {
+                auth_manager->cleanup_expired_tokens();
+                auth_manager->snapshot_sessions();
+            }
         }
+        auth_manager->snapshot_sessions();
     }
     
     return 0;
@@ -2,7 +2,6 @@
 #include "NetworkManager.h"
 #include "auth/AuthClient.h"
 #include "common/NetworkMessage.h"
-#include <sstream>
 #include <chrono>
 #include <iostream>
 #include <sys/socket.h>
@@ -10,10 +9,10 @@
 using namespace std::chrono_literals;
 
 ApplicationManager::ApplicationManager(
-    ThreadSafeQueue<std::string>& network_inbound,
+    ThreadSafeQueue<ServerEvent>& network_inbound,
     ThreadSafeQueue<std::string>& network_outbound,
     ThreadSafeQueue<UICommand>& ui_commands,
-    ThreadSafeQueue<std::string>& input_events,
+    ThreadSafeQueue<InputEvent>& input_events,
     NetworkManager* network_manager,
     const std::string& auth_host,
     int auth_port,
@@ -52,6 +51,154 @@ void ApplicationManager::stop() {
     if (app_thread_.joinable()) {
         app_thread_.join();
     }
+    cancel_login();
+}
+
+void ApplicationManager::start_login(const std::string& username, const std::string& password) {
+    login_.emplace();
+    PendingLogin& login = *login_;
+    login.attempt = ++login_attempts_;
+    InputEvent step_event(InputEventType::LOGIN_STEP, login.attempt);
+    
+    push_ui(UICommand(UICommandType::SHOW_STATUS, StatusData{"Logging in..."}));
+    
+    if (network_manager_) {
+        // The previous session ends here, on this thread: once its network
+        // thread is joined, nothing it read or queued can reach the new one
+        network_manager_->stop();
+        network_inbound_.clear();
+        network_outbound_.clear();
+        credit_open_ = false;
+        in_room_ = false;
+        room_view_ = RoomListView{};
+    }
+    
+    // Both legs start now, so login takes max(auth, connect) rather than the sum
+    std::promise<AuthResult> auth_promise;
+    login.auth = auth_promise.get_future().share();
+    login.auth_thread = std::thread(
+        [this, promise = std::move(auth_promise), step_event, username, password,
+         host = auth_host_, port = auth_port_]() mutable {
+            AuthClient auth_client(host, port);
+            promise.set_value(auth_client.authenticate(username, password));
+            input_events_.push(step_event);
+        });
+    
+    std::promise<std::string> connect_promise;
+    login.connect = connect_promise.get_future().share();
+    login.connect_thread = std::thread(
+        [this, promise = std::move(connect_promise), step_event]() mutable {
+            std::string connect_error;
+            if (network_manager_) {
+                if (!network_manager_->connect(chat_host_, chat_port_, connect_error) && connect_error.empty()) {
+                    connect_error = "unknown error";
+                }
+            }
+            promise.set_value(connect_error);
+            input_events_.push(step_event);
+        });
+}
+
+void ApplicationManager::on_login_step(uint64_t attempt) {
+    if (!login_ || login_->attempt != attempt) {
+        return;  // a leftover from an attempt already cleaned up
+    }
+    PendingLogin& login = *login_;
+    
+    auto ready = [](const auto& future) {
+        return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    };
+    bool auth_ready = ready(login.auth);
+    bool connect_ready = ready(login.connect);
+    
+    // Report the first failure straight away, even if the other leg is still running
+    if (!login.error_shown) {
+        if (auth_ready) {
+            const AuthResult& result = login.auth.get();
+            if (!result.success) {
+                login.error_shown = true;
+                push_ui(UICommand(UICommandType::SHOW_ERROR,
+                    ErrorData{"Login failed: " + result.error_message}));
+            }
+        }
+        if (!login.error_shown && connect_ready && !login.connect.get().empty()) {
+            login.error_shown = true;
+            push_ui(UICommand(UICommandType::SHOW_ERROR,
+                ErrorData{"Failed to connect to chat server: " + login.connect.get()}));
+        }
+    }
+    
+    if (!auth_ready || !connect_ready) {
+        return;
+    }
+    
+    login.auth_thread.join();
+    login.connect_thread.join();
+    AuthResult result = login.auth.get();
+    bool failed = login.error_shown;
+    login_.reset();
+    
+    if (failed) {
+        // Auth was refused after the chat connection opened; drop it
+        if (network_manager_) {
+            network_manager_->stop();
+        }
+        return;
+    }
+    finish_login(result.token, result.display_name);
+}
+
+void ApplicationManager::finish_login(const std::string& token, const std::string& display_name) {
+    if (network_manager_) {
+        // Send token immediately (before starting network thread)
+        // Server expects token as the first message
+        auto auth_msg = NetworkMessage::create_auth(token, true);
+        std::string token_msg = auth_msg.serialize();
+        
+        int sock = network_manager_->get_socket();
+        ssize_t sent = send(sock, token_msg.c_str(), token_msg.length(), 0);
+        if (sent <= 0) {
+            network_manager_->stop();
+            push_ui(UICommand(UICommandType::SHOW_ERROR,
+                ErrorData{"Failed to send authentication token"}));
+            return;
+        }
+        
+        // Start network thread after token is sent
+        network_manager_->start();
+        
+        // Opt in to flow control with the initial window
+        network_outbound_.push(NetworkMessage::create_credit(token, CREDIT_WINDOW).serialize());
+        credit_open_ = true;
+        frames_since_credit_ = 0;
+        
+        // The server follows AUTH with the first page of rooms
+        room_view_ = RoomListView{};
+        room_view_.request = "";
+        room_view_.last_refresh = std::chrono::steady_clock::now();
+    }
+    
+    // Store token and display name
+    state_.set_token(token);
+    state_.set_username(display_name);  // Use display name for UI
+    state_.set_connected(true);
+    
+    // Wait for server's response handled in network messages
+    // Then wait for ROOM_PAGE (or ROOM_LIST) which will trigger SHOW_FOYER
+}
+
+void ApplicationManager::cancel_login() {
+    if (!login_) {
+        return;
+    }
+    // The legs cannot be interrupted; wait for them (bounded by the auth timeout)
+    if (login_->auth_thread.joinable()) {
+        login_->auth_thread.join();
+    }
+    if (login_->connect_thread.joinable()) {
+        login_->connect_thread.join();
+    }
+    login_.reset();
 }
 
 bool ApplicationManager::is_running() const {
@@ -64,235 +211,331 @@ const ApplicationState& ApplicationManager::get_state() const {
 
 void ApplicationManager::application_loop() {
     while (running_) {
-        // Process network messages
-        std::string net_msg;
-        if (network_inbound_.try_pop(net_msg, 10ms)) {
-            process_network_message(net_msg);
+        // Process network events: wait briefly for one, then take whatever else is ready
+        ServerEvent net_event;
+        if (network_inbound_.try_pop(net_event, 10ms)) {
+            size_t frames = 0;
+            do {
+                if (credit_open_ && net_event.type != ServerEventType::DISCONNECTED) {
+                    ++frames_since_credit_;
+                }
+                process_network_event(net_event);
+            } while (++frames < MAX_FRAMES_PER_TICK && network_inbound_.try_pop_immediate(net_event));
         }
+        flush_ui_updates(false);
+        refresh_rooms_if_stale();
+        return_credit();
         
-        // Process input events
-        std::string input_event;
+        // Process input events (QUIT is only a placeholder until try_pop fills it)
+        InputEvent input_event(InputEventType::QUIT);
         if (input_events_.try_pop(input_event, 10ms)) {
             process_input_event(input_event);
         }
     }
 }
 
-std::vector<RoomInfo> ApplicationManager::parse_room_list(const std::string& data) {
-    std::vector<RoomInfo> rooms;
-    std::istringstream stream(data);
-    std::string line;
-    bool started = false;
-    
-    while (std::getline(stream, line)) {
-        if (line == "ROOM_LIST") {
-            started = true;
-            continue;
-        }
-        if (line == "END_ROOM_LIST") {
-            break;
-        }
-        if (line.empty()) {
-            continue;
-        }
-        
-        if (started) {
-            size_t pipe_pos = line.find('|');
-            if (pipe_pos != std::string::npos) {
-                RoomInfo room;
-                room.name = line.substr(0, pipe_pos);
-                room.client_count = std::stoi(line.substr(pipe_pos + 1));
-                rooms.push_back(room);
-            }
-        }
+void ApplicationManager::return_credit() {
+    if (!credit_open_ || frames_since_credit_ < CREDIT_WINDOW / 2) {
+        return;
+    }
+    if (ui_commands_.size() >= UI_BACKLOG_LIMIT) {
+        return;  // UI is behind; let the server hold (and coalesce) for us
+    }
+    std::string frame;
+    NetworkMessage::write_credit(frame, state_.get_token(), frames_since_credit_);
+    network_outbound_.push(std::move(frame));
+    frames_since_credit_ = 0;
+}
+
+void ApplicationManager::request_room_page(bool from_start) {
+    if (!from_start && (room_view_.request || room_view_.next_cursor.empty())) {
+        return;  // already fetching, or nothing left to fetch
     }
     
-    return rooms;
+    std::string cursor = from_start ? "" : room_view_.next_cursor;
+    // A reload asks for everything loaded so far (the server caps the page)
+    size_t limit = from_start ? std::max(room_view_.loaded, ROOM_PAGE_SIZE) : ROOM_PAGE_SIZE;
+    if (from_start) {
+        room_view_.stale = false;
+        room_view_.last_refresh = std::chrono::steady_clock::now();
+    }
+    room_view_.request = cursor;
+    network_outbound_.push(NetworkMessage::create_list_rooms(state_.get_token(), room_view_.prefix,
+                                                             room_view_.sort, cursor, limit).serialize());
 }
 
-bool ApplicationManager::is_in_room() const {
-    return in_room_;
+void ApplicationManager::refresh_rooms_if_stale() {
+    if (!room_view_.stale || in_room_ || !credit_open_) {
+        return;
+    }
+    if (std::chrono::steady_clock::now() - room_view_.last_refresh >= ROOM_REFRESH_INTERVAL) {
+        request_room_page(true);
+    }
 }
 
-void ApplicationManager::process_network_message(const std::string& message) {
-    // Handle connection errors
-    if (message == "SERVER_DISCONNECTED\n" || message == "CONNECTION_ERROR\n") {
-        state_.set_connected(false);
-        state_.set_screen(ApplicationState::Screen::LOGIN);
-        ui_commands_.push(UICommand(UICommandType::SHOW_LOGIN));
-        ui_commands_.push(UICommand(UICommandType::SHOW_ERROR, 
-            ErrorData{"Connection lost"}));
+void ApplicationManager::handle_room_page(RoomPageReply& reply) {
+    // Pages for an older filter or reload are dropped
+    if (!room_view_.request || *room_view_.request != reply.cursor ||
+        reply.prefix != room_view_.prefix || reply.sort != room_view_.sort) {
         return;
     }
+    room_view_.request.reset();
+    room_view_.next_cursor = std::move(reply.next_cursor);
     
-    // Parse JSON message
-    auto net_msg = NetworkMessage::deserialize(message);
+    RoomPageData page;
+    page.append = !reply.cursor.empty();
+    page.total = reply.total;
+    page.prefix = std::move(reply.prefix);
+    page.sort = std::move(reply.sort);
+    page.rooms = std::move(reply.rooms);
     
-    if (net_msg.body.type == "ERROR") {
-        std::string error_msg = net_msg.body.data.value("message", "Unknown error");
-        ui_commands_.push(UICommand(UICommandType::SHOW_ERROR, ErrorData{error_msg}));
-        return;
+    if (page.append) {
+        for (const auto& room : page.rooms) {
+            state_.add_room(room);
+        }
+        room_view_.loaded += page.rooms.size();
+    } else {
+        state_.set_rooms(page.rooms);
+        room_view_.loaded = page.rooms.size();
     }
     
-    if (net_msg.body.type == "ROOM_JOINED") {
-        in_room_ = true;
-        std::string room_name = net_msg.body.data.value("room_name", "");
-        state_.set_current_room(room_name);
-        state_.set_screen(ApplicationState::Screen::CHATROOM);
-        state_.clear_chat_messages();
-        ui_commands_.push(UICommand(UICommandType::SHOW_CHATROOM, room_name));
+    if (!in_room_ && state_.get_screen() != ApplicationState::Screen::FOYER) {
+        state_.set_screen(ApplicationState::Screen::FOYER);
+        push_ui(UICommand(UICommandType::SHOW_FOYER, state_.get_username()));
     }
-    else if (net_msg.body.type == "LEFT_ROOM") {
-        in_room_ = false;
-        state_.set_current_room("");
-        state_.clear_chat_messages();
+    push_ui(UICommand(UICommandType::UPDATE_ROOM_PAGE, std::move(page)));
+}
+
+void ApplicationManager::set_tracing(std::shared_ptr<tracing::TraceLog> log, unsigned sample_every) {
+    trace_log_ = std::move(log);
+    trace_sample_ = trace_log_ ? sample_every : 0;
+}
+
+void ApplicationManager::trace_received(nlohmann::json& trace) {
+    if (!trace_log_ || trace.is_null()) {
+        return;
     }
-    else if (net_msg.body.type == "ROOM_LIST") {
-        std::vector<RoomInfo> rooms;
-        if (net_msg.body.data.contains("rooms") && net_msg.body.data["rooms"].is_array()) {
-            for (const auto& room_name : net_msg.body.data["rooms"]) {
-                RoomInfo info;
-                info.name = room_name.get<std::string>();
-                info.client_count = 0;  // Server can optionally provide this
-                rooms.push_back(info);
-            }
-        }
-        state_.set_rooms(rooms);
-        
-        // Only show foyer if not in a room
-        if (!in_room_) {
-            state_.set_screen(ApplicationState::Screen::FOYER);
-            ui_commands_.push(UICommand(UICommandType::SHOW_FOYER, state_.get_username()));
-            ui_commands_.push(UICommand(UICommandType::UPDATE_ROOM_LIST, 
-                RoomListData{rooms}));
-        }
+    tracing::stamp(trace, tracing::CLIENT_PROCESS);
+    pending_traces_.push_back(std::move(trace));
+}
+
+void ApplicationManager::push_ui(UICommand cmd) {
+    // Keep order: anything gathered so far belongs before this command
+    flush_ui_updates(true);
+    ui_commands_.push(std::move(cmd));
+}
+
+void ApplicationManager::queue_chat_message(std::string message) {
+    state_.add_chat_message(message);
+    pending_chat_.push_back(std::move(message));
+}
+
+void ApplicationManager::flush_ui_updates(bool force) {
+    if (pending_chat_.empty() && !pending_participants_ && !pending_rooms_) {
+        return;
     }
-    else if (net_msg.body.type == "MESSAGE") {
-        std::string sender = net_msg.body.data.value("sender", "Unknown");
-        std::string msg_text = net_msg.body.data.value("message", "");
-        std::string formatted = "[" + sender + "] " + msg_text;
-        
-        state_.add_chat_message(formatted);
-        ui_commands_.push(UICommand(UICommandType::ADD_CHAT_MESSAGE, 
-            ChatMessageData{formatted}));
+    
+    // The first update after a quiet spell goes out at once; the rest of a
+    // burst waits for the next frame
+    auto now = std::chrono::steady_clock::now();
+    if (!force && now - last_ui_flush_ < UI_FRAME_INTERVAL) {
+        return;
     }
-    else if (net_msg.body.type == "PARTICIPANT_LIST") {
-        std::vector<std::string> participants;
-        if (net_msg.body.data.contains("participants") && net_msg.body.data["participants"].is_array()) {
-            participants = net_msg.body.data["participants"].get<std::vector<std::string>>();
-        }
-        
+    last_ui_flush_ = now;
+    
+    if (pending_rooms_) {
+        ui_commands_.push(UICommand(UICommandType::UPDATE_ROOM_LIST, RoomListData{std::move(*pending_rooms_)}));
+        pending_rooms_.reset();
+    }
+    if (pending_participants_) {
         ui_commands_.push(UICommand(UICommandType::UPDATE_PARTICIPANTS,
-            ParticipantsData{participants}));
+            ParticipantsData{std::move(*pending_participants_)}));
+        pending_participants_.reset();
+    }
+    if (!pending_chat_.empty()) {
+        ui_commands_.push(UICommand(UICommandType::ADD_CHAT_MESSAGES,
+            ChatMessagesData{std::move(pending_chat_), std::move(pending_traces_)}));
+        pending_chat_.clear();
+        pending_traces_.clear();
     }
 }
 
-void ApplicationManager::process_input_event(const std::string& event) {
-    // Parse input event format: "EVENT_TYPE:data"
-    size_t colon_pos = event.find(':');
-    std::string event_type = (colon_pos != std::string::npos) 
-        ? event.substr(0, colon_pos) 
-        : event;
-    std::string event_data = (colon_pos != std::string::npos) 
-        ? event.substr(colon_pos + 1) 
-        : "";
-    
-    if (event_type == "LOGIN") {
-        // LOGIN:username:password
-        size_t second_colon = event_data.find(':');
-        if (second_colon == std::string::npos) {
-            ui_commands_.push(UICommand(UICommandType::SHOW_ERROR,
-                ErrorData{"Invalid login format"}));
-            return;
-        }
-        
-        std::string username = event_data.substr(0, second_colon);
-        std::string password = event_data.substr(second_colon + 1);
-        
-        // Authenticate with auth server
-        AuthClient auth_client(auth_host_, auth_port_);
-        AuthResult auth_result = auth_client.authenticate(username, password);
-        
-        if (!auth_result.success) {
-            ui_commands_.push(UICommand(UICommandType::SHOW_ERROR,
-                ErrorData{"Login failed: " + auth_result.error_message}));
-            return;
+bool ApplicationManager::is_in_room() const {
+    return in_room_;
+}
+
+void ApplicationManager::process_network_event(ServerEvent& event) {
+    switch (event.type) {
+        case ServerEventType::DISCONNECTED:
+            credit_open_ = false;
+            room_view_ = RoomListView{};
+            state_.set_connected(false);
+            state_.set_screen(ApplicationState::Screen::LOGIN);
+            push_ui(UICommand(UICommandType::SHOW_LOGIN));
+            push_ui(UICommand(UICommandType::SHOW_ERROR, ErrorData{"Connection lost"}));
+            break;
+            
+        case ServerEventType::SERVER_ERROR:
+            push_ui(UICommand(UICommandType::SHOW_ERROR, std::move(event.get<ErrorData>())));
+            break;
+            
+        case ServerEventType::ROOM_JOINED: {
+            std::string& room_name = event.get<std::string>();
+            in_room_ = true;
+            state_.set_current_room(room_name);
+            state_.set_screen(ApplicationState::Screen::CHATROOM);
+            state_.clear_chat_messages();
+            push_ui(UICommand(UICommandType::SHOW_CHATROOM, std::move(room_name)));
+            break;
         }
-        
-        // Connect to chat server now that we have a token
-        if (network_manager_) {
-            std::string connect_error;
-            if (!network_manager_->connect(chat_host_, chat_port_, connect_error)) {
-                ui_commands_.push(UICommand(UICommandType::SHOW_ERROR,
-                    ErrorData{"Failed to connect to chat server: " + connect_error}));
-                return;
+            
+        case ServerEventType::LEFT_ROOM:
+            in_room_ = false;
+            state_.set_current_room("");
+            state_.clear_chat_messages();
+            // Back in the foyer: reload the rooms that were showing
+            request_room_page(true);
+            break;
+            
+        case ServerEventType::ROOM_LIST: {
+            auto& rooms = event.get<RoomListData>().rooms;
+            state_.set_rooms(rooms);
+            
+            // Only show foyer if not in a room; later lists just replace the pending one
+            if (!in_room_) {
+                if (state_.get_screen() != ApplicationState::Screen::FOYER) {
+                    state_.set_screen(ApplicationState::Screen::FOYER);
+                    push_ui(UICommand(UICommandType::SHOW_FOYER, state_.get_username()));
+                }
+                pending_rooms_ = std::move(rooms);
             }
+            break;
+        }
             
-            // Send token immediately (before starting network thread)
-            // Server expects token as the first message
-            auto auth_msg = NetworkMessage::create_auth(auth_result.token);
-            std::string token_msg = auth_msg.serialize();
+        case ServerEventType::ROOM_PAGE:
+            handle_room_page(event.get<RoomPageReply>());
+            break;
+            
+        case ServerEventType::ROOMS_CHANGED:
+            room_view_.stale = true;
+            break;
+            
+        case ServerEventType::PING:
+            // Answered from this thread so a hung client stops answering
+            network_outbound_.push(NetworkMessage::create_pong(state_.get_token()).serialize());
+            break;
             
-            int sock = network_manager_->get_socket();
-            ssize_t sent = send(sock, token_msg.c_str(), token_msg.length(), 0);
-            if (sent <= 0) {
-                ui_commands_.push(UICommand(UICommandType::SHOW_ERROR,
-                    ErrorData{"Failed to send authentication token"}));
-                return;
+        case ServerEventType::CHAT_LINES:
+            // A busy room's MESSAGE_BATCH arrives as several lines at once
+            for (auto& line : event.get<ChatLinesData>().lines) {
+                queue_chat_message("[" + line.sender + "] " + line.message);
+                trace_received(line.trace);
             }
+            break;
             
-            // Start network thread after token is sent
-            network_manager_->start();
+        case ServerEventType::HISTORY_RESULTS: {
+            const auto& results = event.get<HistoryResultsData>();
+            queue_chat_message("=== Search: " + results.query + " (" +
+                               std::to_string(results.hits.size()) + " found) ===");
+            for (const auto& hit : results.hits) {
+                queue_chat_message("#" + std::to_string(hit.seq) + " [" + hit.sender + "] " + hit.message);
+            }
+            flush_ui_updates(true);
+            break;
         }
-        
-        // Store token and display name
-        state_.set_token(auth_result.token);
-        state_.set_username(auth_result.display_name);  // Use display name for UI
-        state_.set_connected(true);
-        
-        // Wait for server's response handled in network messages
-        // Then wait for ROOM_LIST which will trigger SHOW_FOYER
-    }
-    else if (event_type == "ROOM_SELECTED") {
-        // ROOM_SELECTED:room_name
-        std::string token = state_.get_token();
-        auto msg = NetworkMessage::create_join_room(token, event_data);
-        network_outbound_.push(msg.serialize());
-    }
-    else if (event_type == "CREATE_ROOM") {
-        // CREATE_ROOM:room_name
-        std::string token = state_.get_token();
-        auto msg = NetworkMessage::create_create_room(token, event_data);
-        network_outbound_.push(msg.serialize());
-    }
-    else if (event_type == "LEAVE") {
-        std::string token = state_.get_token();
-        auto msg = NetworkMessage::create_leave(token);
-        network_outbound_.push(msg.serialize());
-    }
-    else if (event_type == "LOGOUT") {
-        network_outbound_.push("/logout\n");
-        state_.set_connected(false);
-        state_.reset();
-        ui_commands_.push(UICommand(UICommandType::SHOW_LOGIN));
-    }
-    else if (event_type == "QUIT") {
-        running_ = false;
-        ui_commands_.push(UICommand(UICommandType::QUIT));
+            
+        case ServerEventType::PARTICIPANT_LIST:
+            pending_participants_ = std::move(event.get<ParticipantsData>().participants);
+            break;
+            
+        case ServerEventType::UNHANDLED:
+            break;
     }
-    else if (event_type == "CHAT_MESSAGE") {
-        // CHAT_MESSAGE:message text
-        // Format our own message with [You] prefix
-        std::string formatted_msg = "[You] " + event_data;
-        
-        // Add to local chat immediately (server won't echo back to us)
-        state_.add_chat_message(formatted_msg);
-        ui_commands_.push(UICommand(UICommandType::ADD_CHAT_MESSAGE, 
-            ChatMessageData{formatted_msg}));
-        
-        // Send to server with token
-        std::string token = state_.get_token();
-        auto msg = NetworkMessage::create_chat_message(token, event_data);
-        network_outbound_.push(msg.serialize());
+}
+
+void ApplicationManager::process_input_event(InputEvent& event) {
+    switch (event.type) {
+        case InputEventType::LOGIN: {
+            if (login_) {
+                push_ui(UICommand(UICommandType::SHOW_STATUS, StatusData{"Login already in progress..."}));
+                break;
+            }
+            const auto& login = event.get<LoginData>();
+            start_login(login.username, login.password);
+            break;
+        }
+            
+        case InputEventType::LOGIN_STEP:
+            on_login_step(event.get<uint64_t>());
+            break;
+            
+        case InputEventType::ROOM_SELECTED:
+            network_outbound_.push(
+                NetworkMessage::create_join_room(state_.get_token(), event.get<std::string>()).serialize());
+            break;
+            
+        case InputEventType::CREATE_ROOM:
+            network_outbound_.push(
+                NetworkMessage::create_create_room(state_.get_token(), event.get<std::string>()).serialize());
+            break;
+            
+        case InputEventType::ROOMS_MORE:
+            // UI scrolled past the loaded rows
+            request_room_page(false);
+            break;
+            
+        case InputEventType::ROOM_FILTER:
+            room_view_.prefix = std::move(event.get<std::string>());
+            room_view_.loaded = 0;
+            request_room_page(true);
+            break;
+            
+        case InputEventType::ROOM_SORT:
+            room_view_.sort = room_view_.sort == "members" ? "name" : "members";
+            room_view_.loaded = 0;
+            request_room_page(true);
+            break;
+            
+        case InputEventType::LEAVE:
+            network_outbound_.push(NetworkMessage::create_leave(state_.get_token()).serialize());
+            break;
+            
+        case InputEventType::LOGOUT:
+            network_outbound_.push("/logout\n");
+            credit_open_ = false;
+            state_.set_connected(false);
+            state_.reset();
+            push_ui(UICommand(UICommandType::SHOW_LOGIN));
+            break;
+            
+        case InputEventType::QUIT:
+            running_ = false;
+            push_ui(UICommand(UICommandType::QUIT));
+            break;
+            
+        case InputEventType::SEARCH_HISTORY:
+            // Looks through this room's stored history instead of chatting
+            network_outbound_.push(NetworkMessage::create_search_history(
+                state_.get_token(), state_.get_current_room(), event.get<std::string>(), 0).serialize());
+            break;
+            
+        case InputEventType::CHAT_MESSAGE: {
+            const auto& input = event.get<ChatInputData>();
+            
+            // Add to local chat immediately with a [You] prefix (server won't echo back to us)
+            queue_chat_message("[You] " + input.text);
+            flush_ui_updates(true);
+            
+            // Send to server with token
+            nlohmann::json trace;
+            if (trace_sample_ > 0 && ++chat_sent_ % trace_sample_ == 0) {
+                trace = tracing::start();
+                tracing::stamp(trace, tracing::CLIENT_INPUT, input.input_us ? input.input_us : tracing::now_us());
+            }
+            std::string frame;
+            NetworkMessage::write_chat_message(frame, state_.get_token(), input.text, trace);
+            network_outbound_.push(std::move(frame));
+            break;
+        }
     }
 }
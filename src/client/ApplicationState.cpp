@@ -1,9 +1,10 @@
 #include "ApplicationState.h"
 #include <algorithm>
 
-ApplicationState::ApplicationState()
+ApplicationState::ApplicationState(size_t chat_capacity)
     : connected_(false)
     , current_screen_(Screen::LOGIN)
+    , chat_messages_(chat_capacity)
 {
 }
 
@@ -46,7 +47,7 @@ void ApplicationState::set_rooms(const std::vector<RoomInfo>& rooms) {
     rooms_ = rooms;
 }
 
-std::vector<RoomInfo> ApplicationState::get_rooms() const {
+std::span<const RoomInfo> ApplicationState::get_rooms() const {
     return rooms_;
 }
 
@@ -67,12 +68,20 @@ std::string ApplicationState::get_current_room() const {
     return current_room_;
 }
 
-void ApplicationState::add_chat_message(const std::string& message) {
-    chat_messages_.push_back(message);
+uint64_t ApplicationState::add_chat_message(std::string message) {
+    return chat_messages_.push(std::move(message));
 }
 
-std::vector<std::string> ApplicationState::get_chat_messages() const {
-    return chat_messages_;
+MessageRing::View ApplicationState::get_chat_messages() const {
+    return chat_messages_.all();
+}
+
+MessageRing::View ApplicationState::get_chat_messages_since(uint64_t last_seen_id) const {
+    return chat_messages_.since(last_seen_id);
+}
+
+uint64_t ApplicationState::last_chat_message_id() const {
+    return chat_messages_.next_id() - 1;
 }
 
 void ApplicationState::clear_chat_messages() {
@@ -83,7 +92,7 @@ void ApplicationState::set_participants(const std::vector<std::string>& particip
     participants_ = participants;
 }
 
-std::vector<std::string> ApplicationState::get_participants() const {
+std::span<const std::string> ApplicationState::get_participants() const {
     return participants_;
 }
 
@@ -0,0 +1,99 @@
+#include "ClientEvents.h"
+#include "common/MessageSchema.h"
+#include "common/Trace.h"
+
+using json = nlohmann::json;
+
+namespace {
+
+// Traces from the network are only kept if they look like ours
+json followed(json& trace) {
+    return tracing::well_formed(trace) ? std::move(trace) : json();
+}
+
+std::vector<RoomInfo> room_infos(std::vector<proto::RoomItem>& rooms) {
+    std::vector<RoomInfo> infos;
+    infos.reserve(rooms.size());
+    for (auto& room : rooms) {
+        infos.push_back(RoomInfo{std::move(room.name), static_cast<int>(room.members)});
+    }
+    return infos;
+}
+
+} // namespace
+
+ServerEvent ServerEvent::decode(std::string_view frame) {
+    json j = json::parse(frame.begin(), frame.end(), nullptr, false);
+    if (j.is_discarded() || !j.is_object() || !j.contains("body") || !j["body"].is_object()) {
+        return ServerEvent();
+    }
+    static const json no_data;
+    json& body = j["body"];
+    const json& data = body.contains("data") ? body["data"] : no_data;
+    std::string type = body.contains("type") && body["type"].is_string() ? body["type"].get<std::string>() : "";
+
+    switch (proto::id_of(type)) {
+        case proto::MessageId::Message: {
+            auto message = proto::Message::from_json(data);
+            ChatLinesData chat;
+            chat.lines.push_back(ChatLine{std::move(message.sender), std::move(message.message), json()});
+            // A single MESSAGE carries its trace in the header
+            if (j.contains("header") && j["header"].is_object() && j["header"].contains("trace")) {
+                chat.lines.back().trace = followed(j["header"]["trace"]);
+            }
+            return ServerEvent(ServerEventType::CHAT_LINES, std::move(chat));
+        }
+        case proto::MessageId::MessageBatch: {
+            auto batch = proto::MessageBatch::from_json(data);
+            ChatLinesData chat;
+            chat.lines.reserve(batch.messages.size());
+            for (auto& entry : batch.messages) {
+                chat.lines.push_back(ChatLine{std::move(entry.sender), std::move(entry.message), followed(entry.trace)});
+            }
+            return ServerEvent(ServerEventType::CHAT_LINES, std::move(chat));
+        }
+        case proto::MessageId::ParticipantList: {
+            auto list = proto::ParticipantList::from_json(data);
+            return ServerEvent(ServerEventType::PARTICIPANT_LIST, ParticipantsData{std::move(list.participants)});
+        }
+        case proto::MessageId::RoomPage: {
+            auto reply = proto::RoomPage::from_json(data);
+            RoomPageReply page;
+            page.rooms = room_infos(reply.rooms);
+            page.prefix = std::move(reply.prefix);
+            page.sort = std::move(reply.sort);
+            page.cursor = std::move(reply.cursor);
+            page.next_cursor = std::move(reply.next_cursor);
+            page.total = reply.total;
+            return ServerEvent(ServerEventType::ROOM_PAGE, std::move(page));
+        }
+        case proto::MessageId::RoomsChanged:
+            return ServerEvent(ServerEventType::ROOMS_CHANGED);
+        case proto::MessageId::Ping:
+            return ServerEvent(ServerEventType::PING);
+        case proto::MessageId::RoomJoined:
+            return ServerEvent(ServerEventType::ROOM_JOINED, proto::RoomJoined::from_json(data).room_name);
+        case proto::MessageId::LeftRoom:
+            return ServerEvent(ServerEventType::LEFT_ROOM);
+        case proto::MessageId::Error:
+            return ServerEvent(ServerEventType::SERVER_ERROR, ErrorData{proto::Error::from_json(data).message});
+        case proto::MessageId::RoomList: {
+            RoomListData list;
+            for (auto& name : proto::RoomList::from_json(data).rooms) {
+                list.rooms.push_back(RoomInfo{std::move(name), 0});
+            }
+            return ServerEvent(ServerEventType::ROOM_LIST, std::move(list));
+        }
+        case proto::MessageId::HistoryResults: {
+            auto reply = proto::HistoryResults::from_json(data);
+            HistoryResultsData results;
+            results.query = std::move(reply.query);
+            for (auto& hit : reply.results) {
+                results.hits.push_back(HistoryLine{hit.seq, std::move(hit.sender), std::move(hit.message)});
+            }
+            return ServerEvent(ServerEventType::HISTORY_RESULTS, std::move(results));
+        }
+        default:
+            return ServerEvent();
+    }
+}
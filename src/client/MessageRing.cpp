@@ -0,0 +1,56 @@
+#include "MessageRing.h"
+#include <algorithm>
+
+MessageRing::MessageRing(size_t capacity)
+    : slots_(std::max<size_t>(capacity, 1))
+{
+}
+
+uint64_t MessageRing::push(std::string message) {
+    if (size_ < slots_.size()) {
+        slots_[(head_ + size_) % slots_.size()] = std::move(message);
+        ++size_;
+    } else {
+        // Full: the new message takes the oldest one's slot
+        slots_[head_] = std::move(message);
+        head_ = (head_ + 1) % slots_.size();
+    }
+    return next_id_++;
+}
+
+void MessageRing::clear() {
+    head_ = 0;
+    size_ = 0;
+}
+
+MessageRing::View MessageRing::all() const {
+    return slice(0, size_);
+}
+
+MessageRing::View MessageRing::since(uint64_t last_seen_id) const {
+    uint64_t first = std::max(last_seen_id + 1, first_id());
+    if (first >= next_id_) {
+        return View({}, {}, next_id_);
+    }
+    size_t offset = static_cast<size_t>(first - first_id());
+    return slice(offset, size_ - offset);
+}
+
+MessageRing::View MessageRing::last(size_t count) const {
+    count = std::min(count, size_);
+    return slice(size_ - count, count);
+}
+
+MessageRing::View MessageRing::slice(size_t offset, size_t count) const {
+    uint64_t first = first_id() + offset;
+    if (count == 0) {
+        return View({}, {}, first);
+    }
+
+    size_t start = (head_ + offset) % slots_.size();
+    size_t contiguous = std::min(count, slots_.size() - start);
+    std::span<const std::string> storage(slots_);
+    return View(storage.subspan(start, contiguous),
+                storage.subspan(0, count - contiguous),
+                first);
+}
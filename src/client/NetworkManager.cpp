@@ -1,4 +1,6 @@
 #include "NetworkManager.h"
+#include "common/NetworkMessage.h"
+#include "common/Trace.h"
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
@@ -11,10 +13,28 @@ constexpr int SELECT_TIMEOUT_MS = 50;
 
 using namespace std::chrono_literals;
 
-NetworkManager::NetworkManager(ThreadSafeQueue<std::string>& inbound,
-                               ThreadSafeQueue<std::string>& outbound)
+namespace {
+
+// Re-encode an outbound traced frame with one more stage
+void stamp_frame(std::string& frame, const char* stage, int64_t t_us) {
+    if (frame.find("\"trace\"") == std::string::npos) {
+        return;
+    }
+    auto msg = NetworkMessage::deserialize(frame);
+    if (tracing::well_formed(msg.header.trace)) {
+        tracing::stamp(msg.header.trace, stage, t_us);
+        frame = msg.serialize();
+    }
+}
+
+} // namespace
+
+NetworkManager::NetworkManager(ThreadSafeQueue<ServerEvent>& inbound,
+                               ThreadSafeQueue<std::string>& outbound,
+                               size_t inbound_limit)
     : inbound_queue_(inbound)
     , outbound_queue_(outbound)
+    , inbound_limit_(inbound_limit)
     , socket_(-1)
     , connected_(false)
     , running_(false)
@@ -34,6 +54,7 @@ bool NetworkManager::connect(const std::string& host, int port, std::string& err
     
     // Reset connection state
     connected_ = false;
+    partial_frame_.clear();
     
     // Create socket
     socket_ = socket(AF_INET, SOCK_STREAM, 0);
@@ -114,7 +135,12 @@ void NetworkManager::network_loop() {
         // Use select() for non-blocking check on socket readability
         fd_set read_fds;
         FD_ZERO(&read_fds);
-        FD_SET(socket_, &read_fds);
+        
+        // Leave data in the socket while the consumer is behind
+        bool can_read = inbound_queue_.size() < inbound_limit_;
+        if (can_read) {
+            FD_SET(socket_, &read_fds);
+        }
         
         struct timeval tv;
         tv.tv_sec = 0;
@@ -122,7 +148,7 @@ void NetworkManager::network_loop() {
         
         int result = select(socket_ + 1, &read_fds, nullptr, nullptr, &tv);
         
-        if (result > 0 && FD_ISSET(socket_, &read_fds)) {
+        if (result > 0 && can_read && FD_ISSET(socket_, &read_fds)) {
             receive_data();
         }
         
@@ -134,24 +160,34 @@ void NetworkManager::network_loop() {
 void NetworkManager::receive_data() {
     char buffer[BUFFER_SIZE];
     
-    ssize_t bytes_read = recv(socket_, buffer, sizeof(buffer) - 1, 0);
+    ssize_t bytes_read = recv(socket_, buffer, sizeof(buffer), 0);
     
     if (bytes_read <= 0) {
-        // Connection closed or error
+        // Connection closed or error; stop() shutting the socket is not a loss
         connected_ = false;
-        running_ = false;
-        
-        if (bytes_read == 0) {
-            inbound_queue_.push("SERVER_DISCONNECTED\n");
-        } else {
-            inbound_queue_.push("CONNECTION_ERROR\n");
+        if (running_.exchange(false)) {
+            inbound_queue_.push(ServerEvent(ServerEventType::DISCONNECTED));
         }
         return;
     }
     
-    // Null-terminate and enqueue
-    buffer[bytes_read] = '\0';
-    inbound_queue_.push(std::string(buffer));
+    // Decode and enqueue complete frames; keep any trailing partial frame for the next read
+    partial_frame_.append(buffer, bytes_read);
+    int64_t received_us = tracing_ ? tracing::now_us() : 0;
+    std::string_view frames(partial_frame_);
+    size_t start = 0;
+    for (size_t end; (end = frames.find('\n', start)) != std::string_view::npos; start = end + 1) {
+        ServerEvent event = ServerEvent::decode(frames.substr(start, end - start));
+        if (tracing_ && event.type == ServerEventType::CHAT_LINES) {
+            for (auto& line : event.get<ChatLinesData>().lines) {
+                if (!line.trace.is_null()) {
+                    tracing::stamp(line.trace, tracing::CLIENT_RECV, received_us);
+                }
+            }
+        }
+        inbound_queue_.push(std::move(event));
+    }
+    partial_frame_.erase(0, start);
 }
 
 void NetworkManager::send_data() {
@@ -162,14 +198,18 @@ void NetworkManager::send_data() {
         if (!connected_) {
             break;  // Don't try to send if disconnected
         }
+        if (tracing_) {
+            stamp_frame(message, tracing::CLIENT_SEND, tracing::now_us());
+        }
         
         ssize_t bytes_sent = send(socket_, message.c_str(), message.length(), 0);
         
         if (bytes_sent < 0) {
             // Send failed - connection likely broken
             connected_ = false;
-            running_ = false;
-            inbound_queue_.push("CONNECTION_ERROR\n");
+            if (running_.exchange(false)) {
+                inbound_queue_.push(ServerEvent(ServerEventType::DISCONNECTED));
+            }
             break;
         }
         
@@ -6,7 +6,7 @@
 using namespace std::chrono_literals;
 
 UIManager::UIManager(ThreadSafeQueue<UICommand>& ui_commands,
-                     ThreadSafeQueue<std::string>& input_events)
+                     ThreadSafeQueue<InputEvent>& input_events)
     : ui_commands_(ui_commands)
     , input_events_(input_events)
     , current_screen_(Screen::LOGIN)
@@ -141,7 +141,7 @@ void UIManager::setup_login_ui() {
     password_input_->set_on_submit([this](const std::string& password) {
         std::string username = login_input_->get_text();
         if (!username.empty() && !password.empty()) {
-            input_events_.push("LOGIN:" + username + ":" + password);
+            input_events_.push(InputEvent(InputEventType::LOGIN, LoginData{username, password}));
             username_ = username;
             login_input_->clear();
             password_input_->clear();
@@ -170,29 +170,31 @@ void UIManager::setup_foyer_ui() {
     
     // Create help label
     help_label_ = std::make_shared<ui::Label>(0, max_y - 2, max_x, 2,
-        "Up/Down: Navigate | Enter: Join | c: Create Room\nq: Quit");
+        "Up/Down: Navigate | Enter: Join | c: Create Room\n/: Filter | s: Sort | q: Quit");
     help_label_->set_attributes(A_DIM);
     
     // Create room menu
     room_menu_ = std::make_shared<ui::Menu>(ui::Rect{2, 3, max_x - 4, max_y - 6});
     room_menu_->set_bordered(true);
-    room_menu_->set_title(" Available Rooms ");
     room_menu_->set_numbered(false);
     room_menu_->set_focus(true);
-    
-    // Update menu when rooms change
-    std::vector<ui::MenuItem> menu_items;
-    for (const auto& room : rooms_) {
-        ui::MenuItem item;
-        item.text = room.name + " (" + std::to_string(room.client_count) + " users)";
-        menu_items.push_back(item);
-    }
-    room_menu_->set_items(menu_items);
+    update_room_menu_title();
+    
+    // Rows come from room_items_; rows past the loaded ones are fetched on demand
+    room_menu_->set_virtual([this](size_t index) -> const ui::MenuItem* {
+        return index < room_items_.size() ? &room_items_[index] : nullptr;
+    }, room_total_);
+    room_menu_->set_on_items_needed([this](size_t) {
+        if (more_rooms_requested_at_ != rooms_.size()) {
+            more_rooms_requested_at_ = rooms_.size();
+            input_events_.push(InputEvent(InputEventType::ROOMS_MORE));
+        }
+    });
     
     // Handle room activation
     room_menu_->set_on_activate([this](size_t index, const ui::MenuItem& item) {
         if (index < rooms_.size()) {
-            input_events_.push("ROOM_SELECTED:" + rooms_[index].name);
+            input_events_.push(InputEvent(InputEventType::ROOM_SELECTED, rooms_[index].name));
         }
     });
     
@@ -202,6 +204,41 @@ void UIManager::setup_foyer_ui() {
     main_window_->add_child(help_label_);
 }
 
+void UIManager::set_room_rows(const std::vector<RoomInfo>& rooms, bool append, size_t total) {
+    if (!append) {
+        rooms_.clear();
+        room_items_.clear();
+    }
+    for (const auto& room : rooms) {
+        rooms_.push_back(room);
+        room_items_.emplace_back(room.name + " (" + std::to_string(room.client_count) + " users)");
+    }
+    room_total_ = std::max(total, rooms_.size());
+    more_rooms_requested_at_ = SIZE_MAX;
+    
+    // Keep selected index in bounds
+    if (selected_room_index_ >= static_cast<int>(room_total_)) {
+        selected_room_index_ = std::max(0, static_cast<int>(room_total_) - 1);
+    }
+    if (room_menu_) {
+        room_menu_->set_virtual_count(room_total_);
+    }
+}
+
+void UIManager::update_room_menu_title() {
+    if (!room_menu_) {
+        return;
+    }
+    std::string title = " Available Rooms";
+    if (room_sort_ == "members") {
+        title += " by members";
+    }
+    if (!room_prefix_.empty()) {
+        title += " '" + room_prefix_ + "*'";
+    }
+    room_menu_->set_title(title + " ");
+}
+
 void UIManager::setup_chatroom_ui() {
     int max_y, max_x;
     getmaxyx(stdscr, max_y, max_x);
@@ -232,11 +269,14 @@ void UIManager::setup_chatroom_ui() {
     chat_input_->set_on_submit([this](const std::string& text) {
         if (!text.empty()) {
             if (text == "/leave") {
-                input_events_.push("LEAVE");
+                input_events_.push(InputEvent(InputEventType::LEAVE));
             } else if (text == "/quit") {
-                input_events_.push("QUIT");
+                input_events_.push(InputEvent(InputEventType::QUIT));
+            } else if (text.rfind("/search ", 0) == 0) {
+                input_events_.push(InputEvent(InputEventType::SEARCH_HISTORY, text.substr(8)));
             } else {
-                input_events_.push("CHAT_MESSAGE:" + text);
+                input_events_.push(InputEvent(InputEventType::CHAT_MESSAGE,
+                    ChatInputData{text, trace_log_ ? tracing::now_us() : 0}));
             }
             chat_input_->clear();
         }
@@ -275,6 +315,15 @@ void UIManager::run() {
         poll_input();
         render();
         
+        if (!drawn_traces_.empty()) {
+            int64_t rendered_us = tracing::now_us();
+            for (auto& drawn : drawn_traces_) {
+                tracing::stamp(drawn, tracing::RENDER, rendered_us);
+                trace_log_->write(drawn);
+            }
+            drawn_traces_.clear();
+        }
+        
         std::this_thread::sleep_for(100ms);  // ~10 FPS, reduces flicker
     }
     
@@ -292,10 +341,28 @@ void UIManager::stop() {
 }
 
 void UIManager::process_commands() {
-    UICommand cmd(UICommandType::QUIT);
-    
-    // Process all available commands
-    while (ui_commands_.try_pop(cmd, 0ms)) {
+    // Take everything queued for this frame at once
+    std::vector<UICommand> commands;
+    UICommand next(UICommandType::QUIT);
+    while (ui_commands_.try_pop(next, 0ms)) {
+        commands.push_back(std::move(next));
+    }
+    
+    // A room or participant list is replaced by any later one in the same frame
+    size_t last_room_list = commands.size();
+    size_t last_participants = commands.size();
+    for (size_t i = 0; i < commands.size(); ++i) {
+        if (commands[i].type == UICommandType::UPDATE_ROOM_LIST) last_room_list = i;
+        if (commands[i].type == UICommandType::UPDATE_PARTICIPANTS) last_participants = i;
+    }
+    
+    for (size_t i = 0; i < commands.size(); ++i) {
+        const UICommand& cmd = commands[i];
+        if ((cmd.type == UICommandType::UPDATE_ROOM_LIST && i != last_room_list) ||
+            (cmd.type == UICommandType::UPDATE_PARTICIPANTS && i != last_participants)) {
+            continue;
+        }
+        
         switch (cmd.type) {
             case UICommandType::SHOW_LOGIN:
                 current_screen_ = Screen::LOGIN;
@@ -325,27 +392,40 @@ void UIManager::process_commands() {
                 
             case UICommandType::UPDATE_ROOM_LIST:
                 if (cmd.has_data()) {
-                    rooms_ = cmd.get<RoomListData>().rooms;
-                    // Keep selected index in bounds
-                    if (selected_room_index_ >= static_cast<int>(rooms_.size())) {
-                        selected_room_index_ = std::max(0, static_cast<int>(rooms_.size()) - 1);
-                    }
-                    // Update menu if it exists
-                    if (room_menu_) {
-                        std::vector<ui::MenuItem> menu_items;
-                        for (const auto& room : rooms_) {
-                            ui::MenuItem item;
-                            item.text = room.name + " (" + std::to_string(room.client_count) + " users)";
-                            menu_items.push_back(item);
-                        }
-                        room_menu_->set_items(menu_items);
+                    const auto& rooms = cmd.get<RoomListData>().rooms;
+                    set_room_rows(rooms, false, rooms.size());
+                }
+                break;
+                
+            case UICommandType::UPDATE_ROOM_PAGE:
+                if (cmd.has_data()) {
+                    const auto& page = cmd.get<RoomPageData>();
+                    bool query_changed = page.prefix != room_prefix_ || page.sort != room_sort_;
+                    room_prefix_ = page.prefix;
+                    room_sort_ = page.sort;
+                    set_room_rows(page.rooms, page.append, page.total);
+                    if (query_changed && room_menu_) {
+                        update_room_menu_title();
+                        room_menu_->set_selected_index(room_total_ > 0 ? 0 : -1);
                     }
                 }
                 break;
                 
             case UICommandType::ADD_CHAT_MESSAGE:
                 if (cmd.has_data()) {
-                    chat_messages_.push_back(cmd.get<ChatMessageData>().message);
+                    chat_messages_.push(cmd.get<ChatMessageData>().message);
+                }
+                break;
+                
+            case UICommandType::ADD_CHAT_MESSAGES:
+                if (cmd.has_data()) {
+                    const auto& data = cmd.get<ChatMessagesData>();
+                    for (const auto& message : data.messages) {
+                        chat_messages_.push(message);
+                    }
+                    if (trace_log_) {
+                        drawn_traces_.insert(drawn_traces_.end(), data.traces.begin(), data.traces.end());
+                    }
                 }
                 break;
                 
@@ -416,10 +496,10 @@ void UIManager::poll_input() {
     // Handle quit on any screen
     if (ch == 'q' || ch == 'Q') {
         if (current_screen_ == Screen::LOGIN && login_input_ && login_input_->get_text().empty()) {
-            input_events_.push("QUIT");
+            input_events_.push(InputEvent(InputEventType::QUIT));
             return;
         } else if (current_screen_ == Screen::FOYER) {
-            input_events_.push("QUIT");
+            input_events_.push(InputEvent(InputEventType::QUIT));
             return;
         }
     }
@@ -442,6 +522,16 @@ void UIManager::poll_input() {
         return;
     }
     
+    // Filter and sort the room list (applied by the server)
+    if (ch == '/' && current_screen_ == Screen::FOYER) {
+        show_room_filter_dialog();
+        return;
+    }
+    if ((ch == 's' || ch == 'S') && current_screen_ == Screen::FOYER) {
+        input_events_.push(InputEvent(InputEventType::ROOM_SORT));
+        return;
+    }
+    
     // Forward to main window (which forwards to focused child)
     if (main_window_) {
         main_window_->handle_event(event);
@@ -624,15 +714,13 @@ void UIManager::render_chatroom() {
             getmaxyx(win, chat_height, chat_width);
             
             // Show last N messages that fit
-            int start_idx = chat_messages_.size() > (size_t)(chat_height - 2)
-                ? chat_messages_.size() - (chat_height - 2)
-                : 0;
+            auto visible = chat_messages_.last(chat_height > 2 ? chat_height - 2 : 0);
             
             int y = 1;
-            for (size_t i = start_idx; i < chat_messages_.size() && y < chat_height - 1; ++i) {
+            for (const auto& message : visible) {
                 mvwprintw(win, y++, 1, "%.*s", 
                           chat_width - 2, 
-                          chat_messages_[i].c_str());
+                          message.c_str());
             }
             
             touchwin(win);
@@ -692,6 +780,22 @@ void UIManager::show_error_popup(const std::string& message) {
 }
 
 void UIManager::show_create_room_dialog() {
+    auto room_name = prompt_dialog(" Create New Room ", "Room name:", "Enter: Create | Esc: Cancel", false);
+    if (room_name) {
+        input_events_.push(InputEvent(InputEventType::CREATE_ROOM, std::move(*room_name)));
+    }
+}
+
+void UIManager::show_room_filter_dialog() {
+    auto prefix = prompt_dialog(" Filter Rooms ", "Name starts with (empty: all):",
+                                "Enter: Apply | Esc: Cancel", true);
+    if (prefix) {
+        input_events_.push(InputEvent(InputEventType::ROOM_FILTER, std::move(*prefix)));
+    }
+}
+
+std::optional<std::string> UIManager::prompt_dialog(const std::string& title, const std::string& label,
+                                                    const std::string& hint, bool allow_empty) {
     int max_y, max_x;
     getmaxyx(stdscr, max_y, max_x);
     
@@ -708,7 +812,8 @@ void UIManager::show_create_room_dialog() {
         wattron(popup, COLOR_PAIR(2) | A_BOLD);
     }
     
-    std::string room_name;
+    std::string text;
+    std::optional<std::string> result;
     bool done = false;
     
     nodelay(stdscr, FALSE);  // Blocking input for dialog
@@ -717,13 +822,13 @@ void UIManager::show_create_room_dialog() {
     while (!done) {
         werase(popup);
         box(popup, 0, 0);
-        mvwprintw(popup, 0, 2, " Create New Room ");
-        mvwprintw(popup, 2, 2, "Room name:");
-        mvwprintw(popup, 3, 2, "%.*s", popup_width - 4, room_name.c_str());
-        mvwprintw(popup, 5, 2, "Enter: Create | Esc: Cancel");
+        mvwprintw(popup, 0, 2, "%s", title.c_str());
+        mvwprintw(popup, 2, 2, "%.*s", popup_width - 4, label.c_str());
+        mvwprintw(popup, 3, 2, "%.*s", popup_width - 4, text.c_str());
+        mvwprintw(popup, 5, 2, "%.*s", popup_width - 4, hint.c_str());
         
         // Position cursor
-        wmove(popup, 3, 2 + room_name.length());
+        wmove(popup, 3, 2 + text.length());
         wrefresh(popup);
         
         int ch = wgetch(popup);
@@ -731,16 +836,16 @@ void UIManager::show_create_room_dialog() {
         if (ch == 27) {  // ESC
             done = true;
         } else if (ch == '\n' || ch == KEY_ENTER) {
-            if (!room_name.empty()) {
-                input_events_.push("CREATE_ROOM:" + room_name);
+            if (allow_empty || !text.empty()) {
+                result = text;
                 done = true;
             }
         } else if (ch == KEY_BACKSPACE || ch == 127 || ch == 8) {
-            if (!room_name.empty()) {
-                room_name.pop_back();
+            if (!text.empty()) {
+                text.pop_back();
             }
-        } else if (ch >= 32 && ch < 127 && room_name.length() < 30) {
-            room_name += static_cast<char>(ch);
+        } else if (ch >= 32 && ch < 127 && text.length() < 30) {
+            text += static_cast<char>(ch);
         }
     }
     
@@ -751,4 +856,5 @@ void UIManager::show_create_room_dialog() {
     // Force full redraw
     clear();
     refresh();
+    return result;
 }
@@ -41,6 +41,8 @@ struct ClientConfig {
     int auth_port = 3001;
     std::string chat_host = "127.0.0.1";
     int chat_port = 3000;
+    std::string trace_path;      // empty = no latency tracing
+    unsigned trace_sample = 1;   // trace one in every N chat lines sent
 };
 
 ClientConfig load_config() {
@@ -54,6 +56,8 @@ ClientConfig load_config() {
         if (j.contains("auth_port")) cfg.auth_port = j.value("auth_port", cfg.auth_port);
         if (j.contains("chat_host")) cfg.chat_host = j.value("chat_host", cfg.chat_host);
         if (j.contains("chat_port")) cfg.chat_port = j.value("chat_port", cfg.chat_port);
+        if (j.contains("trace_path")) cfg.trace_path = j.value("trace_path", cfg.trace_path);
+        if (j.contains("trace_sample")) cfg.trace_sample = j.value("trace_sample", cfg.trace_sample);
     } catch (const std::exception& ex) {
         std::cerr << "Failed to parse config/client_config.json: " << ex.what() << "\n";
     }
@@ -65,10 +69,10 @@ int main() {
         ClientConfig cfg = load_config();
 
         // Create all queues
-        ThreadSafeQueue<std::string> network_inbound;
+        ThreadSafeQueue<ServerEvent> network_inbound;
         ThreadSafeQueue<std::string> network_outbound;
         ThreadSafeQueue<UICommand> ui_commands;
-        ThreadSafeQueue<std::string> input_events;
+        ThreadSafeQueue<InputEvent> input_events;
         
         // Create managers with queue references
         NetworkManager network(network_inbound, network_outbound);
@@ -78,6 +82,17 @@ int main() {
                                       cfg.chat_host, cfg.chat_port);
         UIManager ui(ui_commands, input_events);
         
+        if (!cfg.trace_path.empty()) {
+            auto trace_log = std::make_shared<tracing::TraceLog>();
+            if (!trace_log->open(cfg.trace_path)) {
+                std::cerr << "Error: Could not open trace log: " << cfg.trace_path << "\n";
+                return 1;
+            }
+            network.set_tracing(true);
+            application.set_tracing(trace_log, cfg.trace_sample);
+            ui.set_trace_log(trace_log);
+        }
+        
         // Set up signal handler
         g_ui_manager = &ui;
         g_network_manager = &network;
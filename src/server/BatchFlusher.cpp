@@ -0,0 +1,62 @@
+#include "BatchFlusher.h"
+#include "ChatRoom.h"
+
+void BatchStats::record_delay(uint64_t delay_us) {
+    delay_us_total.fetch_add(delay_us, std::memory_order_relaxed);
+    uint64_t current = delay_us_max.load(std::memory_order_relaxed);
+    while (delay_us > current &&
+           !delay_us_max.compare_exchange_weak(current, delay_us, std::memory_order_relaxed)) {
+    }
+}
+
+BatchFlusher::BatchFlusher(const BatchConfig& config)
+    : config_(config)
+    , thread_(&BatchFlusher::run, this) {}
+
+BatchFlusher::~BatchFlusher() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_one();
+    thread_.join();
+}
+
+void BatchFlusher::schedule(std::weak_ptr<ChatRoom> room, Clock::time_point deadline) {
+    bool earliest;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        earliest = queue_.empty() || deadline < queue_.top().deadline;
+        queue_.push(Entry{deadline, std::move(room)});
+    }
+    if (earliest) {
+        cv_.notify_one();
+    }
+}
+
+void BatchFlusher::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        if (queue_.empty()) {
+            cv_.wait(lock);
+            continue;
+        }
+
+        auto deadline = queue_.top().deadline;
+        if (Clock::now() < deadline) {
+            cv_.wait_until(lock, deadline);
+            continue;
+        }
+
+        auto room = queue_.top().room.lock();
+        queue_.pop();
+
+        // Flush without holding the queue lock; the room may schedule again
+        lock.unlock();
+        if (room) {
+            room->flush_pending();
+        }
+        room.reset();
+        lock.lock();
+    }
+}
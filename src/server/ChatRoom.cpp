@@ -1,9 +1,24 @@
 #include "ChatRoom.h"
-#include <sys/socket.h>
+#include "common/NetworkMessage.h"
 #include <algorithm>
+#include <functional>
 #include <iostream>
 
-ChatRoom::ChatRoom(const std::string& name) : name_(name) {}
+namespace {
+
+// Rate is measured over windows this long
+constexpr auto RATE_WINDOW = std::chrono::milliseconds(100);
+
+} // namespace
+
+ChatRoom::ChatRoom(const std::string& name, std::shared_ptr<IoBackend> io_backend,
+                   std::shared_ptr<BatchFlusher> batch_flusher,
+                   std::shared_ptr<tracing::TraceLog> trace_log)
+    : name_(name)
+    , io_backend_(io_backend ? std::move(io_backend) : std::make_shared<PosixIoBackend>())
+    , trace_log_(std::move(trace_log))
+    , batch_flusher_(std::move(batch_flusher))
+    , window_start_(BatchFlusher::Clock::now()) {}
 
 std::string ChatRoom::get_name() const {
     return name_;
@@ -14,16 +29,19 @@ size_t ChatRoom::get_client_count() const {
     return clients_.size();
 }
 
-void ChatRoom::add_client(int fd, const std::string& name, const std::string& ip) {
+void ChatRoom::add_client(const std::shared_ptr<ClientConnection>& client) {
     std::lock_guard<std::mutex> lock(room_mutex_);
-    clients_.push_back({fd, name, ip});
+    // Held messages are already in the history the newcomer will replay
+    flush_pending_locked();
+    clients_.push_back(client);
 }
 
 void ChatRoom::remove_client(int fd) {
     std::lock_guard<std::mutex> lock(room_mutex_);
+    flush_pending_locked();
     clients_.erase(
         std::remove_if(clients_.begin(), clients_.end(),
-            [fd](const RoomClient& c) { return c.fd == fd; }),
+            [fd](const std::shared_ptr<ClientConnection>& c) { return c->fd() == fd; }),
         clients_.end()
     );
 }
@@ -31,57 +49,224 @@ void ChatRoom::remove_client(int fd) {
 bool ChatRoom::has_client(int fd) const {
     std::lock_guard<std::mutex> lock(room_mutex_);
     return std::any_of(clients_.begin(), clients_.end(),
-        [fd](const RoomClient& c) { return c.fd == fd; });
+        [fd](const std::shared_ptr<ClientConnection>& c) { return c->fd() == fd; });
 }
 
 std::string ChatRoom::get_client_display_name(int fd) const {
     std::lock_guard<std::mutex> lock(room_mutex_);
     auto it = std::find_if(clients_.begin(), clients_.end(),
-        [fd](const RoomClient& c) { return c.fd == fd; });
+        [fd](const std::shared_ptr<ClientConnection>& c) { return c->fd() == fd; });
     if (it != clients_.end()) {
-        return it->name + " (" + it->ip + ")";
+        return (*it)->name() + " (" + (*it)->ip() + ")";
     }
     return "Unknown";
 }
 
-void ChatRoom::add_message(const std::string& message) {
-    std::lock_guard<std::mutex> lock(room_mutex_);
-    add_message_internal(message);
-}
-
-void ChatRoom::add_message_internal(const std::string& message) {
+void ChatRoom::add_message_internal(const SharedPayload& message) {
     chat_history_.push_back(message);
     if (chat_history_.size() > MAX_HISTORY_SIZE) {
         chat_history_.pop_front();
     }
 }
 
-void ChatRoom::broadcast_message(const std::string& message, int sender_fd) {
+void ChatRoom::send_to_members_locked(const SharedPayload& payload, int exclude_fd,
+                                      std::string_view coalesce_key) {
+    std::vector<std::shared_ptr<ClientConnection>> recipients;
+    recipients.reserve(clients_.size());
+    for (const auto& client : clients_) {
+        if (client->fd() != exclude_fd) {
+            recipients.push_back(client);
+        }
+    }
+    
+    // One batched submission for the whole room (io_uring), or one send() each
+    ClientConnection::send_batch(*io_backend_, recipients, payload, coalesce_key);
+}
+
+bool ChatRoom::should_batch_locked(BatchFlusher::Clock::time_point now) {
+    if (!batch_flusher_ || batch_flusher_->config().rate_threshold == 0) {
+        return false;
+    }
+    
+    auto elapsed = now - window_start_;
+    if (elapsed >= RATE_WINDOW) {
+        auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+        // A quiet gap of more than one window means the burst is over
+        last_window_rate_ = elapsed < 2 * RATE_WINDOW ? window_count_ * 1000 / elapsed_ms : 0;
+        window_start_ = now;
+        window_count_ = 0;
+    }
+    ++window_count_;
+    
+    // Either the last full window or the current one so far is over the threshold
+    size_t current_rate = window_count_ * 1000 / RATE_WINDOW.count();
+    return std::max(last_window_rate_, current_rate) >= batch_flusher_->config().rate_threshold;
+}
+
+uint64_t ChatRoom::broadcast_message(const std::string& sender, const std::string& message, int sender_fd,
+                                     const nlohmann::json& trace) {
     std::lock_guard<std::mutex> lock(room_mutex_);
-    add_message_internal(message);  // Use internal version that doesn't lock
     
-    // Format as BROADCAST: for client event system
-    std::string broadcast_msg = "BROADCAST:" + message;
+    // Sequence is assigned under the room lock so history and live order agree
+    uint64_t seq = next_seq_++;
+    std::string timestamp = NetworkMessage::get_timestamp();
     
-    for (const auto& client : clients_) {
-        if (client.fd != sender_fd) {
-            send(client.fd, broadcast_msg.c_str(), broadcast_msg.length(), MSG_NOSIGNAL);
+    // History and every recipient share one immutable buffer
+    std::string frame;
+    NetworkMessage::write_room_message(frame, name_, seq, sender, message, nullptr, timestamp);
+    auto payload = make_payload(std::move(frame));
+    add_message_internal(payload);  // Use internal version that doesn't lock
+    if (history_index_) {
+        history_index_->add(name_, seq, sender, message);
+    }
+    
+    // A traced line goes out with its stages; late joiners replay the plain frame
+    nlohmann::json traced = trace;
+    auto live = payload;
+    if (!traced.is_null()) {
+        tracing::stamp(traced, tracing::BROADCAST_ENQUEUE);
+        std::string traced_frame;
+        NetworkMessage::write_room_message(traced_frame, name_, seq, sender, message, traced, timestamp);
+        live = make_payload(std::move(traced_frame));
+    }
+    
+    auto now = BatchFlusher::Clock::now();
+    if (!should_batch_locked(now)) {
+        flush_pending_locked();  // keep seq order when a burst ends
+        send_to_members_locked(live, sender_fd);
+        if (!traced.is_null()) {
+            finish_trace(std::move(traced));
+        }
+        if (batch_flusher_) {
+            batch_flusher_->stats().immediate_messages.fetch_add(1, std::memory_order_relaxed);
         }
+        return seq;
+    }
+    
+    if (pending_.empty()) {
+        pending_deadline_ = now + batch_flusher_->config().max_delay;
+        batch_flusher_->schedule(weak_from_this(), pending_deadline_);
+    }
+    pending_.push_back(PendingMessage{sender_fd, sender, message, seq, std::move(traced), now});
+    
+    if (pending_.size() >= batch_flusher_->config().max_messages) {
+        flush_pending_locked();
+    }
+    return seq;
+}
+
+void ChatRoom::set_history_index(std::shared_ptr<HistoryIndex> history_index) {
+    std::lock_guard<std::mutex> lock(room_mutex_);
+    history_index_ = std::move(history_index);
+    if (history_index_) {
+        next_seq_ = std::max(next_seq_, history_index_->last_seq(name_) + 1);
     }
 }
 
-void ChatRoom::send_history_to_client(int client_fd) {
+void ChatRoom::finish_trace(nlohmann::json trace) {
+    if (trace_log_) {
+        tracing::stamp(trace, tracing::SOCKET_WRITE);
+        trace_log_->write(trace);
+    }
+}
+
+void ChatRoom::flush_pending() {
     std::lock_guard<std::mutex> lock(room_mutex_);
-    if (!chat_history_.empty()) {
-        std::string history_msg = "=== Chat History ===\n";
-        send(client_fd, history_msg.c_str(), history_msg.length(), MSG_NOSIGNAL);
+    // A later batch has its own deadline; leave it to that timer
+    if (!pending_.empty() && BatchFlusher::Clock::now() >= pending_deadline_) {
+        flush_pending_locked();
+    }
+}
+
+void ChatRoom::flush_pending_locked() {
+    if (pending_.empty()) {
+        return;
+    }
+    
+    auto now = BatchFlusher::Clock::now();
+    auto& stats = batch_flusher_->stats();
+    for (const auto& pending : pending_) {
+        stats.record_delay(std::chrono::duration_cast<std::chrono::microseconds>(
+            now - pending.queued_at).count());
+    }
+    stats.batched_messages.fetch_add(pending_.size(), std::memory_order_relaxed);
+    stats.batches.fetch_add(1, std::memory_order_relaxed);
+    
+    // Members who wrote none of the batch share one frame; authors get a
+    // copy without their own lines, as with single messages
+    std::vector<int> authors;
+    for (const auto& pending : pending_) {
+        authors.push_back(pending.sender_fd);
+    }
+    std::sort(authors.begin(), authors.end());
+    authors.erase(std::unique(authors.begin(), authors.end()), authors.end());
+    
+    std::vector<std::shared_ptr<ClientConnection>> readers;
+    readers.reserve(clients_.size());
+    for (const auto& client : clients_) {
+        if (!std::binary_search(authors.begin(), authors.end(), client->fd())) {
+            readers.push_back(client);
+            continue;
+        }
         
-        for (const auto& msg : chat_history_) {
-            send(client_fd, msg.c_str(), msg.length(), MSG_NOSIGNAL);
+        std::vector<std::reference_wrapper<const PendingMessage>> others;
+        for (const auto& pending : pending_) {
+            if (pending.sender_fd != client->fd()) {
+                others.push_back(pending);
+            }
+        }
+        if (!others.empty()) {
+            std::string frame;
+            NetworkMessage::write_message_batch(frame, name_, others);
+            client->deliver(make_payload(std::move(frame)));
+        }
+    }
+    
+    if (!readers.empty()) {
+        std::string frame;
+        NetworkMessage::write_message_batch(frame, name_, pending_);
+        ClientConnection::send_batch(*io_backend_, readers, make_payload(std::move(frame)));
+    }
+    for (auto& pending : pending_) {
+        if (!pending.trace.is_null()) {
+            finish_trace(std::move(pending.trace));
         }
+    }
+    pending_.clear();
+}
+
+void ChatRoom::broadcast_member_list() {
+    std::lock_guard<std::mutex> lock(room_mutex_);
+    
+    std::vector<std::string> names;
+    names.reserve(clients_.size());
+    for (const auto& client : clients_) {
+        names.push_back(client->name());
+    }
+    
+    std::string frame;
+    NetworkMessage::write_participant_list(frame, names, name_);
+    auto payload = make_payload(std::move(frame));
+    // A member list waiting on a slow client is replaced by the newer one
+    send_to_members_locked(payload, -1, "members:" + name_);
+}
+
+void ChatRoom::send_history_to_client(ClientConnection& client) {
+    std::lock_guard<std::mutex> lock(room_mutex_);
+    // Held messages reach the client in their batch, so leave them out here
+    size_t replay_count = chat_history_.size() - std::min(pending_.size(), chat_history_.size());
+    if (replay_count > 0) {
+        static const SharedPayload history_start = make_payload("=== Chat History ===\n");
+        static const SharedPayload history_end = make_payload("=== End of History ===\n");
+        
+        // Replay the whole history as a single gather write over the stored buffers
+        std::vector<SharedPayload> replay;
+        replay.reserve(chat_history_.size() + 2);
+        replay.push_back(history_start);
+        replay.insert(replay.end(), chat_history_.begin(), chat_history_.begin() + replay_count);
+        replay.push_back(history_end);
         
-        std::string end_msg = "=== End of History ===\n";
-        send(client_fd, end_msg.c_str(), end_msg.length(), MSG_NOSIGNAL);
+        client.send_sequence(replay);
     }
 }
 
@@ -89,7 +274,7 @@ std::vector<std::string> ChatRoom::get_client_names() const {
     std::lock_guard<std::mutex> lock(room_mutex_);
     std::vector<std::string> names;
     for (const auto& client : clients_) {
-        names.push_back(client.name);
+        names.push_back(client->name());
     }
     return names;
 }
@@ -98,7 +283,7 @@ std::vector<int> ChatRoom::get_client_fds() const {
     std::lock_guard<std::mutex> lock(room_mutex_);
     std::vector<int> fds;
     for (const auto& client : clients_) {
-        fds.push_back(client.fd);
+        fds.push_back(client->fd());
     }
     return fds;
 }
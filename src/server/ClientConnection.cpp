@@ -0,0 +1,379 @@
+#include "ClientConnection.h"
+#include <sys/socket.h>
+#include <algorithm>
+
+ClientConnection::ClientConnection(int fd, const std::string& name, const std::string& ip,
+                                   const std::string& token, std::shared_ptr<IoBackend> io_backend,
+                                   size_t max_queued_frames)
+    : fd_(fd)
+    , name_(name)
+    , ip_(ip)
+    , token_(token)
+    , io_backend_(std::move(io_backend))
+    , max_queued_frames_(std::max<size_t>(max_queued_frames, 1))
+    , last_inbound_(std::chrono::steady_clock::now().time_since_epoch().count()) {}
+
+bool ClientConnection::send(std::string_view frame) {
+    std::unique_lock<std::mutex> lock(write_mutex_);
+    if (failed_) {
+        return false;
+    }
+    charge_locked(1);
+    if (!can_write_now_locked()) {
+        commit_locked(make_payload(std::string(frame)));
+        flush_locked(lock);
+        return !failed_;
+    }
+
+    // Nothing ahead of it: write straight from the caller's buffer
+    writing_ = true;
+    lock.unlock();
+    ssize_t written = io_backend_->write_sequence(fd_, std::vector<std::string_view>{frame});
+    lock.lock();
+    writing_ = false;
+    if (written < 0) {
+        fail_locked();
+        return false;
+    }
+    if (static_cast<size_t>(written) < frame.size()) {
+        outbound_.push_front(QueuedFrame{make_payload(std::string(frame.substr(written))), {}});
+        ++committed_;
+        stall_locked();
+    } else {
+        write_blocked_since_.store(0, std::memory_order_relaxed);
+    }
+    flush_locked(lock);
+    return !failed_;
+}
+
+bool ClientConnection::send(const SharedPayload& frame) {
+    std::unique_lock<std::mutex> lock(write_mutex_);
+    if (failed_) {
+        return false;
+    }
+    charge_locked(1);
+    commit_locked(frame);
+    flush_locked(lock);
+    return !failed_;
+}
+
+bool ClientConnection::send_sequence(const std::vector<SharedPayload>& frames) {
+    std::unique_lock<std::mutex> lock(write_mutex_);
+    if (failed_) {
+        return false;
+    }
+    charge_locked(frames.size());
+    for (const auto& frame : frames) {
+        commit_locked(frame);
+    }
+    flush_locked(lock);
+    return !failed_;
+}
+
+bool ClientConnection::deliver(const SharedPayload& frame, std::string_view coalesce_key) {
+    std::unique_lock<std::mutex> lock(write_mutex_);
+    if (failed_) {
+        return false;
+    }
+    enqueue_locked(frame, coalesce_key);
+    flush_locked(lock);
+    return !failed_;
+}
+
+void ClientConnection::grant_credit(uint32_t frames) {
+    std::unique_lock<std::mutex> lock(write_mutex_);
+    flow_controlled_ = true;
+    credit_ += frames;
+    flush_locked(lock);
+}
+
+ClientConnection::PingResult ClientConnection::ping(std::string_view frame) {
+    {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        if (failed_) {
+            return PingResult::FAILED;
+        }
+        if (!can_write_now_locked()) {
+            return PingResult::BUSY;  // the socket is behind; the idle deadline still applies
+        }
+    }
+    return send(frame) ? PingResult::SENT : PingResult::FAILED;
+}
+
+void ClientConnection::touch() {
+    last_inbound_.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+}
+
+std::chrono::steady_clock::time_point ClientConnection::last_inbound() const {
+    return std::chrono::steady_clock::time_point(
+        std::chrono::steady_clock::duration(last_inbound_.load(std::memory_order_relaxed)));
+}
+
+void ClientConnection::reap() {
+    reaped_.store(true, std::memory_order_relaxed);
+    ::shutdown(fd_, SHUT_RDWR);
+}
+
+std::chrono::steady_clock::time_point ClientConnection::write_blocked_since() const {
+    return std::chrono::steady_clock::time_point(
+        std::chrono::steady_clock::duration(write_blocked_since_.load(std::memory_order_relaxed)));
+}
+
+bool ClientConnection::flow_controlled() const {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    return flow_controlled_;
+}
+
+size_t ClientConnection::queued_frames() const {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    return outbound_.size();
+}
+
+uint64_t ClientConnection::dropped_frames() const {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    return dropped_frames_;
+}
+
+uint64_t ClientConnection::coalesced_frames() const {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    return coalesced_frames_;
+}
+
+bool ClientConnection::can_write_now_locked() const {
+    // Anything committed goes first; uncommitted broadcasts may be overtaken by replies
+    return !writing_ && !stalled_ && !failed_ && committed_ == 0;
+}
+
+void ClientConnection::charge_locked(size_t frames) {
+    if (flow_controlled_) {
+        credit_ -= static_cast<int64_t>(frames);
+    }
+}
+
+void ClientConnection::enqueue_locked(const SharedPayload& frame, std::string_view coalesce_key) {
+    // Committed frames are already promised to the wire; only the rest may change
+    auto waiting = outbound_.begin() + static_cast<std::ptrdiff_t>(committed_);
+
+    // State frames (member/room lists) only matter in their latest version
+    if (!coalesce_key.empty()) {
+        for (auto it = waiting; it != outbound_.end(); ++it) {
+            if (it->coalesce_key == coalesce_key) {
+                it->payload = frame;
+                ++coalesced_frames_;
+                return;
+            }
+        }
+    }
+
+    if (outbound_.size() - committed_ >= max_queued_frames_) {
+        ++dropped_frames_;
+        auto oldest_chat = std::find_if(waiting, outbound_.end(),
+            [](const QueuedFrame& queued) { return queued.coalesce_key.empty(); });
+        if (oldest_chat != outbound_.end()) {
+            outbound_.erase(oldest_chat);
+        } else if (coalesce_key.empty() || waiting == outbound_.end()) {
+            // Queue holds only state frames; the new chat frame is the one to go
+            return;
+        } else {
+            // Only state frames, and a new key: the oldest makes room for it
+            outbound_.erase(waiting);
+        }
+    }
+
+    outbound_.push_back(QueuedFrame{frame, std::string(coalesce_key)});
+}
+
+void ClientConnection::commit_locked(const SharedPayload& frame) {
+    // Replies go after what is committed, ahead of broadcasts waiting for credit
+    outbound_.insert(outbound_.begin() + static_cast<std::ptrdiff_t>(committed_), QueuedFrame{frame, {}});
+    ++committed_;
+}
+
+void ClientConnection::flush_locked(std::unique_lock<std::mutex>& lock) {
+    while (!writing_ && !stalled_ && !failed_) {
+        while (committed_ < outbound_.size() && (!flow_controlled_ || credit_ > 0)) {
+            charge_locked(1);
+            ++committed_;
+        }
+        if (committed_ == 0) {
+            return;
+        }
+
+        // Everything committed goes out as one gather write
+        std::vector<SharedPayload> frames;
+        frames.reserve(committed_);
+        size_t total = 0;
+        for (size_t i = 0; i < committed_; ++i) {
+            frames.push_back(outbound_[i].payload);
+            total += outbound_[i].payload ? outbound_[i].payload->size() : 0;
+        }
+        size_t skip = front_written_;
+        total -= skip;
+
+        writing_ = true;
+        lock.unlock();
+        ssize_t written = io_backend_->write_sequence(fd_, frames, skip);
+        lock.lock();
+        writing_ = false;
+
+        if (written < 0) {
+            fail_locked();
+            return;
+        }
+        consume_locked(static_cast<size_t>(written));
+        if (static_cast<size_t>(written) < total) {
+            stall_locked();
+            return;
+        }
+        write_blocked_since_.store(0, std::memory_order_relaxed);
+    }
+}
+
+void ClientConnection::consume_locked(size_t bytes) {
+    bytes += front_written_;
+    front_written_ = 0;
+    while (!outbound_.empty() && committed_ > 0) {
+        size_t size = outbound_.front().payload ? outbound_.front().payload->size() : 0;
+        if (bytes < size) {
+            front_written_ = bytes;
+            return;
+        }
+        bytes -= size;
+        outbound_.pop_front();
+        --committed_;
+    }
+}
+
+void ClientConnection::stall_locked() {
+    stalled_ = true;
+    std::chrono::steady_clock::rep none = 0;
+    write_blocked_since_.compare_exchange_strong(none, std::chrono::steady_clock::now().time_since_epoch().count(),
+                                                 std::memory_order_relaxed);
+    io_backend_->wait_writable(fd_, [weak = weak_from_this()] {
+        if (auto self = weak.lock()) {
+            self->on_writable();
+        }
+    });
+}
+
+void ClientConnection::fail_locked() {
+    failed_ = true;
+    outbound_.clear();
+    committed_ = 0;
+    front_written_ = 0;
+}
+
+void ClientConnection::on_writable() {
+    std::unique_lock<std::mutex> lock(write_mutex_);
+    stalled_ = false;
+    flush_locked(lock);
+}
+
+size_t ClientConnection::send_batch(IoBackend& io_backend,
+                                    const std::vector<std::shared_ptr<ClientConnection>>& connections,
+                                    const SharedPayload& payload,
+                                    std::string_view coalesce_key) {
+    if (connections.empty() || !payload) {
+        return 0;
+    }
+
+    std::vector<ClientConnection*> unique;
+    unique.reserve(connections.size());
+    for (const auto& connection : connections) {
+        unique.push_back(connection.get());
+    }
+    std::sort(unique.begin(), unique.end());
+    unique.erase(std::unique(unique.begin(), unique.end()), unique.end());
+
+    // Decide per connection, one lock at a time: write now, or queue behind its backlog
+    std::vector<ClientConnection*> writers;
+    std::vector<int> fds;
+    writers.reserve(unique.size());
+    fds.reserve(unique.size());
+    size_t taken = 0;
+    for (auto* connection : unique) {
+        std::unique_lock<std::mutex> lock(connection->write_mutex_);
+        if (connection->failed_) {
+            continue;
+        }
+        if (connection->can_write_now_locked() && connection->outbound_.empty() &&
+            (!connection->flow_controlled_ || connection->credit_ > 0)) {
+            connection->charge_locked(1);
+            connection->writing_ = true;
+            writers.push_back(connection);
+            fds.push_back(connection->fd_);
+            continue;
+        }
+        connection->enqueue_locked(payload, coalesce_key);
+        connection->flush_locked(lock);
+        ++taken;
+    }
+
+    if (fds.empty()) {
+        return taken;
+    }
+    std::vector<ssize_t> written;
+    io_backend.write_batch(fds, payload, written);
+
+    // Keep whatever a full socket did not take, ahead of anything queued meanwhile
+    for (size_t i = 0; i < writers.size(); ++i) {
+        ClientConnection* connection = writers[i];
+        std::unique_lock<std::mutex> lock(connection->write_mutex_);
+        connection->writing_ = false;
+        if (written[i] < 0) {
+            connection->fail_locked();
+            continue;
+        }
+        ++taken;
+        if (static_cast<size_t>(written[i]) < payload->size()) {
+            connection->outbound_.push_front(QueuedFrame{payload, std::string(coalesce_key)});
+            ++connection->committed_;
+            connection->front_written_ = static_cast<size_t>(written[i]);
+            connection->stall_locked();
+        } else {
+            connection->write_blocked_since_.store(0, std::memory_order_relaxed);
+        }
+        connection->flush_locked(lock);
+    }
+    return taken;
+}
+
+std::string ClientConnection::current_room() const {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    return current_room_;
+}
+
+void ClientConnection::set_current_room(const std::string& room) {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    current_room_ = room;
+}
+
+bool ClientConnection::subscribe(const std::string& room) {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    return rooms_.insert(room).second;
+}
+
+bool ClientConnection::unsubscribe(const std::string& room) {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    return rooms_.erase(room) > 0;
+}
+
+bool ClientConnection::is_subscribed(const std::string& room) const {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    return rooms_.count(room) > 0;
+}
+
+std::vector<std::string> ClientConnection::rooms() const {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    return std::vector<std::string>(rooms_.begin(), rooms_.end());
+}
+
+bool ClientConnection::paged_room_list() const {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    return paged_room_list_;
+}
+
+void ClientConnection::set_paged_room_list(bool paged) {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    paged_room_list_ = paged;
+}
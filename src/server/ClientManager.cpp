@@ -8,392 +8,557 @@
 #include <algorithm>
 #include <sstream>
 #include <chrono>
+#include <thread>
 
 constexpr int BUFFER_SIZE = 4096;
+// Longest frame a client may send, newline included; it used to be one read
+constexpr size_t MAX_FRAME_SIZE = BUFFER_SIZE;
 
-ClientManager::ClientManager(const std::string& auth_host, int auth_port)
-    : auth_host_(auth_host)
-    , auth_port_(auth_port) {
+namespace {
+
+// One write per line, so concurrent sessions cannot interleave mid-line
+// without a server-wide lock around the log
+void log_line(const std::ostringstream& line, bool flush = false) {
+    std::string text = line.str();
+    std::cout.write(text.data(), static_cast<std::streamsize>(text.size()));
+    if (flush) {
+        std::cout.flush();
+    }
+}
+
+} // namespace
+
+ClientManager::ClientManager(std::shared_ptr<IAuthService> auth_service,
+                             std::shared_ptr<IoBackend> io_backend,
+                             std::shared_ptr<BatchFlusher> batch_flusher,
+                             std::shared_ptr<tracing::TraceLog> trace_log,
+                             size_t lock_stripes)
+    : batch_flusher_(std::move(batch_flusher))
+    , trace_log_(std::move(trace_log))
+    , auth_service_(auth_service ? std::move(auth_service) : std::make_shared<AuthClient>(AuthEndpoint{}))
+    , io_backend_(io_backend ? std::move(io_backend) : std::make_shared<PosixIoBackend>()) {
+    if (lock_stripes == 0) {
+        lock_stripes = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (size_t i = 0; i < lock_stripes; ++i) {
+        stripes_.push_back(std::make_unique<Stripe>());
+    }
+    
     // Create a default "General" room
-    chat_rooms_["General"] = std::make_shared<ChatRoom>("General");
+    stripe_for("General").chat_rooms["General"] = std::make_shared<ChatRoom>("General", io_backend_, batch_flusher_, trace_log_);
+    room_directory_.add("General");
+    
+    foyer_thread_ = std::thread(&ClientManager::foyer_loop, this);
+}
+
+ClientManager::~ClientManager() {
+    {
+        std::lock_guard<std::mutex> lock(foyer_mutex_);
+        stopping_ = true;
+    }
+    foyer_cv_.notify_one();
+    foyer_thread_.join();
+}
+
+void ClientManager::set_history_index(std::shared_ptr<HistoryIndex> index) {
+    history_index_ = std::move(index);
+    for (const auto& stripe : stripes_) {
+        std::lock_guard<std::mutex> lock(stripe->mutex);
+        for (const auto& [name, room] : stripe->chat_rooms) {
+            room->set_history_index(history_index_);
+        }
+    }
+}
+
+void ClientManager::notify_foyer() {
+    // Only the first change of a burst takes the lock to wake the thread
+    if (!foyer_dirty_.exchange(true)) {
+        std::lock_guard<std::mutex> lock(foyer_mutex_);
+        foyer_cv_.notify_one();
+    }
+}
+
+void ClientManager::foyer_loop() {
+    std::unique_lock<std::mutex> lock(foyer_mutex_);
+    while (!stopping_) {
+        foyer_cv_.wait(lock, [this] { return stopping_ || foyer_dirty_; });
+        // Let the rest of a burst of joins and leaves land, then tell the foyer once
+        if (stopping_ || foyer_cv_.wait_for(lock, FOYER_NOTIFY_INTERVAL, [this] { return stopping_; })) {
+            break;
+        }
+        foyer_dirty_ = false;
+        lock.unlock();
+        sync_directory();
+        broadcast_room_list_to_foyer();
+        lock.lock();
+    }
+}
+
+void ClientManager::mark_directory_dirty(const std::string& room_name) {
+    Stripe& stripe = stripe_for(room_name);
+    {
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        stripe.directory_dirty.insert(room_name);
+    }
+    directory_dirty_ = true;
 }
 
-ClientManager::~ClientManager() {}
+void ClientManager::sync_directory() {
+    std::lock_guard<std::mutex> sync_lock(directory_sync_mutex_);
+    if (!directory_dirty_.exchange(false)) {
+        return;
+    }
+    for (const auto& stripe : stripes_) {
+        std::vector<std::pair<std::string, std::shared_ptr<ChatRoom>>> changed;
+        {
+            std::lock_guard<std::mutex> lock(stripe->mutex);
+            for (const auto& name : stripe->directory_dirty) {
+                auto it = stripe->chat_rooms.find(name);
+                if (it != stripe->chat_rooms.end()) {
+                    changed.emplace_back(name, it->second);
+                }
+            }
+            stripe->directory_dirty.clear();
+        }
+        // Counts are read now, so a change after the clear is re-marked and not lost
+        for (const auto& [name, room] : changed) {
+            room_directory_.add(name);
+            room_directory_.set_members(name, room->get_client_count());
+        }
+    }
+}
 
 void ClientManager::remove_client(int client_fd) {
-    std::lock_guard<std::mutex> lock(clients_mutex_);
-    connected_clients_.erase(
-        std::remove_if(connected_clients_.begin(), connected_clients_.end(),
-            [client_fd](const ClientInfo& c) { return c.fd == client_fd; }),
-        connected_clients_.end()
-    );
+    io_backend_->forget(client_fd);
+    
+    Stripe& stripe = stripe_for(client_fd);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    stripe.connections.erase(client_fd);
 }
 
-std::string ClientManager::get_client_name(int client_fd) {
-    std::lock_guard<std::mutex> lock(clients_mutex_);
-    auto it = std::find_if(connected_clients_.begin(), connected_clients_.end(),
-        [client_fd](const ClientInfo& c) { return c.fd == client_fd; });
-    if (it != connected_clients_.end()) {
-        return it->name;
-    }
-    return "Unknown";
+std::shared_ptr<ChatRoom> ClientManager::find_room(const std::string& room_name) {
+    Stripe& stripe = stripe_for(room_name);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    auto it = stripe.chat_rooms.find(room_name);
+    return it != stripe.chat_rooms.end() ? it->second : nullptr;
+}
+
+std::vector<std::string> ClientManager::room_names() const {
+    std::vector<std::string> names;
+    for (const auto& stripe : stripes_) {
+        std::lock_guard<std::mutex> lock(stripe->mutex);
+        for (const auto& [name, room] : stripe->chat_rooms) {
+            names.push_back(name);
+        }
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+std::vector<ClientManagerStripeStats> ClientManager::stripe_stats() const {
+    std::vector<ClientManagerStripeStats> stats;
+    for (const auto& stripe : stripes_) {
+        std::lock_guard<std::mutex> lock(stripe->mutex);
+        stats.push_back(ClientManagerStripeStats{stripe->connections.size(), stripe->chat_rooms.size(),
+                                                stripe->token_cache_hits.load(std::memory_order_relaxed),
+                                                stripe->token_cache_misses.load(std::memory_order_relaxed)});
+    }
+    return stats;
+}
+
+void ClientManager::send_error(ClientConnection& client, const std::string& message) {
+    client.send(NetworkMessage::create_error(message).serialize());
 }
 
 bool ClientManager::validate_token(const std::string& token) {
     auto now = std::chrono::steady_clock::now();
+    Stripe& stripe = stripe_for(token);
     
     // Check cache first
     {
-        std::lock_guard<std::mutex> lock(token_cache_mutex_);
-        auto it = token_cache_.find(token);
-        if (it != token_cache_.end()) {
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        auto it = stripe.token_cache.find(token);
+        if (it != stripe.token_cache.end()) {
             auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - it->second).count();
             if (elapsed < TOKEN_CACHE_SECONDS) {
                 // Token recently validated, trust cache
+                stripe.token_cache_hits.fetch_add(1, std::memory_order_relaxed);
                 return true;
             }
         }
     }
+    stripe.token_cache_misses.fetch_add(1, std::memory_order_relaxed);
     
-    // Validate with auth server
-    AuthClient auth_client(auth_host_, auth_port_);
-    bool valid = auth_client.validate_token(token);
+    // Validate with auth service
+    bool valid = auth_service_->validate_token(token);
     
     if (valid) {
         // Update cache
-        std::lock_guard<std::mutex> lock(token_cache_mutex_);
-        token_cache_[token] = now;
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        stripe.token_cache[token] = now;
     }
     
     return valid;
 }
 
-std::string ClientManager::request_client_name(int client_fd, const std::string& client_ip) {
-    // Client should send: JSON AUTH message
-    char buffer[4096];
-    ssize_t bytes = recv(client_fd, buffer, sizeof(buffer) - 1, 0);
-    
-    if (bytes <= 0) {
-        std::lock_guard<std::mutex> lock(cout_mutex_);
-        std::cerr << "Client from " << client_ip << " disconnected before providing token\n";
-        return "";
-    }
-    
-    buffer[bytes] = '\0';
-    std::string message = buffer;
-    
-    // Parse JSON message
-    auto net_msg = NetworkMessage::deserialize(message);
-    
-    if (net_msg.body.type != "AUTH") {
-        std::lock_guard<std::mutex> lock(cout_mutex_);
-        std::cerr << "Client from " << client_ip << " sent invalid message (expected AUTH)\n";
-        auto error_msg = NetworkMessage::create_error("Expected AUTH message");
-        std::string error_str = error_msg.serialize();
-        send(client_fd, error_str.c_str(), error_str.length(), 0);
-        return "";
+void ClientManager::send_room_list(ClientConnection& client) {
+    client.send(NetworkMessage::create_room_list(room_names()).serialize());
+}
+
+void ClientManager::send_room_page(ClientConnection& client, const proto::ListRooms& request) {
+    RoomQuery query;
+    query.prefix = request.prefix;
+    query.sort = RoomDirectory::parse_sort(request.sort);
+    query.cursor = request.cursor;
+    query.limit = request.limit;
+    
+    sync_directory();
+    RoomPage page = room_directory_.query(query);
+    std::vector<proto::RoomItem> rooms;
+    rooms.reserve(page.rooms.size());
+    for (const auto& room : page.rooms) {
+        rooms.push_back(proto::RoomItem{room.name, room.members});
     }
     
-    std::string token = net_msg.header.token;
-    
-    // Validate token with auth server
-    AuthClient auth_client(auth_host_, auth_port_);
-    auto user_info = auth_client.get_user_info(token);
+    client.send(NetworkMessage::create_room_page(query.prefix, RoomDirectory::sort_name(query.sort),
+                                                 query.cursor, rooms, page.next_cursor,
+                                                 page.total).serialize());
+}
+
+void ClientManager::send_search_results(ClientConnection& client, const proto::SearchRooms& request) {
+    RoomMatch match = RoomDirectory::parse_match(request.match);
     
-    if (!user_info) {
-        std::lock_guard<std::mutex> lock(cout_mutex_);
-        std::cerr << "Client from " << client_ip << " provided invalid token\n";
-        const char* error_msg = "ERROR: Invalid or expired token\n";
-        send(client_fd, error_msg, strlen(error_msg), 0);
-        return "";
+    sync_directory();
+    std::vector<proto::RoomItem> rooms;
+    for (const auto& room : room_directory_.search(request.query, match, request.limit)) {
+        rooms.push_back(proto::RoomItem{room.name, room.members});
     }
     
-    // Store token in client_info for later validation
-    // (caller needs to handle this)
-    
-    // Success - return display name
-    return user_info->display_name;
+    client.send(NetworkMessage::create_search_results(request.query, RoomDirectory::match_name(match),
+                                                      rooms).serialize());
 }
 
-void ClientManager::send_room_list(int client_fd) {
-    std::lock_guard<std::mutex> lock(rooms_mutex_);
-    std::vector<std::string> room_names;
-    for (const auto& [name, room] : chat_rooms_) {
-        room_names.push_back(name);
+void ClientManager::send_history_results(ClientConnection& client, const proto::SearchHistory& request) {
+    if (!history_index_) {
+        send_error(client, "History search is disabled");
+        return;
+    }
+    std::string room_name = request.room_name;
+    if (room_name.empty()) {
+        room_name = client.current_room();
+    }
+    if (!find_room(room_name)) {
+        send_error(client, "Room not found");
+        return;
     }
     
-    auto msg = NetworkMessage::create_room_list(room_names);
-    std::string msg_str = msg.serialize();
-    send(client_fd, msg_str.c_str(), msg_str.length(), 0);
+    std::vector<proto::HistoryItem> results;
+    for (const auto& hit : history_index_->search(room_name, request.query, request.limit)) {
+        results.push_back(proto::HistoryItem{hit.seq, hit.sender, hit.message, hit.timestamp_ms, hit.score});
+    }
+    
+    client.send(NetworkMessage::create_history_results(room_name, request.query, results).serialize());
 }
 
 void ClientManager::broadcast_room_list_to_foyer() {
-    // Send room list update to all clients in foyer (not in a room)
-    std::vector<int> foyer_clients;
-    {
-        std::lock_guard<std::mutex> lock(clients_mutex_);
-        for (const auto& client : connected_clients_) {
-            if (client.current_room.empty()) {
-                foyer_clients.push_back(client.fd);
+    // Send room list update to all clients in foyer (no primary room)
+    std::vector<std::shared_ptr<ClientConnection>> foyer_clients;
+    std::vector<std::shared_ptr<ClientConnection>> paged_clients;
+    for (const auto& stripe : stripes_) {
+        std::lock_guard<std::mutex> lock(stripe->mutex);
+        for (const auto& [fd, client] : stripe->connections) {
+            if (client->current_room().empty()) {
+                (client->paged_room_list() ? paged_clients : foyer_clients).push_back(client);
             }
         }
     }
     
-    for (int fd : foyer_clients) {
-        send_room_list(fd);
+    // Paged clients only hear that something changed and re-fetch the rows they show
+    if (!paged_clients.empty()) {
+        auto notice = make_payload(NetworkMessage::create_rooms_changed(room_directory_.size()).serialize());
+        ClientConnection::send_batch(*io_backend_, paged_clients, notice, "rooms");
     }
-}
-
-void ClientManager::broadcast_member_list_to_room(const std::string& room_name) {
-    std::shared_ptr<ChatRoom> room;
-    {
-        std::lock_guard<std::mutex> lock(rooms_mutex_);
-        auto it = chat_rooms_.find(room_name);
-        if (it == chat_rooms_.end()) {
-            return;
-        }
-        room = it->second;
-    }
-    
-    // Get list of members
-    auto members = room->get_client_names();
     
-    // Create JSON message
-    auto msg = NetworkMessage::create_participant_list(members);
-    std::string msg_str = msg.serialize();
-    
-    // Send to all clients in the room
-    auto client_fds = room->get_client_fds();
-    for (int fd : client_fds) {
-        send(fd, msg_str.c_str(), msg_str.length(), MSG_NOSIGNAL);
+    if (foyer_clients.empty()) {
+        return;
     }
+    
+    // Build the list once and fan it out in a single batch
+    auto payload = make_payload(NetworkMessage::create_room_list(room_names()).serialize());
+    ClientConnection::send_batch(*io_backend_, foyer_clients, payload, "rooms");
 }
 
 bool ClientManager::create_room(const std::string& room_name) {
-    std::lock_guard<std::mutex> lock(rooms_mutex_);
-    if (chat_rooms_.find(room_name) != chat_rooms_.end()) {
+    Stripe& stripe = stripe_for(room_name);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    if (stripe.chat_rooms.find(room_name) != stripe.chat_rooms.end()) {
         return false;
     }
-    chat_rooms_[room_name] = std::make_shared<ChatRoom>(room_name);
+    auto room = std::make_shared<ChatRoom>(room_name, io_backend_, batch_flusher_, trace_log_);
+    if (history_index_) {
+        room->set_history_index(history_index_);
+    }
+    stripe.chat_rooms[room_name] = room;
+    stripe.directory_dirty.insert(room_name);
+    directory_dirty_ = true;
     return true;
 }
 
-bool ClientManager::join_room(int client_fd, ClientInfo& client_info, const std::string& room_name) {
-    std::shared_ptr<ChatRoom> room;
-    {
-        std::lock_guard<std::mutex> lock(rooms_mutex_);
-        auto it = chat_rooms_.find(room_name);
-        if (it == chat_rooms_.end()) {
-            return false;
-        }
-        room = it->second;
+bool ClientManager::subscribe_room(const std::shared_ptr<ClientConnection>& client, const std::string& room_name,
+                                   const std::string& ack) {
+    auto room = find_room(room_name);
+    if (!room) {
+        return false;
     }
     
-    client_info.current_room = room_name;
-    room->add_client(client_fd, client_info.name, client_info.ip);
+    if (!client->subscribe(room_name)) {
+        client->send(ack);  // already receiving this room
+        return true;
+    }
     
-    // Broadcast join notification
-    auto join_notification = NetworkMessage::create_broadcast_message("SERVER", client_info.name + " joined the room");
-    std::string join_str = join_notification.serialize();
-    room->broadcast_message(join_str, client_fd);
+    room->add_client(client);
+    mark_directory_dirty(room_name);
+    room->broadcast_message("SERVER", client->name() + " joined the room", client->fd());
+    room->send_history_to_client(*client);
+    client->send(ack);
+    room->broadcast_member_list();
     
-    room->send_history_to_client(client_fd);
+    std::ostringstream line;
+    line << client->name() << " (" << client->ip() << ") joined room: " << room_name << "\n";
+    log_line(line);
+    return true;
+}
+
+bool ClientManager::unsubscribe_room(const std::shared_ptr<ClientConnection>& client, const std::string& room_name) {
+    if (!client->unsubscribe(room_name)) {
+        return false;
+    }
     
-    // Send success response
-    auto success_msg = NetworkMessage::create_room_joined(room_name);
-    std::string success_str = success_msg.serialize();
-    send(client_fd, success_str.c_str(), success_str.length(), 0);
+    auto room = find_room(room_name);
+    if (room) {
+        room->broadcast_message("SERVER", client->name() + " left the room", client->fd());
+        room->remove_client(client->fd());
+        mark_directory_dirty(room_name);
+        room->broadcast_member_list();
+        
+        std::ostringstream line;
+        line << client->name() << " (" << client->ip() << ") left room: " << room_name << "\n";
+        log_line(line);
+    }
+    return true;
+}
+
+bool ClientManager::join_room(const std::shared_ptr<ClientConnection>& client, const std::string& room_name) {
+    if (!find_room(room_name)) {
+        return false;
+    }
     
-    // Notify foyer clients of room count change
-    broadcast_room_list_to_foyer();
+    // Only one primary room; other rooms stay available through SUBSCRIBE
+    std::string previous = client->current_room();
+    if (!previous.empty() && previous != room_name) {
+        leave_room(client);
+    }
     
-    // Broadcast updated member list to all in room
-    broadcast_member_list_to_room(room_name);
+    client->set_current_room(room_name);
+    subscribe_room(client, room_name, NetworkMessage::create_room_joined(room_name).serialize());
     
-    {
-        std::lock_guard<std::mutex> lock(cout_mutex_);
-        std::cout << client_info.name << " (" << client_info.ip << ") joined room: " << room_name << "\n";
-    }
+    // Notify foyer clients of room count change
+    notify_foyer();
     
     return true;
 }
 
-void ClientManager::leave_room(int client_fd, ClientInfo& client_info) {
-    if (client_info.current_room.empty()) {
+void ClientManager::leave_room(const std::shared_ptr<ClientConnection>& client) {
+    std::string room_name = client->current_room();
+    if (room_name.empty()) {
         return;
     }
     
-    std::shared_ptr<ChatRoom> room;
-    {
-        std::lock_guard<std::mutex> lock(rooms_mutex_);
-        auto it = chat_rooms_.find(client_info.current_room);
-        if (it != chat_rooms_.end()) {
-            room = it->second;
-        }
-    }
+    client->set_current_room("");
+    unsubscribe_room(client, room_name);
     
-    if (room) {
-        // Broadcast leave notification
-        auto leave_notification = NetworkMessage::create_broadcast_message("SERVER", client_info.name + " left the room");
-        std::string leave_str = leave_notification.serialize();
-        room->broadcast_message(leave_str, client_fd);
-        room->remove_client(client_fd);
-        
-        {
-            std::lock_guard<std::mutex> lock(cout_mutex_);
-            std::cout << client_info.name << " (" << client_info.ip << ") left room: " << client_info.current_room << "\n";
-        }
-    }
-    
-    client_info.current_room.clear();
-    auto left_msg = NetworkMessage::create_error("Left room");  // Using error type with message
-    left_msg.body.type = "LEFT_ROOM";
-    std::string left_str = left_msg.serialize();
-    send(client_fd, left_str.c_str(), left_str.length(), 0);
+    client->send(NetworkMessage::create_left_room().serialize());
     
-    // Notify foyer clients of room count change
-    broadcast_room_list_to_foyer();
+    // Notify foyer clients (now including this one) of room count change
+    notify_foyer();
 }
 
-void ClientManager::handle_foyer(int client_fd, ClientInfo& client_info) {
-    send_room_list(client_fd);
+bool ClientManager::dispatch(const std::shared_ptr<ClientConnection>& client, const NetworkMessage& net_msg) {
+    const json& data = net_msg.body.data;
     
-    char buffer[BUFFER_SIZE];
-    while (true) {
-        ssize_t bytes_read = recv(client_fd, buffer, sizeof(buffer) - 1, 0);
-        
-        if (bytes_read <= 0) {
-            return;
-        }
-        
-        buffer[bytes_read] = '\0';
-        std::string message(buffer);
-        
-        // Parse JSON message
-        auto net_msg = NetworkMessage::deserialize(message);
-        
-        // Validate token
-        if (!validate_token(net_msg.header.token)) {
-            auto error_msg = NetworkMessage::create_error("Invalid or expired token");
-            std::string error_str = error_msg.serialize();
-            send(client_fd, error_str.c_str(), error_str.length(), 0);
-            return;
-        }
-        
-        if (net_msg.body.type == "CREATE_ROOM") {
-            std::string room_name = net_msg.body.data.value("room_name", "");
+    switch (proto::id_of(net_msg.body.type)) {
+        case proto::MessageId::CreateRoom: {
+            const std::string room_name = proto::CreateRoom::from_json(data).room_name;
             if (create_room(room_name)) {
                 // Auto-join the creator to the new room
-                if (join_room(client_fd, client_info, room_name)) {
-                    // Notify all foyer clients about the new room
-                    broadcast_room_list_to_foyer();
-                    
-                    std::lock_guard<std::mutex> lock(cout_mutex_);
-                    std::cout << client_info.name << " created and joined room: " << room_name << "\n";
-                    return;
-                }
+                join_room(client, room_name);
+                
+                std::ostringstream line;
+                line << client->name() << " created and joined room: " << room_name << "\n";
+                log_line(line);
             } else {
-                auto error_msg = NetworkMessage::create_error("Room already exists");
-                std::string error_str = error_msg.serialize();
-                send(client_fd, error_str.c_str(), error_str.length(), 0);
+                send_error(*client, "Room already exists");
             }
-        } else if (net_msg.body.type == "JOIN_ROOM") {
-            std::string room_name = net_msg.body.data.value("room_name", "");
-            if (join_room(client_fd, client_info, room_name)) {
-                return;
+            break;
+        }
+        case proto::MessageId::JoinRoom:
+            if (!join_room(client, proto::JoinRoom::from_json(data).room_name)) {
+                send_error(*client, "Room not found");
+            }
+            break;
+        case proto::MessageId::Subscribe: {
+            const std::string room_name = proto::Subscribe::from_json(data).room_name;
+            if (!subscribe_room(client, room_name, NetworkMessage::create_subscribed(room_name).serialize())) {
+                send_error(*client, "Room not found");
+            }
+            break;
+        }
+        case proto::MessageId::Unsubscribe: {
+            const std::string room_name = proto::Unsubscribe::from_json(data).room_name;
+            if (room_name == client->current_room()) {
+                leave_room(client);
+            } else if (unsubscribe_room(client, room_name)) {
+                client->send(NetworkMessage::create_unsubscribed(room_name).serialize());
             } else {
-                auto error_msg = NetworkMessage::create_error("Room not found");
-                std::string error_str = error_msg.serialize();
-                send(client_fd, error_str.c_str(), error_str.length(), 0);
+                send_error(*client, "Not subscribed to room");
             }
-        } else if (net_msg.body.type == "REFRESH_ROOMS") {
-            send_room_list(client_fd);
-        } else if (net_msg.body.type == "QUIT") {
-            return;
+            break;
+        }
+        case proto::MessageId::Leave:
+            leave_room(client);
+            break;
+        case proto::MessageId::RefreshRooms:
+            send_room_list(*client);
+            break;
+        case proto::MessageId::ListRooms:
+            send_room_page(*client, proto::ListRooms::from_json(data));
+            break;
+        case proto::MessageId::SearchRooms:
+            send_search_results(*client, proto::SearchRooms::from_json(data));
+            break;
+        case proto::MessageId::ChatMessage: {
+            auto chat = proto::ChatMessage::from_json(data);
+            // Untagged messages go to the primary room
+            if (chat.room_name.empty()) {
+                chat.room_name = client->current_room();
+            }
+            auto room = client->is_subscribed(chat.room_name) ? find_room(chat.room_name) : nullptr;
+            if (!room) {
+                send_error(*client, "Not subscribed to room");
+                break;
+            }
+            
+            {
+                std::ostringstream line;
+                line << "[" << chat.room_name << "] [" << client->name() << "] " << chat.message << "\n";
+                log_line(line, true);
+            }
+            room->broadcast_message(client->name(), chat.message, client->fd(), net_msg.header.trace);
+            break;
         }
+        case proto::MessageId::SearchHistory:
+            send_history_results(*client, proto::SearchHistory::from_json(data));
+            break;
+        case proto::MessageId::Credit:
+            client->grant_credit(proto::Credit::from_json(data).frames);
+            break;
+        case proto::MessageId::Pong:
+            break;  // the read already counted as activity
+        case proto::MessageId::Quit:
+            if (!client->current_room().empty()) {
+                leave_room(client);
+                send_error(*client, "Disconnected");
+            }
+            return false;
+        default:
+            break;  // server-to-client types and unknown frames are ignored
     }
+    return true;
 }
 
-void ClientManager::handle_room_chat(int client_fd, ClientInfo& client_info) {
-    std::shared_ptr<ChatRoom> room;
-    {
-        std::lock_guard<std::mutex> lock(rooms_mutex_);
-        auto it = chat_rooms_.find(client_info.current_room);
-        if (it != chat_rooms_.end()) {
-            room = it->second;
-        }
-    }
-    
-    if (!room) {
-        return;
+void ClientManager::handle_session(const std::shared_ptr<ClientConnection>& client, std::string pending,
+                                   uint64_t capture_id) {
+    if (client->paged_room_list()) {
+        send_room_page(*client, proto::ListRooms{});  // first page, default query
+    } else {
+        send_room_list(*client);
     }
     
     char buffer[BUFFER_SIZE];
+    bool have_data = !pending.empty();
+    int64_t received_us = tracing::now_us();
     while (true) {
-        ssize_t bytes_read = recv(client_fd, buffer, sizeof(buffer) - 1, 0);
-        
-        if (bytes_read <= 0) {
-            return;
-        }
-        
-        buffer[bytes_read] = '\0';
-        std::string msg_str(buffer);
-        
-        // Parse JSON message
-        auto net_msg = NetworkMessage::deserialize(msg_str);
-        
-        // Validate token
-        if (!validate_token(net_msg.header.token)) {
-            auto error_msg = NetworkMessage::create_error("Invalid or expired token");
-            std::string error_str = error_msg.serialize();
-            send(client_fd, error_str.c_str(), error_str.length(), 0);
-            return;
+        if (!have_data) {
+            ssize_t bytes_read = recv(client->fd(), buffer, sizeof(buffer), 0);
+            
+            if (bytes_read <= 0) {
+                return;
+            }
+            pending.append(buffer, bytes_read);
+            received_us = tracing::now_us();
+            client->touch();
         }
+        have_data = false;
         
-        if (net_msg.body.type == "LEAVE") {
-            leave_room(client_fd, client_info);
-            return;
-        } else if (net_msg.body.type == "QUIT") {
-            leave_room(client_fd, client_info);
-            auto quit_msg = NetworkMessage::create_error("Disconnected");
-            std::string quit_str = quit_msg.serialize();
-            send(client_fd, quit_str.c_str(), quit_str.length(), 0);
-            return;
-        } else if (net_msg.body.type == "CHAT_MESSAGE") {
-            std::string message = net_msg.body.data.value("message", "");
+        // Frames are newline-terminated JSON; one read may hold several or part of one
+        size_t start = 0;
+        for (size_t end; (end = pending.find('\n', start)) != std::string::npos; start = end + 1) {
+            if (end - start >= MAX_FRAME_SIZE) {
+                send_error(*client, "Frame too large");
+                return;
+            }
+            auto net_msg = NetworkMessage::deserialize(pending.substr(start, end - start));
+            bool traced = !net_msg.header.trace.is_null();
+            if (traced && !tracing::well_formed(net_msg.header.trace)) {
+                net_msg.header.trace = nullptr;
+                traced = false;
+            }
             
-            std::string display_name = client_info.name;
-            {
-                std::lock_guard<std::mutex> lock(cout_mutex_);
-                std::cout << "[" << client_info.current_room << "] [" << display_name << "] " << message << "\n";
-                std::cout.flush();
+            // Validate token
+            if (!validate_token(net_msg.header.token)) {
+                send_error(*client, "Invalid or expired token");
+                return;
+            }
+            if (traced) {
+                tracing::stamp(net_msg.header.trace, tracing::SERVER_RECV, received_us);
+                tracing::stamp(net_msg.header.trace, tracing::SERVER_VALIDATED);
             }
             
-            // Broadcast as JSON message
-            auto broadcast_msg = NetworkMessage::create_broadcast_message(display_name, message);
-            std::string broadcast_str = broadcast_msg.serialize();
-            room->broadcast_message(broadcast_str, client_fd);
+            if (capture_id) {
+                capture_->frame(capture_id, net_msg);
+            }
+            if (!dispatch(client, net_msg)) {
+                return;
+            }
+        }
+        pending.erase(0, start);
+        
+        // Without a newline in sight the partial frame must not grow without bound
+        if (pending.size() >= MAX_FRAME_SIZE) {
+            send_error(*client, "Frame too large");
+            return;
         }
     }
 }
 
 void ClientManager::handle_client(int client_fd, const std::string& client_ip) {
-    // Receive token first
+    // Receive token first; the client may send more frames (CREDIT) right behind it
     char token_buffer[512];
-    ssize_t token_bytes = recv(client_fd, token_buffer, sizeof(token_buffer) - 1, 0);
-    
-    if (token_bytes <= 0) {
-        close(client_fd);
-        return;
+    std::string received;
+    size_t auth_end;
+    while ((auth_end = received.find('\n')) == std::string::npos) {
+        ssize_t token_bytes = recv(client_fd, token_buffer, sizeof(token_buffer), 0);
+        if (token_bytes <= 0 || received.size() > MAX_FRAME_SIZE) {
+            close(client_fd);
+            return;
+        }
+        received.append(token_buffer, token_bytes);
     }
     
-    token_buffer[token_bytes] = '\0';
-    std::string token_message = token_buffer;
-    
     // Parse JSON message
-    auto net_msg = NetworkMessage::deserialize(token_message);
+    auto net_msg = NetworkMessage::deserialize(received.substr(0, auth_end));
     
-    if (net_msg.body.type != "AUTH") {
+    if (proto::id_of(net_msg.body.type) != proto::MessageId::Auth) {
         close(client_fd);
         return;
     }
@@ -401,8 +566,7 @@ void ClientManager::handle_client(int client_fd, const std::string& client_ip) {
     std::string token = net_msg.header.token;
     
     // Validate token
-    AuthClient auth_client(auth_host_, auth_port_);
-    auto user_info = auth_client.get_user_info(token);
+    auto user_info = auth_service_->get_user_info(token);
     
     if (!user_info) {
         auto error_msg = NetworkMessage::create_error("Invalid or expired token");
@@ -414,40 +578,60 @@ void ClientManager::handle_client(int client_fd, const std::string& client_ip) {
     
     std::string client_name = user_info->display_name;
     
-    ClientInfo client_info{client_fd, client_name, client_ip, "", token};
+    auto client = std::make_shared<ClientConnection>(client_fd, client_name, client_ip, token, io_backend_,
+                                                     outbound_queue_limit_);
+    client->set_paged_room_list(proto::Auth::from_json(net_msg.body.data).room_list == "paged");
     
     {
-        std::lock_guard<std::mutex> lock(clients_mutex_);
-        connected_clients_.push_back(client_info);
+        Stripe& stripe = stripe_for(client_fd);
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        stripe.connections[client_fd] = client;
     }
     
     {
-        std::lock_guard<std::mutex> lock(cout_mutex_);
-        std::cout << "Client connected: " << client_name << " (" << client_ip << ")\n";
+        std::ostringstream line;
+        line << "Client connected: " << client_name << " (" << client_ip << ")\n";
+        log_line(line);
     }
     
-    // Main loop: alternate between foyer and room
-    while (true) {
-        handle_foyer(client_fd, client_info);
-        
-        if (client_info.current_room.empty()) {
-            break;
-        }
-        
-        handle_room_chat(client_fd, client_info);
-        
-        if (client_info.current_room.empty()) {
-            continue;
-        } else {
-            break;
-        }
+    uint64_t capture_id = capture_ ? capture_->connection_opened(user_info->username, net_msg.body.data) : 0;
+    if (heartbeat_) {
+        heartbeat_->watch(client);
+    }
+    
+    // One loop for foyer, primary room and any extra subscriptions
+    handle_session(client, received.substr(auth_end + 1), capture_id);
+    if (capture_id) {
+        capture_->connection_closed(capture_id);
+    }
+    if (heartbeat_) {
+        heartbeat_->forget(client_fd);  // before the fd can be closed and reused
+    }
+    
+    // Drop every room this connection was still in
+    client->set_current_room("");
+    bool had_rooms = false;
+    for (const auto& room_name : client->rooms()) {
+        had_rooms |= unsubscribe_room(client, room_name);
     }
     
     {
-        std::lock_guard<std::mutex> lock(cout_mutex_);
-        std::cout << client_name << " (" << client_ip << ") disconnected\n";
+        std::ostringstream line;
+        line << client_name << " (" << client_ip << ") disconnected";
+        if (client->reaped()) {
+            line << " (idle timeout)";
+        }
+        if (client->dropped_frames() > 0 || client->coalesced_frames() > 0) {
+            line << " (flow control dropped " << client->dropped_frames()
+                 << ", coalesced " << client->coalesced_frames() << " frames)";
+        }
+        line << "\n";
+        log_line(line);
     }
     
     remove_client(client_fd);
+    if (had_rooms) {
+        notify_foyer();
+    }
     close(client_fd);
 }
@@ -0,0 +1,134 @@
+#include "Heartbeat.h"
+#include "ClientConnection.h"
+#include "common/NetworkMessage.h"
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+HeartbeatConfig sanitized(HeartbeatConfig config) {
+    config.tick = std::max(config.tick, std::chrono::milliseconds(1));
+    return config;
+}
+
+} // namespace
+
+Heartbeat::Heartbeat(const HeartbeatConfig& config)
+    : config_(sanitized(config))
+    , start_(Clock::now())
+    , thread_(&Heartbeat::run, this) {}
+
+Heartbeat::~Heartbeat() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_one();
+    thread_.join();
+}
+
+size_t Heartbeat::watched() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return watched_.size();
+}
+
+void Heartbeat::watch(const std::shared_ptr<ClientConnection>& connection) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Watched& watched = watched_[connection->fd()];
+    wheel_.cancel(watched.timer);
+    watched = Watched{connection, 0, {}};
+    auto first = std::min(config_.ping_interval, config_.idle_timeout);
+    schedule_locked(connection->fd(), watched, connection->last_inbound() + first);
+}
+
+void Heartbeat::forget(int fd) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = watched_.find(fd);
+    if (it != watched_.end()) {
+        wheel_.cancel(it->second.timer);
+        watched_.erase(it);
+    }
+}
+
+uint64_t Heartbeat::tick_of(Clock::time_point time) const {
+    if (time <= start_) {
+        return 0;
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(time - start_);
+    return static_cast<uint64_t>(elapsed / config_.tick);
+}
+
+void Heartbeat::schedule_locked(int fd, Watched& watched, Clock::time_point due) {
+    // Round up so the timer never fires before due
+    uint64_t due_tick = tick_of(due) + 1;
+    uint64_t delay = due_tick > wheel_.now() ? due_tick - wheel_.now() : 1;
+    watched.timer = wheel_.schedule(delay, static_cast<uint64_t>(fd));
+}
+
+void Heartbeat::run() {
+    std::vector<uint64_t> expired;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        cv_.wait_for(lock, config_.tick);
+        if (stopping_) {
+            break;
+        }
+        auto now = Clock::now();
+        expired.clear();
+        wheel_.advance(tick_of(now), expired);
+        for (uint64_t fd : expired) {
+            expire_locked(static_cast<int>(fd), now);
+        }
+    }
+}
+
+void Heartbeat::expire_locked(int fd, Clock::time_point now) {
+    auto it = watched_.find(fd);
+    if (it == watched_.end()) {
+        return;
+    }
+    Watched& watched = it->second;
+    watched.timer = 0;
+    auto connection = watched.connection.lock();
+    if (!connection) {
+        watched_.erase(it);
+        return;
+    }
+
+    // A peer that keeps sending but never reads is as dead as a silent one
+    auto last = connection->last_inbound();
+    auto blocked = connection->write_blocked_since();
+    bool write_stuck = blocked != Clock::time_point{} && now - blocked >= config_.idle_timeout;
+    if (now - last >= config_.idle_timeout || write_stuck) {
+        connection->reap();
+        stats_.reaped_connections.fetch_add(1, std::memory_order_relaxed);
+        watched_.erase(it);
+        return;
+    }
+
+    bool ping_due = config_.ping_interval < config_.idle_timeout && now - last >= config_.ping_interval;
+    if (ping_due && watched.pinged_for != last) {
+        switch (connection->ping(NetworkMessage::create_ping().serialize())) {
+            case ClientConnection::PingResult::SENT:
+                stats_.pings_sent.fetch_add(1, std::memory_order_relaxed);
+                watched.pinged_for = last;
+                break;
+            case ClientConnection::PingResult::BUSY:
+                // Try again shortly; the idle deadline still applies
+                stats_.pings_skipped.fetch_add(1, std::memory_order_relaxed);
+                schedule_locked(fd, watched, std::min(now + config_.tick, last + config_.idle_timeout));
+                return;
+            case ClientConnection::PingResult::FAILED:
+                stats_.reaped_connections.fetch_add(1, std::memory_order_relaxed);
+                watched_.erase(it);
+                return;
+        }
+    }
+
+    bool pinged = watched.pinged_for == last || config_.ping_interval >= config_.idle_timeout;
+    auto due = last + (pinged ? config_.idle_timeout : config_.ping_interval);
+    if (blocked != Clock::time_point{}) {
+        due = std::min(due, blocked + config_.idle_timeout);
+    }
+    schedule_locked(fd, watched, due);
+}
@@ -0,0 +1,659 @@
+#include "HistoryIndex.h"
+#include <sys/stat.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace {
+
+constexpr int MANIFEST_VERSION = 2;  // 2: adds room_seqs
+constexpr char KEY_SEPARATOR = '\x1f';
+constexpr const char* LOG_FILE = "messages.log";
+constexpr const char* MANIFEST_FILE = "MANIFEST";
+
+template <typename T>
+void put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void put_string(std::string& out, const std::string& value) {
+    put(out, static_cast<uint32_t>(value.size()));
+    out += value;
+}
+
+// Bounds-checked cursor over a log record
+class Reader {
+public:
+    Reader(const char* data, size_t size) : data_(data), size_(size), pos_(0) {}
+
+    template <typename T>
+    bool get(T& value) {
+        if (size_ - pos_ < sizeof(T)) return false;
+        std::memcpy(&value, data_ + pos_, sizeof(T));
+        pos_ += sizeof(T);
+        return true;
+    }
+
+    bool get_string(std::string& value) {
+        uint32_t length;
+        if (!get(length) || size_ - pos_ < length) return false;
+        value.assign(data_ + pos_, length);
+        pos_ += length;
+        return true;
+    }
+
+private:
+    const char* data_;
+    size_t size_;
+    size_t pos_;
+};
+
+// Log record: u32 body length, then doc, seq, timestamp, room, sender, message
+struct LogRecord {
+    uint64_t doc = 0;
+    uint64_t seq = 0;
+    int64_t timestamp_ms = 0;
+    std::string room;
+    std::string sender;
+    std::string message;
+};
+
+std::string encode_record(const LogRecord& record) {
+    std::string body;
+    body.reserve(40 + record.room.size() + record.sender.size() + record.message.size());
+    put(body, record.doc);
+    put(body, record.seq);
+    put(body, record.timestamp_ms);
+    put_string(body, record.room);
+    put_string(body, record.sender);
+    put_string(body, record.message);
+
+    std::string out;
+    put(out, static_cast<uint32_t>(body.size()));
+    return out + body;
+}
+
+bool decode_record(const char* data, size_t size, LogRecord& record) {
+    Reader reader(data, size);
+    return reader.get(record.doc) && reader.get(record.seq) && reader.get(record.timestamp_ms) &&
+           reader.get_string(record.room) && reader.get_string(record.sender) &&
+           reader.get_string(record.message);
+}
+
+bool write_all(int fd, const std::string& data) {
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t n = ::write(fd, data.data() + written, data.size() - written);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        written += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool read_exact(int fd, char* out, size_t size, uint64_t offset) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = pread(fd, out + done, size - done, static_cast<off_t>(offset + done));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+std::string make_key(const std::string& room, const std::string& term) {
+    std::string key;
+    key.reserve(room.size() + 1 + term.size());
+    key += room;
+    key += KEY_SEPARATOR;
+    key += term;
+    return key;
+}
+
+int64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+struct Candidate {
+    uint64_t doc;
+    double score;
+};
+
+} // namespace
+
+HistoryIndex::HistoryIndex(std::string dir, HistoryIndexConfig config)
+    : dir_(std::move(dir)), config_(config) {
+    config_.flush_messages = std::max<size_t>(config_.flush_messages, 1);
+    config_.max_segments = std::max<size_t>(config_.max_segments, 1);
+}
+
+HistoryIndex::~HistoryIndex() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    work_cv_.notify_all();
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+    if (log_fd_ >= 0) {
+        ::close(log_fd_);
+    }
+}
+
+std::string HistoryIndex::segment_path(uint64_t generation) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "seg-%06llu.idx", static_cast<unsigned long long>(generation));
+    return dir_ + "/" + name;
+}
+
+bool HistoryIndex::open() {
+    if (log_fd_ >= 0) {
+        return true;
+    }
+    if (mkdir(dir_.c_str(), 0755) != 0 && errno != EEXIST) {
+        std::cerr << "Error: Could not create history directory: " << dir_ << "\n";
+        return false;
+    }
+
+    std::set<std::string> live;
+    std::ifstream manifest_file(dir_ + "/" + MANIFEST_FILE);
+    if (manifest_file) {
+        json manifest = json::parse(manifest_file, nullptr, false);
+        bool valid = !manifest.is_discarded() && manifest.value("version", 0) == MANIFEST_VERSION;
+        if (valid) {
+            next_doc_ = manifest.value("next_doc", uint64_t{1});
+            next_generation_ = manifest.value("next_generation", uint64_t{1});
+            indexed_log_end_ = manifest.value("log_offset", uint64_t{0});
+            json room_seqs = manifest.value("room_seqs", json::object());
+            for (const auto& [room, seq] : room_seqs.items()) {
+                last_seqs_[room] = seq.get<uint64_t>();
+            }
+            for (const auto& name : manifest.value("segments", json::array())) {
+                auto segment = HistorySegment::open(dir_ + "/" + name.get<std::string>());
+                if (!segment) {
+                    valid = false;
+                    break;
+                }
+                segments_.push_back(segment);
+                live.insert(name.get<std::string>());
+            }
+        }
+        if (!valid) {
+            // The log holds every message; rebuild the index from it
+            std::cerr << "History manifest unusable, reindexing " << dir_ << "\n";
+            segments_.clear();
+            live.clear();
+            last_seqs_.clear();
+            next_doc_ = 1;
+            indexed_log_end_ = 0;
+        }
+    }
+
+    // Segments from an interrupted write or a finished merge
+    if (DIR* dir = opendir(dir_.c_str())) {
+        while (dirent* entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            if (name.rfind("seg-", 0) == 0 && live.count(name) == 0) {
+                unlink((dir_ + "/" + name).c_str());
+            }
+        }
+        closedir(dir);
+    }
+
+    std::string log_path = dir_ + "/" + LOG_FILE;
+    log_fd_ = ::open(log_path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (log_fd_ < 0) {
+        std::cerr << "Error: Could not open history log: " << log_path << "\n";
+        return false;
+    }
+    if (!replay_log(indexed_log_end_)) {
+        return false;
+    }
+
+    writer_ = std::thread(&HistoryIndex::run, this);
+    return true;
+}
+
+bool HistoryIndex::replay_log(uint64_t from) {
+    struct stat st;
+    if (fstat(log_fd_, &st) != 0) {
+        return false;
+    }
+    uint64_t size = static_cast<uint64_t>(st.st_size);
+    if (from > size) {
+        std::cerr << "History log is shorter than the index expects: " << dir_ << "\n";
+        from = size;
+    }
+
+    std::string data(size - from, '\0');
+    if (!data.empty() && !read_exact(log_fd_, data.data(), data.size(), from)) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    memtable_.log_end = from;
+    size_t pos = 0;
+    while (data.size() - pos >= sizeof(uint32_t)) {
+        uint32_t length;
+        std::memcpy(&length, data.data() + pos, sizeof(length));
+        LogRecord record;
+        if (data.size() - pos - sizeof(length) < length ||
+            !decode_record(data.data() + pos + sizeof(length), length, record)) {
+            break;
+        }
+        uint64_t offset = from + pos;
+        pos += sizeof(length) + length;
+        index_locked(record.room, record.doc, record.seq, record.message, offset);
+        memtable_.log_end = from + pos;
+        next_doc_ = std::max(next_doc_, record.doc + 1);
+        if (memtable_.docs.size() >= config_.flush_messages) {
+            freeze_locked();
+        }
+    }
+
+    if (pos < data.size()) {
+        // Torn last record from a crash mid-append
+        std::cerr << "Truncating " << (data.size() - pos) << " bytes of partial history log\n";
+        if (ftruncate(log_fd_, static_cast<off_t>(from + pos)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void HistoryIndex::index_locked(const std::string& room, uint64_t doc, uint64_t seq,
+                                const std::string& message, uint64_t log_offset) {
+    memtable_.docs.push_back(HistoryDoc{doc, log_offset, seq});
+    uint64_t& last = last_seqs_[room];
+    last = std::max(last, seq);
+
+    auto terms = tokenize(message);
+    std::sort(terms.begin(), terms.end());
+    for (size_t i = 0; i < terms.size();) {
+        size_t j = i;
+        while (j < terms.size() && terms[j] == terms[i]) {
+            ++j;
+        }
+        memtable_.postings[make_key(room, terms[i])].push_back(
+            HistoryPosting{doc, static_cast<uint32_t>(j - i)});
+        i = j;
+    }
+}
+
+bool HistoryIndex::add(const std::string& room, uint64_t seq, const std::string& sender,
+                       const std::string& message) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (log_fd_ < 0) {
+        return false;
+    }
+
+    LogRecord record{next_doc_, seq, now_ms(), room, sender, message};
+    std::string encoded = encode_record(record);
+    // No fsync here; the log is synced before each segment that refers to it
+    if (!write_all(log_fd_, encoded)) {
+        std::cerr << "Error: Could not append to history log\n";
+        return false;
+    }
+    uint64_t offset = memtable_.log_end;
+    memtable_.log_end += encoded.size();
+    ++next_doc_;
+
+    index_locked(room, record.doc, seq, message, offset);
+    if (memtable_.docs.size() >= config_.flush_messages) {
+        freeze_locked();
+    }
+    return true;
+}
+
+uint64_t HistoryIndex::last_seq(const std::string& room) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = last_seqs_.find(room);
+    return it == last_seqs_.end() ? 0 : it->second;
+}
+
+void HistoryIndex::freeze_locked() {
+    if (memtable_.docs.empty()) {
+        return;
+    }
+    uint64_t log_end = memtable_.log_end;
+    frozen_.push_back(std::make_shared<const HistoryMemTable>(std::move(memtable_)));
+    memtable_ = HistoryMemTable{};
+    memtable_.log_end = log_end;
+    work_cv_.notify_one();
+}
+
+void HistoryIndex::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        work_cv_.wait(lock, [this] {
+            return stopping_ || (!write_failed_ && (!frozen_.empty() || segments_.size() > config_.max_segments));
+        });
+
+        if (!write_failed_ && !frozen_.empty()) {
+            auto table = frozen_.front();
+            std::string path = segment_path(next_generation_++);
+            busy_ = true;
+            lock.unlock();
+
+            // Hits are read back from the log, so it must be durable first
+            fsync(log_fd_);
+            auto segment = HistorySegment::write(path, *table) ? HistorySegment::open(path) : nullptr;
+
+            lock.lock();
+            if (segment) {
+                segments_.push_back(segment);
+                frozen_.pop_front();
+                indexed_log_end_ = table->log_end;
+                lock.unlock();
+                write_manifest();
+                lock.lock();
+            } else {
+                std::cerr << "Error: Could not write history segment " << path << "\n";
+                write_failed_ = true;
+            }
+        } else if (stopping_) {
+            break;
+        } else {
+            busy_ = true;
+            lock.unlock();
+            bool merged = merge_once();
+            lock.lock();
+            if (!merged) {
+                std::cerr << "Error: Could not merge history segments in " << dir_ << "\n";
+                write_failed_ = true;
+            }
+        }
+
+        busy_ = false;
+        idle_cv_.notify_all();
+    }
+    busy_ = false;
+    idle_cv_.notify_all();
+}
+
+bool HistoryIndex::merge_once() {
+    std::vector<std::shared_ptr<HistorySegment>> inputs;
+    size_t start = 0;
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Cheapest run of adjacent segments: small flushes merge long before big ones
+        size_t width = std::min(MERGE_WIDTH, segments_.size());
+        size_t best = SIZE_MAX;
+        for (size_t i = 0; i + width <= segments_.size(); ++i) {
+            size_t docs = 0;
+            for (size_t j = i; j < i + width; ++j) {
+                docs += segments_[j]->doc_count();
+            }
+            if (docs < best) {
+                best = docs;
+                start = i;
+            }
+        }
+        inputs.assign(segments_.begin() + start, segments_.begin() + start + width);
+        path = segment_path(next_generation_++);
+    }
+
+    if (!HistorySegment::merge(path, inputs)) {
+        return false;
+    }
+    auto merged = HistorySegment::open(path);
+    if (!merged) {
+        return false;
+    }
+
+    {
+        // Only this thread changes segments_, so the run is still at start
+        std::lock_guard<std::mutex> lock(mutex_);
+        segments_.erase(segments_.begin() + start, segments_.begin() + start + inputs.size());
+        segments_.insert(segments_.begin() + start, merged);
+    }
+    if (!write_manifest()) {
+        return false;
+    }
+    // Searches still holding an input keep their mapping after the unlink
+    for (const auto& input : inputs) {
+        unlink(input->path().c_str());
+    }
+    return true;
+}
+
+bool HistoryIndex::write_manifest() {
+    json manifest;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        json segments = json::array();
+        for (const auto& segment : segments_) {
+            segments.push_back(segment->path().substr(dir_.size() + 1));
+        }
+        manifest = {
+            {"version", MANIFEST_VERSION},
+            {"next_doc", next_doc_},
+            {"next_generation", next_generation_},
+            {"log_offset", indexed_log_end_},
+            {"room_seqs", last_seqs_},
+            {"segments", segments}
+        };
+    }
+
+    std::string path = dir_ + "/" + MANIFEST_FILE;
+    std::string temp_path = path + ".tmp";
+    int fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::cerr << "Error: Could not write history manifest: " << temp_path << "\n";
+        return false;
+    }
+    bool ok = write_all(fd, manifest.dump(2) + "\n") && fsync(fd) == 0;
+    ::close(fd);
+    if (!ok || rename(temp_path.c_str(), path.c_str()) != 0) {
+        unlink(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+void HistoryIndex::flush() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        freeze_locked();
+    }
+    wait_idle();
+}
+
+void HistoryIndex::wait_idle() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_cv_.wait(lock, [this] {
+        if (stopping_ || !writer_.joinable()) return true;
+        if (busy_) return false;
+        return write_failed_ || (frozen_.empty() && segments_.size() <= config_.max_segments);
+    });
+}
+
+size_t HistoryIndex::segment_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return segments_.size();
+}
+
+uint64_t HistoryIndex::message_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t count = memtable_.docs.size();
+    for (const auto& table : frozen_) {
+        count += table->docs.size();
+    }
+    for (const auto& segment : segments_) {
+        count += segment->doc_count();
+    }
+    return count;
+}
+
+std::vector<std::string> HistoryIndex::tokenize(std::string_view text) {
+    std::vector<std::string> terms;
+    std::string current;
+    for (char ch : text) {
+        unsigned char c = static_cast<unsigned char>(ch);
+        bool word = c >= 0x80 || (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+        if (word) {
+            if (current.size() < MAX_TERM_LENGTH) {
+                current.push_back(c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : ch);
+            }
+        } else if (!current.empty()) {
+            terms.push_back(std::move(current));
+            current.clear();
+        }
+    }
+    if (!current.empty()) {
+        terms.push_back(std::move(current));
+    }
+    return terms;
+}
+
+bool HistoryIndex::resolve_doc(uint64_t doc, HistoryDoc& out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (const HistoryDoc* found = memtable_.find_doc(doc)) {
+        out = *found;
+        return true;
+    }
+    for (const auto& table : frozen_) {
+        if (const HistoryDoc* found = table->find_doc(doc)) {
+            out = *found;
+            return true;
+        }
+    }
+    for (const auto& segment : segments_) {
+        if (segment->find_doc(doc, out)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool HistoryIndex::read_hit(const HistoryDoc& doc, HistoryHit& hit) const {
+    uint32_t length;
+    if (!read_exact(log_fd_, reinterpret_cast<char*>(&length), sizeof(length), doc.log_offset)) {
+        return false;
+    }
+    std::string body(length, '\0');
+    LogRecord record;
+    if (!read_exact(log_fd_, body.data(), length, doc.log_offset + sizeof(length)) ||
+        !decode_record(body.data(), body.size(), record) || record.doc != doc.doc) {
+        return false;
+    }
+    hit.seq = record.seq;
+    hit.sender = std::move(record.sender);
+    hit.message = std::move(record.message);
+    hit.timestamp_ms = record.timestamp_ms;
+    return true;
+}
+
+std::vector<HistoryHit> HistoryIndex::search(const std::string& room, const std::string& query,
+                                             size_t limit) const {
+    limit = limit == 0 ? DEFAULT_RESULTS : std::min(limit, MAX_RESULTS);
+    auto terms = tokenize(query);
+    std::sort(terms.begin(), terms.end());
+    terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+    if (terms.empty() || log_fd_ < 0) {
+        return {};
+    }
+
+    // Snapshot the sources; segments and frozen tables are immutable
+    std::vector<std::shared_ptr<HistorySegment>> segments;
+    std::vector<std::shared_ptr<const HistoryMemTable>> frozen;
+    std::vector<std::vector<HistoryPosting>> recent(terms.size());
+    uint64_t total = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        segments = segments_;
+        frozen.assign(frozen_.begin(), frozen_.end());
+        for (size_t i = 0; i < terms.size(); ++i) {
+            auto it = memtable_.postings.find(make_key(room, terms[i]));
+            if (it != memtable_.postings.end()) {
+                recent[i] = it->second;
+            }
+        }
+        total = memtable_.docs.size();
+        for (const auto& table : frozen) total += table->docs.size();
+        for (const auto& segment : segments) total += segment->doc_count();
+    }
+
+    // Sources cover increasing doc ranges, so appending keeps each list sorted
+    std::vector<std::vector<HistoryPosting>> lists(terms.size());
+    for (size_t i = 0; i < terms.size(); ++i) {
+        std::string key = make_key(room, terms[i]);
+        for (const auto& segment : segments) {
+            segment->append_postings(key, lists[i]);
+        }
+        for (const auto& table : frozen) {
+            auto it = table->postings.find(key);
+            if (it != table->postings.end()) {
+                lists[i].insert(lists[i].end(), it->second.begin(), it->second.end());
+            }
+        }
+        lists[i].insert(lists[i].end(), recent[i].begin(), recent[i].end());
+        if (lists[i].empty()) {
+            return {};  // every term must match
+        }
+    }
+
+    // Intersect starting from the rarest term
+    std::sort(lists.begin(), lists.end(),
+        [](const auto& a, const auto& b) { return a.size() < b.size(); });
+    auto idf = [total](size_t df) { return std::log(1.0 + static_cast<double>(total) / df); };
+
+    std::vector<Candidate> candidates;
+    candidates.reserve(lists[0].size());
+    double first_idf = idf(lists[0].size());
+    for (const auto& posting : lists[0]) {
+        candidates.push_back(Candidate{posting.doc, posting.tf * first_idf});
+    }
+    for (size_t i = 1; i < lists.size() && !candidates.empty(); ++i) {
+        double term_idf = idf(lists[i].size());
+        size_t kept = 0;
+        auto it = lists[i].begin();
+        for (const auto& candidate : candidates) {
+            it = std::lower_bound(it, lists[i].end(), candidate.doc,
+                [](const HistoryPosting& posting, uint64_t doc) { return posting.doc < doc; });
+            if (it == lists[i].end()) {
+                break;
+            }
+            if (it->doc == candidate.doc) {
+                candidates[kept++] = Candidate{candidate.doc, candidate.score + it->tf * term_idf};
+            }
+        }
+        candidates.resize(kept);
+    }
+
+    auto better = [](const Candidate& a, const Candidate& b) {
+        return a.score != b.score ? a.score > b.score : a.doc > b.doc;
+    };
+    size_t top = std::min(limit, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + top, candidates.end(), better);
+
+    std::vector<HistoryHit> hits;
+    hits.reserve(top);
+    for (size_t i = 0; i < top; ++i) {
+        HistoryDoc doc;
+        HistoryHit hit;
+        if (resolve_doc(candidates[i].doc, doc) && read_hit(doc, hit)) {
+            hit.score = candidates[i].score;
+            hits.push_back(std::move(hit));
+        }
+    }
+    return hits;
+}
@@ -0,0 +1,355 @@
+#include "HistorySegment.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+constexpr uint32_t SEGMENT_MAGIC = 0x53484B42;  // "BKHS"
+constexpr uint32_t SEGMENT_VERSION = 1;
+
+struct Header {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t first_doc;
+    uint64_t last_doc;
+    uint64_t doc_count;
+    uint64_t term_count;
+    uint64_t docs_offset;
+    uint64_t keys_offset;
+    uint64_t postings_offset;
+    uint64_t terms_offset;
+};
+
+// Offsets are relative to their section
+struct TermEntry {
+    uint64_t key_offset;
+    uint64_t postings_offset;
+    uint32_t key_length;
+    uint32_t postings_length;
+    uint32_t doc_freq;
+    uint32_t reserved;
+};
+
+struct DocEntry {
+    uint64_t doc;
+    uint64_t log_offset;
+    uint64_t seq;
+};
+
+template <typename T>
+void put(std::string& out, const T& value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+T load(const char* data) {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+void put_varint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+bool get_varint(const char*& pos, const char* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; pos < end && shift < 64; shift += 7) {
+        uint8_t byte = static_cast<uint8_t>(*pos++);
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool write_all(int fd, const std::string& data) {
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t n = ::write(fd, data.data() + written, data.size() - written);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        written += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Accumulates the sections of one segment, then writes them out
+class SegmentBuilder {
+public:
+    void add_doc(const HistoryDoc& doc) {
+        put(docs_, DocEntry{doc.doc, doc.log_offset, doc.seq});
+        first_doc_ = std::min(first_doc_, doc.doc);
+        last_doc_ = std::max(last_doc_, doc.doc);
+        ++doc_count_;
+    }
+
+    void add_raw_docs(const char* data, size_t count, uint64_t first, uint64_t last) {
+        docs_.append(data, count * sizeof(DocEntry));
+        first_doc_ = std::min(first_doc_, first);
+        last_doc_ = std::max(last_doc_, last);
+        doc_count_ += count;
+    }
+
+    // postings must be in doc order
+    void add_term(std::string_view key, const std::vector<HistoryPosting>& postings) {
+        TermEntry entry{};
+        entry.key_offset = keys_.size();
+        entry.key_length = static_cast<uint32_t>(key.size());
+        entry.postings_offset = postings_.size();
+        entry.doc_freq = static_cast<uint32_t>(postings.size());
+        keys_.append(key.data(), key.size());
+
+        uint64_t previous = 0;
+        for (const auto& posting : postings) {
+            put_varint(postings_, posting.doc - previous);
+            put_varint(postings_, posting.tf);
+            previous = posting.doc;
+        }
+        entry.postings_length = static_cast<uint32_t>(postings_.size() - entry.postings_offset);
+        put(terms_, entry);
+        ++term_count_;
+    }
+
+    bool write(const std::string& path) const {
+        Header header{};
+        header.magic = SEGMENT_MAGIC;
+        header.version = SEGMENT_VERSION;
+        header.first_doc = doc_count_ ? first_doc_ : 0;
+        header.last_doc = last_doc_;
+        header.doc_count = doc_count_;
+        header.term_count = term_count_;
+        header.docs_offset = sizeof(Header);
+        header.keys_offset = header.docs_offset + docs_.size();
+        header.postings_offset = header.keys_offset + keys_.size();
+        header.terms_offset = header.postings_offset + postings_.size();
+
+        std::string temp_path = path + ".tmp";
+        int fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            std::cerr << "Error: Could not write history segment: " << temp_path << "\n";
+            return false;
+        }
+        std::string head;
+        put(head, header);
+        bool ok = write_all(fd, head) && write_all(fd, docs_) && write_all(fd, keys_) &&
+                  write_all(fd, postings_) && write_all(fd, terms_) && fsync(fd) == 0;
+        ::close(fd);
+        if (!ok || rename(temp_path.c_str(), path.c_str()) != 0) {
+            unlink(temp_path.c_str());
+            return false;
+        }
+        return true;
+    }
+
+private:
+    std::string docs_;
+    std::string keys_;
+    std::string postings_;
+    std::string terms_;
+    uint64_t first_doc_ = UINT64_MAX;
+    uint64_t last_doc_ = 0;
+    uint64_t doc_count_ = 0;
+    uint64_t term_count_ = 0;
+};
+
+} // namespace
+
+const HistoryDoc* HistoryMemTable::find_doc(uint64_t doc) const {
+    auto it = std::lower_bound(docs.begin(), docs.end(), doc,
+        [](const HistoryDoc& entry, uint64_t id) { return entry.doc < id; });
+    return it != docs.end() && it->doc == doc ? &*it : nullptr;
+}
+
+HistorySegment::~HistorySegment() {
+    if (data_) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+}
+
+std::shared_ptr<HistorySegment> HistorySegment::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Header)) {
+        ::close(fd);
+        return nullptr;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        return nullptr;
+    }
+
+    std::shared_ptr<HistorySegment> segment(new HistorySegment());
+    segment->path_ = path;
+    segment->data_ = static_cast<const char*>(mapped);
+    segment->size_ = size;
+
+    Header header = load<Header>(segment->data_);
+    bool valid = header.magic == SEGMENT_MAGIC && header.version == SEGMENT_VERSION &&
+                 header.docs_offset == sizeof(Header) &&
+                 header.keys_offset == header.docs_offset + header.doc_count * sizeof(DocEntry) &&
+                 header.keys_offset <= header.postings_offset &&
+                 header.postings_offset <= header.terms_offset &&
+                 header.terms_offset + header.term_count * sizeof(TermEntry) == size;
+    if (!valid) {
+        std::cerr << "Ignoring invalid history segment: " << path << "\n";
+        return nullptr;
+    }
+
+    segment->first_doc_ = header.first_doc;
+    segment->last_doc_ = header.last_doc;
+    segment->doc_count_ = header.doc_count;
+    segment->term_count_ = header.term_count;
+    segment->docs_offset_ = header.docs_offset;
+    segment->keys_offset_ = header.keys_offset;
+    segment->postings_offset_ = header.postings_offset;
+    segment->terms_offset_ = header.terms_offset;
+    return segment;
+}
+
+bool HistorySegment::write(const std::string& path, const HistoryMemTable& table) {
+    SegmentBuilder builder;
+    for (const auto& doc : table.docs) {
+        builder.add_doc(doc);
+    }
+
+    std::vector<const std::pair<const std::string, std::vector<HistoryPosting>>*> terms;
+    terms.reserve(table.postings.size());
+    for (const auto& term : table.postings) {
+        terms.push_back(&term);
+    }
+    std::sort(terms.begin(), terms.end(), [](const auto* a, const auto* b) { return a->first < b->first; });
+    for (const auto* term : terms) {
+        builder.add_term(term->first, term->second);
+    }
+    return builder.write(path);
+}
+
+bool HistorySegment::merge(const std::string& path, const std::vector<std::shared_ptr<HistorySegment>>& inputs) {
+    SegmentBuilder builder;
+    for (const auto& input : inputs) {
+        if (input->doc_count_ > 0) {
+            builder.add_raw_docs(input->data_ + input->docs_offset_, input->doc_count_,
+                                 input->first_doc_, input->last_doc_);
+        }
+    }
+
+    // k-way merge of the sorted term tables; equal keys concatenate in doc order
+    std::vector<size_t> next(inputs.size(), 0);
+    std::vector<HistoryPosting> postings;
+    while (true) {
+        std::string_view smallest;
+        bool found = false;
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            if (next[i] < inputs[i]->term_count_) {
+                std::string_view key = inputs[i]->key_at(next[i]);
+                if (!found || key < smallest) {
+                    smallest = key;
+                    found = true;
+                }
+            }
+        }
+        if (!found) {
+            break;
+        }
+
+        std::string key(smallest);
+        postings.clear();
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            if (next[i] < inputs[i]->term_count_ && inputs[i]->key_at(next[i]) == key) {
+                inputs[i]->decode_postings(next[i], postings);
+                ++next[i];
+            }
+        }
+        builder.add_term(key, postings);
+    }
+    return builder.write(path);
+}
+
+std::string_view HistorySegment::key_at(size_t index) const {
+    TermEntry entry = load<TermEntry>(data_ + terms_offset_ + index * sizeof(TermEntry));
+    uint64_t begin = keys_offset_ + entry.key_offset;
+    if (begin + entry.key_length > postings_offset_) {
+        return {};
+    }
+    return std::string_view(data_ + begin, entry.key_length);
+}
+
+void HistorySegment::decode_postings(size_t index, std::vector<HistoryPosting>& out) const {
+    TermEntry entry = load<TermEntry>(data_ + terms_offset_ + index * sizeof(TermEntry));
+    uint64_t begin = postings_offset_ + entry.postings_offset;
+    if (begin + entry.postings_length > terms_offset_) {
+        return;
+    }
+    const char* pos = data_ + begin;
+    const char* end = pos + entry.postings_length;
+    uint64_t doc = 0;
+    out.reserve(out.size() + entry.doc_freq);
+    while (pos < end) {
+        uint64_t delta, tf;
+        if (!get_varint(pos, end, delta) || !get_varint(pos, end, tf)) {
+            return;
+        }
+        doc += delta;
+        out.push_back(HistoryPosting{doc, static_cast<uint32_t>(tf)});
+    }
+}
+
+void HistorySegment::append_postings(std::string_view key, std::vector<HistoryPosting>& out) const {
+    size_t low = 0;
+    size_t high = term_count_;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (key_at(mid) < key) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    if (low < term_count_ && key_at(low) == key) {
+        decode_postings(low, out);
+    }
+}
+
+bool HistorySegment::find_doc(uint64_t doc, HistoryDoc& out) const {
+    if (doc < first_doc_ || doc > last_doc_) {
+        return false;
+    }
+    const char* docs = data_ + docs_offset_;
+    size_t low = 0;
+    size_t high = doc_count_;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (load<DocEntry>(docs + mid * sizeof(DocEntry)).doc < doc) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    if (low == doc_count_) {
+        return false;
+    }
+    DocEntry entry = load<DocEntry>(docs + low * sizeof(DocEntry));
+    if (entry.doc != doc) {
+        return false;
+    }
+    out = HistoryDoc{entry.doc, entry.log_offset, entry.seq};
+    return true;
+}
@@ -0,0 +1,517 @@
+#include "IoBackend.h"
+#include <linux/io_uring.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+int io_uring_setup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int io_uring_enter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete,
+                                    flags, nullptr, 0));
+}
+
+bool would_block(int error) {
+    return error == EAGAIN || error == EWOULDBLOCK;
+}
+
+// Write iovecs until done or the socket is full, continuing after short writes.
+// Returns the bytes written, or -1 if the socket failed.
+ssize_t send_iov(int fd, iovec* iov, size_t count, IoStats& stats) {
+    size_t total = 0;
+    while (count > 0) {
+        msghdr msg{};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = std::min<size_t>(count, IOV_MAX);
+
+        ssize_t sent = sendmsg(fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+        stats.syscalls.fetch_add(1, std::memory_order_relaxed);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (would_block(errno)) {
+                break;
+            }
+            return -1;
+        }
+        total += static_cast<size_t>(sent);
+
+        // Skip fully written iovecs, trim a partially written one
+        size_t remaining = static_cast<size_t>(sent);
+        while (count > 0 && remaining >= iov->iov_len) {
+            remaining -= iov->iov_len;
+            ++iov;
+            --count;
+        }
+        if (count > 0) {
+            iov->iov_base = static_cast<char*>(iov->iov_base) + remaining;
+            iov->iov_len -= remaining;
+        }
+    }
+    return static_cast<ssize_t>(total);
+}
+
+// Non-blocking send() of a whole buffer, for one recipient
+ssize_t send_nowait(int fd, std::string_view payload, IoStats& stats) {
+    size_t total = 0;
+    while (total < payload.size()) {
+        ssize_t sent = send(fd, payload.data() + total, payload.size() - total, MSG_NOSIGNAL | MSG_DONTWAIT);
+        stats.syscalls.fetch_add(1, std::memory_order_relaxed);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (would_block(errno)) {
+                break;
+            }
+            return -1;
+        }
+        total += static_cast<size_t>(sent);
+    }
+    return static_cast<ssize_t>(total);
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// IoBackend
+// ---------------------------------------------------------------------------
+
+IoBackend::~IoBackend() {
+    {
+        std::lock_guard<std::mutex> lock(writable_mutex_);
+        stopping_ = true;
+    }
+    if (writable_thread_.joinable()) {
+        writable_thread_.join();
+    }
+    if (epoll_fd_ >= 0) {
+        close(epoll_fd_);
+    }
+}
+
+ssize_t IoBackend::write_sequence(int fd, const std::vector<std::string_view>& payloads, size_t skip) {
+    std::vector<iovec> iov;
+    iov.reserve(payloads.size());
+    size_t total = 0;
+    for (const auto& payload : payloads) {
+        if (skip >= payload.size()) {
+            skip -= payload.size();
+            continue;
+        }
+        iov.push_back({const_cast<char*>(payload.data()) + skip, payload.size() - skip});
+        total += payload.size() - skip;
+        skip = 0;
+    }
+
+    stats_.payloads.fetch_add(iov.size(), std::memory_order_relaxed);
+    stats_.bytes.fetch_add(total, std::memory_order_relaxed);
+    return send_iov(fd, iov.data(), iov.size(), stats_);
+}
+
+void IoBackend::write_batch(const std::vector<int>& fds, const SharedPayload& payload,
+                            std::vector<ssize_t>& written) {
+    if (!payload) {
+        written.assign(fds.size(), 0);
+        return;
+    }
+    if (zerocopy_threshold_ == 0 || payload->size() < zerocopy_threshold_) {
+        write_batch(fds, std::string_view(*payload), written);
+        return;
+    }
+
+    // Every recipient's send pins the same buffer; no per-recipient copy
+    std::vector<SharedPayload> payloads{payload};
+    written.resize(fds.size());
+    for (size_t i = 0; i < fds.size(); ++i) {
+        written[i] = zerocopy_.send(fds[i], payloads);
+    }
+}
+
+ssize_t IoBackend::write_sequence(int fd, const std::vector<SharedPayload>& payloads, size_t skip) {
+    size_t total = 0;
+    for (const auto& payload : payloads) {
+        total += payload ? payload->size() : 0;
+    }
+
+    if (zerocopy_threshold_ == 0 || total - std::min(skip, total) < zerocopy_threshold_) {
+        std::vector<std::string_view> views;
+        views.reserve(payloads.size());
+        for (const auto& payload : payloads) {
+            if (payload) {
+                views.emplace_back(*payload);
+            }
+        }
+        return write_sequence(fd, views, skip);
+    }
+
+    return zerocopy_.send(fd, payloads, skip);
+}
+
+size_t IoBackend::send_batch(const std::vector<int>& fds, std::string_view payload) {
+    std::vector<ssize_t> written;
+    write_batch(fds, payload, written);
+    return static_cast<size_t>(std::count(written.begin(), written.end(), static_cast<ssize_t>(payload.size())));
+}
+
+size_t IoBackend::send_batch(const std::vector<int>& fds, const SharedPayload& payload) {
+    if (!payload) {
+        return 0;
+    }
+    std::vector<ssize_t> written;
+    write_batch(fds, payload, written);
+    return static_cast<size_t>(std::count(written.begin(), written.end(), static_cast<ssize_t>(payload->size())));
+}
+
+bool IoBackend::send_sequence(int fd, const std::vector<std::string_view>& payloads) {
+    size_t total = 0;
+    for (const auto& payload : payloads) {
+        total += payload.size();
+    }
+    return write_sequence(fd, payloads) == static_cast<ssize_t>(total);
+}
+
+bool IoBackend::send_sequence(int fd, const std::vector<SharedPayload>& payloads) {
+    size_t total = 0;
+    for (const auto& payload : payloads) {
+        total += payload ? payload->size() : 0;
+    }
+    return write_sequence(fd, payloads) == static_cast<ssize_t>(total);
+}
+
+void IoBackend::set_zerocopy_threshold(size_t bytes) {
+    zerocopy_threshold_ = bytes;
+}
+
+void IoBackend::wait_writable(int fd, std::function<void()> on_writable) {
+    std::lock_guard<std::mutex> lock(writable_mutex_);
+    if (epoll_fd_ < 0) {
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd_ < 0) {
+            return;
+        }
+        writable_thread_ = std::thread(&IoBackend::poll_writable, this);
+    }
+
+    // One-shot: the socket is re-armed by the next wait_writable() for it
+    epoll_event event{};
+    event.events = EPOLLOUT | EPOLLONESHOT;
+    event.data.fd = fd;
+    bool known = writable_callbacks_.count(fd) > 0;
+    writable_callbacks_[fd] = std::move(on_writable);
+    if (epoll_ctl(epoll_fd_, known ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &event) < 0 &&
+        epoll_ctl(epoll_fd_, known ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, fd, &event) < 0) {
+        writable_callbacks_.erase(fd);
+    }
+}
+
+void IoBackend::poll_writable() {
+    epoll_event events[64];
+    std::vector<std::function<void()>> ready;
+    while (true) {
+        int count = epoll_wait(epoll_fd_, events, 64, 100);
+
+        std::lock_guard<std::mutex> dispatch(dispatch_mutex_);
+        {
+            std::lock_guard<std::mutex> lock(writable_mutex_);
+            if (stopping_) {
+                return;
+            }
+            for (int i = 0; i < count; ++i) {
+                auto it = writable_callbacks_.find(events[i].data.fd);
+                if (it != writable_callbacks_.end()) {
+                    ready.push_back(std::move(it->second));
+                    writable_callbacks_.erase(it);
+                }
+            }
+        }
+        // Run without writable_mutex_ so a callback can wait_writable() again
+        for (auto& callback : ready) {
+            callback();
+        }
+        ready.clear();
+    }
+}
+
+void IoBackend::forget(int fd) {
+    {
+        std::lock_guard<std::mutex> lock(writable_mutex_);
+        writable_callbacks_.erase(fd);
+        if (epoll_fd_ >= 0) {
+            epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+        }
+    }
+    // A callback already taken for fd may still be running
+    std::lock_guard<std::mutex> dispatch(dispatch_mutex_);
+    zerocopy_.forget(fd);
+}
+
+std::shared_ptr<IoBackend> IoBackend::create(const std::string& preferred,
+                                             std::string& fallback_reason) {
+    fallback_reason.clear();
+
+    if (preferred == "io_uring") {
+        auto backend = std::make_shared<IoUringBackend>();
+        if (backend->is_available()) {
+            return backend;
+        }
+        fallback_reason = "io_uring unavailable: " + std::string(strerror(backend->setup_error()));
+    } else if (preferred != "posix") {
+        fallback_reason = "unknown io backend '" + preferred + "'";
+    }
+
+    return std::make_shared<PosixIoBackend>();
+}
+
+// ---------------------------------------------------------------------------
+// PosixIoBackend
+// ---------------------------------------------------------------------------
+
+void PosixIoBackend::write_batch(const std::vector<int>& fds, std::string_view payload,
+                                 std::vector<ssize_t>& written) {
+    written.resize(fds.size());
+    for (size_t i = 0; i < fds.size(); ++i) {
+        written[i] = send_nowait(fds[i], payload, stats_);
+    }
+
+    stats_.payloads.fetch_add(fds.size(), std::memory_order_relaxed);
+    stats_.bytes.fetch_add(fds.size() * payload.size(), std::memory_order_relaxed);
+}
+
+// ---------------------------------------------------------------------------
+// IoUringBackend
+// ---------------------------------------------------------------------------
+
+struct IoUringBackend::Ring {
+    int fd = -1;
+    unsigned sq_entries = 0;
+
+    // Submission queue
+    unsigned* sq_head = nullptr;
+    unsigned* sq_tail = nullptr;
+    unsigned* sq_mask = nullptr;
+    unsigned* sq_array = nullptr;
+    io_uring_sqe* sqes = nullptr;
+
+    // Completion queue
+    unsigned* cq_head = nullptr;
+    unsigned* cq_tail = nullptr;
+    unsigned* cq_mask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+
+    void* sq_ptr = MAP_FAILED;
+    size_t sq_len = 0;
+    void* cq_ptr = MAP_FAILED;
+    size_t cq_len = 0;
+    size_t sqes_len = 0;
+
+    std::mutex mutex;
+
+    ~Ring() {
+        if (sqes) {
+            munmap(sqes, sqes_len);
+        }
+        if (cq_ptr != MAP_FAILED && cq_ptr != sq_ptr) {
+            munmap(cq_ptr, cq_len);
+        }
+        if (sq_ptr != MAP_FAILED) {
+            munmap(sq_ptr, sq_len);
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+
+    bool init(unsigned entries) {
+        io_uring_params params{};
+        fd = io_uring_setup(entries, &params);
+        if (fd < 0) {
+            return false;
+        }
+
+        sq_entries = params.sq_entries;
+        sq_len = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_len = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+        bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single_mmap) {
+            sq_len = cq_len = std::max(sq_len, cq_len);
+        }
+
+        sq_ptr = mmap(nullptr, sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      fd, IORING_OFF_SQ_RING);
+        if (sq_ptr == MAP_FAILED) {
+            return false;
+        }
+
+        if (single_mmap) {
+            cq_ptr = sq_ptr;
+        } else {
+            cq_ptr = mmap(nullptr, cq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                          fd, IORING_OFF_CQ_RING);
+            if (cq_ptr == MAP_FAILED) {
+                return false;
+            }
+        }
+
+        sqes_len = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqes_ptr = mmap(nullptr, sqes_len, PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+        if (sqes_ptr == MAP_FAILED) {
+            return false;
+        }
+        sqes = static_cast<io_uring_sqe*>(sqes_ptr);
+
+        auto* sq = static_cast<char*>(sq_ptr);
+        sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_mask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+        auto* cq = static_cast<char*>(cq_ptr);
+        cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+};
+
+IoUringBackend::IoUringBackend(unsigned ring_count, unsigned ring_entries) {
+    if (ring_count == 0) {
+        ring_count = std::clamp(std::thread::hardware_concurrency(), 1u, 8u);
+    }
+
+    for (unsigned i = 0; i < ring_count; ++i) {
+        auto ring = std::make_unique<Ring>();
+        if (!ring->init(ring_entries)) {
+            setup_errno_ = errno;  // before ~Ring's munmap/close can change it
+            break;
+        }
+        rings_.push_back(std::move(ring));
+    }
+}
+
+IoUringBackend::~IoUringBackend() = default;
+
+IoUringBackend::Ring& IoUringBackend::acquire_ring() {
+    // Prefer an idle ring; block on the round-robin pick if all are busy
+    unsigned start = next_ring_.fetch_add(1, std::memory_order_relaxed);
+    for (size_t i = 0; i < rings_.size(); ++i) {
+        Ring& ring = *rings_[(start + i) % rings_.size()];
+        if (ring.mutex.try_lock()) {
+            return ring;
+        }
+    }
+
+    Ring& ring = *rings_[start % rings_.size()];
+    ring.mutex.lock();
+    return ring;
+}
+
+void IoUringBackend::write_batch(const std::vector<int>& fds, std::string_view payload,
+                                 std::vector<ssize_t>& written) {
+    written.assign(fds.size(), 0);
+    if (fds.empty()) {
+        return;
+    }
+
+    Ring& ring = acquire_ring();
+    std::lock_guard<std::mutex> lock(ring.mutex, std::adopt_lock);
+
+    size_t offset = 0;
+
+    while (offset < fds.size()) {
+        unsigned batch = static_cast<unsigned>(std::min<size_t>(fds.size() - offset, ring.sq_entries));
+
+        // Queue one SEND per recipient; only this thread produces on the ring
+        unsigned tail = *ring.sq_tail;
+        for (unsigned i = 0; i < batch; ++i) {
+            unsigned index = tail & *ring.sq_mask;
+            io_uring_sqe* sqe = &ring.sqes[index];
+            std::memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = IORING_OP_SEND;
+            sqe->fd = fds[offset + i];
+            sqe->addr = reinterpret_cast<uint64_t>(payload.data());
+            sqe->len = static_cast<uint32_t>(payload.size());
+            sqe->msg_flags = MSG_NOSIGNAL | MSG_DONTWAIT;  // a full socket completes with -EAGAIN
+            sqe->user_data = offset + i;
+            ring.sq_array[index] = index;
+            ++tail;
+        }
+        __atomic_store_n(ring.sq_tail, tail, __ATOMIC_RELEASE);
+
+        // Submit the whole batch and wait for its completions in one call
+        unsigned submitted = 0;
+        unsigned to_submit = batch;
+        while (to_submit > 0) {
+            int ret = io_uring_enter(ring.fd, to_submit, to_submit, IORING_ENTER_GETEVENTS);
+            stats_.syscalls.fetch_add(1, std::memory_order_relaxed);
+            if (ret < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+            submitted += ret;
+            to_submit -= ret;
+        }
+
+        if (to_submit > 0) {
+            // Drop whatever the kernel did not consume so the ring stays usable,
+            // and send those the plain way
+            __atomic_store_n(ring.sq_tail, __atomic_load_n(ring.sq_head, __ATOMIC_ACQUIRE),
+                             __ATOMIC_RELEASE);
+            for (unsigned i = submitted; i < batch; ++i) {
+                written[offset + i] = send_nowait(fds[offset + i], payload, stats_);
+            }
+            stats_.payloads.fetch_add(to_submit, std::memory_order_relaxed);
+            stats_.bytes.fetch_add(to_submit * payload.size(), std::memory_order_relaxed);
+        }
+
+        // Reap one completion per submitted SEND. The kernel reads the payload
+        // until its SEND completes, so this must not return before every one has.
+        unsigned completed = 0;
+        while (completed < submitted) {
+            unsigned head = *ring.cq_head;
+            unsigned cq_tail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+
+            if (head == cq_tail) {
+                int ret = io_uring_enter(ring.fd, 0, submitted - completed, IORING_ENTER_GETEVENTS);
+                stats_.syscalls.fetch_add(1, std::memory_order_relaxed);
+                if (ret < 0 && errno != EINTR) {
+                    // Cannot wait in the kernel; completions still land in the CQ
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+                continue;
+            }
+
+            for (; head != cq_tail && completed < submitted; ++head, ++completed) {
+                const io_uring_cqe& cqe = ring.cqes[head & *ring.cq_mask];
+                if (cqe.user_data < written.size()) {
+                    written[cqe.user_data] = cqe.res >= 0 ? cqe.res : (would_block(-cqe.res) ? 0 : -1);
+                }
+            }
+            __atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+        }
+
+        stats_.payloads.fetch_add(submitted, std::memory_order_relaxed);
+        stats_.bytes.fetch_add(submitted * payload.size(), std::memory_order_relaxed);
+        offset += batch;
+    }
+}
@@ -0,0 +1,141 @@
+#include "RoomDirectory.h"
+#include <algorithm>
+#include <charconv>
+
+namespace {
+
+bool has_prefix(const std::string& name, const std::string& prefix) {
+    return name.compare(0, prefix.size(), prefix) == 0;
+}
+
+// MEMBERS cursors are "<members>:<name>"
+std::string member_cursor(size_t members, const std::string& name) {
+    return std::to_string(members) + ":" + name;
+}
+
+bool parse_member_cursor(const std::string& cursor, size_t& members, std::string& name) {
+    size_t colon = cursor.find(':');
+    if (colon == std::string::npos) {
+        return false;
+    }
+    auto result = std::from_chars(cursor.data(), cursor.data() + colon, members);
+    if (result.ec != std::errc() || result.ptr != cursor.data() + colon) {
+        return false;
+    }
+    name = cursor.substr(colon + 1);
+    return true;
+}
+
+} // namespace
+
+bool RoomDirectory::add(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!by_name_.emplace(name, 0).second) {
+        return false;
+    }
+    by_members_.emplace(0, name);
+    index_.add(name);
+    return true;
+}
+
+void RoomDirectory::set_members(const std::string& name, size_t members) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = by_name_.find(name);
+    if (it == by_name_.end() || it->second == members) {
+        return;
+    }
+    by_members_.erase(MemberKey(it->second, name));
+    by_members_.emplace(members, name);
+    it->second = members;
+    index_.set_members(name, members);
+}
+
+size_t RoomDirectory::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return by_name_.size();
+}
+
+RoomPage RoomDirectory::query(const RoomQuery& query) const {
+    size_t limit = query.limit == 0 ? DEFAULT_PAGE_SIZE : std::min(query.limit, MAX_PAGE_SIZE);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    RoomPage page = query.sort == RoomSort::MEMBERS
+        ? query_by_members_locked(query, limit)
+        : query_by_name_locked(query, limit);
+    page.total = count_prefix_locked(query.prefix);
+    return page;
+}
+
+std::vector<RoomEntry> RoomDirectory::search(std::string_view text, RoomMatch match, size_t limit) const {
+    limit = limit == 0 ? DEFAULT_SEARCH_RESULTS : std::min(limit, MAX_SEARCH_RESULTS);
+    std::lock_guard<std::mutex> lock(mutex_);
+    return index_.search(text, match, limit);
+}
+
+RoomPage RoomDirectory::query_by_name_locked(const RoomQuery& query, size_t limit) const {
+    RoomPage page;
+    auto it = by_name_.lower_bound(query.prefix);
+    if (!query.cursor.empty() && query.cursor >= query.prefix) {
+        it = by_name_.upper_bound(query.cursor);
+    }
+
+    for (; it != by_name_.end() && has_prefix(it->first, query.prefix); ++it) {
+        if (page.rooms.size() == limit) {
+            page.next_cursor = page.rooms.back().name;
+            break;
+        }
+        page.rooms.push_back(RoomEntry{it->first, it->second});
+    }
+    return page;
+}
+
+RoomPage RoomDirectory::query_by_members_locked(const RoomQuery& query, size_t limit) const {
+    RoomPage page;
+    auto it = by_members_.begin();
+    size_t members = 0;
+    std::string name;
+    if (!query.cursor.empty() && parse_member_cursor(query.cursor, members, name)) {
+        it = by_members_.upper_bound(MemberKey(members, name));
+    }
+
+    // Member order ignores names, so a prefix is a filtered scan
+    for (; it != by_members_.end(); ++it) {
+        if (!has_prefix(it->second, query.prefix)) {
+            continue;
+        }
+        if (page.rooms.size() == limit) {
+            const RoomEntry& last = page.rooms.back();
+            page.next_cursor = member_cursor(last.members, last.name);
+            break;
+        }
+        page.rooms.push_back(RoomEntry{it->second, it->first});
+    }
+    return page;
+}
+
+size_t RoomDirectory::count_prefix_locked(const std::string& prefix) const {
+    if (prefix.empty()) {
+        return by_name_.size();
+    }
+    size_t count = 0;
+    for (auto it = by_name_.lower_bound(prefix); it != by_name_.end() && has_prefix(it->first, prefix); ++it) {
+        ++count;
+    }
+    return count;
+}
+
+RoomSort RoomDirectory::parse_sort(std::string_view sort) {
+    return sort == "members" ? RoomSort::MEMBERS : RoomSort::NAME;
+}
+
+const char* RoomDirectory::sort_name(RoomSort sort) {
+    return sort == RoomSort::MEMBERS ? "members" : "name";
+}
+
+RoomMatch RoomDirectory::parse_match(std::string_view match) {
+    return match == "substring" ? RoomMatch::SUBSTRING : RoomMatch::PREFIX;
+}
+
+const char* RoomDirectory::match_name(RoomMatch match) {
+    return match == RoomMatch::SUBSTRING ? "substring" : "prefix";
+}
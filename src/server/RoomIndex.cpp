@@ -0,0 +1,192 @@
+#include "RoomIndex.h"
+#include <algorithm>
+#include <cctype>
+
+bool RoomIndex::RankOrder::operator()(const RankKey& a, const RankKey& b) const {
+    if (a.first != b.first) {
+        return a.first > b.first;
+    }
+    const std::string& name_a = (*rooms)[a.second].name;
+    const std::string& name_b = (*rooms)[b.second].name;
+    if (name_a != name_b) {
+        return name_a < name_b;
+    }
+    return a.second < b.second;
+}
+
+RoomIndex::RoomIndex() : by_rank_(RankOrder{&rooms_}) {}
+
+std::string RoomIndex::fold(std::string_view text) {
+    std::string folded(text);
+    for (char& c : folded) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return folded;
+}
+
+uint32_t RoomIndex::trigram(const char* bytes) {
+    return (static_cast<uint32_t>(static_cast<unsigned char>(bytes[0])) << 16) |
+           (static_cast<uint32_t>(static_cast<unsigned char>(bytes[1])) << 8) |
+           static_cast<uint32_t>(static_cast<unsigned char>(bytes[2]));
+}
+
+bool RoomIndex::add(const std::string& name) {
+    if (ids_.count(name) > 0) {
+        return false;
+    }
+
+    uint32_t id = static_cast<uint32_t>(rooms_.size());
+    rooms_.push_back(Room{name, fold(name), 0});
+    ids_.emplace(name, id);
+    by_folded_.emplace(rooms_[id].folded, id);
+    by_rank_.emplace(0, id);
+
+    // Ids only grow, so appending keeps each posting list sorted
+    const std::string& folded = rooms_[id].folded;
+    for (size_t i = 0; i + 3 <= folded.size(); ++i) {
+        auto& postings = trigrams_[trigram(folded.data() + i)];
+        if (postings.empty() || postings.back() != id) {
+            postings.push_back(id);
+        }
+    }
+    return true;
+}
+
+void RoomIndex::set_members(const std::string& name, size_t members) {
+    auto it = ids_.find(name);
+    if (it == ids_.end()) {
+        return;
+    }
+    Room& room = rooms_[it->second];
+    if (room.members == members) {
+        return;
+    }
+    by_rank_.erase(RankKey(room.members, it->second));
+    room.members = members;
+    by_rank_.emplace(members, it->second);
+}
+
+bool RoomIndex::matches(uint32_t id, const std::string& query, RoomMatch match) const {
+    const std::string& folded = rooms_[id].folded;
+    if (match == RoomMatch::PREFIX) {
+        return folded.compare(0, query.size(), query) == 0;
+    }
+    return folded.find(query) != std::string::npos;
+}
+
+bool RoomIndex::walk_ranked(const std::string& query, RoomMatch match, size_t limit,
+                            std::vector<RoomEntry>& results) const {
+    results.clear();
+    size_t visited = 0;
+    for (auto it = by_rank_.begin(); it != by_rank_.end() && results.size() < limit; ++it) {
+        if (++visited > WALK_VISIT_LIMIT) {
+            return false;
+        }
+        if (matches(it->second, query, match)) {
+            const Room& room = rooms_[it->second];
+            results.push_back(RoomEntry{room.name, room.members});
+        }
+    }
+    return true;
+}
+
+std::vector<RoomEntry> RoomIndex::rank(std::vector<uint32_t>& ids, size_t limit) const {
+    RankOrder order{&rooms_};
+    auto better = [&](uint32_t a, uint32_t b) {
+        return order(RankKey(rooms_[a].members, a), RankKey(rooms_[b].members, b));
+    };
+    size_t count = std::min(limit, ids.size());
+    std::partial_sort(ids.begin(), ids.begin() + count, ids.end(), better);
+
+    std::vector<RoomEntry> results;
+    results.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        results.push_back(RoomEntry{rooms_[ids[i]].name, rooms_[ids[i]].members});
+    }
+    return results;
+}
+
+std::vector<RoomEntry> RoomIndex::search(std::string_view text, RoomMatch match, size_t limit) const {
+    if (limit == 0) {
+        return {};
+    }
+    std::string query = fold(text);
+    std::vector<RoomEntry> results;
+    if (query.empty()) {
+        walk_ranked(query, RoomMatch::PREFIX, limit, results);  // every room matches
+        return results;
+    }
+
+    std::vector<uint32_t> candidates;
+    if (match == RoomMatch::PREFIX) {
+        // Matching names are contiguous in folded order
+        auto first = by_folded_.lower_bound({query, 0});
+        auto in_range = [&](auto it) {
+            return it != by_folded_.end() && it->first.compare(0, query.size(), query) == 0;
+        };
+        size_t count = 0;
+        for (auto it = first; in_range(it) && count <= DENSE_SCAN_LIMIT; ++it) {
+            ++count;
+        }
+        if (count > DENSE_SCAN_LIMIT && walk_ranked(query, match, limit, results)) {
+            return results;
+        }
+        for (auto it = first; in_range(it); ++it) {
+            candidates.push_back(it->second);
+        }
+        return rank(candidates, limit);
+    }
+
+    if (query.size() < 3) {
+        // Too short for trigrams: common enough to walk, else check every room
+        if (walk_ranked(query, match, limit, results)) {
+            return results;
+        }
+        for (uint32_t id = 0; id < rooms_.size(); ++id) {
+            if (matches(id, query, match)) {
+                candidates.push_back(id);
+            }
+        }
+        return rank(candidates, limit);
+    }
+
+    // Posting lists of the query's trigrams, rarest first, each once
+    std::vector<const std::vector<uint32_t>*> postings;
+    for (size_t i = 0; i + 3 <= query.size(); ++i) {
+        auto it = trigrams_.find(trigram(query.data() + i));
+        if (it == trigrams_.end()) {
+            return {};
+        }
+        if (std::find(postings.begin(), postings.end(), &it->second) == postings.end()) {
+            postings.push_back(&it->second);
+        }
+    }
+    std::sort(postings.begin(), postings.end(),
+              [](const auto* a, const auto* b) { return a->size() < b->size(); });
+    postings.resize(std::min(postings.size(), INTERSECT_TRIGRAMS));
+
+    // Ids of the rarest list that the others also hold; every list is
+    // sorted, so each cursor only moves forward
+    std::vector<std::vector<uint32_t>::const_iterator> cursors;
+    for (const auto* list : postings) {
+        cursors.push_back(list->begin());
+    }
+    for (uint32_t id : *postings[0]) {
+        bool in_all = true;
+        for (size_t k = 1; k < postings.size() && in_all; ++k) {
+            cursors[k] = std::lower_bound(cursors[k], postings[k]->end(), id);
+            if (cursors[k] == postings[k]->end()) {
+                return rank(candidates, limit);  // no later id is in every list
+            }
+            in_all = *cursors[k] == id;
+        }
+        if (in_all && matches(id, query, match)) {
+            // Dense: try the member-order walk once, else keep collecting
+            if (candidates.size() == DENSE_SCAN_LIMIT && walk_ranked(query, match, limit, results)) {
+                return results;
+            }
+            candidates.push_back(id);
+        }
+    }
+    return rank(candidates, limit);
+}
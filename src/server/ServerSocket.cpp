@@ -1,6 +1,7 @@
 #include "ServerSocket.h"
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <unistd.h>
 #include <arpa/inet.h>
 
@@ -47,6 +48,12 @@ bool ServerSocket::initialize(std::string& error_msg) {
     return true;
 }
 
+void ServerSocket::set_keepalive(int idle_s, int interval_s, int count) {
+    keepalive_idle_s_ = idle_s;
+    keepalive_interval_s_ = interval_s;
+    keepalive_count_ = count;
+}
+
 void ServerSocket::accept_connections(std::function<void(int, const std::string&)> on_client_connected) {
     while (listening_) {
         sockaddr_in client_addr{};
@@ -61,6 +68,18 @@ void ServerSocket::accept_connections(std::function<void(int, const std::string&
             break;
         }
 
+        if (keepalive_idle_s_ > 0) {
+            int on = 1;
+            setsockopt(client_fd, SOL_SOCKET, SO_KEEPALIVE, &on, sizeof(on));
+            setsockopt(client_fd, IPPROTO_TCP, TCP_KEEPIDLE, &keepalive_idle_s_, sizeof(keepalive_idle_s_));
+            if (keepalive_interval_s_ > 0) {
+                setsockopt(client_fd, IPPROTO_TCP, TCP_KEEPINTVL, &keepalive_interval_s_, sizeof(keepalive_interval_s_));
+            }
+            if (keepalive_count_ > 0) {
+                setsockopt(client_fd, IPPROTO_TCP, TCP_KEEPCNT, &keepalive_count_, sizeof(keepalive_count_));
+            }
+        }
+
         std::string client_ip = inet_ntoa(client_addr.sin_addr);
         
         if (on_client_connected) {
@@ -0,0 +1,122 @@
+#include "TimerWheel.h"
+
+TimerWheel::TimerWheel(uint64_t start_tick)
+    : now_(start_tick) {
+    slots_.fill(NIL);
+}
+
+TimerWheel::TimerId TimerWheel::schedule(uint64_t delay, uint64_t payload) {
+    uint32_t index;
+    if (!free_.empty()) {
+        index = free_.back();
+        free_.pop_back();
+    } else {
+        index = static_cast<uint32_t>(nodes_.size());
+        nodes_.emplace_back();
+    }
+
+    Node& node = nodes_[index];
+    node.expires = now_ + (delay == 0 ? 1 : delay);
+    if (node.expires < now_) {
+        node.expires = UINT64_MAX;  // saturate instead of wrapping into the past
+    }
+    node.payload = payload;
+    place(index);
+    ++size_;
+    return (static_cast<uint64_t>(node.generation) << 32) | (index + uint64_t{1});
+}
+
+bool TimerWheel::cancel(TimerId id) {
+    uint64_t low = id & 0xFFFFFFFFu;
+    if (low == 0 || low > nodes_.size()) {
+        return false;
+    }
+    uint32_t index = static_cast<uint32_t>(low - 1);
+    Node& node = nodes_[index];
+    if (node.slot == NIL || node.generation != static_cast<uint32_t>(id >> 32)) {
+        return false;
+    }
+    unlink(index);
+    release(index);
+    return true;
+}
+
+void TimerWheel::advance(uint64_t tick, std::vector<uint64_t>& expired) {
+    while (now_ < tick) {
+        ++now_;
+        // Empty higher slots first so their timers can land in this tick's slot
+        for (size_t level = LEVELS - 1; level >= 1; --level) {
+            uint64_t mask = (uint64_t{1} << (SLOT_BITS * level)) - 1;
+            if ((now_ & mask) == 0) {
+                cascade(level);
+            }
+        }
+
+        uint32_t slot = static_cast<uint32_t>(now_ & (SLOTS - 1));
+        while (slots_[slot] != NIL) {
+            uint32_t index = slots_[slot];
+            expired.push_back(nodes_[index].payload);
+            unlink(index);
+            release(index);
+        }
+    }
+}
+
+void TimerWheel::place(uint32_t index) {
+    uint64_t expires = nodes_[index].expires;
+    uint64_t differs = expires ^ now_;
+    for (size_t level = 0; level < LEVELS; ++level) {
+        if (differs < (uint64_t{1} << (SLOT_BITS * (level + 1)))) {
+            uint64_t digit = (expires >> (SLOT_BITS * level)) & (SLOTS - 1);
+            link(index, static_cast<uint32_t>(level * SLOTS + digit));
+            return;
+        }
+    }
+    // Beyond the top level: park in the next top-level slot to be emptied
+    size_t top = LEVELS - 1;
+    uint64_t digit = ((now_ >> (SLOT_BITS * top)) + 1) & (SLOTS - 1);
+    link(index, static_cast<uint32_t>(top * SLOTS + digit));
+}
+
+void TimerWheel::link(uint32_t index, uint32_t slot) {
+    Node& node = nodes_[index];
+    node.slot = slot;
+    node.prev = NIL;
+    node.next = slots_[slot];
+    if (node.next != NIL) {
+        nodes_[node.next].prev = index;
+    }
+    slots_[slot] = index;
+}
+
+void TimerWheel::unlink(uint32_t index) {
+    Node& node = nodes_[index];
+    if (node.prev != NIL) {
+        nodes_[node.prev].next = node.next;
+    } else {
+        slots_[node.slot] = node.next;
+    }
+    if (node.next != NIL) {
+        nodes_[node.next].prev = node.prev;
+    }
+    node.prev = NIL;
+    node.next = NIL;
+    node.slot = NIL;
+}
+
+void TimerWheel::release(uint32_t index) {
+    ++nodes_[index].generation;  // stale TimerIds no longer match
+    free_.push_back(index);
+    --size_;
+}
+
+void TimerWheel::cascade(size_t level) {
+    uint64_t digit = (now_ >> (SLOT_BITS * level)) & (SLOTS - 1);
+    uint32_t slot = static_cast<uint32_t>(level * SLOTS + digit);
+    // Every timer here moves to a lower level (or, if parked, a later top slot)
+    while (slots_[slot] != NIL) {
+        uint32_t index = slots_[slot];
+        unlink(index);
+        place(index);
+    }
+}
@@ -0,0 +1,135 @@
+#include "TrafficCapture.h"
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+constexpr auto FLUSH_INTERVAL = std::chrono::seconds(1);
+
+int64_t epoch_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+TrafficCapture::TrafficCapture(std::string path)
+    : path_(std::move(path)), start_(Clock::now()), last_flush_(start_) {}
+
+TrafficCapture::~TrafficCapture() {
+    if (file_) {
+        std::fclose(file_);
+    }
+}
+
+bool TrafficCapture::open() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_) {
+        return true;
+    }
+    file_ = std::fopen(path_.c_str(), "w");
+    if (!file_) {
+        std::cerr << "Error: Could not open capture file: " << path_ << "\n";
+        return false;
+    }
+    start_ = Clock::now();
+    write_locked({{"capture", FORMAT_VERSION}, {"started_ms", epoch_ms()}}, true);
+    return true;
+}
+
+uint64_t TrafficCapture::elapsed_ns() const {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start_).count());
+}
+
+void TrafficCapture::write_locked(const json& record, bool flush) {
+    if (!file_) {
+        return;
+    }
+    std::string line = record.dump();
+    line += '\n';
+    std::fwrite(line.data(), 1, line.size(), file_);
+
+    auto now = Clock::now();
+    if (flush || now - last_flush_ >= FLUSH_INTERVAL) {
+        std::fflush(file_);
+        last_flush_ = now;
+    }
+}
+
+uint64_t TrafficCapture::connection_opened(const std::string& username, const json& auth_data) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t conn = next_conn_++;
+    write_locked({{"t", elapsed_ns()}, {"conn", conn}, {"open", username}, {"data", auth_data}}, false);
+    return conn;
+}
+
+void TrafficCapture::frame(uint64_t conn, const NetworkMessage& message) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++frames_;
+    write_locked({{"t", elapsed_ns()}, {"conn", conn}, {"type", message.body.type},
+                  {"data", message.body.data}}, false);
+}
+
+void TrafficCapture::connection_closed(uint64_t conn) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    write_locked({{"t", elapsed_ns()}, {"conn", conn}, {"close", true}}, true);
+}
+
+uint64_t TrafficCapture::frames() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return frames_;
+}
+
+bool TrafficCapture::load(const std::string& path, std::vector<CapturedEvent>& events, std::string& error) {
+    std::ifstream file(path);
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    std::string line;
+    size_t line_number = 0;
+    while (std::getline(file, line)) {
+        ++line_number;
+        if (line.empty()) {
+            continue;
+        }
+        json record = json::parse(line, nullptr, false);
+        if (record.is_discarded() || !record.is_object()) {
+            // A capture cut off mid-line by a crash still replays up to the cut
+            if (file.peek() == std::char_traits<char>::eof()) {
+                break;
+            }
+            error = "line " + std::to_string(line_number) + ": not JSON";
+            return false;
+        }
+        if (record.contains("capture")) {
+            if (record.value("capture", 0) != FORMAT_VERSION) {
+                error = "unsupported capture version";
+                return false;
+            }
+            continue;
+        }
+
+        CapturedEvent event;
+        event.time_ns = record.value("t", uint64_t{0});
+        event.conn = record.value("conn", uint64_t{0});
+        event.data = record.value("data", json::object());
+        if (record.contains("open")) {
+            event.kind = CapturedEvent::Kind::OPEN;
+            event.user = record.value("open", "");
+        } else if (record.contains("close")) {
+            event.kind = CapturedEvent::Kind::CLOSE;
+        } else {
+            event.kind = CapturedEvent::Kind::FRAME;
+            event.type = record.value("type", "");
+        }
+        if (event.conn == 0) {
+            error = "line " + std::to_string(line_number) + ": missing conn";
+            return false;
+        }
+        events.push_back(std::move(event));
+    }
+    return true;
+}
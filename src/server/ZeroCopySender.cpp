@@ -0,0 +1,318 @@
+#include "ZeroCopySender.h"
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+
+namespace {
+
+// Wrap-aware "a <= b" for the kernel's 32-bit zerocopy counters
+bool seq_leq(uint32_t a, uint32_t b) {
+    return static_cast<int32_t>(b - a) >= 0;
+}
+
+} // namespace
+
+std::shared_ptr<ZeroCopySender::SocketState> ZeroCopySender::state_for(int fd) {
+    std::lock_guard<std::mutex> lock(sockets_mutex_);
+    auto& state = sockets_[fd];
+    if (!state) {
+        state = std::make_shared<SocketState>();
+    }
+    return state;
+}
+
+ssize_t ZeroCopySender::send(int fd, const std::vector<SharedPayload>& payloads, size_t skip) {
+    auto state = state_for(fd);
+    std::lock_guard<std::mutex> lock(state->mutex);
+
+    if (!state->enabled && state->supported) {
+        int one = 1;
+        if (setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == 0) {
+            state->enabled = true;
+        } else {
+            state->supported = false;
+        }
+        stats_.syscalls.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (!state->enabled) {
+        return send_copy(fd, payloads, skip);
+    }
+
+    reap_locked(fd, *state);
+    if (state->in_flight.size() >= MAX_IN_FLIGHT_PER_SOCKET) {
+        // Receiver is not acknowledging; stop pinning more memory for it
+        return send_copy(fd, payloads, skip);
+    }
+
+    size_t offset = skip;
+    std::vector<iovec> iov;
+    iov.reserve(payloads.size());
+    for (const auto& payload : payloads) {
+        if (!payload || skip >= payload->size()) {
+            skip -= payload ? payload->size() : 0;
+            continue;
+        }
+        iov.push_back({const_cast<char*>(payload->data()) + skip, payload->size() - skip});
+        skip = 0;
+    }
+    if (iov.empty()) {
+        return 0;
+    }
+
+    msghdr msg{};
+    msg.msg_iov = iov.data();
+    msg.msg_iovlen = iov.size();
+
+    ssize_t sent;
+    do {
+        sent = sendmsg(fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT | MSG_ZEROCOPY);
+        stats_.syscalls.fetch_add(1, std::memory_order_relaxed);
+    } while (sent < 0 && errno == EINTR);
+
+    if (sent < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return 0;
+        }
+        if (errno == ENOBUFS) {
+            // Out of optmem for pinned pages; copy this one instead
+            return send_copy(fd, payloads, offset);
+        }
+        return -1;
+    }
+
+    // Every successful MSG_ZEROCOPY call consumes one notification id
+    state->in_flight.push_back({state->next_id++, payloads, static_cast<size_t>(sent)});
+    pending_.fetch_add(1, std::memory_order_relaxed);
+    stats_.zerocopy_bytes.fetch_add(sent, std::memory_order_relaxed);
+    return sent;
+}
+
+ssize_t ZeroCopySender::send_copy(int fd, const std::vector<SharedPayload>& payloads, size_t skip) {
+    std::vector<iovec> iov;
+    iov.reserve(payloads.size());
+    for (const auto& payload : payloads) {
+        if (!payload || payload->empty()) {
+            continue;
+        }
+        if (skip >= payload->size()) {
+            skip -= payload->size();
+            continue;
+        }
+        iov.push_back({const_cast<char*>(payload->data()) + skip, payload->size() - skip});
+        skip = 0;
+    }
+
+    size_t total_sent = 0;
+    size_t index = 0;
+    while (index < iov.size()) {
+        msghdr msg{};
+        msg.msg_iov = &iov[index];
+        msg.msg_iovlen = iov.size() - index;
+
+        ssize_t sent = sendmsg(fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+        stats_.syscalls.fetch_add(1, std::memory_order_relaxed);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            return -1;
+        }
+        total_sent += static_cast<size_t>(sent);
+
+        size_t remaining = static_cast<size_t>(sent);
+        while (index < iov.size() && remaining >= iov[index].iov_len) {
+            remaining -= iov[index].iov_len;
+            ++index;
+        }
+        if (index < iov.size()) {
+            iov[index].iov_base = static_cast<char*>(iov[index].iov_base) + remaining;
+            iov[index].iov_len -= remaining;
+        }
+    }
+
+    stats_.fallback_bytes.fetch_add(total_sent, std::memory_order_relaxed);
+    return static_cast<ssize_t>(total_sent);
+}
+
+void ZeroCopySender::reap(int fd) {
+    std::shared_ptr<SocketState> state;
+    {
+        std::lock_guard<std::mutex> lock(sockets_mutex_);
+        auto it = sockets_.find(fd);
+        if (it == sockets_.end()) {
+            return;
+        }
+        state = it->second;
+    }
+
+    std::lock_guard<std::mutex> lock(state->mutex);
+    reap_locked(fd, *state);
+}
+
+void ZeroCopySender::reap_all() {
+    std::vector<std::pair<int, std::shared_ptr<SocketState>>> sockets;
+    {
+        std::lock_guard<std::mutex> lock(sockets_mutex_);
+        sockets.assign(sockets_.begin(), sockets_.end());
+    }
+
+    for (auto& [fd, state] : sockets) {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        reap_locked(fd, *state);
+    }
+    reap_retired();
+}
+
+void ZeroCopySender::reap_retired() {
+    std::vector<std::pair<int, std::shared_ptr<SocketState>>> retired;
+    {
+        std::lock_guard<std::mutex> lock(sockets_mutex_);
+        retired.assign(retired_.begin(), retired_.end());
+    }
+
+    // A retired socket is closed once the kernel has let go of its last page
+    for (auto& [fd, state] : retired) {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        reap_locked(fd, *state);
+        if (state->in_flight.empty()) {
+            // reap_all() and the reaper can both get here; one closes it
+            bool owned = false;
+            {
+                std::lock_guard<std::mutex> sockets_lock(sockets_mutex_);
+                auto it = retired_.find(fd);
+                if (it != retired_.end() && it->second == state) {
+                    retired_.erase(it);
+                    owned = true;
+                }
+            }
+            if (owned) {
+                close(fd);
+            }
+        }
+    }
+}
+
+void ZeroCopySender::reap_locked(int fd, SocketState& state) {
+    while (!state.in_flight.empty()) {
+        char control[128];
+        msghdr msg{};
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        ssize_t ret = recvmsg(fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT);
+        stats_.syscalls.fetch_add(1, std::memory_order_relaxed);
+        if (ret < 0) {
+            break;  // EAGAIN: nothing more completed yet
+        }
+
+        for (cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+            bool is_recverr = (cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) ||
+                              (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR);
+            if (!is_recverr) {
+                continue;
+            }
+
+            auto* err = reinterpret_cast<sock_extended_err*>(CMSG_DATA(cm));
+            if (err->ee_errno != 0 || err->ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+                continue;
+            }
+
+            // Notification covers the inclusive id range [ee_info, ee_data]
+            uint32_t lo = err->ee_info;
+            uint32_t hi = err->ee_data;
+            bool copied = err->ee_code & SO_EE_CODE_ZEROCOPY_COPIED;
+
+            while (!state.in_flight.empty() &&
+                   seq_leq(lo, state.in_flight.front().id) &&
+                   seq_leq(state.in_flight.front().id, hi)) {
+                if (copied) {
+                    stats_.copied_bytes.fetch_add(state.in_flight.front().bytes,
+                                                  std::memory_order_relaxed);
+                }
+                state.in_flight.pop_front();
+                pending_.fetch_sub(1, std::memory_order_relaxed);
+            }
+            stats_.completions.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+void ZeroCopySender::forget(int fd) {
+    std::shared_ptr<SocketState> state;
+    {
+        std::lock_guard<std::mutex> lock(sockets_mutex_);
+        auto it = sockets_.find(fd);
+        if (it == sockets_.end()) {
+            return;
+        }
+        state = std::move(it->second);
+        sockets_.erase(it);
+    }
+
+    std::lock_guard<std::mutex> lock(state->mutex);
+    reap_locked(fd, *state);
+    if (state->in_flight.empty()) {
+        return;
+    }
+
+    // Closing fd would not unpin the pages: the kernel keeps transmitting from
+    // them. Hold the socket open on a dup so the payloads stay referenced and
+    // their completions can still be read; shut it down so the peer sees the
+    // connection end as it would on close().
+    int held = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if (held < 0) {
+        // No way to hear the completions; keep the payloads for good
+        std::lock_guard<std::mutex> sockets_lock(sockets_mutex_);
+        leaked_.push_back(std::move(state));
+        return;
+    }
+    shutdown(held, SHUT_RDWR);
+    std::lock_guard<std::mutex> sockets_lock(sockets_mutex_);
+    retired_[held] = std::move(state);
+    if (!reaper_.joinable()) {
+        reaper_ = std::thread(&ZeroCopySender::reaper_loop, this);
+    }
+    reaper_cv_.notify_one();
+}
+
+// Retired sockets are drained here rather than by whoever calls reap_all(),
+// so they are closed even when nothing else polls for completions
+void ZeroCopySender::reaper_loop() {
+    std::unique_lock<std::mutex> lock(sockets_mutex_);
+    while (!stopping_) {
+        if (retired_.empty()) {
+            reaper_cv_.wait(lock, [this] { return stopping_ || !retired_.empty(); });
+            continue;
+        }
+        lock.unlock();
+        reap_retired();
+        lock.lock();
+        reaper_cv_.wait_for(lock, RETIRED_REAP_INTERVAL, [this] { return stopping_; });
+    }
+}
+
+ZeroCopySender::~ZeroCopySender() {
+    {
+        std::lock_guard<std::mutex> lock(sockets_mutex_);
+        stopping_ = true;
+    }
+    reaper_cv_.notify_one();
+    if (reaper_.joinable()) {
+        reaper_.join();
+    }
+    for (const auto& [fd, state] : retired_) {
+        close(fd);
+    }
+}
+
+size_t ZeroCopySender::pending() const {
+    return pending_.load(std::memory_order_relaxed);
+}
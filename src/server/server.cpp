@@ -1,14 +1,50 @@
 #include <iostream>
 #include <thread>
+#include <chrono>
 #include <fstream>
+#include <algorithm>
 #include <nlohmann/json.hpp>
 #include "ServerSocket.h"
 #include "ClientManager.h"
+#include "IoBackend.h"
+#include "BatchFlusher.h"
+#include "HistoryIndex.h"
+#include "TrafficCapture.h"
+#include "Heartbeat.h"
+#include "common/Trace.h"
+#include "auth/AuthClient.h"
+#include "auth/AuthServer.h"
+#include "auth/EmbeddedAuthService.h"
+#include "auth/FileUserRepository.h"
+#include "auth/SessionStore.h"
 
 struct ServerConfig {
     int port = 3000;
+    std::string auth_mode = "remote";
+    std::string user_db_path = "users.json";
+    std::string session_path;
     std::string auth_host = "127.0.0.1";
     int auth_port = 3001;
+    std::string auth_socket_path;
+    std::string auth_shm_name;
+    std::string io_backend = "posix";
+    size_t zerocopy_threshold = 0;
+    int stats_interval_seconds = 0;
+    unsigned batch_rate_threshold = 0;
+    int batch_max_delay_ms = 5;
+    size_t batch_max_messages = 64;
+    size_t outbound_queue_limit = ClientConnection::DEFAULT_MAX_QUEUED_FRAMES;
+    std::string history_dir = "history";
+    size_t history_flush_messages = HistoryIndexConfig{}.flush_messages;
+    size_t history_max_segments = HistoryIndexConfig{}.max_segments;
+    std::string capture_path;
+    std::string trace_path;
+    int ping_interval_ms = static_cast<int>(HeartbeatConfig{}.ping_interval.count());
+    int idle_timeout_ms = static_cast<int>(HeartbeatConfig{}.idle_timeout.count());
+    int tcp_keepalive_idle_s = 60;
+    int tcp_keepalive_interval_s = 10;
+    int tcp_keepalive_count = 6;
+    size_t lock_stripes = 0;
 };
 
 ServerConfig load_config() {
@@ -19,8 +55,31 @@ ServerConfig load_config() {
         nlohmann::json j;
         file >> j;
         if (j.contains("port")) cfg.port = j.value("port", cfg.port);
+        if (j.contains("auth_mode")) cfg.auth_mode = j.value("auth_mode", cfg.auth_mode);
+        if (j.contains("session_path")) cfg.session_path = j.value("session_path", cfg.session_path);
+        if (j.contains("user_db_path")) cfg.user_db_path = j.value("user_db_path", cfg.user_db_path);
         if (j.contains("auth_host")) cfg.auth_host = j.value("auth_host", cfg.auth_host);
         if (j.contains("auth_port")) cfg.auth_port = j.value("auth_port", cfg.auth_port);
+        if (j.contains("auth_socket_path")) cfg.auth_socket_path = j.value("auth_socket_path", cfg.auth_socket_path);
+        if (j.contains("auth_shm_name")) cfg.auth_shm_name = j.value("auth_shm_name", cfg.auth_shm_name);
+        if (j.contains("io_backend")) cfg.io_backend = j.value("io_backend", cfg.io_backend);
+        if (j.contains("zerocopy_threshold")) cfg.zerocopy_threshold = j.value("zerocopy_threshold", cfg.zerocopy_threshold);
+        if (j.contains("stats_interval_seconds")) cfg.stats_interval_seconds = j.value("stats_interval_seconds", cfg.stats_interval_seconds);
+        if (j.contains("batch_rate_threshold")) cfg.batch_rate_threshold = j.value("batch_rate_threshold", cfg.batch_rate_threshold);
+        if (j.contains("batch_max_delay_ms")) cfg.batch_max_delay_ms = j.value("batch_max_delay_ms", cfg.batch_max_delay_ms);
+        if (j.contains("batch_max_messages")) cfg.batch_max_messages = j.value("batch_max_messages", cfg.batch_max_messages);
+        if (j.contains("outbound_queue_limit")) cfg.outbound_queue_limit = j.value("outbound_queue_limit", cfg.outbound_queue_limit);
+        if (j.contains("history_dir")) cfg.history_dir = j.value("history_dir", cfg.history_dir);
+        if (j.contains("history_flush_messages")) cfg.history_flush_messages = j.value("history_flush_messages", cfg.history_flush_messages);
+        if (j.contains("history_max_segments")) cfg.history_max_segments = j.value("history_max_segments", cfg.history_max_segments);
+        if (j.contains("capture_path")) cfg.capture_path = j.value("capture_path", cfg.capture_path);
+        if (j.contains("trace_path")) cfg.trace_path = j.value("trace_path", cfg.trace_path);
+        if (j.contains("ping_interval_ms")) cfg.ping_interval_ms = j.value("ping_interval_ms", cfg.ping_interval_ms);
+        if (j.contains("idle_timeout_ms")) cfg.idle_timeout_ms = j.value("idle_timeout_ms", cfg.idle_timeout_ms);
+        if (j.contains("tcp_keepalive_idle_s")) cfg.tcp_keepalive_idle_s = j.value("tcp_keepalive_idle_s", cfg.tcp_keepalive_idle_s);
+        if (j.contains("tcp_keepalive_interval_s")) cfg.tcp_keepalive_interval_s = j.value("tcp_keepalive_interval_s", cfg.tcp_keepalive_interval_s);
+        if (j.contains("tcp_keepalive_count")) cfg.tcp_keepalive_count = j.value("tcp_keepalive_count", cfg.tcp_keepalive_count);
+        if (j.contains("lock_stripes")) cfg.lock_stripes = j.value("lock_stripes", cfg.lock_stripes);
     } catch (const std::exception& ex) {
         std::cerr << "Failed to parse config/server_config.json: " << ex.what() << "\n";
     }
@@ -30,8 +89,93 @@ ServerConfig load_config() {
 int main() {
     ServerConfig cfg = load_config();
 
+    std::string fallback_reason;
+    auto io_backend = IoBackend::create(cfg.io_backend, fallback_reason);
+    if (!fallback_reason.empty()) {
+        std::cerr << "Falling back to " << io_backend->name() << " I/O: " << fallback_reason << "\n";
+    }
+    io_backend->set_zerocopy_threshold(cfg.zerocopy_threshold);
+
+    std::shared_ptr<IAuthService> auth_service;
+    std::unique_ptr<AuthServer> embedded_auth_server;
+    if (cfg.auth_mode == "embedded") {
+        // Tokens are checked in-process; clients still log in over auth_port
+        std::shared_ptr<SessionStore> session_store;
+        if (!cfg.session_path.empty()) {
+            session_store = std::make_shared<SessionStore>(cfg.session_path);
+        }
+        auto auth_manager = std::make_shared<AuthManager>(
+            std::make_shared<FileUserRepository>(cfg.user_db_path), session_store);
+        auth_service = std::make_shared<EmbeddedAuthService>(auth_manager);
+        embedded_auth_server = std::make_unique<AuthServer>(auth_manager, cfg.auth_port);
+        embedded_auth_server->start();
+        if (!embedded_auth_server->is_running()) {
+            std::cerr << "Embedded auth failed to listen on port " << cfg.auth_port << "\n";
+            return 1;
+        }
+    } else {
+        AuthEndpoint auth_endpoint;
+        auth_endpoint.host = cfg.auth_host;
+        auth_endpoint.port = cfg.auth_port;
+        auth_endpoint.unix_socket_path = cfg.auth_socket_path;
+        auth_endpoint.shm_name = cfg.auth_shm_name;
+        auth_service = std::make_shared<AuthClient>(auth_endpoint);
+    }
+
+    std::shared_ptr<BatchFlusher> batch_flusher;
+    if (cfg.batch_rate_threshold > 0) {
+        BatchConfig batch_config;
+        batch_config.rate_threshold = cfg.batch_rate_threshold;
+        batch_config.max_delay = std::chrono::milliseconds(cfg.batch_max_delay_ms);
+        batch_config.max_messages = std::max<size_t>(cfg.batch_max_messages, 1);
+        batch_flusher = std::make_shared<BatchFlusher>(batch_config);
+    }
+
+    std::shared_ptr<HistoryIndex> history_index;
+    if (!cfg.history_dir.empty()) {
+        HistoryIndexConfig history_config;
+        history_config.flush_messages = cfg.history_flush_messages;
+        history_config.max_segments = cfg.history_max_segments;
+        history_index = std::make_shared<HistoryIndex>(cfg.history_dir, history_config);
+        if (!history_index->open()) {
+            std::cerr << "History search disabled: could not open " << cfg.history_dir << "\n";
+            history_index.reset();
+        }
+    }
+
+    std::shared_ptr<TrafficCapture> capture;
+    if (!cfg.capture_path.empty()) {
+        capture = std::make_shared<TrafficCapture>(cfg.capture_path);
+        if (!capture->open()) {
+            return 1;
+        }
+        std::cout << "Capturing inbound traffic to " << cfg.capture_path << "\n";
+    }
+
+    std::shared_ptr<tracing::TraceLog> trace_log;
+    if (!cfg.trace_path.empty()) {
+        trace_log = std::make_shared<tracing::TraceLog>();
+        if (!trace_log->open(cfg.trace_path)) {
+            std::cerr << "Could not open trace log " << cfg.trace_path << "\n";
+            return 1;
+        }
+    }
+
+    std::shared_ptr<Heartbeat> heartbeat;
+    if (cfg.idle_timeout_ms > 0) {
+        HeartbeatConfig heartbeat_config;
+        heartbeat_config.ping_interval = std::chrono::milliseconds(cfg.ping_interval_ms);
+        heartbeat_config.idle_timeout = std::chrono::milliseconds(cfg.idle_timeout_ms);
+        heartbeat = std::make_shared<Heartbeat>(heartbeat_config);
+    }
+
     ServerSocket server_socket(cfg.port);
-    ClientManager client_manager(cfg.auth_host, cfg.auth_port);
+    server_socket.set_keepalive(cfg.tcp_keepalive_idle_s, cfg.tcp_keepalive_interval_s, cfg.tcp_keepalive_count);
+    ClientManager client_manager(auth_service, io_backend, batch_flusher, trace_log, cfg.lock_stripes);
+    client_manager.set_outbound_queue_limit(cfg.outbound_queue_limit);
+    client_manager.set_history_index(history_index);
+    client_manager.set_traffic_capture(capture);
+    client_manager.set_heartbeat(heartbeat);
     
     std::string error_msg;
     if (!server_socket.initialize(error_msg)) {
@@ -39,7 +183,57 @@ int main() {
         return 1;
     }
     
-    std::cout << "Server listening on port " << cfg.port << "...\n";
+    std::cout << "Server listening on port " << cfg.port << " (" << io_backend->name() << " I/O, "
+              << cfg.auth_mode << " auth, " << client_manager.stripe_count() << " lock stripes)...\n";
+    
+    if (cfg.stats_interval_seconds > 0) {
+        std::thread([&client_manager, io_backend, batch_flusher, heartbeat, interval = cfg.stats_interval_seconds]() {
+            while (true) {
+                std::this_thread::sleep_for(std::chrono::seconds(interval));
+                io_backend->reap_completions();
+                const auto& io = io_backend->stats();
+                const auto& zc = io_backend->zerocopy_stats();
+                std::cout << "[stats] io=" << io_backend->name()
+                          << " payloads=" << io.payloads
+                          << " bytes=" << io.bytes
+                          << " syscalls=" << io.syscalls
+                          << " zerocopy_bytes=" << zc.zerocopy_bytes
+                          << " zerocopy_copied_bytes=" << zc.copied_bytes
+                          << " zerocopy_fallback_bytes=" << zc.fallback_bytes
+                          << " zerocopy_pending=" << io_backend->zerocopy_pending();
+                if (batch_flusher) {
+                    const auto& batch = batch_flusher->stats();
+                    uint64_t batched = batch.batched_messages;
+                    std::cout << " immediate_messages=" << batch.immediate_messages
+                              << " batched_messages=" << batched
+                              << " batches=" << batch.batches
+                              << " batch_delay_avg_us=" << (batched ? batch.delay_us_total / batched : 0)
+                              << " batch_delay_max_us=" << batch.delay_us_max;
+                }
+                if (heartbeat) {
+                    const auto& beat = heartbeat->stats();
+                    std::cout << " watched_connections=" << heartbeat->watched()
+                              << " pings_sent=" << beat.pings_sent
+                              << " pings_skipped=" << beat.pings_skipped
+                              << " reaped_connections=" << beat.reaped_connections;
+                }
+                // Per stripe, comma separated, so an uneven spread shows up
+                std::string connections, rooms;
+                uint64_t token_hits = 0, token_misses = 0;
+                for (const auto& stripe : client_manager.stripe_stats()) {
+                    connections += (connections.empty() ? "" : ",") + std::to_string(stripe.connections);
+                    rooms += (rooms.empty() ? "" : ",") + std::to_string(stripe.rooms);
+                    token_hits += stripe.token_cache_hits;
+                    token_misses += stripe.token_cache_misses;
+                }
+                std::cout << " stripe_connections=" << connections
+                          << " stripe_rooms=" << rooms
+                          << " token_cache_hits=" << token_hits
+                          << " token_cache_misses=" << token_misses;
+                std::cout << "\n";
+            }
+        }).detach();
+    }
     
     // Accept connections and spawn threads to handle clients
     server_socket.accept_connections([&client_manager](int client_fd, const std::string& client_ip) {
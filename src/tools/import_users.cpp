@@ -0,0 +1,59 @@
+#include "auth/FileUserRepository.h"
+#include "auth/UserImporter.h"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+static void usage(const char* program) {
+    std::cerr << "Usage: " << program << " <users.csv|users.json> [--db users.json] [--threads N] [--replace]\n"
+              << "  --db       user database to import into (default users.json)\n"
+              << "  --threads  parser threads (default: all cores)\n"
+              << "  --replace  overwrite users that already exist (default: keep them)\n";
+}
+
+int main(int argc, char* argv[]) {
+    std::string input;
+    std::string db_path = "users.json";
+    unsigned threads = 0;
+    bool replace_existing = false;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--db") == 0 && i + 1 < argc) {
+            db_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--replace") == 0) {
+            replace_existing = true;
+        } else if (argv[i][0] != '-' && input.empty()) {
+            input = argv[i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (input.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    FileUserRepository repository(db_path);
+    UserImporter importer(threads);
+    ImportReport report = importer.import_file(input, repository, replace_existing);
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+
+    for (const auto& error : report.errors) {
+        std::cerr << input << ": " << error << "\n";
+    }
+
+    std::cout << "Read " << report.records << " records in " << elapsed.count() << " ms: "
+              << report.imported << " imported, "
+              << report.replaced << " replaced, "
+              << report.existing << " already present, "
+              << report.duplicates << " duplicates, "
+              << report.invalid << " invalid\n";
+
+    return report.records == 0 && !report.errors.empty() ? 1 : 0;
+}
@@ -0,0 +1,369 @@
+#include "TrafficCapture.h"
+#include "auth/AuthClient.h"
+#include "common/NetworkMessage.h"
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct Options {
+    std::string capture_path;
+    std::string host = "127.0.0.1";
+    int port = 3000;
+    int auth_port = 3001;
+    double speed = 1.0;  // 0 = as fast as possible
+    std::string password = "replay";
+    bool register_users = false;
+    int drain_ms = 2000;
+};
+
+void usage(const char* program) {
+    std::cerr << "Usage: " << program << " <capture.jsonl> [--host H] [--port N] [--auth-port N]\n"
+              << "       [--speed X|max] [--password PW] [--register] [--drain-ms N]\n"
+              << "  --speed     1 replays at captured pace, 4 four times faster, max without waits\n"
+              << "  --password  password of every captured user (default: replay)\n"
+              << "  --register  create the captured users on the auth server first\n"
+              << "  --drain-ms  how long to wait for replies after the last frame (default 2000)\n";
+}
+
+// Requests with a direct reply, and the reply that answers them
+const std::map<std::string, std::string>& reply_types() {
+    static const std::map<std::string, std::string> replies = {
+        {"CREATE_ROOM", "ROOM_JOINED"},
+        {"JOIN_ROOM", "ROOM_JOINED"},
+        {"LEAVE", "LEFT_ROOM"},
+        {"SUBSCRIBE", "SUBSCRIBED"},
+        {"UNSUBSCRIBE", "UNSUBSCRIBED"},
+        {"REFRESH_ROOMS", "ROOM_LIST"},
+        {"LIST_ROOMS", "ROOM_PAGE"},
+        {"SEARCH_ROOMS", "SEARCH_RESULTS"},
+        {"SEARCH_HISTORY", "HISTORY_RESULTS"},
+    };
+    return replies;
+}
+
+double percentile(std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+int connect_to(const std::string& host, int port) {
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* result = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &result) != 0) {
+        return -1;
+    }
+    int fd = -1;
+    for (addrinfo* ai = result; ai; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) continue;
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) break;
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(result);
+    return fd;
+}
+
+bool send_all(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+/**
+ * Latency bookkeeping shared by the sender and every reader.
+ * Requests wait per connection for their reply type; chat lines wait
+ * (by sender and text) for the first other member to receive them.
+ */
+class Recorder {
+public:
+    void request_sent(uint64_t conn, const std::string& type, Clock::time_point at) {
+        auto reply = reply_types().find(type);
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++sent_;
+        if (reply != reply_types().end()) {
+            pending_[conn].push_back(Pending{type, reply->second, at});
+        }
+    }
+
+    void chat_sent(const std::string& sender, const std::string& message, Clock::time_point at) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        chats_[sender + '\x1f' + message].push_back(at);
+    }
+
+    void received(uint64_t conn, const NetworkMessage& msg, Clock::time_point at) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++received_;
+        const std::string& type = msg.body.type;
+        auto id = proto::id_of(type);
+        if (id == proto::MessageId::Message) {
+            auto line = proto::Message::from_json(msg.body.data);
+            auto it = chats_.find(line.sender + '\x1f' + line.message);
+            if (it != chats_.end()) {
+                record_locked("CHAT_MESSAGE", at - it->second.front());
+                it->second.pop_front();
+                if (it->second.empty()) chats_.erase(it);
+            }
+            return;
+        }
+        if (id == proto::MessageId::MessageBatch) {
+            for (const auto& entry : proto::MessageBatch::from_json(msg.body.data).messages) {
+                auto it = chats_.find(entry.sender + '\x1f' + entry.message);
+                if (it != chats_.end()) {
+                    record_locked("CHAT_MESSAGE", at - it->second.front());
+                    it->second.pop_front();
+                    if (it->second.empty()) chats_.erase(it);
+                }
+            }
+            return;
+        }
+
+        auto& waiting = pending_[conn];
+        if (type == "ERROR") {
+            ++errors_;
+            // An error answers the oldest outstanding request, if any
+            if (!waiting.empty()) waiting.pop_front();
+            return;
+        }
+        auto match = std::find_if(waiting.begin(), waiting.end(),
+            [&](const Pending& pending) { return pending.reply == type; });
+        if (match != waiting.end()) {
+            record_locked(match->request, at - match->sent_at);
+            waiting.erase(match);
+        }
+    }
+
+    void report(double elapsed_s, double max_lag_ms, size_t connections) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t unanswered = 0;
+        for (const auto& [conn, waiting] : pending_) unanswered += waiting.size();
+        size_t undelivered = 0;
+        for (const auto& [key, times] : chats_) undelivered += times.size();
+
+        std::printf("Replayed %llu frames on %zu connections in %.3f s (max send lag %.1f ms)\n",
+                    static_cast<unsigned long long>(sent_), connections, elapsed_s, max_lag_ms);
+        std::printf("Sent %.1f frames/s, received %llu frames, %llu errors\n",
+                    sent_ / std::max(elapsed_s, 1e-9), static_cast<unsigned long long>(received_),
+                    static_cast<unsigned long long>(errors_));
+        std::printf("%-16s %8s %9s %9s %9s %9s\n", "latency (ms)", "count", "p50", "p95", "p99", "max");
+        for (auto& [type, samples] : latencies_) {
+            std::sort(samples.begin(), samples.end());
+            std::printf("%-16s %8zu %9.3f %9.3f %9.3f %9.3f\n", type.c_str(), samples.size(),
+                        percentile(samples, 0.50), percentile(samples, 0.95),
+                        percentile(samples, 0.99), samples.back());
+        }
+        if (unanswered || undelivered) {
+            std::printf("Unanswered requests: %zu, chat lines no one received: %zu\n", unanswered, undelivered);
+        }
+    }
+
+private:
+    struct Pending {
+        std::string request;
+        std::string reply;
+        Clock::time_point sent_at;
+    };
+
+    void record_locked(const std::string& type, Clock::duration latency) {
+        latencies_[type].push_back(std::chrono::duration<double, std::milli>(latency).count());
+    }
+
+    std::mutex mutex_;
+    std::unordered_map<uint64_t, std::deque<Pending>> pending_;
+    std::unordered_map<std::string, std::deque<Clock::time_point>> chats_;
+    std::map<std::string, std::vector<double>> latencies_;
+    uint64_t sent_ = 0;
+    uint64_t received_ = 0;
+    uint64_t errors_ = 0;
+};
+
+// One replayed client: its socket, live token and reader thread
+struct Connection {
+    uint64_t id = 0;
+    int fd = -1;
+    std::string token;
+    std::string display_name;
+    std::thread reader;
+};
+
+void read_frames(Connection& conn, Recorder& recorder, const std::atomic<bool>& stop) {
+    std::string buffer;
+    char chunk[8192];
+    while (!stop.load(std::memory_order_relaxed)) {
+        pollfd pfd{conn.fd, POLLIN, 0};
+        int ready = poll(&pfd, 1, 100);
+        if (ready <= 0) continue;
+        ssize_t n = recv(conn.fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) return;
+        auto now = Clock::now();
+        buffer.append(chunk, static_cast<size_t>(n));
+
+        size_t start = 0;
+        for (size_t end; (end = buffer.find('\n', start)) != std::string::npos; start = end + 1) {
+            if (buffer[start] != '{') continue;  // plain-text history markers
+            recorder.received(conn.id, NetworkMessage::deserialize(buffer.substr(start, end - start)), now);
+        }
+        buffer.erase(0, start);
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--host" && has_value) {
+            options.host = argv[++i];
+        } else if (arg == "--port" && has_value) {
+            options.port = std::atoi(argv[++i]);
+        } else if (arg == "--auth-port" && has_value) {
+            options.auth_port = std::atoi(argv[++i]);
+        } else if (arg == "--speed" && has_value) {
+            std::string speed = argv[++i];
+            options.speed = speed == "max" ? 0.0 : std::atof(speed.c_str());
+            if (speed != "max" && options.speed <= 0.0) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--password" && has_value) {
+            options.password = argv[++i];
+        } else if (arg == "--register") {
+            options.register_users = true;
+        } else if (arg == "--drain-ms" && has_value) {
+            options.drain_ms = std::atoi(argv[++i]);
+        } else if (arg[0] != '-' && options.capture_path.empty()) {
+            options.capture_path = arg;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (options.capture_path.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<CapturedEvent> events;
+    std::string error;
+    if (!TrafficCapture::load(options.capture_path, events, error)) {
+        std::cerr << options.capture_path << ": " << error << "\n";
+        return 1;
+    }
+
+    // Every captured user logs in once; connections of the same user share the token
+    AuthEndpoint endpoint;
+    endpoint.host = options.host;
+    endpoint.port = options.auth_port;
+    AuthClient auth(endpoint);
+    std::map<std::string, AuthResult> logins;
+    for (const auto& event : events) {
+        if (event.kind != CapturedEvent::Kind::OPEN || logins.count(event.user)) continue;
+        if (options.register_users) {
+            auth.register_user(event.user, options.password, event.user);  // may already exist
+        }
+        AuthResult result = auth.authenticate(event.user, options.password);
+        if (!result.success) {
+            std::cerr << "Login failed for " << event.user << ": " << result.error_message << "\n";
+            return 1;
+        }
+        logins[event.user] = result;
+    }
+
+    Recorder recorder;
+    std::atomic<bool> stop{false};
+    std::map<uint64_t, std::unique_ptr<Connection>> connections;
+    std::set<uint64_t> closed;
+    double max_lag_ms = 0.0;
+
+    auto start = Clock::now();
+    for (const auto& event : events) {
+        if (options.speed > 0.0) {
+            auto due = start + std::chrono::nanoseconds(static_cast<int64_t>(event.time_ns / options.speed));
+            std::this_thread::sleep_until(due);
+            max_lag_ms = std::max(max_lag_ms, std::chrono::duration<double, std::milli>(Clock::now() - due).count());
+        }
+
+        if (event.kind == CapturedEvent::Kind::OPEN) {
+            auto conn = std::make_unique<Connection>();
+            conn->id = event.conn;
+            conn->token = logins[event.user].token;
+            conn->display_name = logins[event.user].display_name;
+            conn->fd = connect_to(options.host, options.port);
+            if (conn->fd < 0) {
+                std::cerr << "Could not connect to " << options.host << ":" << options.port << "\n";
+                stop = true;
+                break;
+            }
+            NetworkMessage auth_msg = NetworkMessage::create_auth(conn->token, false);
+            auth_msg.body.data = event.data;
+            send_all(conn->fd, auth_msg.serialize());
+            conn->reader = std::thread(read_frames, std::ref(*conn), std::ref(recorder), std::cref(stop));
+            connections[event.conn] = std::move(conn);
+            continue;
+        }
+
+        auto it = connections.find(event.conn);
+        if (it == connections.end() || closed.count(event.conn)) {
+            continue;  // opened before the capture started
+        }
+        Connection& conn = *it->second;
+        if (event.kind == CapturedEvent::Kind::CLOSE) {
+            shutdown(conn.fd, SHUT_WR);  // the server ends the session; the reader sees EOF
+            closed.insert(event.conn);
+            continue;
+        }
+
+        NetworkMessage msg;
+        msg.header.timestamp = NetworkMessage::get_timestamp();
+        msg.header.token = conn.token;
+        msg.body.type = event.type;
+        msg.body.data = event.data;
+        auto now = Clock::now();
+        recorder.request_sent(conn.id, event.type, now);
+        if (proto::id_of(event.type) == proto::MessageId::ChatMessage) {
+            recorder.chat_sent(conn.display_name, proto::ChatMessage::from_json(event.data).message, now);
+        }
+        send_all(conn.fd, msg.serialize());
+    }
+    double elapsed_s = std::chrono::duration<double>(Clock::now() - start).count();
+
+    // Let replies in flight arrive, then hang up whatever the capture left open
+    std::this_thread::sleep_for(std::chrono::milliseconds(options.drain_ms));
+    stop = true;
+    for (auto& [id, conn] : connections) {
+        if (conn->reader.joinable()) conn->reader.join();
+        close(conn->fd);
+    }
+
+    recorder.report(elapsed_s, max_lag_ms, connections.size());
+    return 0;
+}
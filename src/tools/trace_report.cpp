@@ -0,0 +1,215 @@
+#include "common/Trace.h"
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace {
+
+// Canonical order; a path skips stages its hops did not record
+const std::array<const char*, 9> STAGE_ORDER = {
+    tracing::CLIENT_INPUT, tracing::CLIENT_SEND, tracing::SERVER_RECV,
+    tracing::SERVER_VALIDATED, tracing::BROADCAST_ENQUEUE, tracing::SOCKET_WRITE,
+    tracing::CLIENT_RECV, tracing::CLIENT_PROCESS, tracing::RENDER,
+};
+
+constexpr size_t BUCKETS = 32;  // log2(µs), so the last bucket is over an hour
+constexpr int BAR_WIDTH = 40;
+
+using Stages = std::map<std::string, int64_t>;
+
+void usage(const char* program) {
+    std::cerr << "Usage: " << program << " <trace.jsonl>... [--no-histogram]\n"
+              << "  Joins server and client trace logs by id and prints per-stage latency.\n"
+              << "  Times are wall-clock, so only logs written on one host compare cleanly.\n";
+}
+
+Stages stages_of(const json& trace) {
+    Stages stages;
+    for (const auto& stage : trace["stages"]) {
+        if (stage.is_array() && stage.size() == 2 && stage[0].is_string() && stage[1].is_number_integer()) {
+            stages.emplace(stage[0].get<std::string>(), stage[1].get<int64_t>());
+        }
+    }
+    return stages;
+}
+
+bool load(const std::string& path, std::unordered_map<std::string, std::vector<Stages>>& by_id) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Error: Could not open " << path << "\n";
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        json trace = json::parse(line, nullptr, false);
+        if (trace.is_discarded() || !tracing::well_formed(trace)) {
+            continue;
+        }
+        by_id[trace["id"].get<std::string>()].push_back(stages_of(trace));
+    }
+    return true;
+}
+
+struct Series {
+    std::vector<int64_t> samples;
+    std::array<uint64_t, BUCKETS> buckets{};
+
+    void add(int64_t us) {
+        samples.push_back(us);
+        size_t bucket = 0;
+        while (bucket + 1 < BUCKETS && (int64_t{1} << (bucket + 1)) <= us) {
+            ++bucket;
+        }
+        ++buckets[bucket];
+    }
+};
+
+int64_t percentile(const std::vector<int64_t>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+void print_histogram(const Series& series) {
+    uint64_t peak = *std::max_element(series.buckets.begin(), series.buckets.end());
+    size_t first = 0;
+    size_t last = BUCKETS - 1;
+    while (series.buckets[first] == 0) ++first;
+    while (series.buckets[last] == 0) --last;
+    for (size_t i = first; i <= last; ++i) {
+        int width = static_cast<int>(series.buckets[i] * BAR_WIDTH / peak);
+        // Bucket i holds [2^i, 2^(i+1)) us; bucket 0 also takes 0
+        std::printf("  >=%10lld us  %-*s %llu\n", i == 0 ? 0LL : (1LL << i),
+                    BAR_WIDTH, std::string(static_cast<size_t>(width), '#').c_str(),
+                    static_cast<unsigned long long>(series.buckets[i]));
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> paths;
+    bool histograms = true;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--no-histogram") {
+            histograms = false;
+        } else if (!arg.empty() && arg[0] == '-') {
+            usage(argv[0]);
+            return 1;
+        } else {
+            paths.push_back(arg);
+        }
+    }
+    if (paths.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::unordered_map<std::string, std::vector<Stages>> by_id;
+    for (const auto& path : paths) {
+        if (!load(path, by_id)) {
+            return 1;
+        }
+    }
+
+    // One path per delivery: each receiving client's record, with the
+    // server's socket_write joined in. A trace nobody received (no client
+    // log given) still reports its server-side stages.
+    std::vector<Stages> paths_taken;
+    for (auto& [id, records] : by_id) {
+        const Stages* server = nullptr;
+        std::vector<Stages*> clients;
+        for (auto& record : records) {
+            if (record.count(tracing::SOCKET_WRITE)) {
+                server = &record;
+            } else if (record.count(tracing::CLIENT_RECV) || record.count(tracing::RENDER)) {
+                clients.push_back(&record);
+            }
+        }
+        if (clients.empty()) {
+            if (server) paths_taken.push_back(*server);
+            continue;
+        }
+        for (auto* client : clients) {
+            Stages merged = *client;
+            if (server) merged.insert(server->begin(), server->end());
+            paths_taken.push_back(std::move(merged));
+        }
+    }
+
+    std::map<std::pair<size_t, size_t>, Series> transitions;
+    Series end_to_end;
+    size_t skewed = 0;
+    for (const auto& stages : paths_taken) {
+        int64_t first_us = 0;
+        int64_t last_us = 0;
+        size_t previous = STAGE_ORDER.size();
+        for (size_t i = 0; i < STAGE_ORDER.size(); ++i) {
+            auto it = stages.find(STAGE_ORDER[i]);
+            if (it == stages.end()) {
+                continue;
+            }
+            if (previous == STAGE_ORDER.size()) {
+                first_us = it->second;
+            } else {
+                int64_t delta = it->second - last_us;
+                // Hops stamp from different clocks; a backwards step is skew, not latency
+                if (delta < 0) {
+                    ++skewed;
+                    delta = 0;
+                }
+                transitions[{previous, i}].add(delta);
+            }
+            previous = i;
+            last_us = std::max(last_us, it->second);
+        }
+        if (previous != STAGE_ORDER.size()) {
+            end_to_end.add(last_us - first_us);
+        }
+    }
+
+    std::printf("%zu traces, %zu delivery paths\n\n", by_id.size(), paths_taken.size());
+    if (paths_taken.empty()) {
+        return 0;
+    }
+
+    std::printf("%-40s %8s %10s %10s %10s %10s\n", "Stage (us)", "count", "p50", "p90", "p99", "max");
+    auto print_row = [](const std::string& name, Series& series) {
+        std::sort(series.samples.begin(), series.samples.end());
+        std::printf("%-40s %8zu %10lld %10lld %10lld %10lld\n", name.c_str(), series.samples.size(),
+                    static_cast<long long>(percentile(series.samples, 0.50)),
+                    static_cast<long long>(percentile(series.samples, 0.90)),
+                    static_cast<long long>(percentile(series.samples, 0.99)),
+                    static_cast<long long>(series.samples.back()));
+    };
+    for (auto& [key, series] : transitions) {
+        print_row(std::string(STAGE_ORDER[key.first]) + " -> " + STAGE_ORDER[key.second], series);
+    }
+    if (!end_to_end.samples.empty()) {
+        print_row("end to end", end_to_end);
+    }
+    if (skewed) {
+        std::printf("\n%zu negative steps clamped to 0 (clock skew between hosts?)\n", skewed);
+    }
+
+    if (histograms) {
+        for (const auto& [key, series] : transitions) {
+            std::printf("\n%s -> %s\n", STAGE_ORDER[key.first], STAGE_ORDER[key.second]);
+            print_histogram(series);
+        }
+        if (!end_to_end.samples.empty()) {
+            std::printf("\nend to end\n");
+            print_histogram(end_to_end);
+        }
+    }
+    return 0;
+}
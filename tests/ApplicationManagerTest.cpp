@@ -2,6 +2,11 @@
 #include "ApplicationManager.h"
 #include "ThreadSafeQueue.h"
 #include "UICommand.h"
+#include "ClientEvents.h"
+#include "common/NetworkMessage.h"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
 #include <thread>
 #include <chrono>
 
@@ -9,10 +14,10 @@ using namespace std::chrono_literals;
 
 class ApplicationManagerTest : public ::testing::Test {
 protected:
-    ThreadSafeQueue<std::string> network_inbound;
+    ThreadSafeQueue<ServerEvent> network_inbound;
     ThreadSafeQueue<std::string> network_outbound;
     ThreadSafeQueue<UICommand> ui_commands;
-    ThreadSafeQueue<std::string> input_events;
+    ThreadSafeQueue<InputEvent> input_events;
     
     std::unique_ptr<ApplicationManager> app_manager;
     
@@ -32,6 +37,26 @@ protected:
         app_manager->stop();
     }
     
+    // Deliver a server frame the way NetworkManager does: decoded
+    void push_frame(const NetworkMessage& msg) {
+        network_inbound.push(ServerEvent::decode(msg.serialize()));
+    }
+    
+    // Next frame the application sent to the server
+    bool pop_outbound(NetworkMessage& msg, std::chrono::milliseconds timeout = 500ms) {
+        std::string frame;
+        if (!network_outbound.try_pop(frame, timeout)) {
+            return false;
+        }
+        msg = NetworkMessage::deserialize(frame);
+        return true;
+    }
+    
+    void join_room(const std::string& room_name) {
+        push_frame(NetworkMessage::create_room_joined(room_name));
+        drain_ui_commands();
+    }
+    
     // Helper to get UI commands of a specific type
     std::vector<UICommand> drain_ui_commands(int timeout_ms = 100) {
         std::vector<UICommand> commands;
@@ -42,6 +67,15 @@ protected:
         }
         return commands;
     }
+    
+    static const UICommand* find_command(const std::vector<UICommand>& commands, UICommandType type) {
+        for (const auto& cmd : commands) {
+            if (cmd.type == type) {
+                return &cmd;
+            }
+        }
+        return nullptr;
+    }
 };
 
 TEST_F(ApplicationManagerTest, InitialState) {
@@ -54,86 +88,76 @@ TEST_F(ApplicationManagerTest, InitialState) {
 }
 
 TEST_F(ApplicationManagerTest, LoginFlow) {
-    // Simulate user login input
-    input_events.push("LOGIN:TestUser");
-    
-    // Should send username to network
-    std::string net_msg;
-    ASSERT_TRUE(network_outbound.try_pop(net_msg, 500ms));
-    EXPECT_EQ(net_msg, "TestUser\n");
+    // An auth port nobody listens on
+    int probe = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(bind(probe, (sockaddr*)&addr, sizeof(addr)), 0);
+    socklen_t len = sizeof(addr);
+    getsockname(probe, (sockaddr*)&addr, &len);
+    close(probe);
+    
+    app_manager->stop();
+    app_manager = std::make_unique<ApplicationManager>(
+        network_inbound, network_outbound, ui_commands, input_events, nullptr,
+        "127.0.0.1", ntohs(addr.sin_port));
+    app_manager->start();
+    
+    input_events.push(InputEvent(InputEventType::LOGIN, LoginData{"TestUser", "secret"}));
+    
+    auto commands = drain_ui_commands(1000);
+    const UICommand* status = find_command(commands, UICommandType::SHOW_STATUS);
+    ASSERT_NE(status, nullptr);
+    EXPECT_EQ(status->get<StatusData>().message, "Logging in...");
+    const UICommand* error = find_command(commands, UICommandType::SHOW_ERROR);
+    ASSERT_NE(error, nullptr);
+    EXPECT_EQ(error->get<ErrorData>().message.rfind("Login failed", 0), 0u);
     
-    // Check state updated
     const auto& state = app_manager->get_state();
-    EXPECT_TRUE(state.is_connected());
-    EXPECT_EQ(state.get_username(), "TestUser");
+    EXPECT_FALSE(state.is_connected());
+    EXPECT_EQ(state.get_screen(), ApplicationState::Screen::LOGIN);
 }
 
 TEST_F(ApplicationManagerTest, RoomListProcessing) {
     // Simulate server sending room list
-    std::string room_list = 
-        "ROOM_LIST\n"
-        "General|3\n"
-        "Gaming|5\n"
-        "END_ROOM_LIST\n";
-    
-    network_inbound.push(room_list);
+    push_frame(NetworkMessage::create_room_list({"General", "Gaming"}));
     
     // Should generate UI commands
     auto commands = drain_ui_commands();
     
-    ASSERT_GE(commands.size(), 2);
-    
-    // Should show foyer
-    bool has_show_foyer = false;
-    bool has_update_list = false;
-    
-    for (const auto& cmd : commands) {
-        if (cmd.type == UICommandType::SHOW_FOYER) {
-            has_show_foyer = true;
-        }
-        if (cmd.type == UICommandType::UPDATE_ROOM_LIST) {
-            has_update_list = true;
-            auto rooms = cmd.get<RoomListData>().rooms;
-            EXPECT_EQ(rooms.size(), 2);
-            EXPECT_EQ(rooms[0].name, "General");
-            EXPECT_EQ(rooms[0].client_count, 3);
-            EXPECT_EQ(rooms[1].name, "Gaming");
-            EXPECT_EQ(rooms[1].client_count, 5);
-        }
-    }
-    
-    EXPECT_TRUE(has_show_foyer);
-    EXPECT_TRUE(has_update_list);
+    EXPECT_NE(find_command(commands, UICommandType::SHOW_FOYER), nullptr);
+    const UICommand* update = find_command(commands, UICommandType::UPDATE_ROOM_LIST);
+    ASSERT_NE(update, nullptr);
+    const auto& rooms = update->get<RoomListData>().rooms;
+    ASSERT_EQ(rooms.size(), 2u);
+    EXPECT_EQ(rooms[0].name, "General");
+    EXPECT_EQ(rooms[1].name, "Gaming");
     
     // Check state
     const auto& state = app_manager->get_state();
     EXPECT_EQ(state.get_screen(), ApplicationState::Screen::FOYER);
-    EXPECT_EQ(state.get_rooms().size(), 2);
+    EXPECT_EQ(state.get_rooms().size(), 2u);
 }
 
 TEST_F(ApplicationManagerTest, JoinRoom) {
     // User selects a room
-    input_events.push("ROOM_SELECTED:General");
+    input_events.push(InputEvent(InputEventType::ROOM_SELECTED, std::string("General")));
     
-    // Should send JOIN_ROOM command
-    std::string net_msg;
-    ASSERT_TRUE(network_outbound.try_pop(net_msg, 500ms));
-    EXPECT_EQ(net_msg, "JOIN_ROOM:General\n");
+    // Should send JOIN_ROOM
+    NetworkMessage sent;
+    ASSERT_TRUE(pop_outbound(sent));
+    EXPECT_EQ(sent.body.type, "JOIN_ROOM");
+    EXPECT_EQ(sent.body.data.value("room_name", ""), "General");
     
     // Simulate server response
-    network_inbound.push("JOINED_ROOM:General\n");
+    push_frame(NetworkMessage::create_room_joined("General"));
     
     // Should generate UI command to show chatroom
     auto commands = drain_ui_commands();
-    
-    bool has_show_chatroom = false;
-    for (const auto& cmd : commands) {
-        if (cmd.type == UICommandType::SHOW_CHATROOM) {
-            has_show_chatroom = true;
-        }
-    }
-    
-    EXPECT_TRUE(has_show_chatroom);
+    const UICommand* show = find_command(commands, UICommandType::SHOW_CHATROOM);
+    ASSERT_NE(show, nullptr);
+    EXPECT_EQ(show->get<std::string>(), "General");
     
     // Check state
     const auto& state = app_manager->get_state();
@@ -142,77 +166,69 @@ TEST_F(ApplicationManagerTest, JoinRoom) {
 }
 
 TEST_F(ApplicationManagerTest, ChatMessages) {
-    // First join a room
-    network_inbound.push("JOINED_ROOM:Test\n");
-    std::this_thread::sleep_for(50ms);
-    drain_ui_commands();  // Clear join commands
+    join_room("Test");
     
     // Receive chat message
-    network_inbound.push("CHAT:Alice: Hello everyone!\n");
+    push_frame(NetworkMessage::create_broadcast_message("Alice", "Hello everyone!"));
     
-    // Should generate ADD_CHAT_MESSAGE command
     auto commands = drain_ui_commands();
-    
-    bool has_chat_msg = false;
-    for (const auto& cmd : commands) {
-        if (cmd.type == UICommandType::ADD_CHAT_MESSAGE) {
-            has_chat_msg = true;
-            auto msg = cmd.get<ChatMessageData>().message;
-            EXPECT_EQ(msg, "Alice: Hello everyone!");
-        }
-    }
-    
-    EXPECT_TRUE(has_chat_msg);
+    const UICommand* lines = find_command(commands, UICommandType::ADD_CHAT_MESSAGES);
+    ASSERT_NE(lines, nullptr);
+    ASSERT_EQ(lines->get<ChatMessagesData>().messages.size(), 1u);
+    EXPECT_EQ(lines->get<ChatMessagesData>().messages[0], "[Alice] Hello everyone!");
     
     // Check state
     const auto& state = app_manager->get_state();
     auto messages = state.get_chat_messages();
-    ASSERT_EQ(messages.size(), 1);
-    EXPECT_EQ(messages[0], "Alice: Hello everyone!");
+    ASSERT_EQ(messages.size(), 1u);
+    EXPECT_EQ(messages[0], "[Alice] Hello everyone!");
 }
 
 TEST_F(ApplicationManagerTest, SendChatMessage) {
-    // Join room first
-    network_inbound.push("JOINED_ROOM:Test\n");
-    std::this_thread::sleep_for(50ms);
+    join_room("Test");
     
     // User sends chat message
-    input_events.push("CHAT_MESSAGE:Hello, world!");
+    input_events.push(InputEvent(InputEventType::CHAT_MESSAGE, ChatInputData{"Hello, world!"}));
     
     // Should send to network
-    std::string net_msg;
-    ASSERT_TRUE(network_outbound.try_pop(net_msg, 500ms));
-    EXPECT_EQ(net_msg, "Hello, world!\n");
+    NetworkMessage sent;
+    ASSERT_TRUE(pop_outbound(sent));
+    EXPECT_EQ(sent.body.type, "CHAT_MESSAGE");
+    EXPECT_EQ(sent.body.data.value("message", ""), "Hello, world!");
+    EXPECT_TRUE(sent.header.trace.is_null());
+    
+    // And shows it locally, since the server does not echo it back
+    auto commands = drain_ui_commands();
+    const UICommand* lines = find_command(commands, UICommandType::ADD_CHAT_MESSAGES);
+    ASSERT_NE(lines, nullptr);
+    EXPECT_EQ(lines->get<ChatMessagesData>().messages[0], "[You] Hello, world!");
 }
 
 TEST_F(ApplicationManagerTest, LeaveRoom) {
-    // Join room first
-    network_inbound.push("JOINED_ROOM:Test\n");
-    std::this_thread::sleep_for(50ms);
-    drain_ui_commands();
+    join_room("Test");
     
     // User leaves room
-    input_events.push("LEAVE");
+    input_events.push(InputEvent(InputEventType::LEAVE));
     
-    // Should send /leave
-    std::string net_msg;
-    ASSERT_TRUE(network_outbound.try_pop(net_msg, 500ms));
-    EXPECT_EQ(net_msg, "/leave\n");
+    NetworkMessage sent;
+    ASSERT_TRUE(pop_outbound(sent));
+    EXPECT_EQ(sent.body.type, "LEAVE");
     
-    // Simulate server response
-    network_inbound.push("LEFT_ROOM\nROOM_LIST\nGeneral|2\nEND_ROOM_LIST\n");
+    // Simulate server response: LEFT_ROOM, then the page the client asks for
+    NetworkMessage left;
+    left.body.type = "LEFT_ROOM";
+    push_frame(left);
+    ASSERT_TRUE(pop_outbound(sent));
+    EXPECT_EQ(sent.body.type, "LIST_ROOMS");
+    push_frame(NetworkMessage::create_room_page("", "name", "", {{"General", 2}}, "", 1));
     
     // Should show foyer
     auto commands = drain_ui_commands();
-    
-    bool has_show_foyer = false;
-    for (const auto& cmd : commands) {
-        if (cmd.type == UICommandType::SHOW_FOYER) {
-            has_show_foyer = true;
-        }
-    }
-    
-    EXPECT_TRUE(has_show_foyer);
+    EXPECT_NE(find_command(commands, UICommandType::SHOW_FOYER), nullptr);
+    const UICommand* page = find_command(commands, UICommandType::UPDATE_ROOM_PAGE);
+    ASSERT_NE(page, nullptr);
+    ASSERT_EQ(page->get<RoomPageData>().rooms.size(), 1u);
+    EXPECT_EQ(page->get<RoomPageData>().rooms[0].client_count, 2);
     
     // Check state
     const auto& state = app_manager->get_state();
@@ -222,59 +238,53 @@ TEST_F(ApplicationManagerTest, LeaveRoom) {
 
 TEST_F(ApplicationManagerTest, CreateRoom) {
     // User creates room
-    input_events.push("CREATE_ROOM:MyRoom");
+    input_events.push(InputEvent(InputEventType::CREATE_ROOM, std::string("MyRoom")));
     
-    // Should send CREATE_ROOM command
-    std::string net_msg;
-    ASSERT_TRUE(network_outbound.try_pop(net_msg, 500ms));
-    EXPECT_EQ(net_msg, "CREATE_ROOM:MyRoom\n");
+    NetworkMessage sent;
+    ASSERT_TRUE(pop_outbound(sent));
+    EXPECT_EQ(sent.body.type, "CREATE_ROOM");
+    EXPECT_EQ(sent.body.data.value("room_name", ""), "MyRoom");
 }
 
 TEST_F(ApplicationManagerTest, ErrorHandling) {
     // Simulate room exists error
-    network_inbound.push("ROOM_EXISTS\n");
+    push_frame(NetworkMessage::create_error("Room already exists"));
     
-    // Should generate error command
     auto commands = drain_ui_commands();
-    
-    bool has_error = false;
-    for (const auto& cmd : commands) {
-        if (cmd.type == UICommandType::SHOW_ERROR) {
-            has_error = true;
-            auto error = cmd.get<ErrorData>().message;
-            EXPECT_EQ(error, "Room already exists");
-        }
-    }
-    
-    EXPECT_TRUE(has_error);
+    const UICommand* error = find_command(commands, UICommandType::SHOW_ERROR);
+    ASSERT_NE(error, nullptr);
+    EXPECT_EQ(error->get<ErrorData>().message, "Room already exists");
+}
+
+TEST_F(ApplicationManagerTest, SearchHistoryShowsResultsAsChatLines) {
+    join_room("General");
+    
+    input_events.push(InputEvent(InputEventType::SEARCH_HISTORY, std::string("deploy friday")));
+    NetworkMessage sent;
+    ASSERT_TRUE(pop_outbound(sent));
+    EXPECT_EQ(sent.body.type, "SEARCH_HISTORY");
+    EXPECT_EQ(sent.body.data.value("room_name", ""), "General");
+    EXPECT_EQ(sent.body.data.value("query", ""), "deploy friday");
+    
+    push_frame(NetworkMessage::create_history_results("General", "deploy friday",
+        {proto::HistoryItem{.seq = 7, .sender = "bob", .message = "no deploy on friday"}}));
+    auto commands = drain_ui_commands();
+    const UICommand* lines = find_command(commands, UICommandType::ADD_CHAT_MESSAGES);
+    ASSERT_NE(lines, nullptr);
+    const auto& messages = lines->get<ChatMessagesData>().messages;
+    ASSERT_EQ(messages.size(), 2u);
+    EXPECT_EQ(messages[0], "=== Search: deploy friday (1 found) ===");
+    EXPECT_EQ(messages[1], "#7 [bob] no deploy on friday");
 }
 
 TEST_F(ApplicationManagerTest, ConnectionLost) {
-    // Set up as connected
-    input_events.push("LOGIN:TestUser");
-    std::this_thread::sleep_for(50ms);
-    drain_ui_commands();
-    
     // Simulate connection lost
-    network_inbound.push("SERVER_DISCONNECTED\n");
+    network_inbound.push(ServerEvent(ServerEventType::DISCONNECTED));
     
     // Should show login screen and error
     auto commands = drain_ui_commands();
-    
-    bool has_show_login = false;
-    bool has_error = false;
-    
-    for (const auto& cmd : commands) {
-        if (cmd.type == UICommandType::SHOW_LOGIN) {
-            has_show_login = true;
-        }
-        if (cmd.type == UICommandType::SHOW_ERROR) {
-            has_error = true;
-        }
-    }
-    
-    EXPECT_TRUE(has_show_login);
-    EXPECT_TRUE(has_error);
+    EXPECT_NE(find_command(commands, UICommandType::SHOW_LOGIN), nullptr);
+    EXPECT_NE(find_command(commands, UICommandType::SHOW_ERROR), nullptr);
     
     // Check state
     const auto& state = app_manager->get_state();
@@ -283,18 +293,8 @@ TEST_F(ApplicationManagerTest, ConnectionLost) {
 }
 
 TEST_F(ApplicationManagerTest, Logout) {
-    // Set up as connected
-    input_events.push("LOGIN:TestUser");
-    std::this_thread::sleep_for(50ms);
-    
-    // Drain login network message
-    std::string dummy;
-    network_outbound.try_pop(dummy, 100ms);
-    
-    drain_ui_commands();
-    
     // User logs out
-    input_events.push("LOGOUT");
+    input_events.push(InputEvent(InputEventType::LOGOUT));
     
     // Should send /logout
     std::string net_msg;
@@ -303,13 +303,7 @@ TEST_F(ApplicationManagerTest, Logout) {
     
     // Should show login
     auto commands = drain_ui_commands();
-    bool has_show_login = false;
-    for (const auto& cmd : commands) {
-        if (cmd.type == UICommandType::SHOW_LOGIN) {
-            has_show_login = true;
-        }
-    }
-    EXPECT_TRUE(has_show_login);
+    EXPECT_NE(find_command(commands, UICommandType::SHOW_LOGIN), nullptr);
     
     // Check state reset
     const auto& state = app_manager->get_state();
@@ -318,21 +312,119 @@ TEST_F(ApplicationManagerTest, Logout) {
 }
 
 TEST_F(ApplicationManagerTest, QuitCommand) {
-    input_events.push("QUIT");
+    input_events.push(InputEvent(InputEventType::QUIT));
     
     // Should generate QUIT UI command
     auto commands = drain_ui_commands();
+    EXPECT_NE(find_command(commands, UICommandType::QUIT), nullptr);
+    
+    // Application should stop
+    std::this_thread::sleep_for(100ms);
+    EXPECT_FALSE(app_manager->is_running());
+}
+
+TEST_F(ApplicationManagerTest, PingIsAnsweredWithPong) {
+    push_frame(NetworkMessage::create_ping());
+
+    NetworkMessage sent;
+    ASSERT_TRUE(pop_outbound(sent));
+    EXPECT_EQ(sent.body.type, "PONG");
+    EXPECT_TRUE(drain_ui_commands().empty());
+}
+
+TEST_F(ApplicationManagerTest, BurstOfMessagesArrivesAsFewBatches) {
+    for (int i = 0; i < 200; ++i) {
+        push_frame(NetworkMessage::create_broadcast_message("alice", "line " + std::to_string(i)));
+    }
+    
+    std::this_thread::sleep_for(300ms);
+    auto commands = drain_ui_commands();
+    
+    std::vector<std::string> lines;
+    for (const auto& cmd : commands) {
+        ASSERT_EQ(cmd.type, UICommandType::ADD_CHAT_MESSAGES);
+        const auto& batch = cmd.get<ChatMessagesData>().messages;
+        lines.insert(lines.end(), batch.begin(), batch.end());
+    }
+    EXPECT_LE(commands.size(), 3u);
+    ASSERT_EQ(lines.size(), 200u);
+    EXPECT_EQ(lines.front(), "[alice] line 0");
+    EXPECT_EQ(lines.back(), "[alice] line 199");
+}
+
+TEST_F(ApplicationManagerTest, OnlyLatestParticipantListIsSent) {
+    // Enter a room first so the next burst is not preceded by screen changes
+    push_frame(NetworkMessage::create_room_joined("General"));
+    drain_ui_commands(200);
+    
+    for (int i = 1; i <= 5; ++i) {
+        std::vector<std::string> participants;
+        for (int p = 0; p < i; ++p) {
+            participants.push_back("user" + std::to_string(p));
+        }
+        push_frame(NetworkMessage::create_participant_list(participants, "General"));
+    }
+    
+    std::this_thread::sleep_for(200ms);
+    auto commands = drain_ui_commands();
     
-    bool has_quit = false;
+    size_t updates = 0;
+    std::vector<std::string> last;
     for (const auto& cmd : commands) {
-        if (cmd.type == UICommandType::QUIT) {
-            has_quit = true;
+        if (cmd.type == UICommandType::UPDATE_PARTICIPANTS) {
+            ++updates;
+            last = cmd.get<ParticipantsData>().participants;
         }
     }
+    EXPECT_LE(updates, 2u);
+    EXPECT_EQ(last.size(), 5u);
+}
+
+TEST_F(ApplicationManagerTest, LoginDoesNotBlockTheApplicationThread) {
+    // Auth server that takes 300ms to answer
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(bind(listener, (sockaddr*)&addr, sizeof(addr)), 0);
+    ASSERT_EQ(listen(listener, 1), 0);
+    socklen_t len = sizeof(addr);
+    getsockname(listener, (sockaddr*)&addr, &len);
+    
+    std::thread slow_auth([listener]() {
+        int conn = accept(listener, nullptr, nullptr);
+        char buffer[256];
+        recv(conn, buffer, sizeof(buffer), 0);
+        std::this_thread::sleep_for(300ms);
+        std::string reply = "OK tok123 Test User\n";
+        send(conn, reply.data(), reply.size(), 0);
+        close(conn);
+    });
+    
+    app_manager->stop();
+    app_manager = std::make_unique<ApplicationManager>(
+        network_inbound, network_outbound, ui_commands, input_events, nullptr,
+        "127.0.0.1", ntohs(addr.sin_port));
+    app_manager->start();
+    
+    input_events.push(InputEvent(InputEventType::LOGIN, LoginData{"test", "secret"}));
+    std::this_thread::sleep_for(50ms);
     
-    EXPECT_TRUE(has_quit);
+    // Network frames are still handled while authentication is pending
+    push_frame(NetworkMessage::create_broadcast_message("alice", "hi"));
+    bool saw_message = false;
+    UICommand cmd(UICommandType::QUIT);
+    auto deadline = std::chrono::steady_clock::now() + 200ms;
+    while (!saw_message && ui_commands.try_pop(cmd, 50ms)) {
+        saw_message = cmd.type == UICommandType::ADD_CHAT_MESSAGES;
+    }
+    EXPECT_TRUE(saw_message);
+    EXPECT_LT(std::chrono::steady_clock::now(), deadline);
+    EXPECT_FALSE(app_manager->get_state().is_connected());
     
-    // Application should stop
+    slow_auth.join();
+    close(listener);
     std::this_thread::sleep_for(100ms);
-    EXPECT_FALSE(app_manager->is_running());
+    EXPECT_TRUE(app_manager->get_state().is_connected());
+    EXPECT_EQ(app_manager->get_state().get_username(), "Test User");
 }
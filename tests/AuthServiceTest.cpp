@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+#include "auth/AuthClient.h"
+#include "auth/AuthServer.h"
+#include "auth/EmbeddedAuthService.h"
+#include "auth/InMemoryUserRepository.h"
+#include <unistd.h>
+#include <memory>
+#include <string>
+
+class EmbeddedAuthServiceTest : public ::testing::Test {
+protected:
+    std::shared_ptr<AuthManager> auth_manager;
+    std::unique_ptr<IAuthService> service;
+
+    void SetUp() override {
+        auth_manager = std::make_shared<AuthManager>(std::make_shared<InMemoryUserRepository>());
+        service = std::make_unique<EmbeddedAuthService>(auth_manager);
+        ASSERT_TRUE(service->register_user("bob", "pw", "Bob B"));
+    }
+};
+
+TEST_F(EmbeddedAuthServiceTest, AuthenticateAndLookUp) {
+    AuthResult result = service->authenticate("bob", "pw");
+    ASSERT_TRUE(result.success);
+    EXPECT_EQ(result.display_name, "Bob B");
+
+    EXPECT_TRUE(service->validate_token(result.token));
+    auto info = service->get_user_info(result.token);
+    ASSERT_TRUE(info.has_value());
+    EXPECT_EQ(info->username, "bob");
+    EXPECT_EQ(info->display_name, "Bob B");
+}
+
+TEST_F(EmbeddedAuthServiceTest, RejectsBadCredentialsAndRevokedTokens) {
+    EXPECT_FALSE(service->authenticate("bob", "wrong").success);
+    EXPECT_FALSE(service->register_user("bob", "pw", "Bob Again"));
+
+    AuthResult result = service->authenticate("bob", "pw");
+    ASSERT_TRUE(result.success);
+    EXPECT_TRUE(service->revoke_token(result.token));
+    EXPECT_FALSE(service->validate_token(result.token));
+    EXPECT_FALSE(service->get_user_info(result.token).has_value());
+}
+
+TEST_F(EmbeddedAuthServiceTest, SharedManagerServesNetworkLogins) {
+    // Embedded mode: clients log in over TCP, the chat server checks in-process
+    std::string socket_path = "/tmp/booking_embedded_" + std::to_string(getpid()) + ".sock";
+    AuthServer server(auth_manager, 0, socket_path);
+    server.start();
+    ASSERT_TRUE(server.is_running());
+
+    AuthEndpoint endpoint;
+    endpoint.unix_socket_path = socket_path;
+    AuthClient remote(endpoint);
+    AuthResult result = remote.authenticate("bob", "pw");
+    ASSERT_TRUE(result.success);
+
+    EXPECT_TRUE(service->validate_token(result.token));
+    server.stop();
+}
@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+#include "auth/AuthServer.h"
+#include "auth/AuthClient.h"
+#include "auth/SharedAuthRing.h"
+#include <unistd.h>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(SharedAuthRingTest, CallReturnsHandlerResponse) {
+    std::string name = "/booking_auth_test_" + std::to_string(getpid());
+    auto server_ring = SharedAuthRing::create(name);
+    ASSERT_NE(server_ring, nullptr);
+
+    std::atomic<bool> running{true};
+    std::thread server([&]() {
+        while (running) {
+            server_ring->serve_once([](const std::string& command) {
+                return "ECHO " + command + "\n";
+            }, 10);
+        }
+    });
+
+    auto client_ring = SharedAuthRing::attach(name);
+    ASSERT_NE(client_ring, nullptr);
+
+    std::vector<std::thread> clients;
+    std::atomic<int> matched{0};
+    for (int t = 0; t < 4; ++t) {
+        clients.emplace_back([&, t]() {
+            for (int i = 0; i < 100; ++i) {
+                std::string command = "VALIDATE token" + std::to_string(t * 1000 + i);
+                auto response = client_ring->call(command);
+                if (response && *response == "ECHO " + command) {
+                    ++matched;
+                }
+            }
+        });
+    }
+    for (auto& client : clients) {
+        client.join();
+    }
+
+    running = false;
+    server_ring->wake_server();
+    server.join();
+
+    EXPECT_EQ(matched, 400);
+}
+
+TEST(SharedAuthRingTest, CallFailsWithoutServer) {
+    std::string name = "/booking_auth_idle_" + std::to_string(getpid());
+    auto server_ring = SharedAuthRing::create(name);
+    ASSERT_NE(server_ring, nullptr);
+
+    auto client_ring = SharedAuthRing::attach(name);
+    ASSERT_NE(client_ring, nullptr);
+
+    // Heartbeat goes stale when nobody calls serve_once()
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    EXPECT_FALSE(client_ring->call("VALIDATE abc").has_value());
+}
+
+TEST(AuthTransportTest, LocalTransportsMatchTcpProtocol) {
+    std::string suffix = std::to_string(getpid());
+    std::string db_path = "/tmp/booking_auth_users_" + suffix + ".json";
+    std::string socket_path = "/tmp/booking_auth_" + suffix + ".sock";
+    std::string shm_name = "/booking_auth_server_" + suffix;
+    std::remove(db_path.c_str());
+
+    AuthServer server(0, db_path, socket_path, shm_name);
+    server.start();
+    ASSERT_TRUE(server.is_running());
+
+    AuthEndpoint endpoint;
+    endpoint.unix_socket_path = socket_path;
+    endpoint.shm_name = shm_name;
+    AuthClient client(endpoint);
+
+    ASSERT_TRUE(client.register_user("alice", "secret", "Alice A"));
+    AuthResult result = client.authenticate("alice", "secret");
+    ASSERT_TRUE(result.success);
+
+    EXPECT_TRUE(client.validate_token(result.token));
+    EXPECT_FALSE(client.validate_token("not-a-token"));
+
+    auto info = client.get_user_info(result.token);
+    ASSERT_TRUE(info.has_value());
+    EXPECT_EQ(info->username, "alice");
+
+    server.stop();
+    std::remove(db_path.c_str());
+}
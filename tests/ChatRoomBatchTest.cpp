@@ -0,0 +1,150 @@
+#include <gtest/gtest.h>
+#include "ChatRoom.h"
+#include "common/NetworkMessage.h"
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+class ChatRoomBatchTest : public ::testing::Test {
+protected:
+    std::shared_ptr<IoBackend> backend = std::make_shared<PosixIoBackend>();
+    // Each member: connection on [0], test reads [1]
+    std::vector<std::pair<std::shared_ptr<ClientConnection>, int>> members;
+
+    void TearDown() override {
+        for (auto& [connection, reader] : members) {
+            close(connection->fd());
+            close(reader);
+        }
+    }
+
+    std::shared_ptr<ClientConnection> add_member(ChatRoom& room, const std::string& name) {
+        int sv[2];
+        socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+        auto connection = std::make_shared<ClientConnection>(sv[0], name, "127.0.0.1", "", backend);
+        members.emplace_back(connection, sv[1]);
+        room.add_client(connection);
+        return connection;
+    }
+
+    // Every frame that arrives within timeout_ms
+    std::vector<NetworkMessage> read_frames(int fd, int timeout_ms) {
+        std::string data;
+        char chunk[4096];
+        pollfd pfd{fd, POLLIN, 0};
+        while (poll(&pfd, 1, timeout_ms) > 0) {
+            ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+            if (n <= 0) break;
+            data.append(chunk, n);
+        }
+        std::vector<NetworkMessage> frames;
+        size_t start = 0;
+        for (size_t end; (end = data.find('\n', start)) != std::string::npos; start = end + 1) {
+            frames.push_back(NetworkMessage::deserialize(data.substr(start, end - start)));
+        }
+        return frames;
+    }
+
+    static std::shared_ptr<BatchFlusher> make_flusher(unsigned rate_threshold, size_t max_messages = 64) {
+        BatchConfig config;
+        config.rate_threshold = rate_threshold;
+        config.max_delay = std::chrono::milliseconds(20);
+        config.max_messages = max_messages;
+        return std::make_shared<BatchFlusher>(config);
+    }
+};
+
+TEST_F(ChatRoomBatchTest, QuietRoomSendsSingleMessages) {
+    auto flusher = make_flusher(1000);
+    auto room = std::make_shared<ChatRoom>("General", backend, flusher);
+    auto alice = add_member(*room, "alice");
+    add_member(*room, "bob");
+
+    room->broadcast_message("alice", "hi", alice->fd());
+
+    auto frames = read_frames(members[1].second, 50);
+    ASSERT_EQ(frames.size(), 1u);
+    EXPECT_EQ(frames[0].body.type, "MESSAGE");
+    EXPECT_EQ(flusher->stats().immediate_messages, 1u);
+    EXPECT_EQ(flusher->stats().batches, 0u);
+}
+
+TEST_F(ChatRoomBatchTest, BusyRoomBatchesUntilDeadline) {
+    // 10 msg/s: the first message in a 100ms window already crosses it
+    auto flusher = make_flusher(10);
+    auto room = std::make_shared<ChatRoom>("General", backend, flusher);
+    auto alice = add_member(*room, "alice");
+    add_member(*room, "bob");
+
+    for (int i = 0; i < 5; ++i) {
+        room->broadcast_message("alice", "line " + std::to_string(i), alice->fd());
+    }
+
+    auto frames = read_frames(members[1].second, 100);
+    ASSERT_EQ(frames.size(), 1u);
+    EXPECT_EQ(frames[0].body.type, "MESSAGE_BATCH");
+    EXPECT_EQ(frames[0].body.data.value("room", ""), "General");
+    const auto& messages = frames[0].body.data["messages"];
+    ASSERT_EQ(messages.size(), 5u);
+    for (size_t i = 0; i < messages.size(); ++i) {
+        EXPECT_EQ(messages[i].value("message", ""), "line " + std::to_string(i));
+        EXPECT_EQ(messages[i].value("seq", 0u), i + 1);
+    }
+
+    // The author does not get its own lines back
+    EXPECT_TRUE(read_frames(members[0].second, 0).empty());
+    EXPECT_EQ(flusher->stats().batched_messages, 5u);
+    EXPECT_EQ(flusher->stats().batches, 1u);
+    EXPECT_GE(flusher->stats().delay_us_max, 15000u);
+}
+
+TEST_F(ChatRoomBatchTest, FullBatchFlushesEarlyAndAuthorsSeeOthers) {
+    auto flusher = make_flusher(10, 4);
+    auto room = std::make_shared<ChatRoom>("General", backend, flusher);
+    auto alice = add_member(*room, "alice");
+    auto bob = add_member(*room, "bob");
+    add_member(*room, "carol");
+
+    room->broadcast_message("alice", "a1", alice->fd());
+    room->broadcast_message("bob", "b1", bob->fd());
+    room->broadcast_message("alice", "a2", alice->fd());
+    room->broadcast_message("bob", "b2", bob->fd());
+
+    // max_messages reached: no need to wait for the deadline
+    auto carol_frames = read_frames(members[2].second, 0);
+    ASSERT_EQ(carol_frames.size(), 1u);
+    EXPECT_EQ(carol_frames[0].body.data["messages"].size(), 4u);
+
+    auto alice_frames = read_frames(members[0].second, 0);
+    ASSERT_EQ(alice_frames.size(), 1u);
+    const auto& seen = alice_frames[0].body.data["messages"];
+    ASSERT_EQ(seen.size(), 2u);
+    EXPECT_EQ(seen[0].value("message", ""), "b1");
+    EXPECT_EQ(seen[1].value("message", ""), "b2");
+}
+
+TEST_F(ChatRoomBatchTest, NewcomerHistoryLeavesOutHeldMessages) {
+    auto flusher = make_flusher(10);
+    auto room = std::make_shared<ChatRoom>("General", backend, flusher);
+    auto alice = add_member(*room, "alice");
+
+    room->broadcast_message("alice", "before", alice->fd());  // flushed by add_member
+    auto bob = add_member(*room, "bob");
+    room->broadcast_message("alice", "held", alice->fd());
+    room->send_history_to_client(*bob);
+
+    auto frames = read_frames(members[1].second, 100);
+    std::vector<std::string> lines;
+    for (const auto& frame : frames) {
+        if (frame.body.type == "MESSAGE") {
+            lines.push_back(frame.body.data.value("message", ""));
+        } else if (frame.body.type == "MESSAGE_BATCH") {
+            for (const auto& entry : frame.body.data["messages"]) {
+                lines.push_back(entry.value("message", ""));
+            }
+        }
+    }
+    EXPECT_EQ(lines, (std::vector<std::string>{"before", "held"}));
+}
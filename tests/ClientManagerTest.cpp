@@ -0,0 +1,361 @@
+#include <gtest/gtest.h>
+#include "ClientManager.h"
+#include "auth/EmbeddedAuthService.h"
+#include "auth/InMemoryUserRepository.h"
+#include "common/NetworkMessage.h"
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <string>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Test side of one chat connection: sends frames, reads newline-delimited replies
+class TestClient {
+public:
+    TestClient(ClientManager& manager, const std::string& token, bool paged_rooms = false) : token_(token) {
+        int sv[2];
+        socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+        fd_ = sv[1];
+        thread_ = std::thread(&ClientManager::handle_client, &manager, sv[0], "127.0.0.1");
+        send(NetworkMessage::create_auth(token, paged_rooms));
+    }
+
+    ~TestClient() {
+        send(NetworkMessage::create_quit(token_));
+        thread_.join();
+        close(fd_);
+    }
+
+    void send(const NetworkMessage& msg) {
+        send_raw(msg.serialize());
+    }
+
+    void send_raw(const std::string& bytes) {
+        ::send(fd_, bytes.data(), bytes.size(), MSG_NOSIGNAL);
+    }
+
+    // True once the server has closed the connection
+    bool closed() {
+        char chunk[4096];
+        pollfd pfd{fd_, POLLIN, 0};
+        while (poll(&pfd, 1, 2000) > 0) {
+            if (recv(fd_, chunk, sizeof(chunk), 0) <= 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Next frame of the given type; skips everything else
+    NetworkMessage expect(const std::string& type) {
+        while (true) {
+            size_t end = buffer_.find('\n');
+            while (end == std::string::npos) {
+                pollfd pfd{fd_, POLLIN, 0};
+                if (poll(&pfd, 1, 2000) <= 0) {
+                    ADD_FAILURE() << "timed out waiting for " << type;
+                    return NetworkMessage{};
+                }
+                char chunk[4096];
+                ssize_t n = recv(fd_, chunk, sizeof(chunk), 0);
+                if (n <= 0) {
+                    ADD_FAILURE() << "connection closed waiting for " << type;
+                    return NetworkMessage{};
+                }
+                buffer_.append(chunk, n);
+                end = buffer_.find('\n');
+            }
+            auto msg = NetworkMessage::deserialize(buffer_.substr(0, end));
+            buffer_.erase(0, end + 1);
+            if (msg.body.type == type) {
+                return msg;
+            }
+        }
+    }
+
+    const std::string& token() const { return token_; }
+
+private:
+    int fd_;
+    std::string token_;
+    std::string buffer_;
+    std::thread thread_;
+};
+
+} // namespace
+
+class ClientManagerTest : public ::testing::Test {
+protected:
+    std::shared_ptr<EmbeddedAuthService> auth =
+        std::make_shared<EmbeddedAuthService>(
+            std::make_shared<AuthManager>(std::make_shared<InMemoryUserRepository>()));
+    ClientManager manager{auth};
+
+    std::string login(const std::string& username) {
+        auth->register_user(username, "pw", username);
+        return auth->authenticate(username, "pw").token;
+    }
+};
+
+TEST_F(ClientManagerTest, ConnectionReceivesSeveralRooms) {
+    TestClient alice(manager, login("alice"));
+    alice.expect("ROOM_LIST");
+
+    alice.send(NetworkMessage::create_create_room(alice.token(), "Ops"));
+    alice.expect("ROOM_JOINED");
+    alice.send(NetworkMessage::create_subscribe(alice.token(), "General"));
+    EXPECT_EQ(alice.expect("SUBSCRIBED").body.data.value("room_name", ""), "General");
+
+    TestClient bob(manager, login("bob"));
+    bob.expect("ROOM_LIST");
+    bob.send(NetworkMessage::create_join_room(bob.token(), "General"));
+    bob.expect("ROOM_JOINED");
+
+    bob.send(NetworkMessage::create_chat_message(bob.token(), "hello general"));
+    auto first = alice.expect("MESSAGE");
+    while (first.body.data.value("sender", "") != "bob") {
+        first = alice.expect("MESSAGE");
+    }
+    EXPECT_EQ(first.body.data.value("room", ""), "General");
+    EXPECT_EQ(first.body.data.value("message", ""), "hello general");
+
+    bob.send(NetworkMessage::create_chat_message(bob.token(), "again"));
+    auto second = alice.expect("MESSAGE");
+    EXPECT_EQ(second.body.data.value("seq", 0u), first.body.data.value("seq", 0u) + 1);
+
+    // Alice can post into the subscribed room without leaving her primary one
+    alice.send(NetworkMessage::create_chat_message(alice.token(), "from ops", "General"));
+    auto received = bob.expect("MESSAGE");
+    while (received.body.data.value("sender", "") != "alice") {
+        received = bob.expect("MESSAGE");
+    }
+    EXPECT_EQ(received.body.data.value("message", ""), "from ops");
+
+    alice.send(NetworkMessage::create_unsubscribe(alice.token(), "General"));
+    EXPECT_EQ(alice.expect("UNSUBSCRIBED").body.data.value("room_name", ""), "General");
+}
+
+TEST_F(ClientManagerTest, ChatToUnsubscribedRoomIsRejected) {
+    TestClient carol(manager, login("carol"));
+    carol.expect("ROOM_LIST");
+
+    carol.send(NetworkMessage::create_chat_message(carol.token(), "hi", "General"));
+    EXPECT_EQ(carol.expect("ERROR").body.data.value("message", ""), "Not subscribed to room");
+}
+
+TEST_F(ClientManagerTest, OversizedFrameDisconnects) {
+    TestClient dave(manager, login("dave"));
+    dave.expect("ROOM_LIST");
+
+    // No newline ever arrives; the server must not keep buffering
+    std::string chunk(1024, 'x');
+    for (int i = 0; i < 8; ++i) {
+        dave.send_raw(chunk);
+    }
+    EXPECT_EQ(dave.expect("ERROR").body.data.value("message", ""), "Frame too large");
+    EXPECT_TRUE(dave.closed());
+}
+
+TEST_F(ClientManagerTest, PagedClientListsRoomsInPages) {
+    TestClient dave(manager, login("dave"), true);
+    auto first = dave.expect("ROOM_PAGE");
+    EXPECT_EQ(first.body.data["rooms"].size(), 1u);
+    EXPECT_EQ(first.body.data["rooms"][0].value("name", ""), "General");
+
+    for (const char* name : {"ops-a", "ops-b", "ops-c"}) {
+        dave.send(NetworkMessage::create_create_room(dave.token(), name));
+        dave.expect("ROOM_JOINED");
+    }
+    dave.send(NetworkMessage::create_leave(dave.token()));
+    dave.expect("LEFT_ROOM");
+
+    dave.send(NetworkMessage::create_list_rooms(dave.token(), "ops", "name", "", 2));
+    auto page = dave.expect("ROOM_PAGE");
+    EXPECT_EQ(page.body.data.value("total", 0u), 3u);
+    ASSERT_EQ(page.body.data["rooms"].size(), 2u);
+    EXPECT_EQ(page.body.data["rooms"][0].value("name", ""), "ops-a");
+
+    std::string cursor = page.body.data.value("next_cursor", "");
+    dave.send(NetworkMessage::create_list_rooms(dave.token(), "ops", "name", cursor, 2));
+    auto rest = dave.expect("ROOM_PAGE");
+    EXPECT_EQ(rest.body.data.value("cursor", ""), cursor);
+    ASSERT_EQ(rest.body.data["rooms"].size(), 1u);
+    EXPECT_EQ(rest.body.data["rooms"][0].value("name", ""), "ops-c");
+    EXPECT_EQ(rest.body.data.value("next_cursor", "x"), "");
+}
+
+TEST_F(ClientManagerTest, PagedFoyerGetsChangeNoticeInsteadOfFullList) {
+    TestClient erin(manager, login("erin"), true);
+    erin.expect("ROOM_PAGE");
+
+    TestClient frank(manager, login("frank"));
+    frank.expect("ROOM_LIST");
+    frank.send(NetworkMessage::create_create_room(frank.token(), "Lounge"));
+    frank.expect("ROOM_JOINED");
+
+    EXPECT_EQ(erin.expect("ROOMS_CHANGED").body.data.value("total", 0u), 2u);
+
+    erin.send(NetworkMessage::create_list_rooms(erin.token(), "", "members", "", 10));
+    auto page = erin.expect("ROOM_PAGE");
+    ASSERT_EQ(page.body.data["rooms"].size(), 2u);
+    EXPECT_EQ(page.body.data["rooms"][0].value("name", ""), "Lounge");
+    EXPECT_EQ(page.body.data["rooms"][0].value("members", 0u), 1u);
+}
+
+TEST_F(ClientManagerTest, BurstOfRoomChangesSharesFoyerNotices) {
+    TestClient erin(manager, login("erin"), true);
+    erin.expect("ROOM_PAGE");
+
+    TestClient frank(manager, login("frank"));
+    frank.expect("ROOM_LIST");
+    constexpr size_t ROOMS = 10;
+    for (size_t i = 0; i < ROOMS; ++i) {
+        frank.send(NetworkMessage::create_create_room(frank.token(), "Burst-" + std::to_string(i)));
+        frank.expect("ROOM_JOINED");
+    }
+
+    // The burst is folded into a few notices; the last one carries the final total
+    size_t notices = 0;
+    size_t total = 0;
+    while (total != ROOMS + 1 && notices < ROOMS) {
+        total = erin.expect("ROOMS_CHANGED").body.data.value("total", 0u);
+        ++notices;
+    }
+    EXPECT_EQ(total, ROOMS + 1);
+    EXPECT_LT(notices, ROOMS);
+}
+
+TEST_F(ClientManagerTest, SearchRoomsRanksByMembers) {
+    TestClient gina(manager, login("gina"));
+    gina.expect("ROOM_LIST");
+    gina.send(NetworkMessage::create_create_room(gina.token(), "Book Club"));
+    gina.expect("ROOM_JOINED");
+    gina.send(NetworkMessage::create_create_room(gina.token(), "notebooks"));
+    gina.expect("ROOM_JOINED");
+
+    gina.send(NetworkMessage::create_search_rooms(gina.token(), "BOOK", "substring", 5));
+    auto results = gina.expect("SEARCH_RESULTS");
+    EXPECT_EQ(results.body.data.value("match", ""), "substring");
+    ASSERT_EQ(results.body.data["rooms"].size(), 2u);
+    EXPECT_EQ(results.body.data["rooms"][0].value("name", ""), "notebooks");
+    EXPECT_EQ(results.body.data["rooms"][0].value("members", 0u), 1u);
+    EXPECT_EQ(results.body.data["rooms"][1].value("name", ""), "Book Club");
+
+    gina.send(NetworkMessage::create_search_rooms(gina.token(), "book", "prefix", 5));
+    auto prefixed = gina.expect("SEARCH_RESULTS");
+    ASSERT_EQ(prefixed.body.data["rooms"].size(), 1u);
+    EXPECT_EQ(prefixed.body.data["rooms"][0].value("name", ""), "Book Club");
+}
+
+TEST_F(ClientManagerTest, SearchHistoryFindsIndexedChat) {
+    {
+        TestClient ivy(manager, login("ivy"));
+        ivy.expect("ROOM_LIST");
+        ivy.send(NetworkMessage::create_search_history(ivy.token(), "General", "deploy", 5));
+        EXPECT_EQ(ivy.expect("ERROR").body.data.value("message", ""), "History search is disabled");
+    }
+
+    std::string dir = "/tmp/booking_cm_history_" + std::to_string(getpid());
+    auto history = std::make_shared<HistoryIndex>(dir);
+    ASSERT_TRUE(history->open());
+    manager.set_history_index(history);
+
+    TestClient hank(manager, login("hank"));
+    hank.expect("ROOM_LIST");
+    hank.send(NetworkMessage::create_join_room(hank.token(), "General"));
+    hank.expect("ROOM_JOINED");
+    hank.send(NetworkMessage::create_chat_message(hank.token(), "deploy is done"));
+    hank.send(NetworkMessage::create_chat_message(hank.token(), "coffee"));
+    hank.send(NetworkMessage::create_search_history(hank.token(), "", "DEPLOY", 5));
+    auto results = hank.expect("HISTORY_RESULTS");
+    EXPECT_EQ(results.body.data.value("room_name", ""), "General");
+    ASSERT_EQ(results.body.data["results"].size(), 1u);
+    EXPECT_EQ(results.body.data["results"][0].value("sender", ""), "hank");
+    EXPECT_EQ(results.body.data["results"][0].value("message", ""), "deploy is done");
+    EXPECT_GT(results.body.data["results"][0].value("seq", 0u), 0u);
+
+    hank.send(NetworkMessage::create_search_history(hank.token(), "Nowhere", "deploy", 5));
+    EXPECT_EQ(hank.expect("ERROR").body.data.value("message", ""), "Room not found");
+
+    std::remove((dir + "/messages.log").c_str());
+    rmdir(dir.c_str());
+}
+
+TEST_F(ClientManagerTest, RestartedRoomContinuesHistorySeqs) {
+    std::string dir = "/tmp/booking_cm_restart_" + std::to_string(getpid());
+    std::string token = login("iris");
+    for (const char* message : {"deploy before restart", "deploy after restart"}) {
+        ClientManager restarted{auth};
+        auto history = std::make_shared<HistoryIndex>(dir);
+        ASSERT_TRUE(history->open());
+        restarted.set_history_index(history);
+
+        TestClient iris(restarted, token);
+        iris.expect("ROOM_LIST");
+        iris.send(NetworkMessage::create_join_room(token, "General"));
+        iris.expect("ROOM_JOINED");
+        iris.send(NetworkMessage::create_chat_message(token, message));
+        iris.send(NetworkMessage::create_search_history(token, "General", "deploy", 5));
+        iris.expect("HISTORY_RESULTS");
+    }
+
+    auto history = std::make_shared<HistoryIndex>(dir);
+    ASSERT_TRUE(history->open());
+    auto hits = history->search("General", "deploy");
+    ASSERT_EQ(hits.size(), 2u);
+    EXPECT_EQ(hits[0].message, "deploy after restart");
+    EXPECT_GT(hits[0].seq, hits[1].seq);
+    history.reset();
+
+    std::remove((dir + "/messages.log").c_str());
+    std::remove((dir + "/MANIFEST").c_str());
+    rmdir(dir.c_str());
+}
+
+TEST_F(ClientManagerTest, StripedStateActsAsOneServer) {
+    ClientManager striped{auth, nullptr, nullptr, nullptr, 4};
+    EXPECT_EQ(striped.stripe_count(), 4u);
+    {
+        TestClient ivy(striped, login("ivy"));
+        ivy.expect("ROOM_LIST");
+        for (const char* room : {"Ops", "Dev", "Lounge", "Qa", "Zen"}) {
+            ivy.send(NetworkMessage::create_create_room(ivy.token(), room));
+            ivy.expect("ROOM_JOINED");
+        }
+
+        // Rooms live on different stripes; the full list is still one sorted list
+        TestClient jay(striped, login("jay"));
+        auto list = jay.expect("ROOM_LIST").body.data["rooms"];
+        EXPECT_EQ(list, json({"Dev", "General", "Lounge", "Ops", "Qa", "Zen"}));
+
+        jay.send(NetworkMessage::create_join_room(jay.token(), "Zen"));
+        jay.expect("ROOM_JOINED");
+        jay.send(NetworkMessage::create_chat_message(jay.token(), "across stripes"));
+        auto received = ivy.expect("MESSAGE");
+        while (received.body.data.value("sender", "") != "jay") {
+            received = ivy.expect("MESSAGE");
+        }
+        EXPECT_EQ(received.body.data.value("message", ""), "across stripes");
+
+        size_t connections = 0, rooms = 0;
+        uint64_t token_hits = 0;
+        auto stats = striped.stripe_stats();
+        ASSERT_EQ(stats.size(), 4u);
+        for (const auto& stripe : stats) {
+            connections += stripe.connections;
+            rooms += stripe.rooms;
+            token_hits += stripe.token_cache_hits;
+        }
+        EXPECT_EQ(connections, 2u);
+        EXPECT_EQ(rooms, 6u);
+        EXPECT_GT(token_hits, 0u);
+    }
+
+    for (const auto& stripe : striped.stripe_stats()) {
+        EXPECT_EQ(stripe.connections, 0u);
+    }
+}
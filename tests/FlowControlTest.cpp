@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+#include "ClientConnection.h"
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+class FlowControlTest : public ::testing::Test {
+protected:
+    std::shared_ptr<IoBackend> backend = std::make_shared<PosixIoBackend>();
+    int reader = -1;
+    std::shared_ptr<ClientConnection> connection;
+
+    void open_connection(size_t max_queued = ClientConnection::DEFAULT_MAX_QUEUED_FRAMES) {
+        int sv[2];
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+        reader = sv[1];
+        connection = std::make_shared<ClientConnection>(sv[0], "alice", "127.0.0.1", "", backend, max_queued);
+    }
+
+    void TearDown() override {
+        if (connection) {
+            close(connection->fd());
+            close(reader);
+        }
+    }
+
+    // Lines available right now
+    std::vector<std::string> read_lines() {
+        std::string data;
+        char chunk[4096];
+        pollfd pfd{reader, POLLIN, 0};
+        while (poll(&pfd, 1, 0) > 0) {
+            ssize_t n = recv(reader, chunk, sizeof(chunk), 0);
+            if (n <= 0) break;
+            data.append(chunk, n);
+        }
+        std::vector<std::string> lines;
+        size_t start = 0;
+        for (size_t end; (end = data.find('\n', start)) != std::string::npos; start = end + 1) {
+            lines.push_back(data.substr(start, end - start));
+        }
+        return lines;
+    }
+
+    static SharedPayload frame(const std::string& text) {
+        return make_payload(text + "\n");
+    }
+};
+
+TEST_F(FlowControlTest, UnlimitedUntilFirstCredit) {
+    open_connection();
+    for (int i = 0; i < 10; ++i) {
+        connection->deliver(frame("m" + std::to_string(i)));
+    }
+    EXPECT_FALSE(connection->flow_controlled());
+    EXPECT_EQ(read_lines().size(), 10u);
+}
+
+TEST_F(FlowControlTest, QueuesBeyondCreditAndDrainsInOrder) {
+    open_connection();
+    connection->grant_credit(2);
+    for (int i = 0; i < 5; ++i) {
+        connection->deliver(frame("m" + std::to_string(i)));
+    }
+    EXPECT_EQ(read_lines(), (std::vector<std::string>{"m0", "m1"}));
+    EXPECT_EQ(connection->queued_frames(), 3u);
+
+    connection->grant_credit(10);
+    EXPECT_EQ(read_lines(), (std::vector<std::string>{"m2", "m3", "m4"}));
+    EXPECT_EQ(connection->queued_frames(), 0u);
+}
+
+TEST_F(FlowControlTest, RepliesBypassTheQueueButSpendCredit) {
+    open_connection();
+    connection->grant_credit(1);
+    connection->send(std::string_view("reply\n"));
+    connection->deliver(frame("broadcast"));
+    EXPECT_EQ(read_lines(), (std::vector<std::string>{"reply"}));
+
+    // The reply used the only credit, so one more is needed
+    connection->grant_credit(1);
+    EXPECT_EQ(read_lines(), (std::vector<std::string>{"broadcast"}));
+}
+
+TEST_F(FlowControlTest, StateFramesCoalesce) {
+    open_connection();
+    connection->grant_credit(0);
+    connection->deliver(frame("members v1"), "members:General");
+    connection->deliver(frame("chat"));
+    connection->deliver(frame("members v2"), "members:General");
+    EXPECT_EQ(connection->queued_frames(), 2u);
+    EXPECT_EQ(connection->coalesced_frames(), 1u);
+
+    connection->grant_credit(10);
+    EXPECT_EQ(read_lines(), (std::vector<std::string>{"members v2", "chat"}));
+}
+
+TEST_F(FlowControlTest, FullQueueDropsOldestChat) {
+    open_connection(3);
+    connection->grant_credit(0);
+    connection->deliver(frame("members"), "members:General");
+    for (int i = 0; i < 4; ++i) {
+        connection->deliver(frame("m" + std::to_string(i)));
+    }
+    EXPECT_EQ(connection->queued_frames(), 3u);
+    EXPECT_EQ(connection->dropped_frames(), 2u);
+
+    connection->grant_credit(10);
+    EXPECT_EQ(read_lines(), (std::vector<std::string>{"members", "m2", "m3"}));
+}
+
+TEST_F(FlowControlTest, FullQueueOfStateFramesStaysBounded) {
+    open_connection(3);
+    connection->grant_credit(0);
+    for (const char* room : {"A", "B", "C", "D"}) {
+        connection->deliver(frame(std::string("members ") + room), std::string("members:") + room);
+    }
+    connection->deliver(frame("chat"));
+    EXPECT_EQ(connection->queued_frames(), 3u);
+    EXPECT_EQ(connection->dropped_frames(), 2u);
+
+    connection->grant_credit(10);
+    EXPECT_EQ(read_lines(), (std::vector<std::string>{"members B", "members C", "members D"}));
+}
+
+TEST_F(FlowControlTest, BatchSendQueuesOnlyStalledConnections) {
+    open_connection();
+    int sv[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+    auto other = std::make_shared<ClientConnection>(sv[0], "bob", "127.0.0.1", "", backend);
+
+    connection->grant_credit(0);
+    EXPECT_EQ(ClientConnection::send_batch(*backend, {connection, other}, frame("hello")), 2u);
+    EXPECT_TRUE(read_lines().empty());
+    EXPECT_EQ(connection->queued_frames(), 1u);
+
+    char buffer[16];
+    EXPECT_EQ(recv(sv[1], buffer, sizeof(buffer), 0), 6);
+    close(sv[0]);
+    close(sv[1]);
+}
+
+TEST_F(FlowControlTest, MemberThatStopsReadingHoldsUpNobody) {
+    open_connection();
+    int sv[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+    auto healthy = std::make_shared<ClientConnection>(sv[0], "bob", "127.0.0.1", "", backend);
+
+    // Bob reads everything; alice (the fixture's reader) reads nothing for now
+    std::string bob_data;
+    std::thread bob_reader([&] {
+        char chunk[65536];
+        ssize_t n;
+        while ((n = recv(sv[1], chunk, sizeof(chunk), 0)) > 0) {
+            bob_data.append(chunk, n);
+        }
+    });
+
+    const std::string padding(16 * 1024, 'x');
+    for (int i = 0; i < 100; ++i) {
+        auto payload = frame("m" + std::to_string(i) + padding);
+        EXPECT_EQ(ClientConnection::send_batch(*backend, {connection, healthy}, payload), 2u);
+    }
+    EXPECT_GT(connection->queued_frames(), 0u);
+    EXPECT_NE(connection->write_blocked_since(), std::chrono::steady_clock::time_point{});
+
+    // Bob's own backlog, if his reader fell behind, drains as he reads
+    for (int i = 0; i < 200 && healthy->queued_frames() > 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(healthy->queued_frames(), 0u);
+    shutdown(sv[0], SHUT_WR);
+    bob_reader.join();
+    EXPECT_EQ(bob_data.size(), 100 * (padding.size() + 4) - 10);
+
+    // Once alice reads again her backlog drains, in order, without any new sends
+    std::string alice_data;
+    char chunk[65536];
+    pollfd pfd{reader, POLLIN, 0};
+    while (alice_data.size() < bob_data.size() && poll(&pfd, 1, 2000) > 0) {
+        ssize_t n = recv(reader, chunk, sizeof(chunk), 0);
+        if (n <= 0) break;
+        alice_data.append(chunk, n);
+    }
+    EXPECT_TRUE(alice_data == bob_data);
+    EXPECT_EQ(connection->queued_frames(), 0u);
+    EXPECT_EQ(connection->write_blocked_since(), std::chrono::steady_clock::time_point{});
+
+    close(sv[0]);
+    close(sv[1]);
+}
@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+#include "common/FrameWriter.h"
+#include "common/NetworkMessage.h"
+#include "common/Trace.h"
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace {
+
+const std::string TIMESTAMP = "2026-01-02T03:04:05Z";
+
+// Strings that exercise every escaping path, at offsets on both sides of
+// the 16-byte vector stride
+std::vector<std::string> awkward_strings() {
+    std::vector<std::string> strings = {
+        "",
+        "plain text",
+        "quote \" and backslash \\ and slash /",
+        "tabs\tnewlines\nreturns\rform\ffeed\bbell\x07",
+        std::string("nul\0byte", 8),
+        "del \x7f stays",
+        "caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80",
+        "0123456789abcde\"0123456789abcdef\\",
+        "0123456789abcdef0123456789abcde\xc3\xa9 tail",
+        std::string(100, 'x') + "\n" + std::string(40, 'y'),
+    };
+    std::string controls;
+    for (int c = 0; c < 0x20; ++c) {
+        controls += static_cast<char>(c);
+        controls += 'a';
+    }
+    strings.push_back(controls);
+    return strings;
+}
+
+} // namespace
+
+TEST(FrameWriterTest, ChatMessageMatchesSerialize) {
+    for (const auto& text : awkward_strings()) {
+        auto msg = NetworkMessage::create_chat_message("tok\"en", text);
+        msg.header.timestamp = TIMESTAMP;
+        std::string frame;
+        NetworkMessage::write_chat_message(frame, "tok\"en", text, nullptr, TIMESTAMP);
+        EXPECT_EQ(frame, msg.serialize()) << text;
+    }
+}
+
+TEST(FrameWriterTest, TracedChatMessageMatchesSerialize) {
+    json trace = tracing::start();
+    tracing::stamp(trace, tracing::CLIENT_INPUT, 1234567);
+    auto msg = NetworkMessage::create_chat_message("token", "hello");
+    msg.header.timestamp = TIMESTAMP;
+    msg.header.trace = trace;
+    std::string frame;
+    NetworkMessage::write_chat_message(frame, "token", "hello", trace, TIMESTAMP);
+    EXPECT_EQ(frame, msg.serialize());
+}
+
+TEST(FrameWriterTest, CreditAndRoomMessageMatchSerialize) {
+    auto credit = NetworkMessage::create_credit("token", 4000000000u);
+    credit.header.timestamp = TIMESTAMP;
+    std::string frame;
+    NetworkMessage::write_credit(frame, "token", 4000000000u, TIMESTAMP);
+    EXPECT_EQ(frame, credit.serialize());
+
+    for (const auto& text : awkward_strings()) {
+        auto msg = NetworkMessage::create_room_message("lob\\by", 18446744073709551615ull, "al\tice", text);
+        msg.header.timestamp = TIMESTAMP;
+        frame.clear();
+        NetworkMessage::write_room_message(frame, "lob\\by", 18446744073709551615ull, "al\tice", text,
+                                           nullptr, TIMESTAMP);
+        EXPECT_EQ(frame, msg.serialize()) << text;
+    }
+}
+
+TEST(FrameWriterTest, MessageBatchMatchesSerialize) {
+    json trace = tracing::start();
+    tracing::stamp(trace, tracing::BROADCAST_ENQUEUE, 42);
+    std::vector<proto::BatchItem> entries = {
+        {"alice", "first \"line\"", 7, nullptr},
+        {"bob", "caf\xc3\xa9", 8, trace},
+        {"carol", "", 9, nullptr},
+    };
+    auto msg = NetworkMessage::create_message_batch("lobby", entries);
+    msg.header.timestamp = TIMESTAMP;
+
+    std::string frame;
+    NetworkMessage::write_message_batch(frame, "lobby", entries, TIMESTAMP);
+    EXPECT_EQ(frame, msg.serialize());
+
+    // An empty batch still writes an empty array
+    auto empty = NetworkMessage::create_message_batch("lobby", {});
+    empty.header.timestamp = TIMESTAMP;
+    frame.clear();
+    NetworkMessage::write_message_batch(frame, "lobby", std::vector<proto::BatchItem>{}, TIMESTAMP);
+    EXPECT_EQ(frame, empty.serialize());
+}
+
+TEST(FrameWriterTest, ParticipantListMatchesSerialize) {
+    std::vector<std::string> names = {"alice", "b\"ob", "\xe2\x82\xac"};
+    auto msg = NetworkMessage::create_participant_list(names, "lobby");
+    msg.header.timestamp = TIMESTAMP;
+    std::string frame;
+    NetworkMessage::write_participant_list(frame, names, "lobby", TIMESTAMP);
+    EXPECT_EQ(frame, msg.serialize());
+}
+
+TEST(FrameWriterTest, AppendsAndRoundTrips) {
+    std::string frames = "prefix";
+    NetworkMessage::write_room_message(frames, "lobby", 3, "alice", "one\ntwo", nullptr, TIMESTAMP);
+    NetworkMessage::write_credit(frames, "token", 16, TIMESTAMP);
+    ASSERT_EQ(frames.compare(0, 6, "prefix"), 0);
+
+    size_t first_end = frames.find('\n');
+    auto first = NetworkMessage::deserialize(frames.substr(6, first_end - 6));
+    EXPECT_EQ(first.body.type, "MESSAGE");
+    EXPECT_EQ(first.body.data["message"], "one\ntwo");
+    EXPECT_EQ(first.body.data["seq"], 3);
+    EXPECT_EQ(first.header.timestamp, TIMESTAMP);
+
+    auto second = NetworkMessage::deserialize(frames.substr(first_end + 1));
+    EXPECT_EQ(second.body.type, "CREDIT");
+    EXPECT_EQ(second.header.token, "token");
+    EXPECT_EQ(second.body.data["frames"], 16);
+}
+
+TEST(FrameWriterTest, InvalidUtf8ThrowsLikeSerialize) {
+    const std::vector<std::string> invalid = {
+        "bad \xff byte",
+        "truncated \xe2\x82",
+        "overlong \xc0\xaf",
+        "surrogate \xed\xa0\x80",
+        "past max \xf4\x90\x80\x80",
+    };
+    for (const auto& text : invalid) {
+        auto msg = NetworkMessage::create_chat_message("token", text);
+        EXPECT_THROW(msg.serialize(), json::type_error) << text;
+        std::string frame = "kept";
+        EXPECT_THROW(NetworkMessage::write_chat_message(frame, "token", text, nullptr, TIMESTAMP),
+                     json::type_error) << text;
+    }
+}
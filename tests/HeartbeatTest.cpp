@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+#include "Heartbeat.h"
+#include "ClientConnection.h"
+#include "ChatRoom.h"
+#include "common/NetworkMessage.h"
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+#include <string>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+class HeartbeatTest : public ::testing::Test {
+protected:
+    std::shared_ptr<IoBackend> backend = std::make_shared<PosixIoBackend>();
+    int reader = -1;
+    std::shared_ptr<ClientConnection> connection;
+
+    void SetUp() override {
+        int sv[2];
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+        reader = sv[1];
+        connection = std::make_shared<ClientConnection>(sv[0], "alice", "127.0.0.1", "", backend);
+    }
+
+    void TearDown() override {
+        close(connection->fd());
+        close(reader);
+    }
+
+    static HeartbeatConfig fast_config() {
+        HeartbeatConfig config;
+        config.ping_interval = 60ms;
+        config.idle_timeout = 200ms;
+        config.tick = 5ms;
+        return config;
+    }
+
+    // Next line from the reader; "" on timeout, "EOF" once the socket is shut down
+    std::string read_line(std::chrono::milliseconds timeout) {
+        std::string line;
+        char c;
+        pollfd pfd{reader, POLLIN, 0};
+        while (poll(&pfd, 1, static_cast<int>(timeout.count())) > 0) {
+            ssize_t n = recv(reader, &c, 1, 0);
+            if (n <= 0) return "EOF";
+            if (c == '\n') return line;
+            line += c;
+        }
+        return "";
+    }
+};
+
+TEST_F(HeartbeatTest, PingsQuietConnectionThenReapsIt) {
+    Heartbeat heartbeat(fast_config());
+    heartbeat.watch(connection);
+    EXPECT_EQ(heartbeat.watched(), 1u);
+
+    auto start = std::chrono::steady_clock::now();
+    auto ping = NetworkMessage::deserialize(read_line(1000ms));
+    EXPECT_EQ(ping.body.type, "PING");
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 50ms);
+
+    // One PING per quiet spell, then the shutdown
+    EXPECT_EQ(read_line(1000ms), "EOF");
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 190ms);
+    EXPECT_TRUE(connection->reaped());
+    EXPECT_EQ(heartbeat.stats().pings_sent, 1u);
+    EXPECT_EQ(heartbeat.stats().reaped_connections, 1u);
+    EXPECT_EQ(heartbeat.watched(), 0u);
+}
+
+TEST_F(HeartbeatTest, ActivityKeepsTheConnection) {
+    Heartbeat heartbeat(fast_config());
+    heartbeat.watch(connection);
+
+    for (int i = 0; i < 20; ++i) {
+        std::this_thread::sleep_for(20ms);
+        connection->touch();
+    }
+    EXPECT_EQ(read_line(0ms), "");
+    EXPECT_FALSE(connection->reaped());
+    EXPECT_EQ(heartbeat.stats().pings_sent, 0u);
+
+    // A PONG (any frame) after a PING starts a new quiet spell
+    auto ping = NetworkMessage::deserialize(read_line(1000ms));
+    EXPECT_EQ(ping.body.type, "PING");
+    connection->touch();
+    ping = NetworkMessage::deserialize(read_line(1000ms));
+    EXPECT_EQ(ping.body.type, "PING");
+    EXPECT_FALSE(connection->reaped());
+    EXPECT_EQ(heartbeat.stats().pings_sent, 2u);
+}
+
+TEST_F(HeartbeatTest, ForgottenConnectionsAreLeftAlone) {
+    Heartbeat heartbeat(fast_config());
+    heartbeat.watch(connection);
+    heartbeat.forget(connection->fd());
+    EXPECT_EQ(heartbeat.watched(), 0u);
+
+    EXPECT_EQ(read_line(400ms), "");
+    EXPECT_FALSE(connection->reaped());
+    EXPECT_EQ(heartbeat.stats().reaped_connections, 0u);
+}
+
+TEST_F(HeartbeatTest, PingsCountAgainstCredit) {
+    connection->grant_credit(1);
+    EXPECT_EQ(connection->ping(NetworkMessage::create_ping().serialize()), ClientConnection::PingResult::SENT);
+
+    // Credit is spent, so a broadcast now waits for the client's next CREDIT
+    connection->deliver(make_payload("held\n"));
+    EXPECT_EQ(connection->queued_frames(), 1u);
+    EXPECT_EQ(NetworkMessage::deserialize(read_line(100ms)).body.type, "PING");
+}
+
+TEST_F(HeartbeatTest, MemberThatNeverReadsIsReaped) {
+    // Alice (the fixture) keeps talking but never reads; bob reads everything
+    int sv[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+    auto bob = std::make_shared<ClientConnection>(sv[0], "bob", "127.0.0.1", "", backend);
+    std::thread bob_reader([&] {
+        char chunk[65536];
+        while (recv(sv[1], chunk, sizeof(chunk), 0) > 0) {
+        }
+    });
+
+    ChatRoom room("General", backend);
+    room.add_client(connection);
+    room.add_client(bob);
+    Heartbeat heartbeat(fast_config());
+    heartbeat.watch(connection);
+    heartbeat.watch(bob);
+
+    const std::string padding(8 * 1024, 'x');
+    auto start = std::chrono::steady_clock::now();
+    while (!connection->reaped() && std::chrono::steady_clock::now() - start < 2s) {
+        connection->touch();
+        bob->touch();
+        room.broadcast_message("carol", padding, -1);
+        std::this_thread::sleep_for(5ms);
+    }
+
+    EXPECT_TRUE(connection->reaped());
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 200ms);
+    EXPECT_FALSE(bob->reaped());
+    EXPECT_EQ(heartbeat.stats().reaped_connections, 1u);
+    EXPECT_EQ(heartbeat.watched(), 1u);
+
+    heartbeat.forget(bob->fd());
+    shutdown(sv[0], SHUT_RDWR);
+    bob_reader.join();
+    room.remove_client(connection->fd());
+    room.remove_client(bob->fd());
+    backend->forget(connection->fd());
+    backend->forget(bob->fd());
+    close(sv[0]);
+    close(sv[1]);
+}
@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+#include "HistoryIndex.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+class HistoryIndexTest : public ::testing::Test {
+protected:
+    std::string dir;
+
+    void SetUp() override {
+        dir = "/tmp/booking_history_" + std::to_string(getpid());
+        remove_dir();
+    }
+
+    void TearDown() override {
+        remove_dir();
+    }
+
+    void remove_dir() {
+        if (DIR* handle = opendir(dir.c_str())) {
+            while (dirent* entry = readdir(handle)) {
+                std::string name = entry->d_name;
+                if (name != "." && name != "..") {
+                    std::remove((dir + "/" + name).c_str());
+                }
+            }
+            closedir(handle);
+        }
+        rmdir(dir.c_str());
+    }
+
+    std::unique_ptr<HistoryIndex> open(size_t flush_messages = 4096, size_t max_segments = 8) {
+        HistoryIndexConfig config;
+        config.flush_messages = flush_messages;
+        config.max_segments = max_segments;
+        auto index = std::make_unique<HistoryIndex>(dir, config);
+        EXPECT_TRUE(index->open());
+        return index;
+    }
+
+    static std::vector<uint64_t> seqs(const std::vector<HistoryHit>& hits) {
+        std::vector<uint64_t> result;
+        for (const auto& hit : hits) {
+            result.push_back(hit.seq);
+        }
+        return result;
+    }
+};
+
+TEST_F(HistoryIndexTest, TokenizeLowercasesAndSplits) {
+    EXPECT_EQ(HistoryIndex::tokenize("Deploy v2, TONIGHT!"),
+              (std::vector<std::string>{"deploy", "v2", "tonight"}));
+    EXPECT_EQ(HistoryIndex::tokenize("café au-lait"),
+              (std::vector<std::string>{"café", "au", "lait"}));
+    EXPECT_EQ(HistoryIndex::tokenize(std::string(100, 'x'))[0].size(), HistoryIndex::MAX_TERM_LENGTH);
+}
+
+TEST_F(HistoryIndexTest, MatchesEveryTermAndRanksByRelevance) {
+    auto index = open();
+    index->add("General", 1, "alice", "the build is broken");
+    index->add("General", 2, "bob", "broken build again, build server down");
+    index->add("General", 3, "carol", "lunch?");
+    index->add("Other", 1, "dave", "build broken here too");
+
+    auto hits = index->search("General", "Build BROKEN");
+    EXPECT_EQ(seqs(hits), (std::vector<uint64_t>{2, 1}));
+    EXPECT_EQ(hits[0].sender, "bob");
+    EXPECT_EQ(hits[0].message, "broken build again, build server down");
+    EXPECT_GT(hits[0].score, hits[1].score);
+
+    EXPECT_TRUE(index->search("General", "build lunch").empty());
+    EXPECT_TRUE(index->search("General", "   ").empty());
+    EXPECT_EQ(seqs(index->search("Other", "broken")), (std::vector<uint64_t>{1}));
+}
+
+TEST_F(HistoryIndexTest, TiesPreferNewerMessagesAndLimitApplies) {
+    auto index = open();
+    for (uint64_t seq = 1; seq <= 5; ++seq) {
+        index->add("General", seq, "alice", "standup");
+    }
+    EXPECT_EQ(seqs(index->search("General", "standup", 3)), (std::vector<uint64_t>{5, 4, 3}));
+}
+
+TEST_F(HistoryIndexTest, SearchesAcrossSegmentsAndMemtable) {
+    auto index = open(2);
+    for (uint64_t seq = 1; seq <= 5; ++seq) {
+        index->add("General", seq, "alice", "release " + std::to_string(seq));
+    }
+    index->wait_idle();
+    EXPECT_EQ(index->segment_count(), 2u);
+    EXPECT_EQ(index->message_count(), 5u);
+
+    EXPECT_EQ(seqs(index->search("General", "release")), (std::vector<uint64_t>{5, 4, 3, 2, 1}));
+    EXPECT_EQ(seqs(index->search("General", "release 3")), (std::vector<uint64_t>{3}));
+}
+
+TEST_F(HistoryIndexTest, MergesAdjacentSegments) {
+    auto index = open(1, 2);
+    for (uint64_t seq = 1; seq <= 12; ++seq) {
+        index->add("General", seq, "alice", seq % 2 ? "odd message" : "even message");
+    }
+    index->flush();
+    EXPECT_LE(index->segment_count(), 2u);
+    EXPECT_EQ(index->message_count(), 12u);
+    EXPECT_EQ(seqs(index->search("General", "odd", 50)), (std::vector<uint64_t>{11, 9, 7, 5, 3, 1}));
+}
+
+TEST_F(HistoryIndexTest, ReopenRestoresSegmentsAndReplaysLog) {
+    {
+        auto index = open(3);
+        for (uint64_t seq = 1; seq <= 4; ++seq) {
+            index->add("General", seq, "alice", "persisted note");
+        }
+        index->wait_idle();
+        EXPECT_EQ(index->segment_count(), 1u);
+    }
+
+    auto index = open(3);
+    EXPECT_EQ(index->segment_count(), 1u);
+    EXPECT_EQ(index->message_count(), 4u);
+    index->add("General", 5, "bob", "persisted again");
+    EXPECT_EQ(seqs(index->search("General", "persisted")), (std::vector<uint64_t>{5, 4, 3, 2, 1}));
+}
+
+TEST_F(HistoryIndexTest, LastSeqSurvivesReopen) {
+    {
+        auto index = open(2);
+        index->add("General", 1, "alice", "in a segment");
+        index->add("Lounge", 7, "bob", "in a segment");
+        index->add("General", 2, "alice", "only in the log");
+        index->wait_idle();
+        EXPECT_EQ(index->segment_count(), 1u);
+        EXPECT_EQ(index->last_seq("General"), 2u);
+    }
+
+    auto index = open(2);
+    EXPECT_EQ(index->last_seq("General"), 2u);
+    EXPECT_EQ(index->last_seq("Lounge"), 7u);
+    EXPECT_EQ(index->last_seq("Nowhere"), 0u);
+}
+
+TEST_F(HistoryIndexTest, TornLogTailIsDropped) {
+    {
+        auto index = open();
+        index->add("General", 1, "alice", "kept message");
+        index->add("General", 2, "alice", "lost message");
+    }
+    std::string log_path = dir + "/messages.log";
+    int fd = ::open(log_path.c_str(), O_RDWR);
+    ASSERT_GE(fd, 0);
+    off_t size = lseek(fd, 0, SEEK_END);
+    ASSERT_EQ(ftruncate(fd, size - 3), 0);
+    close(fd);
+
+    auto index = open();
+    EXPECT_EQ(index->message_count(), 1u);
+    EXPECT_EQ(seqs(index->search("General", "message")), (std::vector<uint64_t>{1}));
+    index->add("General", 3, "alice", "new message");
+    EXPECT_EQ(seqs(index->search("General", "message")), (std::vector<uint64_t>{3, 1}));
+}
@@ -0,0 +1,269 @@
+#include <gtest/gtest.h>
+#include "IoBackend.h"
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+
+class IoBackendTest : public ::testing::Test {
+protected:
+    // Each pair: [0] is written by the backend, [1] is read by the test
+    std::vector<std::pair<int, int>> pairs;
+
+    void SetUp() override {
+        for (int i = 0; i < 4; ++i) {
+            int sv[2];
+            ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+            pairs.emplace_back(sv[0], sv[1]);
+        }
+    }
+
+    void TearDown() override {
+        for (auto& [writer, reader] : pairs) {
+            close(writer);
+            close(reader);
+        }
+    }
+
+    std::vector<int> writer_fds() const {
+        std::vector<int> fds;
+        for (const auto& [writer, reader] : pairs) {
+            fds.push_back(writer);
+        }
+        return fds;
+    }
+
+    std::string read_all(int fd, size_t expected) {
+        std::string data;
+        char buffer[4096];
+        while (data.size() < expected) {
+            ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+            if (n <= 0) break;
+            data.append(buffer, n);
+        }
+        return data;
+    }
+};
+
+TEST_F(IoBackendTest, PosixBatchDeliversToEveryRecipient) {
+    PosixIoBackend backend;
+    std::string payload = "{\"body\":{\"type\":\"MESSAGE\"}}\n";
+
+    EXPECT_EQ(backend.send_batch(writer_fds(), payload), pairs.size());
+    for (const auto& [writer, reader] : pairs) {
+        EXPECT_EQ(read_all(reader, payload.size()), payload);
+    }
+    EXPECT_EQ(backend.stats().syscalls, pairs.size());
+}
+
+TEST_F(IoBackendTest, IoUringBatchUsesSingleSubmission) {
+    IoUringBackend backend(1);
+    if (!backend.is_available()) {
+        GTEST_SKIP() << "io_uring not available on this kernel";
+    }
+
+    std::string payload = "{\"body\":{\"type\":\"MESSAGE\"}}\n";
+
+    EXPECT_EQ(backend.send_batch(writer_fds(), payload), pairs.size());
+    for (const auto& [writer, reader] : pairs) {
+        EXPECT_EQ(read_all(reader, payload.size()), payload);
+    }
+    EXPECT_EQ(backend.stats().payloads, pairs.size());
+    EXPECT_LE(backend.stats().syscalls, 2u);
+}
+
+TEST_F(IoBackendTest, SendSequencePreservesOrder) {
+    PosixIoBackend backend;
+    std::vector<std::string_view> parts = {"first\n", "", "second\n", "third\n"};
+
+    int reader = pairs[0].second;
+    ASSERT_TRUE(backend.send_sequence(pairs[0].first, parts));
+    EXPECT_EQ(read_all(reader, 19), "first\nsecond\nthird\n");
+    EXPECT_EQ(backend.stats().syscalls, 1u);
+}
+
+TEST_F(IoBackendTest, CreateFallsBackForUnknownBackend) {
+    std::string reason;
+    auto backend = IoBackend::create("kqueue", reason);
+
+    ASSERT_NE(backend, nullptr);
+    EXPECT_STREQ(backend->name(), "posix");
+    EXPECT_FALSE(reason.empty());
+}
+
+TEST_F(IoBackendTest, ZeroCopyPayloadIsReleasedAfterCompletion) {
+    // MSG_ZEROCOPY needs TCP; build a loopback connection
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_GE(listener, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(bind(listener, (sockaddr*)&addr, sizeof(addr)), 0);
+    ASSERT_EQ(listen(listener, 1), 0);
+    socklen_t len = sizeof(addr);
+    ASSERT_EQ(getsockname(listener, (sockaddr*)&addr, &len), 0);
+
+    int sender = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_EQ(connect(sender, (sockaddr*)&addr, sizeof(addr)), 0);
+    int receiver = accept(listener, nullptr, nullptr);
+    ASSERT_GE(receiver, 0);
+
+    PosixIoBackend backend;
+    backend.set_zerocopy_threshold(1024);
+
+    auto payload = make_payload(std::string(64 * 1024, 'x'));
+    std::weak_ptr<const std::string> observer = payload;
+
+    EXPECT_EQ(backend.send_batch({sender}, payload), 1u);
+    payload.reset();
+    EXPECT_EQ(read_all(receiver, 64 * 1024), std::string(64 * 1024, 'x'));
+
+    const auto& zc = backend.zerocopy_stats();
+    if (zc.zerocopy_bytes == 0) {
+        close(sender);
+        close(receiver);
+        close(listener);
+        GTEST_SKIP() << "SO_ZEROCOPY not supported here";
+    }
+
+    // The sender holds the buffer until the kernel's completion is reaped
+    for (int i = 0; i < 100 && backend.zerocopy_pending() > 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        backend.reap_completions();
+    }
+    EXPECT_EQ(backend.zerocopy_pending(), 0u);
+    EXPECT_TRUE(observer.expired());
+    EXPECT_GT(zc.completions, 0u);
+    backend.forget(sender);
+
+    close(sender);
+    close(receiver);
+    close(listener);
+}
+
+TEST_F(IoBackendTest, ZeroCopyPayloadOutlivesForget) {
+    // A small receive window keeps most of the payload unacknowledged
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_GE(listener, 0);
+    int window = 16384;
+    setsockopt(listener, SOL_SOCKET, SO_RCVBUF, &window, sizeof(window));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(bind(listener, (sockaddr*)&addr, sizeof(addr)), 0);
+    ASSERT_EQ(listen(listener, 1), 0);
+    socklen_t len = sizeof(addr);
+    ASSERT_EQ(getsockname(listener, (sockaddr*)&addr, &len), 0);
+
+    int sender = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_EQ(connect(sender, (sockaddr*)&addr, sizeof(addr)), 0);
+    int receiver = accept(listener, nullptr, nullptr);
+    ASSERT_GE(receiver, 0);
+
+    PosixIoBackend backend;
+    backend.set_zerocopy_threshold(1024);
+
+    const std::string expected(64 * 1024, 'z');
+    auto payload = make_payload(expected);
+    std::weak_ptr<const std::string> observer = payload;
+    EXPECT_EQ(backend.send_batch({sender}, payload), 1u);
+    payload.reset();
+
+    if (backend.zerocopy_stats().zerocopy_bytes == 0) {
+        backend.forget(sender);
+        close(sender);
+        close(receiver);
+        close(listener);
+        GTEST_SKIP() << "SO_ZEROCOPY not supported here";
+    }
+
+    // The session ends while the kernel still transmits from the buffer
+    backend.forget(sender);
+    close(sender);
+    EXPECT_FALSE(observer.expired());
+    EXPECT_GT(backend.zerocopy_pending(), 0u);
+
+    EXPECT_EQ(read_all(receiver, expected.size()), expected);
+    for (int i = 0; i < 100 && backend.zerocopy_pending() > 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        backend.reap_completions();
+    }
+    EXPECT_EQ(backend.zerocopy_pending(), 0u);
+    EXPECT_TRUE(observer.expired());
+
+    close(receiver);
+    close(listener);
+}
+
+TEST_F(IoBackendTest, RetiredZeroCopySocketIsClosedWithoutStats) {
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_GE(listener, 0);
+    int window = 16384;
+    setsockopt(listener, SOL_SOCKET, SO_RCVBUF, &window, sizeof(window));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(bind(listener, (sockaddr*)&addr, sizeof(addr)), 0);
+    ASSERT_EQ(listen(listener, 1), 0);
+    socklen_t len = sizeof(addr);
+    ASSERT_EQ(getsockname(listener, (sockaddr*)&addr, &len), 0);
+
+    int sender = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_EQ(connect(sender, (sockaddr*)&addr, sizeof(addr)), 0);
+    int receiver = accept(listener, nullptr, nullptr);
+    ASSERT_GE(receiver, 0);
+
+    PosixIoBackend backend;
+    backend.set_zerocopy_threshold(1024);
+
+    const std::string expected(64 * 1024, 'z');
+    auto payload = make_payload(expected);
+    std::weak_ptr<const std::string> observer = payload;
+    EXPECT_EQ(backend.send_batch({sender}, payload), 1u);
+    payload.reset();
+
+    if (backend.zerocopy_stats().zerocopy_bytes == 0) {
+        backend.forget(sender);
+        close(sender);
+        close(receiver);
+        close(listener);
+        GTEST_SKIP() << "SO_ZEROCOPY not supported here";
+    }
+
+    // Count this process's fds open on the sender's socket
+    struct stat socket_stat{};
+    ASSERT_EQ(fstat(sender, &socket_stat), 0);
+    auto open_on_socket = [&] {
+        size_t count = 0;
+        for (const auto& entry : std::filesystem::directory_iterator("/proc/self/fd")) {
+            struct stat st{};
+            if (stat(entry.path().c_str(), &st) == 0 && st.st_ino == socket_stat.st_ino &&
+                st.st_dev == socket_stat.st_dev) {
+                ++count;
+            }
+        }
+        return count;
+    };
+
+    // Nothing calls reap_completions() (the stats thread's job) in this test
+    backend.forget(sender);
+    close(sender);
+    ASSERT_FALSE(observer.expired());
+    EXPECT_EQ(open_on_socket(), 1u);
+
+    EXPECT_EQ(read_all(receiver, expected.size()), expected);
+    for (int i = 0; i < 200 && (!observer.expired() || open_on_socket() > 0); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_TRUE(observer.expired());
+    EXPECT_EQ(backend.zerocopy_pending(), 0u);
+    EXPECT_EQ(open_on_socket(), 0u);
+
+    close(receiver);
+    close(listener);
+}
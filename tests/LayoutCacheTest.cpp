@@ -0,0 +1,40 @@
+#include <gtest/gtest.h>
+#include "ui/LayoutCache.h"
+#include <string>
+#include <vector>
+
+using ui::TextLayout;
+using ui::WrapMode;
+
+TEST(LayoutCacheTest, FlowWrapsWholeTextAsOneParagraph) {
+    auto lines = ui::layout_text("the quick  brown\nfox jumps", 10, WrapMode::FLOW);
+    EXPECT_EQ(lines, (std::vector<std::string>{"the quick", "brown fox", "jumps"}));
+}
+
+TEST(LayoutCacheTest, LinesKeepsParagraphsAndBlankLines) {
+    auto lines = ui::layout_text("one two three\n\nfour", 7, WrapMode::LINES);
+    EXPECT_EQ(lines, (std::vector<std::string>{"one two", "three", "", "four"}));
+}
+
+TEST(LayoutCacheTest, NoneOnlySplitsOnNewlines) {
+    auto lines = ui::layout_text("a long first line\nb", 4, WrapMode::NONE);
+    EXPECT_EQ(lines, (std::vector<std::string>{"a long first line", "b"}));
+}
+
+TEST(LayoutCacheTest, ReusesLayoutUntilTextOrWidthChanges) {
+    TextLayout layout;
+    std::string text = "hello wide world";
+
+    const auto* first = &layout.lines(text, 8, WrapMode::FLOW);
+    EXPECT_EQ(&layout.lines(text, 8, WrapMode::FLOW), first);
+    EXPECT_EQ(layout.layouts(), 1u);
+
+    layout.lines(text, 20, WrapMode::FLOW);
+    EXPECT_EQ(layout.layouts(), 2u);
+    EXPECT_EQ(layout.lines(text, 20, WrapMode::FLOW).size(), 1u);
+
+    text = "changed";
+    layout.invalidate();
+    EXPECT_EQ(layout.lines(text, 20, WrapMode::FLOW), (std::vector<std::string>{"changed"}));
+    EXPECT_EQ(layout.layouts(), 3u);
+}
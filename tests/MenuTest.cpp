@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+#include "ui/Menu.h"
+#include <string>
+#include <vector>
+
+namespace {
+
+ui::Event key(int code) {
+    ui::Event event;
+    event.type = ui::EventType::KEY_PRESS;
+    event.key = code;
+    return event;
+}
+
+} // namespace
+
+class MenuVirtualTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        for (int i = 0; i < 3; ++i) {
+            loaded.emplace_back("room" + std::to_string(i));
+        }
+        menu.set_virtual([this](size_t index) -> const ui::MenuItem* {
+            return index < loaded.size() ? &loaded[index] : nullptr;
+        }, 10);
+        menu.set_focus(true);
+    }
+
+    std::vector<ui::MenuItem> loaded;
+    ui::Menu menu{0, 0, 20, 5};
+};
+
+TEST_F(MenuVirtualTest, CountsRowsBeyondLoadedItems) {
+    EXPECT_TRUE(menu.is_virtual());
+    EXPECT_EQ(menu.get_item_count(), 10u);
+    EXPECT_EQ(menu.get_selected_index(), 0);
+    ASSERT_NE(menu.find_item(2), nullptr);
+    EXPECT_EQ(menu.find_item(2)->text, "room2");
+    EXPECT_EQ(menu.find_item(5), nullptr);
+}
+
+TEST_F(MenuVirtualTest, SelectionMovesOntoUnloadedRowsButDoesNotActivate) {
+    int activations = 0;
+    menu.set_on_activate([&](size_t, const ui::MenuItem&) { ++activations; });
+
+    menu.handle_event(key(KEY_END));
+    EXPECT_EQ(menu.get_selected_index(), 9);
+    EXPECT_EQ(menu.get_selected_item(), nullptr);
+    menu.handle_event(key('\n'));
+    EXPECT_EQ(activations, 0);
+
+    menu.handle_event(key(KEY_HOME));
+    menu.handle_event(key('\n'));
+    EXPECT_EQ(activations, 1);
+}
+
+TEST_F(MenuVirtualTest, ShrinkingCountClampsSelection) {
+    menu.set_selected_index(8);
+    menu.set_virtual_count(4);
+    EXPECT_EQ(menu.get_selected_index(), 3);
+
+    menu.set_items({ui::MenuItem("only")});
+    EXPECT_FALSE(menu.is_virtual());
+    EXPECT_EQ(menu.get_item_count(), 1u);
+}
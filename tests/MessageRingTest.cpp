@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+#include "MessageRing.h"
+#include "ApplicationState.h"
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<std::string> collect(const MessageRing::View& view) {
+    return std::vector<std::string>(view.begin(), view.end());
+}
+
+} // namespace
+
+TEST(MessageRingTest, IdsIncreaseFromOne) {
+    MessageRing ring(4);
+    EXPECT_EQ(ring.push("a"), 1u);
+    EXPECT_EQ(ring.push("b"), 2u);
+    EXPECT_EQ(ring.first_id(), 1u);
+    EXPECT_EQ(ring.next_id(), 3u);
+    EXPECT_EQ(collect(ring.all()), (std::vector<std::string>{"a", "b"}));
+}
+
+TEST(MessageRingTest, OverwritesOldestWhenFull) {
+    MessageRing ring(3);
+    for (int i = 1; i <= 5; ++i) {
+        ring.push("m" + std::to_string(i));
+    }
+    EXPECT_EQ(ring.size(), 3u);
+    EXPECT_EQ(ring.first_id(), 3u);
+
+    auto view = ring.all();
+    EXPECT_EQ(view.first_id(), 3u);
+    EXPECT_EQ(collect(view), (std::vector<std::string>{"m3", "m4", "m5"}));
+    // Wrapped: two contiguous pieces
+    EXPECT_EQ(view.head().size() + view.tail().size(), 3u);
+    EXPECT_FALSE(view.tail().empty());
+}
+
+TEST(MessageRingTest, SinceReturnsOnlyNewMessages) {
+    MessageRing ring(8);
+    for (int i = 1; i <= 5; ++i) {
+        ring.push("m" + std::to_string(i));
+    }
+
+    auto delta = ring.since(3);
+    EXPECT_EQ(delta.first_id(), 4u);
+    EXPECT_EQ(collect(delta), (std::vector<std::string>{"m4", "m5"}));
+    EXPECT_TRUE(ring.since(5).empty());
+    EXPECT_EQ(ring.since(0).size(), 5u);
+}
+
+TEST(MessageRingTest, SinceAnOverwrittenIdStartsAtOldestKept) {
+    MessageRing ring(2);
+    for (int i = 1; i <= 6; ++i) {
+        ring.push("m" + std::to_string(i));
+    }
+    auto delta = ring.since(1);
+    EXPECT_EQ(delta.first_id(), 5u);
+    EXPECT_EQ(collect(delta), (std::vector<std::string>{"m5", "m6"}));
+}
+
+TEST(MessageRingTest, LastAndClearKeepIdsMonotonic) {
+    MessageRing ring(4);
+    for (int i = 1; i <= 6; ++i) {
+        ring.push("m" + std::to_string(i));
+    }
+    EXPECT_EQ(collect(ring.last(2)), (std::vector<std::string>{"m5", "m6"}));
+    EXPECT_EQ(ring.last(10).size(), 4u);
+
+    ring.clear();
+    EXPECT_TRUE(ring.all().empty());
+    EXPECT_EQ(ring.push("after"), 7u);
+    EXPECT_EQ(ring.since(6).back(), "after");
+}
+
+TEST(MessageRingTest, ApplicationStateHistoryIsBounded) {
+    ApplicationState state(3);
+    for (int i = 1; i <= 10; ++i) {
+        state.add_chat_message("m" + std::to_string(i));
+    }
+    EXPECT_EQ(state.get_chat_messages().size(), 3u);
+    EXPECT_EQ(state.last_chat_message_id(), 10u);
+    EXPECT_EQ(collect(state.get_chat_messages_since(8)), (std::vector<std::string>{"m9", "m10"}));
+}
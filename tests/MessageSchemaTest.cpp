@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+#include "common/MessageSchema.h"
+#include "common/NetworkMessage.h"
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+
+TEST(MessageSchemaTest, FactoriesWriteTheSameDataAsBefore) {
+    // body.data as the hand-written factories built it
+    EXPECT_EQ(NetworkMessage::create_join_room("t", "General").body.data, json({{"room_name", "General"}}));
+    EXPECT_EQ(NetworkMessage::create_leave("t").body.data, json::object());
+    EXPECT_EQ(NetworkMessage::create_auth("t").body.data, json::object());
+    EXPECT_EQ(NetworkMessage::create_auth("t", true).body.data, json({{"room_list", "paged"}}));
+    EXPECT_EQ(NetworkMessage::create_chat_message("t", "hi").body.data, json({{"message", "hi"}}));
+    EXPECT_EQ(NetworkMessage::create_chat_message("t", "hi", "Dev").body.data,
+              json({{"message", "hi"}, {"room_name", "Dev"}}));
+    EXPECT_EQ(NetworkMessage::create_list_rooms("t", "ab", "members", "c", 25).body.data,
+              json({{"prefix", "ab"}, {"sort", "members"}, {"cursor", "c"}, {"limit", 25}}));
+    EXPECT_EQ(NetworkMessage::create_broadcast_message("alice", "hi").body.data,
+              json({{"sender", "alice"}, {"message", "hi"}}));
+    EXPECT_EQ(NetworkMessage::create_room_message("General", 4, "alice", "hi").body.data,
+              json({{"sender", "alice"}, {"message", "hi"}, {"room", "General"}, {"seq", 4}}));
+    EXPECT_EQ(NetworkMessage::create_room_page("a", "name", "", {{"abc", 3}}, "abc", 9).body.data,
+              json({{"prefix", "a"}, {"sort", "name"}, {"cursor", ""},
+                    {"rooms", {{{"name", "abc"}, {"members", 3}}}}, {"next_cursor", "abc"}, {"total", 9}}));
+
+    auto left = NetworkMessage::create_left_room();
+    EXPECT_EQ(left.body.type, "LEFT_ROOM");
+    EXPECT_EQ(left.body.data, json({{"message", "Left room"}}));
+    EXPECT_EQ(left.header.token, "");
+}
+
+TEST(MessageSchemaTest, ReadingIsLenient) {
+    auto page = proto::ListRooms::from_json({{"prefix", 7}, {"limit", "ten"}, {"cursor", "c"}, {"extra", 1}});
+    EXPECT_EQ(page.prefix, "");
+    EXPECT_EQ(page.sort, "name");
+    EXPECT_EQ(page.cursor, "c");
+    EXPECT_EQ(page.limit, 0u);
+
+    EXPECT_EQ(proto::Credit::from_json({{"frames", -1}}).frames, 0u);
+    EXPECT_EQ(proto::Credit::from_json({{"frames", 1ull << 40}}).frames, 0u);
+    EXPECT_EQ(proto::Credit::from_json({{"frames", 64}}).frames, 64u);
+    EXPECT_EQ(proto::JoinRoom::from_json(json::array()).room_name, "");
+    EXPECT_EQ(proto::Error::from_json(json()).message, "Unknown error");
+
+    auto batch = proto::MessageBatch::from_json(
+        {{"room", "General"}, {"messages", {{{"sender", "bob"}, {"message", "one"}, {"seq", 1}}, "junk", {{"seq", 2}}}}});
+    ASSERT_EQ(batch.messages.size(), 2u);
+    EXPECT_EQ(batch.messages[0].sender, "bob");
+    EXPECT_TRUE(batch.messages[0].trace.is_null());
+    EXPECT_EQ(batch.messages[1].sender, "Unknown");
+    EXPECT_EQ(batch.messages[1].seq, 2u);
+
+    auto list = proto::ParticipantList::from_json({{"participants", {"alice", 3, "bob"}}});
+    EXPECT_EQ(list.participants, (std::vector<std::string>{"alice", "bob"}));
+}
+
+TEST(MessageSchemaTest, LooksUpTypesByName) {
+    EXPECT_EQ(proto::id_of("CHAT_MESSAGE"), proto::MessageId::ChatMessage);
+    EXPECT_EQ(proto::id_of("MESSAGE"), proto::MessageId::Message);
+    EXPECT_EQ(proto::id_of("MESSAGE_BATCH"), proto::MessageId::MessageBatch);
+    EXPECT_EQ(proto::id_of("AUTH"), proto::MessageId::Auth);
+    EXPECT_EQ(proto::id_of(""), proto::MessageId::UNKNOWN);
+    EXPECT_EQ(proto::id_of("message"), proto::MessageId::UNKNOWN);
+
+    auto any = proto::from_json("SEARCH_HISTORY", {{"query", "deploy"}, {"limit", 5}});
+    ASSERT_TRUE(std::holds_alternative<proto::SearchHistory>(any));
+    EXPECT_EQ(std::get<proto::SearchHistory>(any).query, "deploy");
+    EXPECT_EQ(std::get<proto::SearchHistory>(any).limit, 5u);
+    EXPECT_TRUE(std::holds_alternative<std::monostate>(proto::from_json("NOPE", json::object())));
+}
+
+TEST(MessageSchemaTest, BinaryRoundTrips) {
+    proto::HistoryResults results{.room_name = "General", .query = "deploy",
+                                  .results = {{1, "alice", "no deploy", -5, 2.5}, {300, "b\xc3\xb6" "b", "", 1700000000000, 0.125}}};
+    std::string bytes;
+    proto::write_binary(bytes, results);
+    EXPECT_LT(bytes.size(), results.to_json().dump().size());
+
+    auto decoded = proto::read_binary(bytes);
+    ASSERT_TRUE(decoded.has_value());
+    ASSERT_TRUE(std::holds_alternative<proto::HistoryResults>(*decoded));
+    EXPECT_EQ(std::get<proto::HistoryResults>(*decoded).to_json(), results.to_json());
+
+    proto::MessageBatch batch{.room = "General",
+                              .messages = {{"alice", "one", 1, nullptr}, {"bob", "two", 2, json{{"id", "ab"}, {"stages", json::array()}}}}};
+    bytes.clear();
+    proto::write_binary(bytes, batch);
+    decoded = proto::read_binary(bytes);
+    ASSERT_TRUE(decoded.has_value());
+    EXPECT_EQ(std::get<proto::MessageBatch>(*decoded).to_json(), batch.to_json());
+
+    bytes.clear();
+    proto::write_binary(bytes, proto::Quit{});
+    EXPECT_EQ(bytes.size(), 1u);
+    decoded = proto::read_binary(bytes);
+    ASSERT_TRUE(decoded.has_value());
+    EXPECT_TRUE(std::holds_alternative<proto::Quit>(*decoded));
+}
+
+TEST(MessageSchemaTest, BinaryRejectsMalformedInput) {
+    std::string bytes;
+    proto::write_binary(bytes, proto::RoomPage{.prefix = "a", .rooms = {{"abc", 3}}, .total = 1});
+
+    for (size_t length = 0; length < bytes.size(); ++length) {
+        EXPECT_FALSE(proto::read_binary(bytes.substr(0, length)).has_value()) << length;
+    }
+    EXPECT_FALSE(proto::read_binary(bytes + "x").has_value());
+    EXPECT_FALSE(proto::read_binary(std::string(1, static_cast<char>(proto::MessageId::UNKNOWN))).has_value());
+
+    // An array count larger than the remaining input
+    std::string hostile(1, static_cast<char>(proto::MessageId::RoomList));
+    hostile += "\xff\xff\xff\xff\x0f";
+    EXPECT_FALSE(proto::read_binary(hostile).has_value());
+}
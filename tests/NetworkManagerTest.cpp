@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 #include "NetworkManager.h"
 #include "ThreadSafeQueue.h"
+#include "common/NetworkMessage.h"
+#include "common/Trace.h"
 #include <thread>
 #include <chrono>
 #include <sys/socket.h>
@@ -12,7 +14,7 @@ using namespace std::chrono_literals;
 
 class NetworkManagerTest : public ::testing::Test {
 protected:
-    ThreadSafeQueue<std::string> inbound_queue;
+    ThreadSafeQueue<ServerEvent> inbound_queue;
     ThreadSafeQueue<std::string> outbound_queue;
     
     // Simple echo server for testing
@@ -66,6 +68,19 @@ protected:
         }
     }
     
+    // The echo server bounces frames back, so tests send what the server would
+    static std::string chat_frame(const std::string& text) {
+        return NetworkMessage::create_broadcast_message("alice", text).serialize();
+    }
+    
+    // Text of the single chat line an event carries, or "" if it is not one
+    static std::string line_text(const ServerEvent& event) {
+        if (event.type != ServerEventType::CHAT_LINES || event.get<ChatLinesData>().lines.size() != 1) {
+            return "";
+        }
+        return event.get<ChatLinesData>().lines[0].message;
+    }
+    
     void run_echo_server() {
         fd_set read_fds;
         struct timeval tv;
@@ -138,12 +153,13 @@ TEST_F(NetworkManagerTest, SendAndReceive) {
     network.start();
     
     // Send a message
-    outbound_queue.push("Hello, Server!\n");
+    outbound_queue.push(chat_frame("Hello, Server!"));
     
-    // Wait for echo response
-    std::string response;
+    // Wait for echo response, decoded on the network thread
+    ServerEvent response;
     ASSERT_TRUE(inbound_queue.try_pop(response, 1000ms));
-    EXPECT_EQ(response, "Hello, Server!\n");
+    EXPECT_EQ(line_text(response), "Hello, Server!");
+    EXPECT_EQ(response.get<ChatLinesData>().lines[0].sender, "alice");
     
     network.stop();
 }
@@ -158,23 +174,15 @@ TEST_F(NetworkManagerTest, MultipleMessages) {
     
     // Send multiple messages
     for (int i = 0; i < 5; ++i) {
-        outbound_queue.push("Message " + std::to_string(i) + "\n");
+        outbound_queue.push(chat_frame("Message " + std::to_string(i)));
         std::this_thread::sleep_for(50ms);  // Small delay to prevent batching
     }
     
-    // Receive echoed messages - TCP may batch them
-    std::string all_responses;
-    for (int i = 0; i < 5; ++i) {
-        std::string response;
-        if (inbound_queue.try_pop(response, 1000ms)) {
-            all_responses += response;
-        }
-    }
-    
-    // Check that all messages were received (order preserved)
+    // TCP may merge the echoes; each frame is still its own event, in order
     for (int i = 0; i < 5; ++i) {
-        EXPECT_NE(all_responses.find("Message " + std::to_string(i)), std::string::npos)
-            << "Missing message " << i;
+        ServerEvent response;
+        ASSERT_TRUE(inbound_queue.try_pop(response, 1000ms)) << "Missing message " << i;
+        EXPECT_EQ(line_text(response), "Message " + std::to_string(i));
     }
     
     network.stop();
@@ -189,9 +197,9 @@ TEST_F(NetworkManagerTest, StopCleansUpProperly) {
     network.start();
     
     // Send a message
-    outbound_queue.push("Test\n");
+    outbound_queue.push(chat_frame("Test"));
     
-    std::string response;
+    ServerEvent response;
     ASSERT_TRUE(inbound_queue.try_pop(response, 1000ms));
     
     // Stop should clean up without hanging
@@ -219,12 +227,12 @@ TEST_F(NetworkManagerTest, QueueReferencesValid) {
     network.start();
     
     // Push to the queue we passed in
-    outbound_queue.push("Reference Test\n");
+    outbound_queue.push(chat_frame("Reference Test"));
     
     // Should receive on the inbound queue we passed in
-    std::string response;
+    ServerEvent response;
     ASSERT_TRUE(inbound_queue.try_pop(response, 1000ms));
-    EXPECT_EQ(response, "Reference Test\n");
+    EXPECT_EQ(line_text(response), "Reference Test");
     
     network.stop();
 }
@@ -237,8 +245,8 @@ TEST_F(NetworkManagerTest, ServerDisconnectDetected) {
     network.start();
     
     // Send a message to establish connection
-    outbound_queue.push("Test\n");
-    std::string response;
+    outbound_queue.push(chat_frame("Test"));
+    ServerEvent response;
     ASSERT_TRUE(inbound_queue.try_pop(response, 1000ms));
     
     // Close server side
@@ -251,10 +259,109 @@ TEST_F(NetworkManagerTest, ServerDisconnectDetected) {
     std::this_thread::sleep_for(200ms);
     EXPECT_FALSE(network.is_connected());
     
-    // Should have received disconnect message
-    std::string disconnect_msg;
-    if (inbound_queue.try_pop(disconnect_msg, 100ms)) {
-        EXPECT_TRUE(disconnect_msg.find("DISCONNECTED") != std::string::npos ||
-                   disconnect_msg.find("ERROR") != std::string::npos);
+    // Should have received disconnect event
+    ServerEvent disconnect;
+    ASSERT_TRUE(inbound_queue.try_pop(disconnect, 100ms));
+    EXPECT_EQ(disconnect.type, ServerEventType::DISCONNECTED);
+}
+
+TEST_F(NetworkManagerTest, StopIsNotReportedAsDisconnect) {
+    NetworkManager network(inbound_queue, outbound_queue);
+    
+    std::string error;
+    ASSERT_TRUE(network.connect("127.0.0.1", server_port, error));
+    network.start();
+    
+    outbound_queue.push(chat_frame("Test"));
+    ServerEvent response;
+    ASSERT_TRUE(inbound_queue.try_pop(response, 1000ms));
+    
+    // A stop() before reconnecting must not leave a DISCONNECTED for the next session
+    network.stop();
+    ServerEvent stale;
+    EXPECT_FALSE(inbound_queue.try_pop(stale, 200ms));
+}
+
+TEST_F(NetworkManagerTest, SplitsReadsIntoFrames) {
+    NetworkManager network(inbound_queue, outbound_queue);
+    
+    std::string error;
+    ASSERT_TRUE(network.connect("127.0.0.1", server_port, error));
+    network.start();
+    
+    // One write, echoed back in one read, holding two frames and a partial one
+    std::string third = chat_frame("third");
+    outbound_queue.push(chat_frame("first") + chat_frame("second") + third.substr(0, 20));
+    ServerEvent response;
+    ASSERT_TRUE(inbound_queue.try_pop(response, 1000ms));
+    EXPECT_EQ(line_text(response), "first");
+    ASSERT_TRUE(inbound_queue.try_pop(response, 1000ms));
+    EXPECT_EQ(line_text(response), "second");
+    
+    outbound_queue.push(third.substr(20));
+    ASSERT_TRUE(inbound_queue.try_pop(response, 1000ms));
+    EXPECT_EQ(line_text(response), "third");
+    
+    network.stop();
+}
+
+TEST_F(NetworkManagerTest, DecodesBatchesAndStampsTraces) {
+    NetworkManager network(inbound_queue, outbound_queue);
+    network.set_tracing(true);
+    
+    std::string error;
+    ASSERT_TRUE(network.connect("127.0.0.1", server_port, error));
+    network.start();
+    
+    std::vector<proto::BatchItem> entries = {
+        {"alice", "one", 1, nullptr},
+        {"bob", "two", 2, tracing::start()},
+        {"bob", "three", 3, "not a trace"},
+    };
+    outbound_queue.push(NetworkMessage::create_message_batch("General", entries).serialize() +
+                        "not json\n");
+    
+    ServerEvent batch;
+    ASSERT_TRUE(inbound_queue.try_pop(batch, 1000ms));
+    ASSERT_EQ(batch.type, ServerEventType::CHAT_LINES);
+    const auto& lines = batch.get<ChatLinesData>().lines;
+    ASSERT_EQ(lines.size(), 3u);
+    EXPECT_EQ(lines[0].sender, "alice");
+    EXPECT_TRUE(lines[0].trace.is_null());
+    ASSERT_TRUE(tracing::well_formed(lines[1].trace));
+    EXPECT_EQ(lines[1].trace["stages"].back()[0], tracing::CLIENT_RECV);
+    EXPECT_TRUE(lines[2].trace.is_null());
+    
+    // Frames that do not decode still arrive, so flow control can count them
+    ServerEvent unknown;
+    ASSERT_TRUE(inbound_queue.try_pop(unknown, 1000ms));
+    EXPECT_EQ(unknown.type, ServerEventType::UNHANDLED);
+    
+    network.stop();
+}
+
+TEST_F(NetworkManagerTest, StopsReadingWhenInboundQueueIsFull) {
+    NetworkManager network(inbound_queue, outbound_queue, 2);
+    
+    std::string error;
+    ASSERT_TRUE(network.connect("127.0.0.1", server_port, error));
+    network.start();
+    
+    for (int i = 0; i < 4; ++i) {
+        outbound_queue.push(chat_frame("frame " + std::to_string(i)));
+        // Longer than one select() wait, so no two frames share a send (and an echo)
+        std::this_thread::sleep_for(120ms);
     }
+    
+    // Nothing is read once two frames are waiting
+    EXPECT_EQ(inbound_queue.size(), 2u);
+    
+    // Draining lets the rest through, in order
+    ServerEvent response;
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(inbound_queue.try_pop(response, 1000ms));
+        EXPECT_EQ(line_text(response), "frame " + std::to_string(i));
+    }
+    
+    network.stop();
 }
@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+#include "RoomDirectory.h"
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<std::string> names(const RoomPage& page) {
+    std::vector<std::string> result;
+    for (const auto& room : page.rooms) {
+        result.push_back(room.name);
+    }
+    return result;
+}
+
+} // namespace
+
+TEST(RoomDirectoryTest, PagesByNameWithCursor) {
+    RoomDirectory directory;
+    for (const char* name : {"delta", "alpha", "echo", "charlie", "bravo"}) {
+        directory.add(name);
+    }
+
+    RoomQuery query;
+    query.limit = 2;
+    RoomPage first = directory.query(query);
+    EXPECT_EQ(names(first), (std::vector<std::string>{"alpha", "bravo"}));
+    EXPECT_EQ(first.total, 5u);
+
+    query.cursor = first.next_cursor;
+    RoomPage second = directory.query(query);
+    EXPECT_EQ(names(second), (std::vector<std::string>{"charlie", "delta"}));
+
+    query.cursor = second.next_cursor;
+    RoomPage last = directory.query(query);
+    EXPECT_EQ(names(last), (std::vector<std::string>{"echo"}));
+    EXPECT_TRUE(last.next_cursor.empty());
+}
+
+TEST(RoomDirectoryTest, CursorSurvivesInsertsBeforeIt) {
+    RoomDirectory directory;
+    for (const char* name : {"b", "d", "f"}) {
+        directory.add(name);
+    }
+
+    RoomQuery query;
+    query.limit = 2;
+    RoomPage first = directory.query(query);
+    EXPECT_EQ(names(first), (std::vector<std::string>{"b", "d"}));
+
+    directory.add("a");
+    directory.add("e");
+    query.cursor = first.next_cursor;
+    EXPECT_EQ(names(directory.query(query)), (std::vector<std::string>{"e", "f"}));
+}
+
+TEST(RoomDirectoryTest, PrefixFiltersAndCounts) {
+    RoomDirectory directory;
+    for (const char* name : {"dev", "dev-ops", "design", "general", "de"}) {
+        directory.add(name);
+    }
+
+    RoomQuery query;
+    query.prefix = "dev";
+    RoomPage page = directory.query(query);
+    EXPECT_EQ(names(page), (std::vector<std::string>{"dev", "dev-ops"}));
+    EXPECT_EQ(page.total, 2u);
+    EXPECT_TRUE(page.next_cursor.empty());
+}
+
+TEST(RoomDirectoryTest, SortsByMembersAndFollowsUpdates) {
+    RoomDirectory directory;
+    for (const char* name : {"quiet", "busy", "medium", "also-busy"}) {
+        directory.add(name);
+    }
+    directory.set_members("busy", 10);
+    directory.set_members("also-busy", 10);
+    directory.set_members("medium", 3);
+
+    RoomQuery query;
+    query.sort = RoomSort::MEMBERS;
+    query.limit = 3;
+    RoomPage page = directory.query(query);
+    EXPECT_EQ(names(page), (std::vector<std::string>{"also-busy", "busy", "medium"}));
+    EXPECT_EQ(page.rooms[0].members, 10u);
+
+    query.cursor = page.next_cursor;
+    EXPECT_EQ(names(directory.query(query)), (std::vector<std::string>{"quiet"}));
+
+    directory.set_members("quiet", 20);
+    query.cursor.clear();
+    query.limit = 1;
+    EXPECT_EQ(names(directory.query(query)), (std::vector<std::string>{"quiet"}));
+}
+
+TEST(RoomDirectoryTest, LimitIsCapped) {
+    RoomDirectory directory;
+    for (size_t i = 0; i < RoomDirectory::MAX_PAGE_SIZE + 10; ++i) {
+        directory.add("room" + std::to_string(i));
+    }
+
+    RoomQuery query;
+    query.limit = 100000;
+    RoomPage page = directory.query(query);
+    EXPECT_EQ(page.rooms.size(), RoomDirectory::MAX_PAGE_SIZE);
+    EXPECT_FALSE(page.next_cursor.empty());
+
+    query.limit = 0;
+    EXPECT_EQ(directory.query(query).rooms.size(), RoomDirectory::DEFAULT_PAGE_SIZE);
+    EXPECT_FALSE(directory.add("room0"));
+}
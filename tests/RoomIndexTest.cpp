@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+#include "RoomIndex.h"
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<std::string> names(const std::vector<RoomEntry>& rooms) {
+    std::vector<std::string> result;
+    for (const auto& room : rooms) {
+        result.push_back(room.name);
+    }
+    return result;
+}
+
+} // namespace
+
+TEST(RoomIndexTest, PrefixIsCaseInsensitiveAndRankedByMembers) {
+    RoomIndex index;
+    for (const char* name : {"DevOps", "dev", "Design", "general"}) {
+        index.add(name);
+    }
+    index.set_members("dev", 2);
+    index.set_members("DevOps", 5);
+
+    EXPECT_EQ(names(index.search("DEV", RoomMatch::PREFIX, 10)),
+              (std::vector<std::string>{"DevOps", "dev"}));
+    EXPECT_EQ(names(index.search("de", RoomMatch::PREFIX, 10)),
+              (std::vector<std::string>{"DevOps", "dev", "Design"}));
+    EXPECT_TRUE(index.search("x", RoomMatch::PREFIX, 10).empty());
+}
+
+TEST(RoomIndexTest, SubstringUsesTrigramsAndVerifiesMatches) {
+    RoomIndex index;
+    for (const char* name : {"rust-lang", "trust-fund", "crusty", "rusty-nails", "ru-st"}) {
+        index.add(name);
+    }
+    index.set_members("crusty", 3);
+
+    EXPECT_EQ(names(index.search("rust", RoomMatch::SUBSTRING, 10)),
+              (std::vector<std::string>{"crusty", "rust-lang", "rusty-nails", "trust-fund"}));
+    EXPECT_EQ(names(index.search("USTY", RoomMatch::SUBSTRING, 10)),
+              (std::vector<std::string>{"crusty", "rusty-nails"}));
+    // Every trigram present, but never adjacent in one name
+    EXPECT_TRUE(index.search("ust-l-", RoomMatch::SUBSTRING, 10).empty());
+    // Shorter than a trigram
+    EXPECT_EQ(names(index.search("-s", RoomMatch::SUBSTRING, 10)), (std::vector<std::string>{"ru-st"}));
+}
+
+TEST(RoomIndexTest, EmptyQueryReturnsLargestRooms) {
+    RoomIndex index;
+    for (const char* name : {"a", "b", "c"}) {
+        index.add(name);
+    }
+    index.set_members("c", 9);
+    index.set_members("a", 4);
+    EXPECT_EQ(names(index.search("", RoomMatch::PREFIX, 2)), (std::vector<std::string>{"c", "a"}));
+    EXPECT_FALSE(index.add("a"));
+}
+
+TEST(RoomIndexTest, DenseMatchesWalkMemberOrder) {
+    RoomIndex index;
+    const size_t rooms = RoomIndex::DENSE_SCAN_LIMIT * 4;
+    for (size_t i = 0; i < rooms; ++i) {
+        index.add("room-" + std::to_string(i));
+    }
+    index.set_members("room-7000", 50);
+    index.set_members("room-12", 40);
+    index.set_members("room-3", 40);
+
+    EXPECT_EQ(names(index.search("room", RoomMatch::PREFIX, 3)),
+              (std::vector<std::string>{"room-7000", "room-12", "room-3"}));
+    EXPECT_EQ(names(index.search("oom-", RoomMatch::SUBSTRING, 3)),
+              (std::vector<std::string>{"room-7000", "room-12", "room-3"}));
+
+    // Sparse query among dense trigrams: rarest trigram bounds the scan
+    auto exact = index.search("m-7000", RoomMatch::SUBSTRING, 5);
+    ASSERT_EQ(exact.size(), 1u);
+    EXPECT_EQ(exact[0].members, 50u);
+}
+
+TEST(RoomIndexTest, CommonTrigramsAreIntersected) {
+    // Every trigram of "foo bar" is in thousands of rooms, but only the
+    // empty "foo bar-N" rooms hold them together; busier rooms would fill
+    // the member-order walk long before reaching them
+    RoomIndex index;
+    const size_t rooms = RoomIndex::DENSE_SCAN_LIMIT * 3;
+    for (size_t i = 0; i < rooms; ++i) {
+        std::string n = std::to_string(i);
+        for (std::string name : {"foo x" + n, "q bar" + n, "zo bq" + n}) {
+            index.add(name);
+            index.set_members(name, 1);
+        }
+    }
+    for (const char* name : {"foo bar-1", "FOO BAR-2"}) {
+        index.add(name);
+    }
+
+    EXPECT_EQ(names(index.search("foo bar", RoomMatch::SUBSTRING, 10)),
+              (std::vector<std::string>{"FOO BAR-2", "foo bar-1"}));
+}
+
+TEST(RoomIndexTest, MatchesBelowTheWalkLimitAreStillFound) {
+    // Far more busy non-matching rooms than the walk visits, and many
+    // more matches than fit the dense limit, all of them empty
+    RoomIndex index;
+    for (size_t i = 0; i < RoomIndex::WALK_VISIT_LIMIT + 4000; ++i) {
+        std::string name = "aa-" + std::to_string(i);
+        index.add(name);
+        index.set_members(name, 5);
+    }
+    for (size_t i = 0; i < RoomIndex::DENSE_SCAN_LIMIT + 1000; ++i) {
+        index.add("zz-" + std::to_string(i));
+    }
+
+    for (auto [query, match] : {std::pair{"zz", RoomMatch::PREFIX}, std::pair{"zz", RoomMatch::SUBSTRING},
+                                std::pair{"z", RoomMatch::SUBSTRING}, std::pair{"zz-", RoomMatch::SUBSTRING}}) {
+        auto rooms = index.search(query, match, 20);
+        ASSERT_EQ(rooms.size(), 20u) << query;
+        // Ties on members are ranked by name
+        EXPECT_EQ(rooms[0].name, "zz-0") << query;
+        EXPECT_EQ(rooms[0].members, 0u) << query;
+    }
+}
+
+TEST(RoomIndexTest, HundredThousandRooms) {
+    RoomIndex index;
+    for (size_t i = 0; i < 100000; ++i) {
+        index.add("room" + std::to_string(i));
+    }
+    for (size_t i = 0; i < 100; ++i) {
+        index.set_members("room" + std::to_string(i * 997), i + 1);
+    }
+
+    auto top = index.search("room", RoomMatch::PREFIX, 3);
+    EXPECT_EQ(names(top), (std::vector<std::string>{"room98703", "room97706", "room96709"}));
+    auto contains = index.search("9870", RoomMatch::SUBSTRING, 1);
+    ASSERT_EQ(contains.size(), 1u);
+    EXPECT_EQ(contains[0].name, "room98703");
+}
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include "ui/RowBuffer.h"
+#include <cstdio>
+#include <string>
+
+namespace {
+
+std::string text_of(const ui::RowBuffer& row) {
+    std::string text;
+    for (int i = 0; i < row.width(); ++i) {
+        text += static_cast<char>(row.cells()[i] & A_CHARTEXT);
+    }
+    return text;
+}
+
+// Off-screen ncurses session writing to /dev/null
+class RowBufferScreenTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        out_ = std::fopen("/dev/null", "w");
+        in_ = std::fopen("/dev/null", "r");
+        screen_ = newterm("vt100", out_, in_);
+        if (!screen_) {
+            GTEST_SKIP() << "no vt100 terminfo";
+        }
+        win_ = newwin(5, 20, 0, 0);
+    }
+
+    void TearDown() override {
+        if (win_) delwin(win_);
+        if (screen_) {
+            endwin();
+            delscreen(screen_);
+        }
+        if (in_) std::fclose(in_);
+        if (out_) std::fclose(out_);
+    }
+
+    FILE* out_ = nullptr;
+    FILE* in_ = nullptr;
+    SCREEN* screen_ = nullptr;
+    WINDOW* win_ = nullptr;
+};
+
+} // namespace
+
+TEST(RowBufferTest, ComposesTextIntoBlankRow) {
+    ui::RowBuffer row;
+    row.reset(10);
+    int col = row.put_number(0, 12);
+    col = row.put(col, ". ");
+    row.put(col, "room");
+    EXPECT_EQ(text_of(row), "12. room  ");
+}
+
+TEST(RowBufferTest, ClipsAndTruncatesToWidth) {
+    ui::RowBuffer row;
+    row.reset(8);
+    row.put_truncated(0, "a very long room name", 8);
+    EXPECT_EQ(text_of(row), "a ver...");
+
+    row.reset(4);
+    EXPECT_EQ(row.put(2, "xyz"), 4);
+    EXPECT_EQ(text_of(row), "  xy");
+}
+
+TEST(RowBufferTest, KeepsAttributesAndBlanksControlCharacters) {
+    ui::RowBuffer row;
+    row.reset(3);
+    row.put(0, "a\tb", A_BOLD);
+    EXPECT_EQ(text_of(row), "a b");
+    EXPECT_TRUE(row.cells()[0] & A_BOLD);
+}
+
+TEST_F(RowBufferScreenTest, SkipsRowsAlreadyOnScreen) {
+    ui::RowBuffer row;
+    row.reset(10);
+    row.put(0, "lobby", A_REVERSE);
+
+    EXPECT_TRUE(row.draw(win_, 1, 2));
+    EXPECT_FALSE(row.draw(win_, 1, 2));
+    EXPECT_EQ(row.rows_drawn(), 1u);
+    EXPECT_EQ(row.rows_skipped(), 1u);
+
+    // Something else overwrote the row: it is drawn again
+    werase(win_);
+    EXPECT_TRUE(row.draw(win_, 1, 2));
+    EXPECT_EQ(mvwinch(win_, 1, 2), static_cast<chtype>('l') | A_REVERSE);
+}
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+#include "auth/AuthManager.h"
+#include "auth/InMemoryUserRepository.h"
+#include "auth/SessionStore.h"
+#include <unistd.h>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+
+class SessionStoreTest : public ::testing::Test {
+protected:
+    std::string path;
+    std::shared_ptr<InMemoryUserRepository> users;
+
+    void SetUp() override {
+        path = "/tmp/booking_sessions_" + std::to_string(getpid());
+        remove_files();
+        users = std::make_shared<InMemoryUserRepository>();
+        AuthManager setup(users);
+        ASSERT_TRUE(setup.register_user("carol", "pw", "Carol C"));
+    }
+
+    void TearDown() override {
+        remove_files();
+    }
+
+    void remove_files() {
+        std::remove((path + ".snapshot").c_str());
+        std::remove((path + ".log").c_str());
+        std::remove((path + ".log.old").c_str());
+    }
+
+    // A manager as it would be built by a freshly started auth server
+    std::unique_ptr<AuthManager> restart() {
+        return std::make_unique<AuthManager>(users, std::make_shared<SessionStore>(path));
+    }
+};
+
+TEST_F(SessionStoreTest, TokensSurviveRestart) {
+    std::string kept, revoked;
+    {
+        auto manager = restart();
+        kept = manager->authenticate("carol", "pw").token;
+        revoked = manager->authenticate("carol", "pw").token;
+        manager->revoke_token(revoked);
+    }
+
+    auto manager = restart();
+    EXPECT_TRUE(manager->validate_token(kept));
+    EXPECT_FALSE(manager->validate_token(revoked));
+
+    auto session = manager->get_token(kept);
+    ASSERT_TRUE(session.has_value());
+    EXPECT_EQ(session->username, "carol");
+    EXPECT_EQ(session->display_name, "Carol C");
+}
+
+TEST_F(SessionStoreTest, SnapshotEmptiesLog) {
+    auto manager = restart();
+    std::string token = manager->authenticate("carol", "pw").token;
+
+    auto store = std::make_shared<SessionStore>(path);
+    EXPECT_EQ(store->load().size(), 1u);
+
+    manager->snapshot_sessions();
+    std::ifstream log(path + ".log", std::ios::binary | std::ios::ate);
+    EXPECT_EQ(log.tellg(), 0);
+
+    EXPECT_TRUE(restart()->validate_token(token));
+}
+
+TEST_F(SessionStoreTest, AppendsDuringSnapshotAreKept) {
+    AuthToken before("before", "carol", "Carol C", {});
+    AuthToken during("during", "carol", "Carol C", {});
+    {
+        SessionStore store(path);
+        store.append_issue(before);
+        store.rotate_log();
+        // Issued after the sessions were copied but before the snapshot landed
+        store.append_issue(during);
+        EXPECT_EQ(store.load().size(), 2u);
+        ASSERT_TRUE(store.write_snapshot({before}));
+        EXPECT_EQ(store.log_records(), 1u);
+    }
+
+    EXPECT_EQ(SessionStore(path).load().size(), 2u);
+    std::ifstream old_log(path + ".log.old");
+    EXPECT_FALSE(old_log.good());
+}
+
+TEST_F(SessionStoreTest, TornLogTailIsIgnored) {
+    std::string token;
+    {
+        auto manager = restart();
+        token = manager->authenticate("carol", "pw").token;
+    }
+
+    // Simulate a crash part-way through appending the next record
+    std::ofstream log(path + ".log", std::ios::binary | std::ios::app);
+    log.write("I\x40\x00\x00\x00partial", 12);
+    log.close();
+
+    EXPECT_TRUE(restart()->validate_token(token));
+}
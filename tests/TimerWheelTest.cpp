@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+#include "TimerWheel.h"
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+TEST(TimerWheelTest, FiresOnTheDueTick) {
+    TimerWheel wheel;
+    wheel.schedule(3, 30);
+    wheel.schedule(1, 10);
+    wheel.schedule(0, 11);  // clamped to one tick
+    wheel.schedule(2, 20);
+    EXPECT_EQ(wheel.size(), 4u);
+
+    std::vector<uint64_t> expired;
+    wheel.advance(1, expired);
+    std::sort(expired.begin(), expired.end());
+    EXPECT_EQ(expired, (std::vector<uint64_t>{10, 11}));
+
+    expired.clear();
+    wheel.advance(3, expired);
+    EXPECT_EQ(expired, (std::vector<uint64_t>{20, 30}));
+    EXPECT_EQ(wheel.size(), 0u);
+
+    expired.clear();
+    wheel.advance(2, expired);  // the past is a no-op
+    EXPECT_TRUE(expired.empty());
+    EXPECT_EQ(wheel.now(), 3u);
+}
+
+TEST(TimerWheelTest, CancelAndStaleIds) {
+    TimerWheel wheel;
+    auto first = wheel.schedule(5, 1);
+    auto second = wheel.schedule(5, 2);
+    EXPECT_TRUE(wheel.cancel(first));
+    EXPECT_FALSE(wheel.cancel(first));
+    EXPECT_FALSE(wheel.cancel(0));
+    EXPECT_FALSE(wheel.cancel(12345));
+
+    // The freed node is reused; the old id must not cancel the new timer
+    auto third = wheel.schedule(5, 3);
+    EXPECT_NE(third, first);
+    EXPECT_FALSE(wheel.cancel(first));
+
+    std::vector<uint64_t> expired;
+    wheel.advance(5, expired);
+    std::sort(expired.begin(), expired.end());
+    EXPECT_EQ(expired, (std::vector<uint64_t>{2, 3}));
+    EXPECT_FALSE(wheel.cancel(second));
+}
+
+TEST(TimerWheelTest, CascadesThroughEveryLevel) {
+    // Start off a level boundary so timers cross several of them
+    TimerWheel wheel(1000);
+    const std::vector<uint64_t> delays = {63, 64, 65, 4095, 4096, 4097, 262143, 262144, 300000,
+                                          16777215, 16777216, 16777300};
+    for (uint64_t delay : delays) {
+        wheel.schedule(delay, delay);
+    }
+
+    std::vector<uint64_t> expired;
+    for (uint64_t delay : delays) {
+        wheel.advance(1000 + delay - 1, expired);
+        EXPECT_TRUE(std::find(expired.begin(), expired.end(), delay) == expired.end()) << delay;
+        wheel.advance(1000 + delay, expired);
+        EXPECT_EQ(expired.back(), delay);
+    }
+    EXPECT_EQ(wheel.size(), 0u);
+}
+
+TEST(TimerWheelTest, MatchesAReferenceModel) {
+    std::mt19937_64 rng(7);
+    TimerWheel wheel;
+    std::map<uint64_t, uint64_t> due;                       // payload -> expiry tick
+    std::map<uint64_t, TimerWheel::TimerId> ids;
+    uint64_t next_payload = 1;
+
+    for (int round = 0; round < 2000; ++round) {
+        for (int i = 0; i < 3; ++i) {
+            uint64_t delay = 1 + rng() % (rng() % 2 ? 100 : 20000);
+            uint64_t payload = next_payload++;
+            ids[payload] = wheel.schedule(delay, payload);
+            due[payload] = wheel.now() + delay;
+        }
+        if (!ids.empty() && rng() % 3 == 0) {
+            auto it = std::next(ids.begin(), static_cast<long>(rng() % ids.size()));
+            EXPECT_TRUE(wheel.cancel(it->second));
+            due.erase(it->first);
+            ids.erase(it);
+        }
+
+        uint64_t target = wheel.now() + rng() % 50;
+        std::vector<uint64_t> expired;
+        wheel.advance(target, expired);
+        for (uint64_t payload : expired) {
+            ASSERT_EQ(due.count(payload), 1u);
+            EXPECT_LE(due[payload], target);
+            due.erase(payload);
+            ids.erase(payload);
+        }
+        for (const auto& [payload, tick] : due) {
+            ASSERT_GT(tick, target) << payload;
+        }
+        ASSERT_EQ(wheel.size(), due.size());
+    }
+}
@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+#include "ChatRoom.h"
+#include "common/NetworkMessage.h"
+#include "common/Trace.h"
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+class TraceTest : public ::testing::Test {
+protected:
+    std::shared_ptr<IoBackend> backend = std::make_shared<PosixIoBackend>();
+    std::vector<std::pair<std::shared_ptr<ClientConnection>, int>> members;
+    std::string path;
+
+    void SetUp() override {
+        path = "/tmp/booking_trace_" + std::to_string(getpid()) + ".jsonl";
+        std::remove(path.c_str());
+    }
+
+    void TearDown() override {
+        for (auto& [connection, reader] : members) {
+            close(connection->fd());
+            close(reader);
+        }
+        std::remove(path.c_str());
+    }
+
+    std::shared_ptr<ClientConnection> add_member(ChatRoom& room, const std::string& name) {
+        int sv[2];
+        socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+        auto connection = std::make_shared<ClientConnection>(sv[0], name, "127.0.0.1", "", backend);
+        members.emplace_back(connection, sv[1]);
+        room.add_client(connection);
+        return connection;
+    }
+
+    std::string read_all(int fd, int timeout_ms) {
+        std::string data;
+        char chunk[4096];
+        pollfd pfd{fd, POLLIN, 0};
+        while (poll(&pfd, 1, timeout_ms) > 0) {
+            ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+            if (n <= 0) break;
+            data.append(chunk, n);
+        }
+        return data;
+    }
+
+    std::vector<nlohmann::json> logged_traces() {
+        std::vector<nlohmann::json> traces;
+        std::ifstream file(path);
+        for (std::string line; std::getline(file, line);) {
+            traces.push_back(nlohmann::json::parse(line));
+        }
+        return traces;
+    }
+
+    static bool has_stage(const nlohmann::json& trace, const char* stage) {
+        for (const auto& entry : trace["stages"]) {
+            if (entry[0] == stage) return true;
+        }
+        return false;
+    }
+};
+
+TEST_F(TraceTest, HeaderTraceRoundTripsAndIsOmittedWhenUnset) {
+    auto plain = NetworkMessage::create_chat_message("token", "hi");
+    EXPECT_EQ(plain.serialize().find("\"trace\""), std::string::npos);
+
+    auto traced = NetworkMessage::create_chat_message("token", "hi");
+    traced.header.trace = tracing::start();
+    tracing::stamp(traced.header.trace, tracing::CLIENT_INPUT, 42);
+    auto parsed = NetworkMessage::deserialize(traced.serialize());
+    ASSERT_TRUE(tracing::well_formed(parsed.header.trace));
+    EXPECT_EQ(parsed.header.trace["id"], traced.header.trace["id"]);
+    EXPECT_EQ(parsed.header.trace["stages"][0][1], 42);
+    EXPECT_TRUE(NetworkMessage::deserialize(plain.serialize()).header.trace.is_null());
+}
+
+TEST_F(TraceTest, IllFormedTracesAreRejected) {
+    EXPECT_FALSE(tracing::well_formed(nullptr));
+    EXPECT_FALSE(tracing::well_formed({{"id", 7}, {"stages", nlohmann::json::array()}}));
+    nlohmann::json long_trace = tracing::start();
+    for (int i = 0; i < 16; ++i) tracing::stamp(long_trace, tracing::RENDER, i);
+    EXPECT_FALSE(tracing::well_formed(long_trace));
+}
+
+TEST_F(TraceTest, BroadcastStampsLiveCopyAndLogsSocketWrite) {
+    auto log = std::make_shared<tracing::TraceLog>();
+    ASSERT_TRUE(log->open(path));
+    auto room = std::make_shared<ChatRoom>("General", backend, nullptr, log);
+    auto alice = add_member(*room, "alice");
+    add_member(*room, "bob");
+
+    auto trace = tracing::start();
+    tracing::stamp(trace, tracing::SERVER_RECV);
+    room->broadcast_message("alice", "traced", alice->fd(), trace);
+    room->broadcast_message("alice", "plain", alice->fd());
+
+    std::string data = read_all(members[1].second, 50);
+    size_t newline = data.find('\n');
+    ASSERT_NE(newline, std::string::npos);
+    auto first = NetworkMessage::deserialize(data.substr(0, newline));
+    ASSERT_TRUE(tracing::well_formed(first.header.trace));
+    EXPECT_EQ(first.header.trace["id"], trace["id"]);
+    EXPECT_TRUE(has_stage(first.header.trace, tracing::BROADCAST_ENQUEUE));
+    EXPECT_EQ(data.find("\"trace\"", newline), std::string::npos);
+
+    auto logged = logged_traces();
+    ASSERT_EQ(logged.size(), 1u);
+    EXPECT_EQ(logged[0]["id"], trace["id"]);
+    EXPECT_TRUE(has_stage(logged[0], tracing::SOCKET_WRITE));
+
+    // Newcomers replay history without the trace
+    auto carol = add_member(*room, "carol");
+    room->send_history_to_client(*carol);
+    std::string history = read_all(members[2].second, 50);
+    EXPECT_NE(history.find("traced"), std::string::npos);
+    EXPECT_EQ(history.find("\"trace\""), std::string::npos);
+}
+
+TEST_F(TraceTest, BatchedBroadcastCarriesTracePerEntry) {
+    BatchConfig config;
+    config.rate_threshold = 1;
+    config.max_delay = std::chrono::milliseconds(20);
+    auto flusher = std::make_shared<BatchFlusher>(config);
+    auto log = std::make_shared<tracing::TraceLog>();
+    ASSERT_TRUE(log->open(path));
+    auto room = std::make_shared<ChatRoom>("General", backend, flusher, log);
+    auto alice = add_member(*room, "alice");
+    add_member(*room, "bob");
+
+    auto trace = tracing::start();
+    room->broadcast_message("alice", "one", alice->fd());
+    room->broadcast_message("alice", "two", alice->fd(), trace);
+
+    std::string data = read_all(members[1].second, 100);
+    auto frame = NetworkMessage::deserialize(data.substr(0, data.find('\n')));
+    ASSERT_EQ(frame.body.type, "MESSAGE_BATCH");
+    const auto& messages = frame.body.data["messages"];
+    ASSERT_EQ(messages.size(), 2u);
+    EXPECT_FALSE(messages[0].contains("trace"));
+    ASSERT_TRUE(messages[1].contains("trace"));
+    EXPECT_TRUE(has_stage(messages[1]["trace"], tracing::BROADCAST_ENQUEUE));
+
+    auto logged = logged_traces();
+    ASSERT_EQ(logged.size(), 1u);
+    EXPECT_TRUE(has_stage(logged[0], tracing::SOCKET_WRITE));
+}
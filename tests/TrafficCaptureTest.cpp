@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+#include "TrafficCapture.h"
+#include <unistd.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+class TrafficCaptureTest : public ::testing::Test {
+protected:
+    std::string path;
+
+    void SetUp() override {
+        path = "/tmp/booking_capture_" + std::to_string(getpid()) + ".jsonl";
+        std::remove(path.c_str());
+    }
+
+    void TearDown() override {
+        std::remove(path.c_str());
+    }
+};
+
+TEST_F(TrafficCaptureTest, RoundTripsConnectionsAndFrames) {
+    {
+        TrafficCapture capture(path);
+        ASSERT_TRUE(capture.open());
+        uint64_t alice = capture.connection_opened("alice", {{"room_list", "paged"}});
+        uint64_t bob = capture.connection_opened("bob", json::object());
+        EXPECT_NE(alice, bob);
+        capture.frame(alice, NetworkMessage::create_join_room("secret-token", "General"));
+        capture.frame(bob, NetworkMessage::create_chat_message("secret-token", "hi there"));
+        capture.connection_closed(alice);
+        EXPECT_EQ(capture.frames(), 2u);
+    }
+
+    std::vector<CapturedEvent> events;
+    std::string error;
+    ASSERT_TRUE(TrafficCapture::load(path, events, error)) << error;
+    ASSERT_EQ(events.size(), 5u);
+
+    EXPECT_EQ(events[0].kind, CapturedEvent::Kind::OPEN);
+    EXPECT_EQ(events[0].user, "alice");
+    EXPECT_EQ(events[0].data.value("room_list", ""), "paged");
+    EXPECT_EQ(events[2].kind, CapturedEvent::Kind::FRAME);
+    EXPECT_EQ(events[2].type, "JOIN_ROOM");
+    EXPECT_EQ(events[2].data.value("room_name", ""), "General");
+    EXPECT_EQ(events[3].conn, events[1].conn);
+    EXPECT_EQ(events[3].data.value("message", ""), "hi there");
+    EXPECT_EQ(events[4].kind, CapturedEvent::Kind::CLOSE);
+    for (size_t i = 1; i < events.size(); ++i) {
+        EXPECT_GE(events[i].time_ns, events[i - 1].time_ns);
+    }
+
+    // Tokens never reach the file
+    std::ifstream file(path);
+    std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(contents.find("secret-token"), std::string::npos);
+}
+
+TEST_F(TrafficCaptureTest, TruncatedLastLineIsIgnored) {
+    {
+        TrafficCapture capture(path);
+        ASSERT_TRUE(capture.open());
+        capture.connection_opened("alice", json::object());
+    }
+    {
+        std::ofstream file(path, std::ios::app);
+        file << "{\"t\":12,\"conn\":1,\"ty";
+    }
+
+    std::vector<CapturedEvent> events;
+    std::string error;
+    ASSERT_TRUE(TrafficCapture::load(path, events, error)) << error;
+    EXPECT_EQ(events.size(), 1u);
+
+    std::ofstream(path, std::ios::app) << "\n{\"t\":13,\"conn\":1,\"close\":true}\n";
+    events.clear();
+    EXPECT_FALSE(TrafficCapture::load(path, events, error));
+}
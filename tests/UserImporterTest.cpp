@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+#include "auth/FileUserRepository.h"
+#include "auth/InMemoryUserRepository.h"
+#include "auth/UserImporter.h"
+#include <unistd.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+TEST(UserImporterTest, ParsesCsvAcrossChunks) {
+    // Large enough to be split across several threads
+    std::string csv = "# username,password_hash,display_name,roles\n";
+    for (int i = 0; i < 20000; ++i) {
+        csv += "user" + std::to_string(i) + ",abc123,User " + std::to_string(i) + ",user;tester\n";
+    }
+    csv += "user5,abc123,Dup,user\n";
+    csv += "bad name,abc123,Bad,user\n";
+    csv += "nohash,,No Hash,user\n";
+
+    UserImporter importer(4);
+    ImportReport report;
+    auto users = importer.parse_csv(csv, report);
+
+    EXPECT_EQ(report.records, 20003u);
+    EXPECT_EQ(users.size(), 20000u);
+    EXPECT_EQ(report.duplicates, 1u);
+    EXPECT_EQ(report.invalid, 2u);
+    ASSERT_EQ(report.errors.size(), 2u);
+    EXPECT_EQ(report.errors[0].rfind("line 20003:", 0), 0u) << report.errors[0];
+
+    EXPECT_EQ(users[7]->username, "user7");
+    EXPECT_EQ(users[7]->display_name, "User 7");
+    EXPECT_EQ(users[7]->roles, (std::vector<std::string>{"user", "tester"}));
+}
+
+TEST(UserImporterTest, ParsesRepositoryJson) {
+    std::string json = R"({"users": [
+        {"username": "amy", "password_hash": "h1", "display_name": "Amy \"A\"", "roles": ["user"]},
+        {"username": "ben", "password_hash": "h2", "display_name": "", "roles": []},
+        {"username": "amy", "password_hash": "h3", "display_name": "Other", "roles": []}
+    ]})";
+
+    UserImporter importer(2);
+    ImportReport report;
+    auto users = importer.parse_json(json, report);
+
+    ASSERT_EQ(users.size(), 2u);
+    EXPECT_EQ(report.duplicates, 1u);
+    EXPECT_EQ(users[0]->display_name, "Amy \"A\"");
+    EXPECT_EQ(users[1]->display_name, "ben");  // defaults to username
+}
+
+TEST(UserImporterTest, ImportWritesDatabaseOnceAndReloads) {
+    std::string suffix = std::to_string(getpid());
+    std::string csv_path = "/tmp/booking_import_" + suffix + ".csv";
+    std::string db_path = "/tmp/booking_import_" + suffix + ".json";
+    std::remove(db_path.c_str());
+    {
+        std::ofstream csv(csv_path);
+        csv << "alice,h1,Alice W,user\n"
+            << "bob,h2,Bob \\ Builder,user;admin\n";
+    }
+
+    {
+        FileUserRepository repository(db_path);
+        ASSERT_TRUE(repository.create_user(User("alice", "old", "Old Alice")).get());
+
+        UserImporter importer;
+        ImportReport report = importer.import_file(csv_path, repository);
+        EXPECT_EQ(report.imported, 1u);
+        EXPECT_EQ(report.existing, 1u);
+        EXPECT_EQ(repository.lookup_user("alice")->password_hash, "old");
+    }
+
+    FileUserRepository reloaded(db_path);
+    EXPECT_EQ(reloaded.get_user_count().get(), 2u);
+    auto bob = reloaded.lookup_user("bob");
+    ASSERT_NE(bob, nullptr);
+    EXPECT_EQ(bob->display_name, "Bob \\ Builder");
+    EXPECT_EQ(bob->roles, (std::vector<std::string>{"user", "admin"}));
+
+    std::remove(csv_path.c_str());
+    std::remove(db_path.c_str());
+}
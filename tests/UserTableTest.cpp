@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+#include "auth/UserTable.h"
+#include "auth/InMemoryUserRepository.h"
+#include <atomic>
+#include <string>
+#include <thread>
+
+namespace {
+
+UserTable::UserPtr make_user(const std::string& name) {
+    return std::make_shared<const User>(name, "hash", "Display " + name);
+}
+
+} // namespace
+
+TEST(UserTableTest, InsertFindErase) {
+    UserTable table;
+    EXPECT_EQ(table.find("nobody"), nullptr);
+
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_TRUE(table.insert(make_user("user" + std::to_string(i))));
+    }
+    EXPECT_FALSE(table.insert(make_user("user7")));
+    EXPECT_EQ(table.size(), 1000u);
+
+    // Erase every third user; the rest must stay reachable across probe chains
+    for (int i = 0; i < 1000; i += 3) {
+        ASSERT_TRUE(table.erase("user" + std::to_string(i)));
+    }
+    EXPECT_FALSE(table.erase("user0"));
+
+    for (int i = 0; i < 1000; ++i) {
+        auto user = table.find("user" + std::to_string(i));
+        if (i % 3 == 0) {
+            EXPECT_EQ(user, nullptr) << i;
+        } else {
+            ASSERT_NE(user, nullptr) << i;
+            EXPECT_EQ(user->display_name, "Display user" + std::to_string(i));
+        }
+    }
+}
+
+TEST(UserTableTest, AssignReplacesExistingOnly) {
+    UserTable table;
+    EXPECT_FALSE(table.assign(make_user("dave")));
+    ASSERT_TRUE(table.insert(make_user("dave")));
+
+    auto updated = std::make_shared<const User>("dave", "hash2", "Dave D");
+    EXPECT_TRUE(table.assign(updated));
+    EXPECT_EQ(table.find("dave"), updated);
+    EXPECT_EQ(table.size(), 1u);
+}
+
+TEST(UserTableTest, RepositorySnapshotsAreStable) {
+    InMemoryUserRepository repo;
+    ASSERT_TRUE(repo.create_user(User("erin", "hash", "Erin E")).get());
+
+    auto before = repo.snapshot();
+    auto erin = repo.lookup_user("erin");
+    ASSERT_NE(erin, nullptr);
+
+    ASSERT_TRUE(repo.update_user(User("erin", "hash", "Erin Renamed")).get());
+    ASSERT_TRUE(repo.delete_user("test").get());
+
+    // Earlier snapshots and handed-out users are unaffected by later writes
+    EXPECT_EQ(erin->display_name, "Erin E");
+    EXPECT_NE(before->find("test"), nullptr);
+    EXPECT_EQ(repo.lookup_user("erin")->display_name, "Erin Renamed");
+    EXPECT_EQ(repo.lookup_user("test"), nullptr);
+}
+
+TEST(UserTableTest, ReadersRunDuringWrites) {
+    InMemoryUserRepository repo;
+    std::atomic<bool> done{false};
+    std::atomic<int> misses{0};
+
+    std::thread reader([&]() {
+        while (!done) {
+            if (!repo.lookup_user("test")) {
+                ++misses;
+            }
+        }
+    });
+
+    for (int i = 0; i < 500; ++i) {
+        repo.create_user(User("writer" + std::to_string(i), "hash", "W"));
+    }
+    done = true;
+    reader.join();
+
+    EXPECT_EQ(misses, 0);
+    EXPECT_EQ(repo.get_user_count().get(), 501u);
+}